@@ -11,30 +11,25 @@ let SortMode = null;
 let nSections = 0;
 
 
-let language = navigator.language || "en";
-let PageCollator = new Intl.Collator (language, { sensitivity : "case" });
-let SectionCollator = new Intl.Collator (language, { sensitivity : "base", numeric : true });
+/*  Only the first page of results (by section) is embedded in the page;
+    the rest are fetched from /api/apropos, already sorted, as the reader
+    scrolls towards the end of the list.  Generation is bumped whenever
+    the list is rebuilt, so that a response for the old order is ignored.
+*/
 
+let Generation = 0;
+let nLoaded = 0;
+let nTotal = 0;
+let fLoading = false;
+let PrevSection = null;
+let CurrentTable = null;
+let CurrentContainer = null;
 
+const Sentinel = document.createElement ("div");
+const Observer = ("IntersectionObserver" in window)
+                   ? new IntersectionObserver (OnSentinelVisible, { rootMargin: "800px" })
+                   : null;
 
-function CompareBySection
-   (left, 
-    right)
-
-{
-  let t = SectionCollator.compare (left [1], right [1]);
-  return (t == 0) ? PageCollator.compare (left [0], right [0]) : t;
-}
-
-
-function CompareByName
-   (left,
-    right)
-
-{
-  let t = PageCollator.compare (left [0], right [0]);
-  return (t == 0) ? SectionCollator.compare (left [1], right [1]) : t;
-}
 
 
 function ShowSection
@@ -101,90 +96,53 @@ function HideAll
 }
 
 
-function SetSortMode
-   (mode)
+function AppendTableHeader
+    (table)
 
 {
-  let fBySection, Compare, LinkText;
-
-  switch (mode)
-  {
-    case "bysection":   fBySection = true;   break;
-    case "byname":      fBySection = false;  break;
-    default:            return;
-  }
-
-  if (SortMode === mode)
-    return;
-
-  SortMode = mode;
-
-
-  if (fBySection)
-  {
-    ShowAllBtn.removeAttribute ("Disabled");
-    HideAllBtn.removeAttribute ("Disabled");
-    ByNameBtn.removeAttribute ("Active");
-    BySectionBtn.setAttribute ("Active", "1");
-
-    Compare = CompareBySection;
-    LinkText = ((PageName, section) => PageName);
-  }
-  else
-  {
-    ShowAllBtn.setAttribute ("Disabled", "1");
-    HideAllBtn.setAttribute ("Disabled", "1");
-    BySectionBtn.removeAttribute ("Active");
-    ByNameBtn.setAttribute ("Active", "1");
+  let row, cell;
 
-    Compare = CompareByName;
-    LinkText = ((PageName, section) => `${PageName}(${section})`);
-  }
+  row = document.createElement ("tr");
+  row.className = "AproposTableHeader";
+  table.append (row);
+  
+  cell = document.createElement ("th");
+  cell.setAttribute ("Column", "page");
+  cell.textContent = "Page";
+  row.append (cell);
+  
+  cell = document.createElement ("th");
+  cell.setAttribute ("Column", "description");
+  cell.textContent = "Description";
+  row.append (cell);
+}
 
 
-  results.sort (Compare);
 
+function AppendResults
+    (page)
 
-  let elts = [... ResultsDiv.children];
-  for (let i = elts.length - 1; i >= 0; i--)
-  {
-    ResultsDiv.removeChild (elts [i]);
-  }
+{
+  let fBySection = (SortMode === "bysection");
+  let results = page.results, nResults = results.length;
+  let bar, HideBtn, row, cell, content;
+  let touched = [];
 
 
-  let bar, HideBtn, container, table, row, cell, content;
-  let PrevSection = null, nResults = results.length, n = 0;
- 
-  
-  if (!fBySection)
+  if (CurrentContainer)
   {
-    table = document.createElement ("table"); 
-    table.className = "AproposTable";
-    ResultsDiv.append (table);
-  
-    row = document.createElement ("tr");
-    row.className = "AproposTableHeader";
-    table.append (row);
-    
-    cell = document.createElement ("th");
-    cell.setAttribute ("Column", "page");
-    cell.textContent = "Page";
-    row.append (cell);
-    
-    cell = document.createElement ("th");
-    cell.setAttribute ("Column", "description");
-    cell.textContent = "Description";
-    row.append (cell);
+    touched.push (CurrentContainer);
   }
 
 
   for (let i = 0; i < nResults; i++)
   {
-    let [page, section, description] = results [i];    
+    let [name, section, description] = results [i];
   
 
     if (fBySection && (section != PrevSection))
     {
+      let n = nSections;
       let ElementID = `Section_${n}`;
       let FullSectionTitle = SectionTitles [section.toLowerCase ()];
 
@@ -202,56 +160,45 @@ function SetSortMode
       HideBtn.id = ElementID + "_HideButton";
       HideBtn.className = "HideButton";
       HideBtn.setAttribute ("State", "SHOWN");
-      HideBtn.onclick = new Function ("event", `ShowSection (${n}, "toggle");`);
+      HideBtn.onclick = function (event) { ShowSection (n, "toggle"); };
       bar.append (HideBtn);
 
  
-      container = document.createElement ("div");
-      container.id = ElementID;
-      container.className = "AproposContainer";
-      container.style.overflow = "hidden";
-      ResultsDiv.append (container);
+      CurrentContainer = document.createElement ("div");
+      CurrentContainer.id = ElementID;
+      CurrentContainer.className = "AproposContainer";
+      CurrentContainer.style.overflow = "hidden";
+      ResultsDiv.append (CurrentContainer);
+      touched.push (CurrentContainer);
 
 
-      table = document.createElement ("table"); 
-      table.className = "AproposTable";      
-      container.append (table);
+      CurrentTable = document.createElement ("table"); 
+      CurrentTable.className = "AproposTable";      
+      CurrentContainer.append (CurrentTable);
 
 
       row = document.createElement ("tr");
       row.className = "AproposTableHeader";
-      table.append (row);
+      CurrentTable.append (row);
 
-      row = document.createElement ("tr");
-      row.className = "AproposTableHeader";
-      table.append (row);
-
-      cell = document.createElement ("th");
-      cell.setAttribute ("Column", "page");
-      cell.textContent = "Page";
-      row.append (cell);
-      
-      cell = document.createElement ("th");
-      cell.setAttribute ("Column", "description");
-      cell.textContent = "Description";
-      row.append (cell);
+      AppendTableHeader (CurrentTable);
 
       PrevSection = section;
-      n++;
+      nSections++;
     }
 
 
-    let prefix = (page.indexOf (":") >= 0) ? UriPrefix : "";
+    let prefix = (name.indexOf (":") >= 0) ? UriPrefix : "";
 
     row = document.createElement ("tr");
     row.className = "AproposTableRow";
-    table.append (row);
+    CurrentTable.append (row);
 
     cell = document.createElement ("td");
     row.append (cell);
     content = document.createElement ("a");
-    content.textContent = LinkText (page, section);
-    content.setAttribute ("href", `${prefix}man/${page}(${section})`);
+    content.textContent = fBySection ? name : `${name}(${section})`;
+    content.setAttribute ("href", `${prefix}man/${name}(${section})`);
     content.setAttribute ("target", "_blank");
     content.setAttribute ("RefType", "manpage");
     cell.append (content);
@@ -261,7 +208,174 @@ function SetSortMode
     row.append (cell);  
   }
 
-  nSections = n;
+
+  /*  Sections that are open and grew need a new height limit, or the
+      rows just added would stay clipped.
+  */
+
+  for (let container of touched)
+  {
+    if (container.getAttribute ("State") != "HIDDEN")
+    {
+      container.style.maxHeight = `${container.scrollHeight}px`;
+    }
+  }
+
+
+  nLoaded = page.offset + nResults;
+  nTotal = page.total;
+
+
+  /*  Re-observing the sentinel makes the observer report it again even
+      if it never left the viewport, so short pages keep loading.
+  */
+
+  if (Observer)
+  {
+    Observer.unobserve (Sentinel);
+  }
+
+  if ((nLoaded < nTotal) && (nResults > 0))
+  {
+    ResultsDiv.append (Sentinel);
+
+    if (Observer)
+    {
+      Observer.observe (Sentinel);
+    }
+    else
+    {
+      LoadMore ();
+    }
+  }
+  else
+  {
+    Sentinel.remove ();
+  }
+}
+
+
+
+function LoadMore
+    ()
+
+{
+  if (fLoading)
+    return;
+
+  let gen = Generation;
+  let sort = (SortMode === "byname") ? "name" : "section";
+  let query = encodeURIComponent (AproposQuery);
+
+  fLoading = true;
+
+  fetch (`/api/apropos?q=${query}&mode=regex&sort=${sort}`
+           + `&offset=${nLoaded}&limit=${AproposPageSize}`)
+    .then (function (response)
+           {
+             if (!response.ok)
+               throw new Error (response.statusText);
+
+             return response.json ();
+           })
+    .then (function (page)
+           {
+             if (gen != Generation)
+               return;
+
+             fLoading = false;
+             AppendResults (page);
+           })
+    .catch (function (error)
+            {
+              if (gen == Generation)
+              {
+                fLoading = false;
+              }
+            });
+}
+
+
+
+function OnSentinelVisible
+    (entries)
+
+{
+  for (let entry of entries)
+  {
+    if (entry.isIntersecting)
+    {
+      LoadMore ();
+      return;
+    }
+  }
+}
+
+
+
+function SetSortMode
+   (mode)
+
+{
+  let fBySection;
+
+  switch (mode)
+  {
+    case "bysection":   fBySection = true;   break;
+    case "byname":      fBySection = false;  break;
+    default:            return;
+  }
+
+  if (SortMode === mode)
+    return;
+
+  SortMode = mode;
+
+
+  if (fBySection)
+  {
+    ShowAllBtn.removeAttribute ("Disabled");
+    HideAllBtn.removeAttribute ("Disabled");
+    ByNameBtn.removeAttribute ("Active");
+    BySectionBtn.setAttribute ("Active", "1");
+  }
+  else
+  {
+    ShowAllBtn.setAttribute ("Disabled", "1");
+    HideAllBtn.setAttribute ("Disabled", "1");
+    BySectionBtn.removeAttribute ("Active");
+    ByNameBtn.setAttribute ("Active", "1");
+  }
+
+
+  let elts = [... ResultsDiv.children];
+  for (let i = elts.length - 1; i >= 0; i--)
+  {
+    ResultsDiv.removeChild (elts [i]);
+  }
+
+  Generation++;
+  fLoading = false;
+  nLoaded = 0;
+  nSections = 0;
+  PrevSection = null;
+  CurrentTable = null;
+  CurrentContainer = null;
+
+
+  if (fBySection)
+  {
+    AppendResults (FirstPage);
+  }
+  else
+  {
+    CurrentTable = document.createElement ("table"); 
+    CurrentTable.className = "AproposTable";
+    ResultsDiv.append (CurrentTable);
+
+    AppendTableHeader (CurrentTable);
+    LoadMore ();
+  }
 }
 
 
@@ -274,9 +388,9 @@ HideAllBtn.onclick = HideAll;
 SetSortMode ("bysection");
 
 
-let text = (results.length == 1)
-             ? "1 page" : `${results.length} pages in ${nSections} section${(nSections == 1) ? "" : "s"}`;
+let n = FirstPage.sections;
+let text = (FirstPage.total == 1)
+             ? "1 page" : `${FirstPage.total} pages in ${n} section${(n == 1) ? "" : "s"}`;
 
 document.getElementById ("Nav-Apropos-NResults").innerHTML 
       = "<span Label=\"\">Results:</span>" + text;
-
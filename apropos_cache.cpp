@@ -0,0 +1,521 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#include <stdlib.h>                    /*  C/C++ RTL headers.  */
+#include <string.h>
+#include <strings.h>
+#include <locale.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "utility.h"                   /*  Application headers.  */
+#include "documentation_api.h"
+#include "apropos_cache.h"
+#include "apropos_index.h"
+
+
+
+#define MAX_CACHED_SEARCHES     16
+#define MAX_CACHE_AGE           300    /*  Seconds.  */
+
+
+
+/*  Entries are kept in order of use, most recent first.  Each is 
+*   referenced by the cache itself (until it is dropped) and by every 
+*   caller that has acquired it but not yet released it.
+*/
+
+struct APROPOSCACHEENTRY
+{
+  APROPOSRESULTSET    set;
+  APROPOSCACHEENTRY  *pNext;
+  char               *pKeyword;
+  APROPOSMODE         mode;
+  time_t              CreationTime;
+  int                 nRefs;
+};
+
+
+
+static APROPOSCACHEENTRY *pFirstEntry = NULL;
+static int nEntries = 0;
+static pthread_mutex_t CacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t CollationOnce = PTHREAD_ONCE_INIT;
+static locale_t CollationLocale = (locale_t) 0;
+
+
+
+/*  Function prototypes.
+*/
+
+static APROPOSCACHEENTRY* FindEntry (const char*, APROPOSMODE);
+static void DropEntry (APROPOSCACHEENTRY*);
+static void ReleaseEntry (APROPOSCACHEENTRY*);
+static void SortAproposResults (APROPOSRESULTSET*);
+static int CompareBySection (const void*, const void*);
+static int CompareByName (const void*, const void*, void*);
+static int CompareSections (const char*, const char*);
+static int CompareNames (const char*, const char*);
+static void InitCollation (void);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                    AcquireAproposResults
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Looks up the results of an apropos search, running the search if it 
+*   isn't in the cache (or its results are more than MAX_CACHE_AGE
+*   seconds old).  Returns false, with *pErrorOut filled in as by 
+*   GetAproposContent(), if the search fails or finds nothing.  The 
+*   set returned must be given back with ReleaseAproposResults().
+*/
+
+bool AcquireAproposResults
+    (const char               *pKeyword,
+     APROPOSMODE               mode,
+     const APROPOSRESULTSET  **ppSetOut,
+     PROCESSERRORINFO         *pErrorOut)
+
+{
+  APROPOSCACHEENTRY *pEntry, **ppLink;
+  APROPOSRESULT *pResults;
+  int nResults;
+
+
+  *ppSetOut = NULL;
+
+  pthread_mutex_lock (&CacheLock);
+
+  if ((pEntry = FindEntry (pKeyword, mode)) != NULL)
+  {
+    pEntry->nRefs++;
+    pthread_mutex_unlock (&CacheLock);
+
+    *ppSetOut = &pEntry->set;
+    return true;
+  }
+
+  pthread_mutex_unlock (&CacheLock);
+
+
+  /*  Run the search without holding the lock; apropos(1) can take a 
+  *   while.  Two requests for the same search may both end up running
+  *   it, in which case the later entry simply hides the earlier one.
+  *   Regex searches are answered from the trigram index when it is 
+  *   ready.  Finding nothing there is reported the way apropos(1) 
+  *   reports it, with exit status 16.
+  */
+
+  if ((mode == APROPOS_REGEX) && SearchAproposIndex (pKeyword, &pResults, &nResults))
+  {
+    if (nResults == 0)
+    {
+      pErrorOut->context    = ERRORCTXT_RUNTIME;
+      pErrorOut->ErrorCode  = W_EXITCODE (16, 0);
+      pErrorOut->pExecPath  = "apropos";
+
+      return false;
+    }
+  }
+  else if (!GetAproposContent (pKeyword, mode, &pResults, &nResults, pErrorOut))
+  {
+    return false;
+  }
+
+
+  pEntry = (APROPOSCACHEENTRY*) malloc (sizeof (APROPOSCACHEENTRY));
+  pEntry->set.pResults   = pResults;
+  pEntry->set.nResults   = nResults;
+  pEntry->pKeyword       = strdup (pKeyword);
+  pEntry->mode           = mode;
+  pEntry->CreationTime   = time (NULL);
+  pEntry->nRefs          = 2;
+
+  SortAproposResults (&pEntry->set);
+
+
+  pthread_mutex_lock (&CacheLock);
+
+  if (nEntries >= MAX_CACHED_SEARCHES)
+  {
+    for (ppLink = &pFirstEntry; (*ppLink)->pNext != NULL; ppLink = &(*ppLink)->pNext)
+      ;
+
+    DropEntry (*ppLink);
+  }
+
+  pEntry->pNext = pFirstEntry;
+  pFirstEntry = pEntry;
+  nEntries++;
+
+  pthread_mutex_unlock (&CacheLock);
+
+
+  *ppSetOut = &pEntry->set;
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                    ReleaseAproposResults
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void ReleaseAproposResults
+    (const APROPOSRESULTSET  *pSet)
+
+{
+  if (pSet == NULL)
+    return;
+
+  pthread_mutex_lock (&CacheLock);
+
+  /*  The set is the first member of its entry.  */
+  ReleaseEntry ((APROPOSCACHEENTRY*) pSet);
+
+  pthread_mutex_unlock (&CacheLock);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                FindEntry
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Finds a search's entry and moves it to the front of the list.  An 
+*   entry that has grown too old is dropped instead.  The caller must 
+*   hold CacheLock.
+*/
+
+static
+APROPOSCACHEENTRY* FindEntry
+   (const char   *pKeyword,
+    APROPOSMODE   mode)
+
+{
+  APROPOSCACHEENTRY *pEntry, **ppLink;
+
+
+  for (ppLink = &pFirstEntry; (pEntry = *ppLink) != NULL; ppLink = &pEntry->pNext)
+  {
+    if ((pEntry->mode == mode) && (strcmp (pEntry->pKeyword, pKeyword) == 0))
+    {
+      if (time (NULL) - pEntry->CreationTime > MAX_CACHE_AGE)
+      {
+        DropEntry (pEntry);
+        return NULL;
+      }
+
+      *ppLink = pEntry->pNext;
+      pEntry->pNext = pFirstEntry;
+      pFirstEntry = pEntry;
+      return pEntry;
+    }
+  }
+
+  return NULL;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                DropEntry
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Removes an entry from the list.  It is freed once nobody holds it.
+*   The caller must hold CacheLock.
+*/
+
+static
+void DropEntry
+   (APROPOSCACHEENTRY  *pEntry)
+
+{
+  APROPOSCACHEENTRY **ppLink;
+
+
+  for (ppLink = &pFirstEntry; *ppLink != pEntry; ppLink = &(*ppLink)->pNext)
+    ;
+
+  *ppLink = pEntry->pNext;
+  nEntries--;
+
+  ReleaseEntry (pEntry);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             ReleaseEntry
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void ReleaseEntry
+   (APROPOSCACHEENTRY  *pEntry)
+
+{
+  if (--pEntry->nRefs > 0)
+    return;
+
+  free (pEntry->set.pResults);
+  free (pEntry->set.pByName);
+  free (pEntry->pKeyword);
+  free (pEntry);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       SortAproposResults
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Sorts the results by section, builds the by-name index, and counts
+*   the sections.
+*/
+
+static
+void SortAproposResults
+   (APROPOSRESULTSET  *pSet)
+
+{
+  int i;
+  APROPOSRESULT *pResults = pSet->pResults;
+
+
+  pthread_once (&CollationOnce, InitCollation);
+
+  qsort (pResults, pSet->nResults, sizeof (APROPOSRESULT), CompareBySection);
+
+
+  pSet->pByName = (int*) malloc (sizeof (int) * (pSet->nResults + 1));
+
+  for (i = 0; i < pSet->nResults; i++)
+  {
+    pSet->pByName [i] = i;
+  }
+
+  qsort_r (pSet->pByName, pSet->nResults, sizeof (int), CompareByName, pResults);
+
+
+  for (i = 0, pSet->nSections = 0; i < pSet->nResults; i++)
+  {
+    if ((i == 0) || (strcmp (pResults [i].pSection, pResults [i - 1].pSection) != 0))
+    {
+      pSet->nSections++;
+    }
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         CompareBySection
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Sections that differ only in case are told apart before the names 
+*   are looked at, so that each one's results stay together.
+*/
+
+static
+int CompareBySection
+   (const void  *pLeft,
+    const void  *pRight)
+
+{
+  const APROPOSRESULT *pA = (const APROPOSRESULT*) pLeft;
+  const APROPOSRESULT *pB = (const APROPOSRESULT*) pRight;
+  int t;
+
+
+  if ((t = CompareSections (pA->pSection, pB->pSection)) != 0)
+    return t;
+
+  if ((t = strcmp (pA->pSection, pB->pSection)) != 0)
+    return t;
+
+  return CompareNames (pA->pPageTitle, pB->pPageTitle);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            CompareByName
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+int CompareByName
+   (const void  *pLeft,
+    const void  *pRight,
+    void        *pContext)
+
+{
+  const APROPOSRESULT *pResults = (const APROPOSRESULT*) pContext;
+  const APROPOSRESULT *pA = pResults + *(const int*) pLeft;
+  const APROPOSRESULT *pB = pResults + *(const int*) pRight;
+  int t;
+
+
+  if ((t = CompareNames (pA->pPageTitle, pB->pPageTitle)) != 0)
+    return t;
+
+  if ((t = CompareSections (pA->pSection, pB->pSection)) != 0)
+    return t;
+
+  return strcmp (pA->pSection, pB->pSection);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          CompareSections
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Compares section names the way the apropos page used to (with a 
+*   numeric, case-insensitive collator): runs of digits are compared by
+*   value, so "3" comes before "10", and everything else is compared 
+*   without regard to case.
+*/
+
+static
+int CompareSections
+   (const char  *pA,
+    const char  *pB)
+
+{
+  int cbA, cbB, t;
+  unsigned char a, b;
+
+
+  while ((*pA != '\0') && (*pB != '\0'))
+  {
+    if ((*pA >= '0') && (*pA <= '9') && (*pB >= '0') && (*pB <= '9'))
+    {
+      while (*pA == '0')
+        pA++;
+      while (*pB == '0')
+        pB++;
+
+      for (cbA = 0; (pA [cbA] >= '0') && (pA [cbA] <= '9'); cbA++)
+        ;
+      for (cbB = 0; (pB [cbB] >= '0') && (pB [cbB] <= '9'); cbB++)
+        ;
+
+      if (cbA != cbB)
+        return cbA - cbB;
+
+      if ((t = memcmp (pA, pB, cbA)) != 0)
+        return t;
+
+      pA += cbA;
+      pB += cbB;
+      continue;
+    }
+
+    a = (unsigned char) *(pA++);
+    b = (unsigned char) *(pB++);
+
+    if ((a >= 'A') && (a <= 'Z'))
+      a += 'a' - 'A';
+    if ((b >= 'A') && (b <= 'Z'))
+      b += 'a' - 'A';
+
+    if (a != b)
+      return a - b;
+  }
+
+  return (*pA != '\0') - (*pB != '\0');
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             CompareNames
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Compares page names using the collation order of the server's 
+*   locale.  In the C locale that would put every capitalized name 
+*   ahead of every lowercase one, so there case is ignored instead, 
+*   except to break ties.
+*/
+
+static
+int CompareNames
+   (const char  *pA,
+    const char  *pB)
+
+{
+  int t;
+
+
+  t = (CollationLocale != (locale_t) 0) 
+        ? strcoll_l (pA, pB, CollationLocale)
+        : strcasecmp (pA, pB);
+
+  return (t != 0) ? t : strcmp (pA, pB);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            InitCollation
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Sets up the locale used by CompareNames(), from LC_ALL, LC_COLLATE
+*   or LANG (the first that is set), unless that is the C locale (or
+*   C.UTF-8, which collates by code point).
+*/
+
+static
+void InitCollation
+   (void)
+
+{
+  unsigned int i;
+  const char *pName = NULL;
+  static const char *VariableNames [] = { "LC_ALL", "LC_COLLATE", "LANG" };
+
+
+  for (i = 0; i < sizeof (VariableNames) / sizeof (VariableNames [0]); i++)
+  {
+    if (((pName = getenv (VariableNames [i])) != NULL) && (*pName != '\0'))
+      break;
+
+    pName = NULL;
+  }
+
+  if ((pName == NULL) 
+         || (strcmp (pName, "C") == 0) 
+         || (strncmp (pName, "C.", 2) == 0)
+         || (strcmp (pName, "POSIX") == 0))
+    return;
+
+  CollationLocale = newlocale (LC_COLLATE_MASK, pName, (locale_t) 0);
+}
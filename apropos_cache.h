@@ -0,0 +1,73 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#ifndef __APROPOS_CACHE_H_
+#define __APROPOS_CACHE_H_
+
+
+#include "documentation_api.h"     /*  For APROPOSRESULT type.  */
+
+
+
+/*  The results of an apropos search, in both of the orders the apropos
+*   page offers.  pResults is sorted by section (then by name); 
+*   pByName holds the indexes of the same results sorted by name (then
+*   by section).  nSections is the number of distinct sections.  A set
+*   is never changed once it has been built, so it can be read without
+*   locking for as long as it is held.
+*/
+
+struct APROPOSRESULTSET
+{
+  APROPOSRESULT  *pResults;
+  int            *pByName;
+  int             nResults;
+  int             nSections;
+};
+
+
+
+/*  A small cache of recent apropos searches, so that fetching the 
+*   results a page at a time doesn't mean running apropos(1) for each
+*   page.  All of the functions are thread-safe.
+*/
+
+extern "C"
+{
+extern bool AcquireAproposResults
+    (const char               *pKeyword,
+     APROPOSMODE               mode,
+     const APROPOSRESULTSET  **ppSetOut,
+     PROCESSERRORINFO         *pErrorOut);
+
+
+extern void ReleaseAproposResults
+    (const APROPOSRESULTSET   *pSet);
+}
+
+
+#endif
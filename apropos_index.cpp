@@ -0,0 +1,1192 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#include <stdlib.h>                    /*  C/C++ RTL headers.  */
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <tre/tre.h>                   /*  Library headers.  */
+
+#include "utility.h"                   /*  Application headers.  */
+#include "arena.h"
+#include "documentation_api.h"
+#include "index_file.h"
+#include "apropos_index.h"
+
+
+
+#define MAX_EXACT_STRINGS    16
+#define MAX_EXACT_LENGTH     24
+
+
+
+/*  The whatis entries, as returned by GetAproposContent(), and a 
+*   trigram index over them.  Each entry's name and description are
+*   lowercased (ASCII only) and joined with a newline; pTrigrams holds 
+*   every distinct trigram found in the results, sorted, and the 
+*   entries containing pTrigrams [i] are pPostings [pStarts [i]] up to
+*   pPostings [pStarts [i + 1]], in ascending order.
+*/
+
+struct APROPOSINDEX
+{
+  APROPOSRESULT  *pEntries;
+  int             nEntries;
+  uint32_t       *pTrigrams;
+  uint32_t       *pStarts;
+  int             nTrigrams;
+  uint32_t       *pPostings;
+};
+
+
+
+/*  A regex is turned into a query on the trigram index, following Russ
+*   Cox's "Regular Expression Matching with a Trigram Index".  Any entry
+*   the regex matches also satisfies the query, so only the entries
+*   that satisfy it need to be tested against the regex itself.  A 
+*   query of TQ_ALL is satisfied by every entry; TQ_AND and TQ_OR nodes
+*   never have TQ_ALL children.
+*/
+
+enum TRIGRAMQUERYOP { TQ_ALL, TQ_TRIGRAM, TQ_AND, TQ_OR };
+
+struct TRIGRAMQUERY
+{
+  TRIGRAMQUERYOP   op;
+  uint32_t         trigram;
+  TRIGRAMQUERY    *pLeft;
+  TRIGRAMQUERY    *pRight;
+};
+
+
+/*  What is known about the strings matched by part of a regex: either 
+*   the complete (small) set of them, or a query they all satisfy.
+*/
+
+struct REGEXINFO
+{
+  bool            fExact;
+  const char    **pExact;
+  int             nExact;
+  TRIGRAMQUERY   *pMatch;
+};
+
+
+struct REGEXPARSER
+{
+  const char  *p;
+  ARENA       *pArena;
+  bool         fFailed;
+};
+
+
+
+static TRIGRAMQUERY AllQuery = {TQ_ALL, 0, NULL, NULL};
+
+
+
+/*  Function prototypes.
+*/
+
+static APROPOSINDEX* BuildIndex (APROPOSRESULT*, int);
+static void FreeIndex (void*);
+static int CompareKeys (const void*, const void*);
+static TRIGRAMQUERY* RegexToQuery (ARENA*, const char*);
+static REGEXINFO ParseAlternation (REGEXPARSER*);
+static REGEXINFO ParseConcatenation (REGEXPARSER*);
+static REGEXINFO ParseRepetition (REGEXPARSER*);
+static REGEXINFO ParseAtom (REGEXPARSER*);
+static REGEXINFO ParseBracket (REGEXPARSER*);
+static REGEXINFO AnyInfo (void);
+static REGEXINFO ExactInfo (const char**, int);
+static REGEXINFO CrossExact (REGEXPARSER*, const REGEXINFO*, const REGEXINFO*);
+static int LongestExact (const REGEXINFO*);
+static TRIGRAMQUERY* InfoToQuery (REGEXPARSER*, const REGEXINFO*);
+static TRIGRAMQUERY* MakeQuery (REGEXPARSER*, TRIGRAMQUERYOP, TRIGRAMQUERY*, TRIGRAMQUERY*);
+static const uint32_t* EvaluateQuery (const APROPOSINDEX*, ARENA*, const TRIGRAMQUERY*, int*);
+
+
+
+static SHAREDINDEX Index = SHARED_INDEX_INITIALIZER (FreeIndex, 0);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                  Trigram
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static inline
+uint32_t Trigram
+   (const char  *p)
+
+{
+  return ((uint32_t) FoldChar (p [0]) << 16) 
+           | ((uint32_t) FoldChar (p [1]) << 8) 
+           | FoldChar (p [2]);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       UpdateAproposIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Builds a new index from apropos results and puts it in place of the
+*   old one.  The name index's build calls this with the results it got,
+*   so that apropos(1) is only run once per refresh.
+*/
+
+void UpdateAproposIndex
+    (APROPOSRESULT  *pResults,
+     int             nResults)
+
+{
+  ReplaceSharedIndex (&Index, BuildIndex (pResults, nResults));
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       SearchAproposIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Does what "apropos --regex" does: finds the entries whose names or
+*   descriptions match an extended regex, ignoring case.  The regex is
+*   only run on the candidates the trigram query leaves, which for a
+*   typical search is a small fraction of the database.
+*/
+
+bool SearchAproposIndex
+    (const char      *pRegex,
+     APROPOSRESULT  **ppResultsOut,
+     int             *pnResultsOut)
+
+{
+  int i, k, n, nCandidates, nMatches;
+  size_t cbText;
+  char *pStr;
+  const uint32_t *pCandidates;
+  int *pMatches;
+  const APROPOSRESULT *pEntry;
+  APROPOSRESULT *pResults;
+  const APROPOSINDEX *pIndex;
+  const TRIGRAMQUERY *pQuery;
+  ARENA *pArena;
+  regex_t regex;
+
+
+  *ppResultsOut = NULL;
+  *pnResultsOut = 0;
+
+  if (tre_regcomp (&regex, pRegex, REG_EXTENDED | REG_ICASE | REG_NOSUB) != 0)
+    return false;
+
+
+  if ((pIndex = (const APROPOSINDEX*) AcquireSharedIndex (&Index)) == NULL)
+  {
+    tre_regfree (&regex);
+    return false;
+  }
+
+
+  /*  Find the candidates (all of the entries, if the regex has no 
+  *   usable trigrams) and test each one.
+  */
+
+  pArena = AcquireArena ();
+  pQuery = RegexToQuery (pArena, pRegex);
+
+  if (pQuery->op == TQ_ALL)
+  {
+    pCandidates = NULL;
+    nCandidates = pIndex->nEntries;
+  }
+  else
+  {
+    pCandidates = EvaluateQuery (pIndex, pArena, pQuery, &nCandidates);
+  }
+
+  pMatches = (int*) ArenaAlloc (pArena, sizeof (int) * (nCandidates + 1));
+  nMatches = 0;
+  cbText = 0;
+
+  for (k = 0; k < nCandidates; k++)
+  {
+    i = (pCandidates != NULL) ? (int) pCandidates [k] : k;
+    pEntry = pIndex->pEntries + i;
+
+    if ((tre_regexec (&regex, pEntry->pPageTitle, 0, NULL, 0) == 0)
+          || (tre_regexec (&regex, pEntry->pDescription, 0, NULL, 0) == 0))
+    {
+      pMatches [nMatches++] = i;
+      cbText += strlen (pEntry->pPageTitle) + strlen (pEntry->pSection) 
+                  + strlen (pEntry->pDescription) + 3;
+    }
+  }
+
+
+  /*  Copy the matches into a block of their own, so that they don't 
+  *   depend on the index staying around.
+  */
+
+  if (nMatches > 0)
+  {
+    pResults = (APROPOSRESULT*) malloc (sizeof (APROPOSRESULT) * (nMatches + 1) + cbText);
+    pStr = (char*) (pResults + nMatches + 1);
+
+    for (n = 0; n < nMatches; n++)
+    {
+      pEntry = pIndex->pEntries + pMatches [n];
+
+      pResults [n].pPageTitle = pStr;
+      pStr = stpcpy (pStr, pEntry->pPageTitle) + 1;
+      pResults [n].pSection = pStr;
+      pStr = stpcpy (pStr, pEntry->pSection) + 1;
+      pResults [n].pDescription = pStr;
+      pStr = stpcpy (pStr, pEntry->pDescription) + 1;
+    }
+
+    memset (pResults + nMatches, 0, sizeof (APROPOSRESULT));
+
+    *ppResultsOut = pResults;
+    *pnResultsOut = nMatches;
+  }
+
+
+  ReleaseArena (pArena);
+  tre_regfree (&regex);
+
+  ReleaseSharedIndex (&Index, pIndex);
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               BuildIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Collects every (trigram, entry) pair as one 64-bit key, sorts them,
+*   and packs the distinct ones into posting lists.  The index takes 
+*   ownership of pResults.
+*/
+
+static
+APROPOSINDEX* BuildIndex
+   (APROPOSRESULT  *pResults,
+    int             nResults)
+
+{
+  int i, j, t, cbName, cbText;
+  size_t k, n, nKeys, nKeysAllocated;
+  uint64_t *pKeys;
+  uint32_t trigram;
+  char *pText;
+  APROPOSINDEX *pIndex;
+
+
+  nKeysAllocated = 4096;
+  pKeys = (uint64_t*) malloc (sizeof (uint64_t) * nKeysAllocated);
+  nKeys = 0;
+
+  for (i = 0; i < nResults; i++)
+  {
+    cbName = strlen (pResults [i].pPageTitle);
+    cbText = cbName + strlen (pResults [i].pDescription) + 1;
+
+    if (nKeys + cbText > nKeysAllocated)
+    {
+      nKeysAllocated = 2 * nKeysAllocated + cbText;
+      pKeys = (uint64_t*) realloc (pKeys, sizeof (uint64_t) * nKeysAllocated);
+    }
+
+    pText = (char*) malloc (cbText + 1);
+    memcpy (pText, pResults [i].pPageTitle, cbName);
+    pText [cbName] = '\n';
+    strcpy (pText + cbName + 1, pResults [i].pDescription);
+
+    for (j = 0; j + 3 <= cbText; j++)
+    {
+      pKeys [nKeys++] = ((uint64_t) Trigram (pText + j) << 32) | (uint32_t) i;
+    }
+
+    free (pText);
+  }
+
+  qsort (pKeys, nKeys, sizeof (uint64_t), CompareKeys);
+
+
+  /*  Drop the duplicates, then count the distinct trigrams.
+  */
+
+  for (k = n = 0; k < nKeys; k++)
+  {
+    if ((n == 0) || (pKeys [k] != pKeys [n - 1]))
+    {
+      pKeys [n++] = pKeys [k];
+    }
+  }
+
+  nKeys = n;
+
+  for (k = 0, t = 0; k < nKeys; k++)
+  {
+    t += (k == 0) || ((pKeys [k] >> 32) != (pKeys [k - 1] >> 32));
+  }
+
+
+  pIndex = (APROPOSINDEX*) malloc (sizeof (APROPOSINDEX));
+  pIndex->pEntries   = pResults;
+  pIndex->nEntries   = nResults;
+  pIndex->nTrigrams  = t;
+  pIndex->pTrigrams  = (uint32_t*) malloc (sizeof (uint32_t) * (t + 1));
+  pIndex->pStarts    = (uint32_t*) malloc (sizeof (uint32_t) * (t + 1));
+  pIndex->pPostings  = (uint32_t*) malloc (sizeof (uint32_t) * (nKeys + 1));
+
+  for (k = 0, t = 0; k < nKeys; k++)
+  {
+    trigram = (uint32_t) (pKeys [k] >> 32);
+
+    if ((k == 0) || (trigram != pIndex->pTrigrams [t - 1]))
+    {
+      pIndex->pTrigrams [t] = trigram;
+      pIndex->pStarts [t++] = k;
+    }
+
+    pIndex->pPostings [k] = (uint32_t) pKeys [k];
+  }
+
+  pIndex->pStarts [t] = nKeys;
+
+
+  free (pKeys);
+
+  return pIndex;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                FreeIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void FreeIndex
+   (void  *pIndex)
+
+{
+  APROPOSINDEX *pApropos = (APROPOSINDEX*) pIndex;
+
+
+  free (pApropos->pEntries);
+  free (pApropos->pTrigrams);
+  free (pApropos->pStarts);
+  free (pApropos->pPostings);
+  free (pApropos);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              CompareKeys
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+int CompareKeys
+   (const void  *pLeft,
+    const void  *pRight)
+
+{
+  uint64_t a = *(const uint64_t*) pLeft, b = *(const uint64_t*) pRight;
+
+
+  return (a < b) ? -1 : (a > b);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             RegexToQuery
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Works out the trigram query for an extended regex that is already 
+*   known to compile.  Anything the parser doesn't understand makes the
+*   whole query TQ_ALL, which is slow but never wrong.
+*/
+
+static
+TRIGRAMQUERY* RegexToQuery
+   (ARENA       *pArena,
+    const char  *pRegex)
+
+{
+  REGEXPARSER parser;
+  REGEXINFO info;
+  TRIGRAMQUERY *pQuery;
+
+
+  parser.p        = pRegex;
+  parser.pArena   = pArena;
+  parser.fFailed  = false;
+
+  info = ParseAlternation (&parser);
+  pQuery = InfoToQuery (&parser, &info);
+
+  return (parser.fFailed || (*parser.p != '\0')) ? &AllQuery : pQuery;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         ParseAlternation
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  a|b matches the strings either side does.
+*/
+
+static
+REGEXINFO ParseAlternation
+   (REGEXPARSER  *pParser)
+
+{
+  REGEXINFO info, next;
+  const char **pExact;
+
+
+  info = ParseConcatenation (pParser);
+
+  while (*pParser->p == '|')
+  {
+    pParser->p++;
+    next = ParseConcatenation (pParser);
+
+    if (info.fExact && next.fExact && (info.nExact + next.nExact <= MAX_EXACT_STRINGS))
+    {
+      pExact = (const char**) ArenaAlloc (pParser->pArena, 
+                                          sizeof (char*) * (info.nExact + next.nExact));
+      memcpy (pExact, info.pExact, sizeof (char*) * info.nExact);
+      memcpy (pExact + info.nExact, next.pExact, sizeof (char*) * next.nExact);
+
+      info = ExactInfo (pExact, info.nExact + next.nExact);
+    }
+    else
+    {
+      info.pMatch = MakeQuery (pParser, TQ_OR, InfoToQuery (pParser, &info), 
+                               InfoToQuery (pParser, &next));
+      info.fExact = false;
+    }
+  }
+
+  return info;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       ParseConcatenation
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Runs of exact pieces are combined into longer exact strings (so that
+*   "a[bc]d" gives "abd" and "acd").  When a run can't be extended (too
+*   many or too long strings, or a piece that isn't exact), its trigrams
+*   are added to the query and a new run begins.
+*/
+
+static
+REGEXINFO ParseConcatenation
+   (REGEXPARSER  *pParser)
+
+{
+  static const char *EmptyString = "";
+
+  REGEXINFO current, atom, info;
+  TRIGRAMQUERY *pMatch = &AllQuery;
+  bool fFlushed = false;
+
+
+  current = ExactInfo (&EmptyString, 1);
+
+  while ((*pParser->p != '\0') && (*pParser->p != '|') && (*pParser->p != ')'))
+  {
+    atom = ParseRepetition (pParser);
+
+    if (atom.fExact 
+          && (current.nExact * atom.nExact <= MAX_EXACT_STRINGS)
+          && (LongestExact (&current) + LongestExact (&atom) <= MAX_EXACT_LENGTH))
+    {
+      current = CrossExact (pParser, &current, &atom);
+    }
+    else
+    {
+      pMatch = MakeQuery (pParser, TQ_AND, pMatch, InfoToQuery (pParser, &current));
+      fFlushed = true;
+
+      if (atom.fExact)
+      {
+        current = atom;
+      }
+      else
+      {
+        pMatch = MakeQuery (pParser, TQ_AND, pMatch, atom.pMatch);
+        current = ExactInfo (&EmptyString, 1);
+      }
+    }
+  }
+
+  if (!fFlushed)
+    return current;
+
+  info.fExact  = false;
+  info.pExact  = NULL;
+  info.nExact  = 0;
+  info.pMatch  = MakeQuery (pParser, TQ_AND, pMatch, InfoToQuery (pParser, &current));
+
+  return info;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          ParseRepetition
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  x* and x{0,n} tell us nothing.  x+ and x{n,m} (n > 0) contain at 
+*   least one x, so they satisfy x's query.  x? adds the empty string 
+*   to x's exact set.
+*/
+
+static
+REGEXINFO ParseRepetition
+   (REGEXPARSER  *pParser)
+
+{
+  static const char *EmptyString = "";
+
+  int min, max;
+  char *pEnd;
+  const char **pExact;
+  REGEXINFO info;
+  TRIGRAMQUERY *pMatch;
+
+
+  info = ParseAtom (pParser);
+
+  for (;;)
+  {
+    switch (*pParser->p)
+    {
+      case '*':
+        min = 0;
+        max = -1;
+        pParser->p++;
+        break;
+
+      case '+':
+        min = 1;
+        max = -1;
+        pParser->p++;
+        break;
+
+      case '?':
+        min = 0;
+        max = 1;
+        pParser->p++;
+        break;
+
+      case '{':
+        pEnd = (char*) pParser->p + 1;
+
+        if (!isdigit (*pEnd))
+        {
+          pParser->fFailed = true;
+          return AnyInfo ();
+        }
+
+        min = max = strtol (pEnd, &pEnd, 10);
+
+        if ((pEnd [0] == ',') && (pEnd [1] == '}'))
+        {
+          max = -1;
+          pEnd++;
+        }
+        else if ((pEnd [0] == ',') && isdigit (pEnd [1]))
+        {
+          max = strtol (pEnd + 1, &pEnd, 10);
+        }
+
+        if (*pEnd != '}')
+        {
+          pParser->fFailed = true;
+          return AnyInfo ();
+        }
+
+        pParser->p = pEnd + 1;
+        break;
+
+      default:
+        return info;
+    }
+
+
+    if ((min == 1) && (max == 1))
+      continue;
+
+    if ((min == 0) && (max == 1) && info.fExact && (info.nExact < MAX_EXACT_STRINGS))
+    {
+      pExact = (const char**) ArenaAlloc (pParser->pArena, sizeof (char*) * (info.nExact + 1));
+      memcpy (pExact, info.pExact, sizeof (char*) * info.nExact);
+      pExact [info.nExact] = EmptyString;
+
+      info = ExactInfo (pExact, info.nExact + 1);
+    }
+    else if (min == 0)
+    {
+      info = AnyInfo ();
+    }
+    else
+    {
+      pMatch = InfoToQuery (pParser, &info);
+      info = AnyInfo ();
+      info.pMatch = pMatch;
+    }
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                ParseAtom
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Only escaped metacharacters are taken as literals; other escapes 
+*   (\w, \<, back-references and the like) match we-don't-know-what.
+*   So do bytes outside ASCII.
+*/
+
+static
+REGEXINFO ParseAtom
+   (REGEXPARSER  *pParser)
+
+{
+  static const char *EmptyString = "";
+
+  unsigned char c;
+  bool fEscaped = false;
+  char *pLiteral;
+  const char **pExact;
+  REGEXINFO info;
+
+
+  switch (c = *pParser->p)
+  {
+    case '(':
+      pParser->p++;
+
+      if (*pParser->p == '?')
+      {
+        pParser->fFailed = true;
+        return AnyInfo ();
+      }
+
+      info = ParseAlternation (pParser);
+
+      if (*pParser->p != ')')
+      {
+        pParser->fFailed = true;
+        return AnyInfo ();
+      }
+
+      pParser->p++;
+      return info;
+
+    case '[':
+      return ParseBracket (pParser);
+
+    case '.':
+      pParser->p++;
+      return AnyInfo ();
+
+    case '^':
+    case '$':
+      pParser->p++;
+      return ExactInfo (&EmptyString, 1);
+
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+      pParser->fFailed = true;
+      return AnyInfo ();
+
+    case '\\':
+      if ((c = pParser->p [1]) == '\0')
+      {
+        pParser->fFailed = true;
+        return AnyInfo ();
+      }
+
+      fEscaped = true;
+      pParser->p++;
+      break;
+  }
+
+
+  pParser->p++;
+
+  if ((fEscaped && (strchr (".[]()*+?{}|^$\\", c) == NULL)) || (c >= 0x80))
+    return AnyInfo ();
+
+
+  pLiteral = (char*) ArenaAlloc (pParser->pArena, 2);
+  pLiteral [0] = FoldChar (c);
+  pLiteral [1] = '\0';
+
+  pExact = (const char**) ArenaAlloc (pParser->pArena, sizeof (char*));
+  pExact [0] = pLiteral;
+
+  return ExactInfo (pExact, 1);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             ParseBracket
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  A bracket expression is exact if it lists a few plain characters.
+*   Negated ones, character classes and anything outside ASCII match
+*   too much to be useful.
+*/
+
+static
+REGEXINFO ParseBracket
+   (REGEXPARSER  *pParser)
+
+{
+  int c, n = 0;
+  bool fUseless = false, Seen [256];
+  const char *p = pParser->p + 1, *pClose;
+  const char **pExact;
+  char *pLiteral;
+
+
+  memset (Seen, 0, sizeof (Seen));
+
+  if (*p == '^')
+  {
+    fUseless = true;
+    p++;
+  }
+
+  if (*p == ']')
+  {
+    Seen [']'] = true;
+    p++;
+  }
+
+
+  while ((*p != '\0') && (*p != ']'))
+  {
+    if ((p [0] == '[') && ((p [1] == ':') || (p [1] == '=') || (p [1] == '.')))
+    {
+      for (pClose = p + 2; (*pClose != '\0') && ((pClose [0] != p [1]) || (pClose [1] != ']')); pClose++)
+        ;
+
+      if (*pClose == '\0')
+        break;
+
+      fUseless = true;
+      p = pClose + 2;
+    }
+    else if ((p [1] == '-') && (p [2] != ']') && (p [2] != '\0'))
+    {
+      for (c = (unsigned char) p [0]; c <= (unsigned char) p [2]; c++)
+      {
+        Seen [c] = true;
+      }
+
+      p += 3;
+    }
+    else
+    {
+      Seen [(unsigned char) *p++] = true;
+    }
+  }
+
+  if (*p != ']')
+  {
+    pParser->fFailed = true;
+    return AnyInfo ();
+  }
+
+  pParser->p = p + 1;
+
+
+  /*  Fold the characters and see how many are left.
+  */
+
+  for (c = 'A'; c <= 'Z'; c++)
+  {
+    Seen [c + ('a' - 'A')] |= Seen [c];
+    Seen [c] = false;
+  }
+
+  for (c = 0x80; c < 256; c++)
+  {
+    fUseless |= Seen [c];
+  }
+
+  fUseless |= Seen ['\\'];
+
+  for (c = 1; c < 0x80; c++)
+  {
+    n += Seen [c];
+  }
+
+  if (fUseless || (n == 0) || (n > MAX_EXACT_STRINGS))
+    return AnyInfo ();
+
+
+  pExact = (const char**) ArenaAlloc (pParser->pArena, sizeof (char*) * n);
+  pLiteral = (char*) ArenaAlloc (pParser->pArena, 2 * n);
+
+  for (c = 1, n = 0; c < 0x80; c++)
+  {
+    if (Seen [c])
+    {
+      pLiteral [0] = (char) c;
+      pLiteral [1] = '\0';
+      pExact [n++] = pLiteral;
+      pLiteral += 2;
+    }
+  }
+
+  return ExactInfo (pExact, n);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                  AnyInfo
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+REGEXINFO AnyInfo
+   (void)
+
+{
+  REGEXINFO info;
+
+
+  info.fExact  = false;
+  info.pExact  = NULL;
+  info.nExact  = 0;
+  info.pMatch  = &AllQuery;
+
+  return info;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                ExactInfo
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+REGEXINFO ExactInfo
+   (const char  **pExact,
+    int           nExact)
+
+{
+  REGEXINFO info;
+
+
+  info.fExact  = true;
+  info.pExact  = pExact;
+  info.nExact  = nExact;
+  info.pMatch  = NULL;
+
+  return info;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               CrossExact
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns every string of pLeft followed by every string of pRight.
+*/
+
+static
+REGEXINFO CrossExact
+   (REGEXPARSER      *pParser,
+    const REGEXINFO  *pLeft,
+    const REGEXINFO  *pRight)
+
+{
+  int i, j, n, cbLeft, cbRight;
+  const char **pExact;
+  char *pStr;
+
+
+  pExact = (const char**) ArenaAlloc (pParser->pArena, 
+                                      sizeof (char*) * pLeft->nExact * pRight->nExact);
+
+  for (i = n = 0; i < pLeft->nExact; i++)
+  {
+    for (j = 0; j < pRight->nExact; j++)
+    {
+      cbLeft = strlen (pLeft->pExact [i]);
+      cbRight = strlen (pRight->pExact [j]);
+
+      pStr = (char*) ArenaAlloc (pParser->pArena, cbLeft + cbRight + 1);
+      memcpy (pStr, pLeft->pExact [i], cbLeft);
+      strcpy (pStr + cbLeft, pRight->pExact [j]);
+
+      pExact [n++] = pStr;
+    }
+  }
+
+  return ExactInfo (pExact, n);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             LongestExact
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+int LongestExact
+   (const REGEXINFO  *pInfo)
+
+{
+  int i, cbStr, cbLongest = 0;
+
+
+  for (i = 0; i < pInfo->nExact; i++)
+  {
+    cbStr = strlen (pInfo->pExact [i]);
+    cbLongest = (cbStr > cbLongest) ? cbStr : cbLongest;
+  }
+
+  return cbLongest;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              InfoToQuery
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  An exact set becomes the OR, over its strings, of the AND of each 
+*   string's trigrams.  A string shorter than three characters could be
+*   anywhere, so it makes the whole thing TQ_ALL.
+*/
+
+static
+TRIGRAMQUERY* InfoToQuery
+   (REGEXPARSER      *pParser,
+    const REGEXINFO  *pInfo)
+
+{
+  int i, j, cbStr;
+  TRIGRAMQUERY *pQuery = NULL, *pAnd, *pTrigram;
+
+
+  if (!pInfo->fExact)
+    return pInfo->pMatch;
+
+  for (i = 0; i < pInfo->nExact; i++)
+  {
+    if ((cbStr = strlen (pInfo->pExact [i])) < 3)
+      return &AllQuery;
+
+    pAnd = &AllQuery;
+
+    for (j = 0; j + 3 <= cbStr; j++)
+    {
+      pTrigram = (TRIGRAMQUERY*) ArenaAlloc (pParser->pArena, sizeof (TRIGRAMQUERY));
+      pTrigram->op       = TQ_TRIGRAM;
+      pTrigram->trigram  = Trigram (pInfo->pExact [i] + j);
+      pTrigram->pLeft    = NULL;
+      pTrigram->pRight   = NULL;
+
+      pAnd = MakeQuery (pParser, TQ_AND, pAnd, pTrigram);
+    }
+
+    pQuery = (pQuery == NULL) ? pAnd : MakeQuery (pParser, TQ_OR, pQuery, pAnd);
+  }
+
+  return (pQuery != NULL) ? pQuery : &AllQuery;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                MakeQuery
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Combines two queries with TQ_AND or TQ_OR, simplifying away TQ_ALL.
+*/
+
+static
+TRIGRAMQUERY* MakeQuery
+   (REGEXPARSER     *pParser,
+    TRIGRAMQUERYOP   op,
+    TRIGRAMQUERY    *pLeft,
+    TRIGRAMQUERY    *pRight)
+
+{
+  TRIGRAMQUERY *pQuery;
+
+
+  if ((pLeft->op == TQ_ALL) || (pRight->op == TQ_ALL))
+  {
+    if (op == TQ_OR)
+      return &AllQuery;
+
+    return (pLeft->op == TQ_ALL) ? pRight : pLeft;
+  }
+
+  pQuery = (TRIGRAMQUERY*) ArenaAlloc (pParser->pArena, sizeof (TRIGRAMQUERY));
+  pQuery->op       = op;
+  pQuery->trigram  = 0;
+  pQuery->pLeft    = pLeft;
+  pQuery->pRight   = pRight;
+
+  return pQuery;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            EvaluateQuery
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the entries that satisfy a query (which must not be TQ_ALL),
+*   in ascending order, and stores the number of them in *pnOut.  A
+*   trigram's list is its posting list itself; ANDs and ORs merge their
+*   operands' lists into new ones allocated from pArena.
+*/
+
+static
+const uint32_t* EvaluateQuery
+   (const APROPOSINDEX  *pIndex,
+    ARENA               *pArena,
+    const TRIGRAMQUERY  *pQuery,
+    int                 *pnOut)
+
+{
+  int lo, hi, mid, i, j, n, nLeft, nRight;
+  const uint32_t *pLeft, *pRight;
+  uint32_t *pList;
+
+
+  if (pQuery->op == TQ_TRIGRAM)
+  {
+    lo = 0;
+    hi = pIndex->nTrigrams;
+
+    while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+
+      if (pIndex->pTrigrams [mid] < pQuery->trigram)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+    if ((lo == pIndex->nTrigrams) || (pIndex->pTrigrams [lo] != pQuery->trigram))
+    {
+      *pnOut = 0;
+      return pIndex->pPostings;
+    }
+
+    *pnOut = pIndex->pStarts [lo + 1] - pIndex->pStarts [lo];
+    return pIndex->pPostings + pIndex->pStarts [lo];
+  }
+
+
+  pLeft = EvaluateQuery (pIndex, pArena, pQuery->pLeft, &nLeft);
+
+  if ((nLeft == 0) && (pQuery->op == TQ_AND))
+  {
+    *pnOut = 0;
+    return pLeft;
+  }
+
+  pRight = EvaluateQuery (pIndex, pArena, pQuery->pRight, &nRight);
+
+
+  i = j = n = 0;
+
+  if (pQuery->op == TQ_AND)
+  {
+    pList = (uint32_t*) ArenaAlloc (pArena, sizeof (uint32_t) * (((nLeft < nRight) ? nLeft : nRight) + 1));
+
+    while ((i < nLeft) && (j < nRight))
+    {
+      if (pLeft [i] < pRight [j])
+        i++;
+      else if (pLeft [i] > pRight [j])
+        j++;
+      else
+      {
+        pList [n++] = pLeft [i];
+        i++;
+        j++;
+      }
+    }
+  }
+  else
+  {
+    pList = (uint32_t*) ArenaAlloc (pArena, sizeof (uint32_t) * (nLeft + nRight + 1));
+
+    while ((i < nLeft) || (j < nRight))
+    {
+      if ((j == nRight) || ((i < nLeft) && (pLeft [i] < pRight [j])))
+        pList [n++] = pLeft [i++];
+      else if ((i == nLeft) || (pLeft [i] > pRight [j]))
+        pList [n++] = pRight [j++];
+      else
+      {
+        pList [n++] = pLeft [i];
+        i++;
+        j++;
+      }
+    }
+  }
+
+  *pnOut = n;
+  return pList;
+}
@@ -0,0 +1,64 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#ifndef __APROPOS_INDEX_H_
+#define __APROPOS_INDEX_H_
+
+
+#include "documentation_api.h"     /*  For APROPOSRESULT type.  */
+
+
+
+/*  An in-memory copy of the whatis database with a trigram index over
+*   the names and descriptions, used to answer regex apropos searches 
+*   without running apropos(1).  UpdateAproposIndex() builds a new copy
+*   from the results of an apropos(1) run, which it takes ownership of,
+*   and puts it in place of the old one.
+*
+*   SearchAproposIndex() returns false if there is no index yet or the
+*   regex doesn't compile, in which case the caller should run 
+*   apropos(1) instead.  Otherwise *ppResultsOut receives the matching
+*   entries in one block of memory, laid out as GetAproposContent() 
+*   lays it out, which the caller must free; it is NULL if nothing
+*   matched.  Both functions are thread-safe.
+*/
+
+extern "C"
+{
+extern void UpdateAproposIndex
+    (APROPOSRESULT  *pResults,
+     int             nResults);
+
+
+extern bool SearchAproposIndex
+    (const char      *pRegex,
+     APROPOSRESULT  **ppResultsOut,
+     int             *pnResultsOut);
+}
+
+
+#endif
@@ -31,16 +31,10 @@
 
 #include "utility.h"                   /*  Application headers.  */
 #include "html_formatting.h"
+#include "page_builder.h"
 #include "apropostohtml.h"
 #include "installation.h"
-#include "common_js.h"
-
-
-
-/*  Dynamically-generated headers.
-*/
-
-#include "dynamic/apropos_script.h"
+#include "assets.h"
 
 
 
@@ -48,13 +42,17 @@
                                                      AproposResultsToHTML
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Generates the apropos page.  Only the first page of results (by 
+*   section) goes into it; apropos.js fetches the rest from the apropos 
+*   API as they are scrolled into view.
+*/
+
 void AproposResultsToHTML
-    (FILE                 *stream,
-     const char           *pKeyword,
-     const char           *pUriPrefix,
-     const char           *pStylesheet,
-     const APROPOSRESULT  *pResults,
-     int                   nResults)
+    (PAGEBUILDER             *pPage,
+     const char              *pKeyword,
+     const char              *pUriPrefix,
+     const char              *pStylesheetUri,
+     const APROPOSRESULTSET  *pSet)
 
 {
   int i;
@@ -62,86 +60,149 @@ void AproposResultsToHTML
   char id [32], description [128];
 
 
-  HTMLizeText (buffer, sizeof (buffer), pKeyword, -1, NULL, NULL, 0);
-
-  fprintf (stream,
-           "<!DOCTYPE html>\n\n"
-           "<html>\n"
-           "<head>\n"
-           "<title>Apropos: %s</title>\n"
-           "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
-           "<base href=\"%s\">\n"
-           "<style>\n%s\n</style>\n"
-           "</head>\n"
-           "<body Type=\"apropos\">\n",
-           buffer, 
-           pUriPrefix,
-           pStylesheet);
-
-
-  fprintf (stream, 
-           "<div id=\"NavBar\">\n"
-           "<div id=\"Nav-Apropos-NResults\"></div>\n"
-           "<div id=\"Nav-Apropos-Sort\">\n"
-           "<span Label=\"1\">Sort by:</span>"
-           "<span id=\"ByNameButton\" class=\"Button FormatSelector\">Name</span>\n"
-           "&nbsp;\n"
-           "<span id=\"BySectionButton\" class=\"Button FormatSelector\">Section</span>\n"
-           "</div>\n"
-           "<div id=\"Nav-Apropos-ShowHide\">\n"
-           "<span id=\"ShowAllButton\" class=\"Button\">Show all sections</span>\n"
-           "&nbsp;\n"
-           "<span id=\"HideAllButton\" class=\"Button\">Hide all sections</span>\n"
-           "</div>\n"           
-           "</div>\n");
-
-
-  fprintf (stream, 
-           "<div id=\"Main\">\n"
-           "<div id=\"Results\"></div>\n"           
-           "</div>\n\n\n");
-
-  fprintf (stream, "<script>\n\"use strict\";\n");
-  fprintf (stream, "const UriPrefix = \"%s\";\n\n", pUriPrefix);
-
-  fprintf (stream, "%s", AdjustMarginCode);
-
-
-  fprintf (stream, "const SectionTitles =\n{\n");
+  HTMLEscapeText (buffer, sizeof (buffer), pKeyword, -1);
+
+  PagePrintf (pPage,
+              "<!DOCTYPE html>\n\n"
+              "<html>\n"
+              "<head>\n"
+              "<title>Apropos: %s</title>\n"
+              "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
+              "<base href=\"%s\">\n"
+              "<link rel=\"stylesheet\" href=\"%s\">\n"
+              "</head>\n"
+              "<body Type=\"apropos\">\n",
+              buffer, 
+              pUriPrefix,
+              pStylesheetUri);
+
+
+  PageAppendStatic (pPage, 
+                    "<div id=\"NavBar\">\n"
+                    "<div id=\"Nav-Apropos-NResults\"></div>\n"
+                    "<div id=\"Nav-Apropos-Sort\">\n"
+                    "<span Label=\"1\">Sort by:</span>"
+                    "<span id=\"ByNameButton\" class=\"Button FormatSelector\">Name</span>\n"
+                    "&nbsp;\n"
+                    "<span id=\"BySectionButton\" class=\"Button FormatSelector\">Section</span>\n"
+                    "</div>\n"
+                    "<div id=\"Nav-Apropos-ShowHide\">\n"
+                    "<span id=\"ShowAllButton\" class=\"Button\">Show all sections</span>\n"
+                    "&nbsp;\n"
+                    "<span id=\"HideAllButton\" class=\"Button\">Hide all sections</span>\n"
+                    "</div>\n"           
+                    "</div>\n", -1);
+
+
+  PageAppendStatic (pPage, 
+                    "<div id=\"Main\">\n"
+                    "<div id=\"Results\"></div>\n"           
+                    "</div>\n\n\n", -1);
+
+  PagePrintf (pPage, 
+              "<script src=\"%s\"></script>\n"
+              "<script>\n\"use strict\";\n", 
+              AssetUri (ASSET_COMMON_SCRIPT));
+  PagePrintf (pPage, "const UriPrefix = \"%s\";\n\n", pUriPrefix);
+
+
+  PageAppendStatic (pPage, "const SectionTitles =\n{\n", -1);
   for (i = 0; ManualSections [i] != NULL; i += 2)
   {
     JSEscapeString (ManualSections [i], id, sizeof (id));
     JSEscapeString (ManualSections [i + 1], description, sizeof (description));
 
-    fprintf (stream, "%s   \"%s\": \"%s\"", 
-             (i == 0) ? "" : ",\n",
-             id, description);
+    PagePrintf (pPage, "%s   \"%s\": \"%s\"", 
+                (i == 0) ? "" : ",\n",
+                id, description);
   }
 
-  fprintf (stream, "\n};\n\n\n");
+  PageAppendStatic (pPage, "\n};\n\n\n", -1);
+
+
+  JSEscapeString (pKeyword, buffer, sizeof (buffer));
+  PagePrintf (pPage, "const AproposQuery = \"%s\";\n", buffer);
+  PagePrintf (pPage, "const AproposPageSize = %d;\n\n", APROPOS_PAGE_SIZE);
 
+  PageAppendStatic (pPage, "const FirstPage =\n", -1);
+  AproposResultsToJSON (pPage, pKeyword, pSet, false, 0, APROPOS_PAGE_SIZE);
+  PageAppendStatic (pPage, ";\n\n", -1);
 
-  fprintf (stream, "\nlet results =\n[");
 
-  for (i = 0; i < nResults; i++)
+  PagePrintf (pPage, 
+              "</script>\n"
+              "<script src=\"%s\"></script>\n"
+              "</body>\n</html>\n",
+              AssetUri (ASSET_APROPOS_SCRIPT));
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                     AproposResultsToJSON
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Writes up to limit results, starting with result number offset in
+*   the order requested, as a JSON object:
+*
+*     { "query": "...", "sort": "section", "total": 1234, "sections": 9,
+*       "offset": 0, "results": [ [ "page", "section", "Description" ], ... ] }
+*
+*   The totals are for the whole search, so a client can tell how many
+*   more pages there are.
+*/
+
+void AproposResultsToJSON
+    (PAGEBUILDER             *pPage,
+     const char              *pKeyword,
+     const APROPOSRESULTSET  *pSet,
+     bool                     fByName,
+     int                      offset,
+     int                      limit)
+
+{
+  int i, iEnd;
+  const APROPOSRESULT *pResult;
+  char title [256], section [64], description [1024];
+
+
+  if (offset > pSet->nResults)
   {
-    JSEscapeString (pResults [i].pDescription, buffer, sizeof (buffer));
+    offset = pSet->nResults;
+  }
 
-    if ((buffer [0] >= 'a') && (buffer [0] <= 'z'))
-    {
-      buffer [0] -= 'a' - 'A';
-    }
+  iEnd = (limit < pSet->nResults - offset) ? offset + limit : pSet->nResults;
 
-  	fprintf (stream, "[\"%s\", \"%s\", \"%s\"]%s\n",
-  		       pResults [i].pPageTitle,
-  		       pResults [i].pSection,
-  		       buffer,
-  		       (i == nResults - 1) ? "];\n\n" : ",");
-  } 
 
+  JSEscapeString (pKeyword, description, sizeof (description));
 
-  fprintf (stream, "%s</script>\n</body>\n</html>\n",
-           ScriptCode);
-}
+  PagePrintf (pPage,
+              "{\"query\":\"%s\",\"sort\":\"%s\",\"total\":%d,\"sections\":%d,"
+              "\"offset\":%d,\"results\":[",
+              description,
+              fByName ? "name" : "section",
+              pSet->nResults,
+              pSet->nSections,
+              offset);
 
 
+  for (i = offset; i < iEnd; i++)
+  {
+    pResult = pSet->pResults + (fByName ? pSet->pByName [i] : i);
+
+    JSEscapeString (pResult->pPageTitle, title, sizeof (title));
+    JSEscapeString (pResult->pSection, section, sizeof (section));
+    JSEscapeString (pResult->pDescription, description, sizeof (description));
+
+    if ((description [0] >= 'a') && (description [0] <= 'z'))
+    {
+      description [0] -= 'a' - 'A';
+    }
+
+    PagePrintf (pPage, "%s\n[\"%s\",\"%s\",\"%s\"]",
+                (i == offset) ? "" : ",",
+                title, section, description);
+  }
+
+  PageAppendStatic (pPage, "]}", -1);
+}
@@ -29,7 +29,20 @@
 #define __APROPOSTOHTML_H_
 
 
-#include "documentation_api.h"     /*  For APROPOSRESULT type.  */
+#include "apropos_cache.h"         /*  For APROPOSRESULTSET type.  */
+#include "page_builder.h"          /*  For PAGEBUILDER type.  */
+
+
+
+/*  Limits on the number of results sent at a time by the apropos API
+*   (and embedded in the apropos page to begin with).
+*/
+
+enum
+{
+  APROPOS_PAGE_SIZE      = 200,
+  APROPOS_MAX_PAGE_SIZE  = 1000
+};
 
 
 
@@ -37,12 +50,20 @@ extern "C"
 {
 
 extern void AproposResultsToHTML
-    (FILE                 *stream,
-     const char           *pKeyword,
-     const char           *pUriPrefix,
-     const char           *pStylesheet,
-     const APROPOSRESULT  *pResults,
-     int                   nResults);
+    (PAGEBUILDER             *pPage,
+     const char              *pKeyword,
+     const char              *pUriPrefix,
+     const char              *pStylesheetUri,
+     const APROPOSRESULTSET  *pSet);
+
+
+extern void AproposResultsToJSON
+    (PAGEBUILDER             *pPage,
+     const char              *pKeyword,
+     const APROPOSRESULTSET  *pSet,
+     bool                     fByName,
+     int                      offset,
+     int                      limit);
 
 }
 
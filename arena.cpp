@@ -0,0 +1,434 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#include <stdlib.h>                    /*  C/C++ RTL headers.  */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "arena.h"                     /*  Application headers.  */
+
+
+
+#define ARENA_BLOCK_SIZE        65536
+#define ARENA_LARGE_SIZE        (ARENA_BLOCK_SIZE / 4)
+#define ARENA_ALIGNMENT         16
+#define MAX_FREE_ARENAS         4
+
+#define ROUND_UP(cb)            (((cb) + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1))
+#define BLOCK_HEADER_SIZE       ROUND_UP (sizeof (ARENABLOCK))
+#define BLOCK_DATA(pBlock)      ((char*) (pBlock) + BLOCK_HEADER_SIZE)
+
+
+
+/*  Allocations up to ARENA_LARGE_SIZE bytes are carved out of blocks of
+*   ARENA_BLOCK_SIZE bytes.  Anything larger gets a block of its own, 
+*   which can be resized with realloc() when the allocation grows.
+*/
+
+struct ARENABLOCK
+{
+  ARENABLOCK  *pNext;
+  ARENABLOCK  *pPrev;              /*  Large blocks only.  */
+  size_t       cbSize;
+  size_t       cbUsed;
+};
+
+
+
+static pthread_key_t FreeListKey;
+static pthread_once_t FreeListKeyOnce = PTHREAD_ONCE_INIT;
+
+
+
+/*  Function prototypes.
+*/
+
+static void CreateFreeListKey (void);
+static void FreeArenaList (void*);
+static void FreeArena (ARENA*);
+static void ResetArena (ARENA*);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             AcquireArena
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns an empty arena, reusing one released earlier by the calling
+*   thread if there is one.
+*/
+
+ARENA* AcquireArena
+   (void)
+
+{
+  ARENA *pArena;
+
+
+  pthread_once (&FreeListKeyOnce, CreateFreeListKey);
+
+  pArena = (ARENA*) pthread_getspecific (FreeListKey);
+
+  if (pArena != NULL)
+  {
+    pthread_setspecific (FreeListKey, pArena->pNextFree);
+    pArena->pNextFree = NULL;
+    return pArena;
+  }
+
+  return (ARENA*) calloc (1, sizeof (ARENA));
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             ReleaseArena
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Frees everything allocated from an arena and puts the arena on the
+*   calling thread's free list, keeping one block for the next request.
+*   Each thread keeps at most MAX_FREE_ARENAS arenas.
+*/
+
+void ReleaseArena
+   (ARENA  *pArena)
+
+{
+  int n;
+  ARENA *pFirst, *pFree;
+
+
+  if (pArena == NULL)
+    return;
+
+  ResetArena (pArena);
+
+  pthread_once (&FreeListKeyOnce, CreateFreeListKey);
+
+  pFirst = (ARENA*) pthread_getspecific (FreeListKey);
+
+  for (pFree = pFirst, n = 0; pFree != NULL; pFree = pFree->pNextFree)
+  {
+    n++;
+  }
+
+  if (n >= MAX_FREE_ARENAS)
+  {
+    FreeArena (pArena);
+    return;
+  }
+
+  pArena->pNextFree = pFirst;
+  pthread_setspecific (FreeListKey, pArena);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               ArenaAlloc
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Allocates cbSize bytes (not zeroed), aligned for any type.
+*/
+
+void* ArenaAlloc
+   (ARENA   *pArena,
+    size_t   cbSize)
+
+{
+  void *pData;
+  ARENABLOCK *pBlock;
+
+
+  cbSize = (cbSize == 0) ? ARENA_ALIGNMENT : ROUND_UP (cbSize);
+
+  if (cbSize > ARENA_LARGE_SIZE)
+  {
+    pBlock = (ARENABLOCK*) malloc (BLOCK_HEADER_SIZE + cbSize);
+    pBlock->cbSize = pBlock->cbUsed = cbSize;
+    pBlock->pPrev = NULL;
+    pBlock->pNext = pArena->pLargeBlocks;
+
+    if (pBlock->pNext != NULL)
+    {
+      pBlock->pNext->pPrev = pBlock;
+    }
+
+    pArena->pLargeBlocks = pBlock;
+    return BLOCK_DATA (pBlock);
+  }
+
+
+  pBlock = pArena->pBlocks;
+
+  if ((pBlock == NULL) || (pBlock->cbUsed + cbSize > pBlock->cbSize))
+  {
+    pBlock = (ARENABLOCK*) malloc (BLOCK_HEADER_SIZE + ARENA_BLOCK_SIZE);
+    pBlock->cbSize = ARENA_BLOCK_SIZE;
+    pBlock->cbUsed = 0;
+    pBlock->pPrev = NULL;
+    pBlock->pNext = pArena->pBlocks;
+    pArena->pBlocks = pBlock;
+  }
+
+  pData = BLOCK_DATA (pBlock) + pBlock->cbUsed;
+  pBlock->cbUsed += cbSize;
+  pArena->pLast = pData;
+
+  return pData;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             ArenaRealloc
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Resizes an allocation made from the arena, whose current size (as 
+*   last passed to ArenaAlloc() or ArenaRealloc()) is cbOldSize.  The 
+*   most recent allocation grows in place if there is room, and a large
+*   one is resized with realloc(); otherwise the data is copied.
+*/
+
+void* ArenaRealloc
+   (ARENA   *pArena,
+    void    *pData,
+    size_t   cbOldSize,
+    size_t   cbNewSize)
+
+{
+  void *pNewData;
+  size_t offset;
+  ARENABLOCK *pBlock;
+
+
+  if (pData == NULL)
+    return ArenaAlloc (pArena, cbNewSize);
+
+  if (cbNewSize <= cbOldSize)
+    return pData;
+
+
+  cbOldSize = ROUND_UP (cbOldSize);
+  cbNewSize = ROUND_UP (cbNewSize);
+
+  if (cbOldSize > ARENA_LARGE_SIZE)
+  {
+    pBlock = (ARENABLOCK*) ((char*) pData - BLOCK_HEADER_SIZE);
+    pBlock = (ARENABLOCK*) realloc (pBlock, BLOCK_HEADER_SIZE + cbNewSize);
+    pBlock->cbSize = pBlock->cbUsed = cbNewSize;
+
+    if (pBlock->pPrev == NULL)
+    {
+      pArena->pLargeBlocks = pBlock;
+    }
+    else
+    {
+      pBlock->pPrev->pNext = pBlock;
+    }
+
+    if (pBlock->pNext != NULL)
+    {
+      pBlock->pNext->pPrev = pBlock;
+    }
+
+    return BLOCK_DATA (pBlock);
+  }
+
+
+  if ((pData == pArena->pLast) && (cbNewSize <= ARENA_LARGE_SIZE))
+  {
+    pBlock = pArena->pBlocks;
+    offset = (char*) pData - BLOCK_DATA (pBlock);
+
+    if (offset + cbNewSize <= pBlock->cbSize)
+    {
+      pBlock->cbUsed = offset + cbNewSize;
+      return pData;
+    }
+  }
+
+  pNewData = ArenaAlloc (pArena, cbNewSize);
+  memcpy (pNewData, pData, cbOldSize);
+
+  return pNewData;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             ArenaStrndup
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+char* ArenaStrndup
+   (ARENA       *pArena,
+    const char  *pStr,
+    size_t       length)
+
+{
+  char *pCopy;
+
+
+  length = strnlen (pStr, length);
+
+  pCopy = (char*) ArenaAlloc (pArena, length + 1);
+  memcpy (pCopy, pStr, length);
+  pCopy [length] = '\0';
+
+  return pCopy;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              ArenaPrintf
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Like asprintf(), but the string is allocated from the arena.
+*/
+
+char* ArenaPrintf
+   (ARENA       *pArena,
+    const char  *pFormat,
+    ...)
+
+{
+  int length;
+  char *pStr;
+  va_list args;
+
+
+  va_start (args, pFormat);
+  length = vsnprintf (NULL, 0, pFormat, args);
+  va_end (args);
+
+  pStr = (char*) ArenaAlloc (pArena, length + 1);
+
+  va_start (args, pFormat);
+  vsnprintf (pStr, length + 1, pFormat, args);
+  va_end (args);
+
+  return pStr;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               ResetArena
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Frees everything allocated from an arena except its most recent
+*   block, which is emptied.
+*/
+
+static
+void ResetArena
+   (ARENA  *pArena)
+
+{
+  ARENABLOCK *pBlock, *pNext;
+
+
+  for (pBlock = pArena->pLargeBlocks; pBlock != NULL; pBlock = pNext)
+  {
+    pNext = pBlock->pNext;
+    free (pBlock);
+  }
+
+  pArena->pLargeBlocks = NULL;
+
+
+  if (pArena->pBlocks != NULL)
+  {
+    for (pBlock = pArena->pBlocks->pNext; pBlock != NULL; pBlock = pNext)
+    {
+      pNext = pBlock->pNext;
+      free (pBlock);
+    }
+
+    pArena->pBlocks->pNext = NULL;
+    pArena->pBlocks->cbUsed = 0;
+  }
+
+  pArena->pLast = NULL;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                FreeArena
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void FreeArena
+   (ARENA  *pArena)
+
+{
+  ResetArena (pArena);
+  free (pArena->pBlocks);
+  free (pArena);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                        CreateFreeListKey
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void CreateFreeListKey
+   (void)
+
+{
+  pthread_key_create (&FreeListKey, FreeArenaList);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            FreeArenaList
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Frees a thread's free list when the thread exits.
+*/
+
+static
+void FreeArenaList
+   (void  *pFirst)
+
+{
+  ARENA *pArena, *pNext;
+
+
+  for (pArena = (ARENA*) pFirst; pArena != NULL; pArena = pNext)
+  {
+    pNext = pArena->pNextFree;
+    FreeArena (pArena);
+  }
+}
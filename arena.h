@@ -0,0 +1,92 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#ifndef __ARENA_H_
+#define __ARENA_H_
+
+
+#include <stddef.h>                /*  For size_t.  */
+
+
+
+/*  A bump-pointer allocator for the temporary data used while handling
+*   one request.  Nothing allocated from an arena is freed individually;
+*   everything goes at once when the arena is released.  Released 
+*   arenas are kept on a per-thread list and handed out again by 
+*   AcquireArena(), so a request normally allocates nothing new.
+*/
+
+struct ARENABLOCK;
+
+struct ARENA
+{
+  ARENABLOCK  *pBlocks;             /*  Most recent first.  */
+  ARENABLOCK  *pLargeBlocks;        /*  One allocation each.  */
+  void        *pLast;               /*  Most recent allocation.  */
+  ARENA       *pNextFree;
+};
+
+
+
+extern "C"
+{
+
+extern ARENA* AcquireArena
+   (void);
+
+
+extern void ReleaseArena
+   (ARENA  *pArena);
+
+
+extern void* ArenaAlloc
+   (ARENA   *pArena,
+    size_t   cbSize);
+
+
+extern void* ArenaRealloc
+   (ARENA   *pArena,
+    void    *pData,
+    size_t   cbOldSize,
+    size_t   cbNewSize);
+
+
+extern char* ArenaStrndup
+   (ARENA       *pArena,
+    const char  *pStr,
+    size_t       length);
+
+
+extern char* ArenaPrintf
+   (ARENA       *pArena,
+    const char  *pFormat,
+    ...)
+    __attribute__ ((format (printf, 2, 3)));
+
+}
+
+#endif
@@ -0,0 +1,186 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#include <stdlib.h>                    /*  C/C++ RTL headers.  */
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "assets.h"                    /*  Application headers.  */
+#include "common_js.h"
+
+#include "dynamic/man_page_script.h"
+#include "dynamic/apropos_script.h"
+
+
+
+/*  Function prototypes.
+*/
+
+static void RegisterAsset (ASSETID, const char*, const char*, const char*, 
+                           const char*);
+static uint64_t HashContent (const char*, int);
+
+
+
+static ASSET Assets [NUM_ASSETS];
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         InitializeAssets
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Builds the asset table.  Must be called before the server starts;
+*   the table is read-only afterward.
+*/
+
+void InitializeAssets
+   (const char  *pStylesheet)
+
+{
+  RegisterAsset (ASSET_STYLESHEET, "css", "text/css; charset=UTF-8", 
+                 "", pStylesheet);
+
+  RegisterAsset (ASSET_COMMON_SCRIPT, "js", "text/javascript; charset=UTF-8", 
+                 "\"use strict\";\n", AdjustMarginCode);
+
+  RegisterAsset (ASSET_MAN_PAGE_SCRIPT, "js", "text/javascript; charset=UTF-8", 
+                 "\"use strict\";\n", ManPageScript);
+
+  RegisterAsset (ASSET_APROPOS_SCRIPT, "js", "text/javascript; charset=UTF-8", 
+                 "\"use strict\";\n", AproposScript);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                 AssetUri
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+const char* AssetUri
+   (ASSETID  id)
+
+{
+  return Assets [id].Uri;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                FindAsset
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Looks up an asset by request path ("/static/<hash>.<ext>").  Returns
+*   NULL if there is no such asset.
+*/
+
+const ASSET* FindAsset
+   (const char  *pPath)
+
+{
+  int i;
+
+
+  if (pPath [0] == '/')
+  {
+    pPath++;
+  }
+
+  for (i = 0; i < NUM_ASSETS; i++)
+  {
+    if (strcmp (pPath, Assets [i].Uri) == 0)
+      return Assets + i;
+  }
+
+  return NULL;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            RegisterAsset
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void RegisterAsset
+   (ASSETID      id,
+    const char  *pExtension,
+    const char  *pContentType,
+    const char  *pPrologue,
+    const char  *pText)
+
+{
+  int cbPrologue, cbText;
+  char *pData;
+  ASSET *pAsset = Assets + id;
+
+
+  cbPrologue = strlen (pPrologue);
+  cbText = strlen (pText);
+
+  pData = (char*) malloc (cbPrologue + cbText + 1);
+  memcpy (pData, pPrologue, cbPrologue);
+  memcpy (pData + cbPrologue, pText, cbText + 1);
+
+  pAsset->pContentType = pContentType;
+  pAsset->pData = pData;
+  pAsset->cbData = cbPrologue + cbText;
+
+  snprintf (pAsset->Uri, sizeof (pAsset->Uri), "static/%016llx.%s", 
+            (unsigned long long) HashContent (pData, pAsset->cbData),
+            pExtension);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              HashContent
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  64-bit FNV-1a.  This only has to distinguish revisions of the same
+*   asset, so a cryptographic hash isn't needed.
+*/
+
+static
+uint64_t HashContent
+   (const char  *pData,
+    int          length)
+
+{
+  int i;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+
+  for (i = 0; i < length; i++)
+  {
+    hash ^= (unsigned char) pData [i];
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
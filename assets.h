@@ -0,0 +1,73 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#ifndef __ASSETS_H_
+#define __ASSETS_H_
+
+
+
+/*  Resources (stylesheet and scripts) that pages reference by URI 
+*   rather than inlining.  Each URI contains a hash of the content, so 
+*   clients may cache the assets indefinitely.
+*/
+
+enum ASSETID
+{
+  ASSET_STYLESHEET = 0,
+  ASSET_COMMON_SCRIPT,
+  ASSET_MAN_PAGE_SCRIPT,
+  ASSET_APROPOS_SCRIPT,
+  NUM_ASSETS
+};
+
+
+struct ASSET
+{
+  char         Uri [32];            /*  Relative, e.g., "static/<hash>.css".  */
+  const char  *pContentType;
+  const char  *pData;
+  int          cbData;
+};
+
+
+
+extern "C"
+{
+extern void InitializeAssets
+    (const char  *pStylesheet);
+
+
+extern const char* AssetUri
+    (ASSETID  id);
+
+
+extern const ASSET* FindAsset
+    (const char  *pPath);
+}
+
+
+#endif
@@ -0,0 +1,738 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#include <stdlib.h>                    /*  C/C++ RTL headers.  */
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+
+#include "utility.h"                   /*  Application headers.  */
+#include "arena.h"
+#include "html_formatting.h"
+#include "name_index.h"
+#include "index_file.h"
+#include "backlink_index.h"
+
+
+
+#define INDEX_MAGIC          "MHBLX001"
+
+#define MAX_NAME_LENGTH      32            /*  As recognized in page text.  */
+#define MAX_SECTION_LENGTH   8
+
+
+
+/*  While the index is being built, pages are numbered as they are in
+*   the page name index.  Each page's references are found on their 
+*   own, then added to the shared list of links under BuildLock.  The
+*   links are collected unsorted, since the pages are done by several
+*   threads at once, and sorted when the file is written.
+*
+*   The pages are rendered by the full-text index's build, which hands
+*   each one's text to AddPageBacklinks(), so that every page is only 
+*   rendered once for both indexes.
+*/
+
+struct BUILDLINK
+{
+  uint32_t  target;
+  uint32_t  source;
+};
+
+
+struct BACKLINKBUILDER
+{
+  const NAMEINDEX  *pNames;
+  BUILDLINK        *pLinks;
+  size_t            nLinks;
+  size_t            nLinksAllocated;
+  pthread_mutex_t   BuildLock;
+};
+
+
+
+/*  Function prototypes.
+*/
+
+static int ResolveReference (const NAMEINDEX*, const char*, const char*);
+static bool WriteIndexFile (BACKLINKBUILDER*, const char*);
+static int ComparePageOrder (const void*, const void*, void*);
+static int CompareLinks (const void*, const void*);
+static void* LoadIndexFile (const char*);
+static bool ValidateIndex (const BACKLINKINDEX*, size_t);
+static void FreeIndex (void*);
+
+
+
+static SHAREDINDEX Index = SHARED_INDEX_INITIALIZER (FreeIndex, 0);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                        LoadBacklinkIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Maps the existing backlink file, the first time it is called, so 
+*   that backlinks can be shown right away.  Returns true if there is
+*   an index.  Building a new one is up to StartFullTextIndexBuild().
+*/
+
+bool LoadBacklinkIndex
+    (const char  *pIndexFile)
+
+{
+  return LoadSharedIndex (&Index, LoadIndexFile, pIndexFile);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                     AcquireBacklinkIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+const BACKLINKINDEX* AcquireBacklinkIndex
+    (void)
+
+{
+  return (const BACKLINKINDEX*) AcquireSharedIndex (&Index);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                     ReleaseBacklinkIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void ReleaseBacklinkIndex
+    (const BACKLINKINDEX  *pIndex)
+
+{
+  ReleaseSharedIndex (&Index, pIndex);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            FindBacklinks
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Looks up a page by name and section; an empty section stands for the
+*   first section the name appears in.  *ppSourcesOut receives the 
+*   numbers of the pages that refer to it, in name order, and the number
+*   of them is returned.  Returns -1 if the page isn't in the index.
+*/
+
+int FindBacklinks
+    (const BACKLINKINDEX   *pIndex,
+     const char            *pName,
+     const char            *pSection,
+     const uint32_t       **ppSourcesOut)
+
+{
+  int iLow = 0, iHigh = pIndex->pHeader->nPages, iMid, r;
+  const BACKLINKPAGE *pPage;
+
+
+  *ppSourcesOut = NULL;
+
+
+  /*  Find the first page that doesn't sort before (pName, pSection).
+  */
+
+  while (iLow < iHigh)
+  {
+    iMid = (iLow + iHigh) / 2;
+    pPage = pIndex->pPages + iMid;
+
+    if ((r = strcmp (pIndex->pBase + pPage->name, pName)) == 0)
+    {
+      r = strcmp (pIndex->pBase + pPage->section, pSection);
+    }
+
+    if (r < 0)
+      iLow = iMid + 1;
+    else
+      iHigh = iMid;
+  }
+
+  if (iLow == (int) pIndex->pHeader->nPages)
+    return -1;
+
+  pPage = pIndex->pPages + iLow;
+
+  if ((strcmp (pIndex->pBase + pPage->name, pName) != 0)
+        || ((pSection [0] != '\0') && (strcmp (pIndex->pBase + pPage->section, pSection) != 0)))
+    return -1;
+
+
+  *ppSourcesOut = pIndex->pSources + pIndex->pFirstLink [iLow];
+  return pIndex->pFirstLink [iLow + 1] - pIndex->pFirstLink [iLow];
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       BeginBacklinkBuild
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Starts collecting the links among the pages in pNames, which must 
+*   stay acquired until FinishBacklinkBuild().
+*/
+
+BACKLINKBUILDER* BeginBacklinkBuild
+    (const NAMEINDEX  *pNames)
+
+{
+  BACKLINKBUILDER *pBuilder;
+
+
+  pBuilder = (BACKLINKBUILDER*) calloc (1, sizeof (BACKLINKBUILDER));
+  pBuilder->pNames = pNames;
+  pthread_mutex_init (&pBuilder->BuildLock, NULL);
+
+  return pBuilder;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         AddPageBacklinks
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Records a link for every reference in a page's rendered text to 
+*   another page in the index, found just as they are when the page is
+*   shown.  The caller leaves out a page whose text is the same as one 
+*   already seen (usually the same page under another name), so that it
+*   isn't listed twice as referring to the same pages.  Several threads
+*   may call this at once.
+*/
+
+void AddPageBacklinks
+    (BACKLINKBUILDER  *pBuilder,
+     int               iPage,
+     const char       *pText,
+     int               cbText,
+     ARENA            *pArena)
+
+{
+  int i, j, k, iTarget, nPageLinks = 0, nAllocated = 16;
+  size_t cb;
+  TEXTATTRIBUTES *pAttrs;
+  BUILDLINK *pPageLinks;
+  char name [MAX_NAME_LENGTH + 1], section [MAX_SECTION_LENGTH + 1];
+
+
+  pAttrs = (TEXTATTRIBUTES*) ArenaAlloc (pArena, sizeof (TEXTATTRIBUTES) * (cbText + 1));
+  memset (pAttrs, 0, sizeof (TEXTATTRIBUTES) * (cbText + 1));
+
+  if (RecognizeManPageRefs (pText, cbText, pAttrs) == 0)
+    return;
+
+  pPageLinks = (BUILDLINK*) ArenaAlloc (pArena, sizeof (BUILDLINK) * nAllocated);
+
+
+  /*  Each reference is a run of marked characters of the form
+  *   "name(section)".
+  */
+
+  for (i = 0; i < cbText; i = k)
+  {
+    if (!(pAttrs [i] & TEXT_ATTR_MAN_PAGE_REF))
+    {
+      k = i + 1;
+      continue;
+    }
+
+    for (k = i, j = 0; (k < cbText) && (pAttrs [k] & TEXT_ATTR_MAN_PAGE_REF) && (pText [k] != '('); k++)
+    {
+      if (!(pAttrs [k] & TEXT_ATTR_LINK_SKIP) && (j < MAX_NAME_LENGTH))
+      {
+        name [j++] = pText [k];
+      }
+    }
+
+    name [j] = '\0';
+
+    for (k++, j = 0; (k < cbText) && (pAttrs [k] & TEXT_ATTR_MAN_PAGE_REF) && (pText [k] != ')'); k++)
+    {
+      if (!(pAttrs [k] & TEXT_ATTR_LINK_SKIP) && (j < MAX_SECTION_LENGTH))
+      {
+        section [j++] = pText [k];
+      }
+    }
+
+    section [j] = '\0';
+    k++;
+
+
+    iTarget = ResolveReference (pBuilder->pNames, name, section);
+
+    if ((iTarget < 0) || (iTarget == iPage))
+      continue;
+
+    if (nPageLinks == nAllocated)
+    {
+      pPageLinks = (BUILDLINK*) ArenaRealloc (pArena, pPageLinks, 
+                                              sizeof (BUILDLINK) * nAllocated,
+                                              sizeof (BUILDLINK) * nAllocated * 2);
+      nAllocated *= 2;
+    }
+
+    pPageLinks [nPageLinks].target = iTarget;
+    pPageLinks [nPageLinks].source = iPage;
+    nPageLinks++;
+  }
+
+  if (nPageLinks == 0)
+    return;
+
+
+  /*  Add the page's links to the shared list.  Duplicates are removed
+  *   when the file is written.
+  */
+
+  pthread_mutex_lock (&pBuilder->BuildLock);
+
+  if (pBuilder->nLinks + nPageLinks > pBuilder->nLinksAllocated)
+  {
+    cb = pBuilder->nLinksAllocated + pBuilder->nLinksAllocated / 2 + nPageLinks + 4096;
+
+    pBuilder->pLinks = (BUILDLINK*) realloc (pBuilder->pLinks, sizeof (BUILDLINK) * cb);
+    pBuilder->nLinksAllocated = cb;
+  }
+
+  memcpy (pBuilder->pLinks + pBuilder->nLinks, pPageLinks, sizeof (BUILDLINK) * nPageLinks);
+  pBuilder->nLinks += nPageLinks;
+
+  pthread_mutex_unlock (&pBuilder->BuildLock);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      FinishBacklinkBuild
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Writes out the links collected by pBuilder and puts the new file in
+*   place of the current index, then frees pBuilder.  If pIndexFile is
+*   NULL, or anything fails, the current index stays as it is and false
+*   is returned.
+*/
+
+bool FinishBacklinkBuild
+    (BACKLINKBUILDER  *pBuilder,
+     const char       *pIndexFile)
+
+{
+  void *pIndex = NULL;
+
+
+  if ((pIndexFile != NULL) && WriteIndexFile (pBuilder, pIndexFile))
+  {
+    pIndex = LoadIndexFile (pIndexFile);
+  }
+
+  pthread_mutex_destroy (&pBuilder->BuildLock);
+  free (pBuilder->pLinks);
+  free (pBuilder);
+
+
+  if (pIndex == NULL)
+    return false;
+
+  ReplaceSharedIndex (&Index, pIndex);
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         ResolveReference
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Finds the page a reference leads to, the way man(1) would: the name
+*   may differ in case, and the section may be a more specific one 
+*   (so that "(3)" finds a page in section 3ssl).  An exact match is 
+*   preferred.  Returns the page's number, or -1 if there is no such 
+*   page.
+*/
+
+static
+int ResolveReference
+   (const NAMEINDEX  *pNames,
+    const char       *pName,
+    const char       *pSection)
+
+{
+  int i, iFirst, nMatches, score, BestScore = 0, iBest = -1;
+  size_t cbSection = strlen (pSection);
+  const char *pEntryName, *pEntrySection;
+
+
+  if ((pName [0] == '\0') || (cbSection == 0))
+    return -1;
+
+  nMatches = FindNamePrefix (pNames, pName, &iFirst);
+
+  for (i = iFirst; i < iFirst + nMatches; i++)
+  {
+    pEntryName = pNames->pText + pNames->pEntries [i].name;
+    pEntrySection = pNames->pText + pNames->pEntries [i].section;
+
+    if (strcasecmp (pEntryName, pName) != 0)
+      continue;
+
+    if (strcasecmp (pEntrySection, pSection) == 0)
+      score = 4;
+    else if (strncasecmp (pEntrySection, pSection, cbSection) == 0)
+      score = 2;
+    else
+      continue;
+
+    score += (strcmp (pEntryName, pName) == 0);
+
+    if (score > BestScore)
+    {
+      BestScore = score;
+      iBest = i;
+    }
+  }
+
+  return iBest;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           WriteIndexFile
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Renumbers the pages in name order, sorts the links by target and 
+*   source (dropping duplicates), and writes out the backlink file in 
+*   the layout described in backlink_index.h.
+*/
+
+static
+bool WriteIndexFile
+   (BACKLINKBUILDER  *pBuilder,
+    const char       *pIndexFile)
+
+{
+  int i, r, nPages = pBuilder->pNames->nEntries;
+  uint32_t *pOrder, *pRank, *pFirstLink, *pSources, nLinks = 0;
+  uint64_t cbFile;
+  size_t j, cbText;
+  char *pText, *pStr;
+  const char *pName, *pSection;
+  BACKLINKHEADER header;
+  BACKLINKPAGE *pPages;
+  INDEXFILEPART parts [5];
+  bool fSuccess;
+
+
+  pOrder = (uint32_t*) malloc (sizeof (uint32_t) * (nPages + 1));
+  pRank = (uint32_t*) malloc (sizeof (uint32_t) * (nPages + 1));
+
+  for (i = 0; i < nPages; i++)
+  {
+    pOrder [i] = i;
+  }
+
+  qsort_r (pOrder, nPages, sizeof (uint32_t), ComparePageOrder, (void*) pBuilder->pNames);
+
+  for (r = 0; r < nPages; r++)
+  {
+    pRank [pOrder [r]] = r;
+  }
+
+  for (j = 0; j < pBuilder->nLinks; j++)
+  {
+    pBuilder->pLinks [j].target = pRank [pBuilder->pLinks [j].target];
+    pBuilder->pLinks [j].source = pRank [pBuilder->pLinks [j].source];
+  }
+
+  qsort (pBuilder->pLinks, pBuilder->nLinks, sizeof (BUILDLINK), CompareLinks);
+
+
+  /*  Build the adjacency arrays.
+  */
+
+  pFirstLink = (uint32_t*) malloc (sizeof (uint32_t) * (nPages + 1));
+  pSources = (uint32_t*) malloc (sizeof (uint32_t) * (pBuilder->nLinks + 1));
+
+  for (r = 0, j = 0; r < nPages; r++)
+  {
+    pFirstLink [r] = nLinks;
+
+    for ( ; (j < pBuilder->nLinks) && (pBuilder->pLinks [j].target == (uint32_t) r); j++)
+    {
+      if ((nLinks == pFirstLink [r]) || (pSources [nLinks - 1] != pBuilder->pLinks [j].source))
+      {
+        pSources [nLinks++] = pBuilder->pLinks [j].source;
+      }
+    }
+  }
+
+  pFirstLink [nPages] = nLinks;
+
+
+  for (i = 0, cbText = 0; i < nPages; i++)
+  {
+    cbText += strlen (pBuilder->pNames->pText + pBuilder->pNames->pEntries [i].name) + 1;
+    cbText += strlen (pBuilder->pNames->pText + pBuilder->pNames->pEntries [i].section) + 1;
+  }
+
+  pText = (char*) malloc (cbText + 1);
+  pPages = (BACKLINKPAGE*) malloc (sizeof (BACKLINKPAGE) * (nPages + 1));
+
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, INDEX_MAGIC, sizeof (header.magic));
+  header.nPages           = nPages;
+  header.nLinks           = nLinks;
+  header.PagesOffset      = sizeof (BACKLINKHEADER);
+  header.FirstLinkOffset  = header.PagesOffset + sizeof (BACKLINKPAGE) * nPages;
+  header.SourcesOffset    = header.FirstLinkOffset + sizeof (uint32_t) * (nPages + 1);
+  header.TextOffset       = header.SourcesOffset + sizeof (uint32_t) * nLinks;
+
+  cbFile = (uint64_t) header.TextOffset + cbText;
+
+  if (cbFile > UINT32_MAX)
+  {
+    fSuccess = false;
+    goto Done;
+  }
+
+  header.cbFile = (uint32_t) cbFile;
+
+
+  for (r = 0, pStr = pText; r < nPages; r++)
+  {
+    pName = pBuilder->pNames->pText + pBuilder->pNames->pEntries [pOrder [r]].name;
+    pSection = pBuilder->pNames->pText + pBuilder->pNames->pEntries [pOrder [r]].section;
+
+    pPages [r].name = header.TextOffset + (pStr - pText);
+    pStr = stpcpy (pStr, pName) + 1;
+    pPages [r].section = header.TextOffset + (pStr - pText);
+    pStr = stpcpy (pStr, pSection) + 1;
+  }
+
+
+  parts [0].pData = &header;
+  parts [0].cbData = sizeof (header);
+  parts [1].pData = pPages;
+  parts [1].cbData = sizeof (BACKLINKPAGE) * nPages;
+  parts [2].pData = pFirstLink;
+  parts [2].cbData = sizeof (uint32_t) * (nPages + 1);
+  parts [3].pData = pSources;
+  parts [3].cbData = sizeof (uint32_t) * nLinks;
+  parts [4].pData = pText;
+  parts [4].cbData = cbText;
+
+  fSuccess = ReplaceIndexFile (pIndexFile, parts, 5);
+
+
+Done:
+  free (pOrder);
+  free (pRank);
+  free (pFirstLink);
+  free (pSources);
+  free (pText);
+  free (pPages);
+
+  return fSuccess;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         ComparePageOrder
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+int ComparePageOrder
+   (const void  *pLeft,
+    const void  *pRight,
+    void        *pContext)
+
+{
+  const NAMEINDEX *pNames = (const NAMEINDEX*) pContext;
+  const NAMEINDEXENTRY *pA = pNames->pEntries + *(const uint32_t*) pLeft;
+  const NAMEINDEXENTRY *pB = pNames->pEntries + *(const uint32_t*) pRight;
+  int r;
+
+
+  if ((r = strcmp (pNames->pText + pA->name, pNames->pText + pB->name)) != 0)
+    return r;
+
+  return strcmp (pNames->pText + pA->section, pNames->pText + pB->section);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             CompareLinks
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+int CompareLinks
+   (const void  *pLeft,
+    const void  *pRight)
+
+{
+  const BUILDLINK *pA = (const BUILDLINK*) pLeft;
+  const BUILDLINK *pB = (const BUILDLINK*) pRight;
+
+
+  if (pA->target != pB->target)
+    return (pA->target < pB->target) ? -1 : 1;
+
+  return (pA->source < pB->source) ? -1 : (pA->source > pB->source);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            LoadIndexFile
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Maps a backlink file into memory.  Returns NULL if the file doesn't
+*   exist or isn't a valid index.
+*/
+
+static
+void* LoadIndexFile
+   (const char  *pIndexFile)
+
+{
+  const char *pBase;
+  size_t cbFile;
+  BACKLINKINDEX *pIndex;
+
+
+  if ((pBase = MapIndexFile (pIndexFile, sizeof (BACKLINKHEADER), &cbFile)) == NULL)
+    return NULL;
+
+  pIndex = (BACKLINKINDEX*) malloc (sizeof (BACKLINKINDEX));
+  pIndex->pBase    = pBase;
+  pIndex->pHeader  = (const BACKLINKHEADER*) pBase;
+
+  if (!ValidateIndex (pIndex, cbFile))
+  {
+    UnmapIndexFile (pBase, cbFile);
+    free (pIndex);
+    return NULL;
+  }
+
+  pIndex->pPages      = (const BACKLINKPAGE*) (pIndex->pBase + pIndex->pHeader->PagesOffset);
+  pIndex->pFirstLink  = (const uint32_t*) (pIndex->pBase + pIndex->pHeader->FirstLinkOffset);
+  pIndex->pSources    = (const uint32_t*) (pIndex->pBase + pIndex->pHeader->SourcesOffset);
+
+  return pIndex;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            ValidateIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Checks that every offset and page number in the file is in range,
+*   so that a damaged or truncated file can't make a lookup read outside
+*   the mapping, which is cbFile bytes long.
+*/
+
+static
+bool ValidateIndex
+   (const BACKLINKINDEX  *pIndex,
+    size_t                cbFile)
+
+{
+  uint32_t i;
+  const char *pBase = pIndex->pBase;
+  const BACKLINKHEADER *pHeader = pIndex->pHeader;
+  const BACKLINKPAGE *pPages;
+  const uint32_t *pFirstLink, *pSources;
+
+
+  if ((memcmp (pHeader->magic, INDEX_MAGIC, sizeof (pHeader->magic)) != 0)
+         || (pHeader->cbFile != cbFile)
+         || (pHeader->PagesOffset != sizeof (BACKLINKHEADER))
+         || (pHeader->FirstLinkOffset != pHeader->PagesOffset + (uint64_t) sizeof (BACKLINKPAGE) * pHeader->nPages)
+         || (pHeader->SourcesOffset != pHeader->FirstLinkOffset + (uint64_t) sizeof (uint32_t) * (pHeader->nPages + 1))
+         || (pHeader->TextOffset != pHeader->SourcesOffset + (uint64_t) sizeof (uint32_t) * pHeader->nLinks)
+         || (pHeader->TextOffset > pHeader->cbFile))
+    return false;
+
+  if ((pHeader->nPages > 0)
+         && ((pHeader->TextOffset == pHeader->cbFile) 
+                || (pBase [pHeader->cbFile - 1] != '\0')))
+    return false;
+
+
+  pPages = (const BACKLINKPAGE*) (pBase + pHeader->PagesOffset);
+  pFirstLink = (const uint32_t*) (pBase + pHeader->FirstLinkOffset);
+  pSources = (const uint32_t*) (pBase + pHeader->SourcesOffset);
+
+  for (i = 0; i < pHeader->nPages; i++)
+  {
+    if ((pPages [i].name < pHeader->TextOffset) || (pPages [i].name >= pHeader->cbFile)
+          || (pPages [i].section < pHeader->TextOffset) || (pPages [i].section >= pHeader->cbFile)
+          || (pFirstLink [i] > pFirstLink [i + 1]))
+      return false;
+  }
+
+  if ((pFirstLink [0] != 0) || (pFirstLink [pHeader->nPages] != pHeader->nLinks))
+    return false;
+
+  for (i = 0; i < pHeader->nLinks; i++)
+  {
+    if (pSources [i] >= pHeader->nPages)
+      return false;
+  }
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                FreeIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void FreeIndex
+   (void  *pIndex)
+
+{
+  BACKLINKINDEX *pBacklinks = (BACKLINKINDEX*) pIndex;
+
+
+  UnmapIndexFile (pBacklinks->pBase, pBacklinks->pHeader->cbFile);
+  free (pBacklinks);
+}
@@ -0,0 +1,142 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#ifndef __BACKLINK_INDEX_H_
+#define __BACKLINK_INDEX_H_
+
+
+#include <stdint.h>
+
+#include "arena.h"                 /*  For ARENA type.  */
+#include "name_index.h"            /*  For NAMEINDEX type.  */
+
+
+
+/*  The layout of a backlink file, which is mapped into memory as is.  
+*   The pages that refer to each page are kept in compressed sparse row
+*   form: those of page i are Sources [FirstLink [i]] up to (but not 
+*   including) Sources [FirstLink [i + 1]].  All offsets are from the 
+*   start of the file, and numbers are in native byte order.
+*
+*     BACKLINKHEADER
+*     BACKLINKPAGE  [nPages]        Sorted by name, then by section
+*                                   (strcmp order).
+*     uint32_t      [nPages + 1]    FirstLink.
+*     uint32_t      [nLinks]        Sources (page numbers), in order.
+*     Text                          NUL-terminated names and sections.
+*/
+
+struct BACKLINKHEADER
+{
+  char      magic [8];
+  uint32_t  nPages;
+  uint32_t  nLinks;
+  uint32_t  PagesOffset;
+  uint32_t  FirstLinkOffset;
+  uint32_t  SourcesOffset;
+  uint32_t  TextOffset;
+  uint32_t  cbFile;
+};
+
+
+struct BACKLINKPAGE
+{
+  uint32_t  name;              /*  Offsets of the name and section.  */
+  uint32_t  section;
+};
+
+
+
+/*  A backlink file that has been mapped into memory.
+*/
+
+struct BACKLINKINDEX
+{
+  const char            *pBase;
+  const BACKLINKHEADER  *pHeader;
+  const BACKLINKPAGE    *pPages;
+  const uint32_t        *pFirstLink;
+  const uint32_t        *pSources;
+};
+
+
+
+/*  Collects links while the index is being built.
+*/
+
+struct BACKLINKBUILDER;
+
+
+
+/*  LoadBacklinkIndex() maps the backlink file the first time it is 
+*   called.  The file is rebuilt along with the full-text index, by
+*   StartFullTextIndexBuild(), which renders each page once and passes
+*   its text to AddPageBacklinks().  Until an index is available, 
+*   AcquireBacklinkIndex() returns NULL.  All of the functions are 
+*   thread-safe.
+*/
+
+extern "C"
+{
+extern bool LoadBacklinkIndex
+    (const char  *pIndexFile);
+
+
+extern BACKLINKBUILDER* BeginBacklinkBuild
+    (const NAMEINDEX  *pNames);
+
+
+extern void AddPageBacklinks
+    (BACKLINKBUILDER  *pBuilder,
+     int               iPage,
+     const char       *pText,
+     int               cbText,
+     ARENA            *pArena);
+
+
+extern bool FinishBacklinkBuild
+    (BACKLINKBUILDER  *pBuilder,
+     const char       *pIndexFile);
+
+
+extern const BACKLINKINDEX* AcquireBacklinkIndex
+    (void);
+
+
+extern void ReleaseBacklinkIndex
+    (const BACKLINKINDEX  *pIndex);
+
+
+extern int FindBacklinks
+    (const BACKLINKINDEX   *pIndex,
+     const char            *pName,
+     const char            *pSection,
+     const uint32_t       **ppSourcesOut);
+}
+
+
+#endif
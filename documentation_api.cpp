@@ -30,8 +30,11 @@
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/stat.h>
 #include <limits.h>
 
 #include <tre/tre.h>                   /*  Library headers.  */
@@ -44,6 +47,18 @@
 
 static regex_t ParseRegex, AproposRegex;
 
+static bool fUseCatPages = false;
+
+
+
+/*  Function prototypes.
+*/
+
+static bool StartManProcess (const char*, const char*, pid_t*, int*, PROCESSERRORINFO*);
+static bool WaitForManProcess (pid_t, PROCESSERRORINFO*);
+static bool GetCatPageContent (const char*, const char*, char**, int*);
+static char* FindCatPage (const char*);
+
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
@@ -100,6 +115,19 @@ void manInitializeRegexes
 
 
 
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                        manEnableCatPages
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void manEnableCatPages
+   (bool  fEnable)
+
+{
+  fUseCatPages = fEnable;
+}
+
+
+
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
                                                         ParseManPageTitle
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
@@ -161,16 +189,188 @@ bool GetManPageContent
     PROCESSERRORINFO    *pErrorOut)
 
 {
-  int nArgs = 0, fdOutput, status = 0, cbData;
+  int fdOutput, cbData;
   pid_t pid;
   char *pData;
-  const char *pCommand, *pArguments [8];
-
-  const char *pExecutable = ManPath;
 
   *ppDataOut = NULL;
   *pcbDataOut = 0;
 
+
+  /*  If a cat page that is at least as new as the manual page source is
+  *   available, use it instead of running man(1) to format the page.
+  */
+
+  if (fUseCatPages
+         && GetCatPageContent (pPageTitle, pSection, ppDataOut, pcbDataOut))
+    return true;
+
+
+  /*  Run man(1) and capture its output into a buffer.
+  */
+
+  if (!StartManProcess (pPageTitle, pSection, &pid, &fdOutput, pErrorOut))
+    return false;
+
+  CaptureInput (fdOutput, (void**) &pData, &cbData, 0, ' ');
+  close (fdOutput);
+
+
+  /*  Wait until the man(1) process has terminated; obtain its exit status.
+  */
+
+  if (!WaitForManProcess (pid, pErrorOut))
+  {
+    free (pData);
+    return false;
+  }
+
+
+  *ppDataOut = pData;
+  *pcbDataOut = cbData;
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                        OpenManPageStream
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Like GetManPageContent(), but lets the caller read the page text
+*   with ReadManPageStream() while man(1) is still producing it.  A cat
+*   page, if one is used, is read into memory and handed out from there.
+*/
+
+bool OpenManPageStream
+   (const char          *pPageTitle,
+    const char          *pSection,
+    MANPAGESTREAM       *pStream,
+    PROCESSERRORINFO    *pErrorOut)
+
+{
+  pStream->pid = -1;
+  pStream->fdOutput = -1;
+  pStream->pData = NULL;
+  pStream->cbData = 0;
+  pStream->iData = 0;
+
+  if (fUseCatPages
+         && GetCatPageContent (pPageTitle, pSection, 
+                               &pStream->pData, &pStream->cbData))
+    return true;
+
+  return StartManProcess (pPageTitle, pSection, 
+                          &pStream->pid, &pStream->fdOutput, pErrorOut);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                        ReadManPageStream
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Reads the next piece of the page text, blocking until some is
+*   available.  Returns the number of bytes read, or 0 at the end of the
+*   text.  As with GetManPageContent(), zero bytes are replaced with 
+*   spaces.
+*/
+
+int ReadManPageStream
+   (MANPAGESTREAM  *pStream,
+    char           *pBuffer,
+    int             cbMax)
+
+{
+  int i, cbRead;
+
+
+  if (pStream->fdOutput < 0)
+  {
+    cbRead = Min (pStream->cbData - pStream->iData, cbMax);
+    memcpy (pBuffer, pStream->pData + pStream->iData, cbRead);
+    pStream->iData += cbRead;
+
+    return cbRead;
+  }
+
+
+  do
+  {
+    cbRead = read (pStream->fdOutput, pBuffer, cbMax);
+  }
+  while ((cbRead < 0) && (errno == EINTR));
+
+  if (cbRead <= 0)
+    return 0;
+
+  for (i = 0; i < cbRead; i++)
+  {
+    if (pBuffer [i] == '\0')
+    {
+      pBuffer [i] = ' ';
+    }
+  }
+
+  return cbRead;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       CloseManPageStream
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Releases the stream and waits for man(1) to terminate.  If fAbort is
+*   set, man(1) is terminated first.  Returns false, with error
+*   information, if man(1) did not complete successfully.
+*/
+
+bool CloseManPageStream
+   (MANPAGESTREAM     *pStream,
+    bool               fAbort,
+    PROCESSERRORINFO  *pErrorOut)
+
+{
+  if (pStream->fdOutput < 0)
+  {
+    free (pStream->pData);
+    pStream->pData = NULL;
+    return true;
+  }
+
+  close (pStream->fdOutput);
+  pStream->fdOutput = -1;
+
+  if (fAbort)
+  {
+    kill (pStream->pid, SIGTERM);
+  }
+
+  return WaitForManProcess (pStream->pid, pErrorOut);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          StartManProcess
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+bool StartManProcess
+   (const char          *pPageTitle,
+    const char          *pSection,
+    pid_t               *pPidOut,
+    int                 *pfdOutput,
+    PROCESSERRORINFO    *pErrorOut)
+
+{
+  int nArgs = 0;
+  const char *pCommand, *pArguments [8];
+
+  const char *pExecutable = ManPath;
+
  
   /*  Construct the argument list.
   */
@@ -201,36 +401,317 @@ bool GetManPageContent
   /*  Run man(1) as a child process.
   */
 
-  if (!CreateChildProcess (&pid, pErrorOut, pExecutable, pArguments,
-                           STDIN_NULL | STDOUT_REDIRECT | STDERR_NULL, 
-                           NULL, &fdOutput, NULL))
+  return CreateChildProcess (pPidOut, pErrorOut, pExecutable, pArguments,
+                             STDIN_NULL | STDOUT_REDIRECT | STDERR_NULL, 
+                             NULL, pfdOutput, NULL);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                        WaitForManProcess
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+bool WaitForManProcess
+   (pid_t              pid,
+    PROCESSERRORINFO  *pErrorOut)
+
+{
+  int status = 0;
+
+
+  waitpid (pid, &status, 0);
+
+  if (WIFSIGNALED (status) || (WEXITSTATUS (status) != 0))
+  {
+    pErrorOut->context    = ERRORCTXT_RUNTIME;
+    pErrorOut->ErrorCode  = status;
+    pErrorOut->pExecPath  = ManPath;
+
     return false;
+  }
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                        GetCatPageContent
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+bool GetCatPageContent
+   (const char   *pPageTitle,
+    const char   *pSection,
+    char        **ppDataOut,
+    int          *pcbDataOut)
+
+{
+  int n = 0, fdOutput, length, status = 0;
+  pid_t pid;
+  bool fSuccess;
+  char c, *pSourcePath, *pCatPath;
+  const char *pCommand, *pArguments [8];
+  PROCESSERRORINFO error;
 
+  const char *pExecutable = ManPath;
 
-  /*  Capture the output from man(1) into a buffer.
+
+  /*  Ask man(1) where the source for the page is located.  This is
+  *   much cheaper than formatting the page.
   */
 
-  CaptureInput (fdOutput, (void**) &pData, &cbData, 0, ' ');
+  pCommand = strrchr (pExecutable, '/');
+  pCommand = (pCommand == NULL) ? pExecutable : (pCommand + 1);
+
+  pArguments [n++] = pCommand;
+  pArguments [n++] = "-w";
+
+  if ((pSection != NULL) && (pSection [0] != '\0'))
+  {
+    pArguments [n++] = pSection;
+  }
+
+  pArguments [n++] = pPageTitle;
+  pArguments [n] = NULL;
+
+
+  if (!CreateChildProcess (&pid, &error, pExecutable, pArguments,
+                           STDIN_NULL | STDOUT_REDIRECT | STDERR_NULL, 
+                           NULL, &fdOutput, NULL))
+    return false;
+
+  CaptureInput (fdOutput, (void**) &pSourcePath, &length, PATH_MAX, '\0');
   close (fdOutput);
 
+  waitpid (pid, &status, 0);
 
-  /*  Wait until the man(1) process has terminated; obtain its exit status.
+
+  /*  Keep only the first line of the output.
   */
 
-  waitpid (pid, &status, 0);
+  pSourcePath [strcspn (pSourcePath, "\n")] = '\0';
+  length = strlen (pSourcePath);
 
+  while ((length > 0)
+           && (c = pSourcePath [length - 1], ((c == ' ') || (c == '\t') || (c == '\r'))))
+  {
+    pSourcePath [--length] = '\0';
+  }
 
-  if (WIFSIGNALED (status) || (WEXITSTATUS (status) != 0))
+
+  if (WIFSIGNALED (status) || (WEXITSTATUS (status) != 0)
+         || (pSourcePath [0] != '/'))
   {
-    free (pData);
+    free (pSourcePath);
+    return false;
+  }
 
-    pErrorOut->context    = ERRORCTXT_RUNTIME;
-    pErrorOut->ErrorCode  = status;
-    pErrorOut->pExecPath  = pExecutable;
 
+  /*  Locate a fresh cat page and read it.
+  */
+
+  pCatPath = FindCatPage (pSourcePath);
+  free (pSourcePath);
+
+  if (pCatPath == NULL)
     return false;
+
+  fSuccess = ReadCompressedFile (pCatPath, ppDataOut, pcbDataOut);
+  free (pCatPath);
+
+  return fSuccess;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              FindCatPage
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+char* FindCatPage
+   (const char  *pSourcePath)
+
+{
+  int i, t, cbRoot, cbStem;
+  const char *pRoot, *pCatRoot, *pRelative, *pBasename, *pSubdir, *pExtension;
+  char *pCatPath;
+  struct stat SourceInfo, CatInfo;
+
+
+  if ((stat (pSourcePath, &SourceInfo) != 0)
+         || ((SourceInfo.st_mode & S_IFMT) != S_IFREG))
+    return NULL;
+
+
+  /*  Find the manual page hierarchy that contains the source file.
+  */
+
+  for (i = 0; (pRoot = CatPageDirectories [i]) != NULL; i += 2)
+  {
+    cbRoot = strlen (pRoot);
+    if ((strncmp (pSourcePath, pRoot, cbRoot) == 0)
+           && (pSourcePath [cbRoot] == '/'))
+      break;
+  }
+
+  if (pRoot == NULL)
+    return NULL;
+
+  pCatRoot = CatPageDirectories [i + 1];
+
+
+  /*  The source file must reside in a "manN" subdirectory.  (The relative
+  *   path may begin with a locale directory, e.g., "de/man1/ls.1.gz".)
+  */
+
+  pRelative = pSourcePath + cbRoot + 1;
+  pBasename = strrchr (pRelative, '/');
+
+  if (pBasename == NULL)
+    return NULL;
+
+  pBasename++;
+
+  pSubdir = pBasename - 1;
+  while ((pSubdir > pRelative) && (pSubdir [-1] != '/'))
+  {
+    pSubdir--;
   }
 
+  if (strncmp (pSubdir, "man", 3) != 0)
+    return NULL;
+
+
+  /*  Remove the compression extension, if any, from the file name.
+  */
+
+  cbStem = strlen (pBasename);
+
+  for (i = 0; (pExtension = Decompressors [i]) != NULL; i += 2)
+  {
+    t = strlen (pExtension);
+    if ((cbStem > t) && (strcmp (pBasename + cbStem - t, pExtension) == 0))
+    {
+      cbStem -= t;
+      break;
+    }
+  }
+
+
+  /*  Try the uncompressed cat page first, then each compressed variant.
+  *   man-db gives a cat page the same modification time as its source
+  *   file, so a cat page that is older than the source is stale.
+  */
+
+  for (i = -2; (i < 0) || (Decompressors [i] != NULL); i += 2)
+  {
+    asprintf (&pCatPath, "%s/%.*scat%.*s%s",
+              pCatRoot,
+              (int) (pSubdir - pRelative), pRelative,
+              (int) (pBasename - pSubdir - 3 + cbStem), pSubdir + 3,
+              (i < 0) ? "" : Decompressors [i]);
+
+    if ((stat (pCatPath, &CatInfo) == 0)
+           && ((CatInfo.st_mode & S_IFMT) == S_IFREG)
+           && (CatInfo.st_size > 0)
+           && (CatInfo.st_mtime >= SourceInfo.st_mtime))
+      return pCatPath;
+
+    free (pCatPath);
+  }
+
+  return NULL;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       ReadCompressedFile
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Reads a whole file, running it through the decompressor for its
+*   extension (see Decompressors []) if it has one.  Returns false if
+*   the file can't be read or is empty.
+*/
+
+bool ReadCompressedFile
+   (const char   *pPath,
+    char        **ppDataOut,
+    int          *pcbDataOut)
+
+{
+  int i, t, fd, cbData, length, status = 0;
+  pid_t pid;
+  char *pData;
+  const char *pExtension, *pExecutable = NULL, *pCommand;
+  PROCESSERRORINFO error;
+
+
+  *ppDataOut = NULL;
+  *pcbDataOut = 0;
+
+
+  /*  Select a decompression program based on the file extension.
+  */
+
+  length = strlen (pPath);
+
+  for (i = 0; (pExtension = Decompressors [i]) != NULL; i += 2)
+  {
+    t = strlen (pExtension);
+    if ((length > t) && (strcmp (pPath + length - t, pExtension) == 0))
+    {
+      pExecutable = Decompressors [i + 1];
+      break;
+    }
+  }
+
+
+  /*  Uncompressed files are read directly.
+  */
+
+  if (pExecutable == NULL)
+  {
+    if ((fd = open (pPath, O_RDONLY | O_CLOEXEC)) < 0)
+      return false;
+
+    CaptureInput (fd, (void**) &pData, &cbData, 0, ' ');
+    close (fd);
+  }
+  else
+  {
+    pCommand = strrchr (pExecutable, '/');
+    pCommand = (pCommand == NULL) ? pExecutable : (pCommand + 1);
+
+    const char *pArguments [] = { pCommand, pPath, NULL };
+
+    if (!CreateChildProcess (&pid, &error, pExecutable, pArguments,
+                             STDIN_NULL | STDOUT_REDIRECT | STDERR_NULL, 
+                             NULL, &fd, NULL))
+      return false;
+
+    CaptureInput (fd, (void**) &pData, &cbData, 0, ' ');
+    close (fd);
+
+    waitpid (pid, &status, 0);
+
+    if (WIFSIGNALED (status) || (WEXITSTATUS (status) != 0))
+    {
+      free (pData);
+      return false;
+    }
+  }
+
+
+  if (cbData == 0)
+  {
+    free (pData);
+    return false;
+  }
 
   *ppDataOut = pData;
   *pcbDataOut = cbData;
@@ -252,12 +733,13 @@ bool GetAproposContent
     PROCESSERRORINFO    *pErrorOut)
 
 {
-  int i, n, cb, status = 0, fdOutput;
-  int cbRemaining, nLines, cbRawData, cbTotal, length;
-  char *pRawData, *pLine, *pNextLine;
+  int i, k, n, cb, status = 0, fdOutput;
+  int nLines, cbRawData, cbTotal;
+  char *pRawData, *pLine;
   char *pStr, *pPageTitle, *pSection, *pDescription;
-  const char *pCommand, *pRawDataEnd, *pArguments [8];
+  const char *pCommand, *pArguments [8];
   APROPOSRESULT *pResults;
+  LINEINDEX *pLines;
   pid_t pid;
   regmatch_t match [4];
 
@@ -338,17 +820,13 @@ bool GetAproposContent
   }
 
 
-  /*  Count the lines in the apropos output.
+  /*  Find the lines in the apropos output.
   */
 
-  nLines = 1;
-  for (i = 0; i < cbRawData; i++)
-  {
-    if (pRawData [i] == '\n')
-    {
-      nLines++;
-    }
-  }
+  nLines = CountLines (pRawData, cbRawData);
+
+  pLines = (LINEINDEX*) malloc (sizeof (LINEINDEX) * nLines);
+  IndexLines (pRawData, cbRawData, 0, pLines, nLines);
 
 
   /*  Allocate a memory block large enough to hold the 
@@ -368,19 +846,11 @@ bool GetAproposContent
   *   descriptions from each line of the raw data.
   */
 
-  i = 0;
-  pRawDataEnd = pRawData + cbRawData;
-  pNextLine = pRawData;  
-
-  while ((pLine = pNextLine) != NULL)
+  for (i = k = 0; k < nLines; k++)
   {
-    cbRemaining = pRawDataEnd - pLine;
-    pNextLine = (char*) memchr (pLine, '\n', cbRemaining);
-    length = (pNextLine == NULL)
-                ? cbRemaining : (pNextLine++ - pLine);
-
+    pLine = pRawData + pLines [k].offset;
   
-    if (tre_regnexec (&AproposRegex, pLine, length, 4, match, 0))
+    if (tre_regnexec (&AproposRegex, pLine, pLines [k].length, 4, match, 0))
       continue;
 
 
@@ -409,6 +879,7 @@ bool GetAproposContent
   /*  Free the raw data--we no longer need it.
   */
 
+  free (pLines);
   free (pRawData);
 
 
@@ -41,6 +41,19 @@ struct APROPOSRESULT
 };
 
 
+/*  A manual page being read with ReadManPageStream().
+*/
+
+struct MANPAGESTREAM
+{
+  pid_t   pid;
+  int     fdOutput;
+  char   *pData;             /*  Cat page content, if one is used.  */
+  int     cbData;
+  int     iData;
+};
+
+
 enum APROPOSMODE
 {
   APROPOS_REGEX      = 1,
@@ -68,6 +81,10 @@ extern void manInitializeRegexes
    (void);
 
 
+extern void manEnableCatPages
+   (bool  fEnable);
+
+
 extern bool ParseManPageTitle
    (const char   *pStr,
     char         *pTitleOut,
@@ -84,6 +101,25 @@ extern bool GetManPageContent
     PROCESSERRORINFO    *pErrorOut);
 
 
+extern bool OpenManPageStream
+   (const char          *pPageTitle,
+    const char          *pSection,
+    MANPAGESTREAM       *pStream,
+    PROCESSERRORINFO    *pErrorOut);
+
+
+extern int ReadManPageStream
+   (MANPAGESTREAM       *pStream,
+    char                *pBuffer,
+    int                  cbMax);
+
+
+extern bool CloseManPageStream
+   (MANPAGESTREAM       *pStream,
+    bool                 fAbort,
+    PROCESSERRORINFO    *pErrorOut);
+
+
 extern bool GetAproposContent
    (const char          *pSearchKeyword,
     APROPOSMODE          SearchMode,
@@ -105,6 +141,12 @@ extern bool GetInfoContent
     int                *pcbDataOut,
     PROCESSERRORINFO   *pErrorOut);
 
+
+extern bool ReadCompressedFile
+   (const char   *pPath,
+    char        **ppDataOut,
+    int          *pcbDataOut);
+
 }
 
 #endif
@@ -0,0 +1,366 @@
+
+
+const char AproposScript []
+        = "const TitleSeparator = \"\\u2002\\u2014\\u2002\";\n"
+          "\n"
+          "const ShowAllBtn = document.getElementById (\"ShowAllButton\");\n"
+          "const HideAllBtn = document.getElementById (\"HideAllButton\");\n"
+          "const BySectionBtn = document.getElementById (\"BySectionButton\");\n"
+          "const ByNameBtn = document.getElementById (\"ByNameButton\");\n"
+          "const ResultsDiv = document.getElementById (\"Results\");\n"
+          "\n\n"
+          "let SortMode = null;\n"
+          "let nSections = 0;\n"
+          "\n\n"
+          "/*  Only the first page of results (by section) is embedded in the page;\n"
+          "    the rest are fetched from /api/apropos, already sorted, as the reader\n"
+          "    scrolls towards the end of the list.  Generation is bumped whenever\n"
+          "    the list is rebuilt, so that a response for the old order is ignored.\n"
+          "*/\n"
+          "\n"
+          "let Generation = 0;\n"
+          "let nLoaded = 0;\n"
+          "let nTotal = 0;\n"
+          "let fLoading = false;\n"
+          "let PrevSection = null;\n"
+          "let CurrentTable = null;\n"
+          "let CurrentContainer = null;\n"
+          "\n"
+          "const Sentinel = document.createElement (\"div\");\n"
+          "const Observer = (\"IntersectionObserver\" in window)\n"
+          "                   ? new IntersectionObserver (OnSentinelVisible, { rootMargin: \"800px\" })\n"
+          "                   : null;\n"
+          "\n\n\n"
+          "function ShowSection\n"
+          "   (section,\n"
+          "    state)\n"
+          "\n"
+          "{\n"
+          "  let content = document.getElementById (`Section_${section}`);\n"
+          "  let fCurrentState = (content.getAttribute (\"State\") != \"HIDDEN\");\n"
+          "  let fShow;\n"
+          "\n\n"
+          "  switch (state)\n"
+          "  {\n"
+          "    case \"show\":     fShow = true;            break;\n"
+          "    case \"hide\":     fShow = false;           break;\n"
+          "    case \"toggle\":   fShow = !fCurrentState;  break;\n"
+          "    default:         return;\n"
+          "  }\n"
+          "\n\n"
+          "  if (fShow == fCurrentState)\n"
+          "    return;\n"
+          "\n"
+          "  let button = document.getElementById (`Section_${section}_HideButton`);\n"
+          "  let header = document.getElementById (`Section_${section}_HeaderBar`);\n"
+          "\n"
+          "  let v = fShow ? [ \"SHOWN\", `${content.scrollHeight}px` ]\n"
+          "                : [ \"HIDDEN\", \"0px\" ];\n"
+          "\n\n"
+          "  content.style.maxHeight = v [1];\n"
+          "  content.setAttribute (\"State\", v [0]);\n"
+          "  button.setAttribute (\"State\", v [0]);\n"
+          "  header.setAttribute (\"State\", v [0]);\n"
+          "}\n"
+          "\n\n"
+          "function ShowAll\n"
+          "   ()\n"
+          "\n"
+          "{\n"
+          "  if (SortMode !== \"bysection\")\n"
+          "    return;\n"
+          "\n"
+          "  for (let i = 0; i < nSections; i++)\n"
+          "  {\n"
+          "    ShowSection (i, \"show\");\n"
+          "  }\n"
+          "}\n"
+          "\n\n"
+          "function HideAll\n"
+          "   ()\n"
+          "\n"
+          "{\n"
+          "  if (SortMode !== \"bysection\")\n"
+          "    return;\n"
+          "\n"
+          "  for (let i = 0; i < nSections; i++)\n"
+          "  {\n"
+          "    ShowSection (i, \"hide\");\n"
+          "  }\n"
+          "}\n"
+          "\n\n"
+          "function AppendTableHeader\n"
+          "    (table)\n"
+          "\n"
+          "{\n"
+          "  let row, cell;\n"
+          "\n"
+          "  row = document.createElement (\"tr\");\n"
+          "  row.className = \"AproposTableHeader\";\n"
+          "  table.append (row);\n"
+          "\n"
+          "  cell = document.createElement (\"th\");\n"
+          "  cell.setAttribute (\"Column\", \"page\");\n"
+          "  cell.textContent = \"Page\";\n"
+          "  row.append (cell);\n"
+          "\n"
+          "  cell = document.createElement (\"th\");\n"
+          "  cell.setAttribute (\"Column\", \"description\");\n"
+          "  cell.textContent = \"Description\";\n"
+          "  row.append (cell);\n"
+          "}\n"
+          "\n\n\n"
+          "function AppendResults\n"
+          "    (page)\n"
+          "\n"
+          "{\n"
+          "  let fBySection = (SortMode === \"bysection\");\n"
+          "  let results = page.results, nResults = results.length;\n"
+          "  let bar, HideBtn, row, cell, content;\n"
+          "  let touched = [];\n"
+          "\n\n"
+          "  if (CurrentContainer)\n"
+          "  {\n"
+          "    touched.push (CurrentContainer);\n"
+          "  }\n"
+          "\n\n"
+          "  for (let i = 0; i < nResults; i++)\n"
+          "  {\n"
+          "    let [name, section, description] = results [i];\n"
+          "\n\n"
+          "    if (fBySection && (section != PrevSection))\n"
+          "    {\n"
+          "      let n = nSections;\n"
+          "      let ElementID = `Section_${n}`;\n"
+          "      let FullSectionTitle = SectionTitles [section.toLowerCase ()];\n"
+          "\n\n"
+          "      bar = document.createElement (\"div\");\n"
+          "      bar.id = ElementID + \"_HeaderBar\";\n"
+          "      bar.className = \"AproposSectionBar\";\n"
+          "      bar.textContent = (FullSectionTitle && (FullSectionTitle != \"\"))\n"
+          "                          ? `Section ${section}${TitleSeparator}${FullSectionTitle}`\n"
+          "                          : `Section ${section}`\n"
+          "      bar.setAttribute (\"State\", \"SHOWN\");\n"
+          "      ResultsDiv.append (bar);\n"
+          "\n"
+          "      HideBtn = document.createElement (\"span\");\n"
+          "      HideBtn.id = ElementID + \"_HideButton\";\n"
+          "      HideBtn.className = \"HideButton\";\n"
+          "      HideBtn.setAttribute (\"State\", \"SHOWN\");\n"
+          "      HideBtn.onclick = function (event) { ShowSection (n, \"toggle\"); };\n"
+          "      bar.append (HideBtn);\n"
+          "\n\n"
+          "      CurrentContainer = document.createElement (\"div\");\n"
+          "      CurrentContainer.id = ElementID;\n"
+          "      CurrentContainer.className = \"AproposContainer\";\n"
+          "      CurrentContainer.style.overflow = \"hidden\";\n"
+          "      ResultsDiv.append (CurrentContainer);\n"
+          "      touched.push (CurrentContainer);\n"
+          "\n\n"
+          "      CurrentTable = document.createElement (\"table\");\n"
+          "      CurrentTable.className = \"AproposTable\";\n"
+          "      CurrentContainer.append (CurrentTable);\n"
+          "\n\n"
+          "      row = document.createElement (\"tr\");\n"
+          "      row.className = \"AproposTableHeader\";\n"
+          "      CurrentTable.append (row);\n"
+          "\n"
+          "      AppendTableHeader (CurrentTable);\n"
+          "\n"
+          "      PrevSection = section;\n"
+          "      nSections++;\n"
+          "    }\n"
+          "\n\n"
+          "    let prefix = (name.indexOf (\":\") >= 0) ? UriPrefix : \"\";\n"
+          "\n"
+          "    row = document.createElement (\"tr\");\n"
+          "    row.className = \"AproposTableRow\";\n"
+          "    CurrentTable.append (row);\n"
+          "\n"
+          "    cell = document.createElement (\"td\");\n"
+          "    row.append (cell);\n"
+          "    content = document.createElement (\"a\");\n"
+          "    content.textContent = fBySection ? name : `${name}(${section})`;\n"
+          "    content.setAttribute (\"href\", `${prefix}man/${name}(${section})`);\n"
+          "    content.setAttribute (\"target\", \"_blank\");\n"
+          "    content.setAttribute (\"RefType\", \"manpage\");\n"
+          "    cell.append (content);\n"
+          "\n"
+          "    cell = document.createElement (\"td\");\n"
+          "    cell.textContent = description;\n"
+          "    row.append (cell);\n"
+          "  }\n"
+          "\n\n"
+          "  /*  Sections that are open and grew need a new height limit, or the\n"
+          "      rows just added would stay clipped.\n"
+          "  */\n"
+          "\n"
+          "  for (let container of touched)\n"
+          "  {\n"
+          "    if (container.getAttribute (\"State\") != \"HIDDEN\")\n"
+          "    {\n"
+          "      container.style.maxHeight = `${container.scrollHeight}px`;\n"
+          "    }\n"
+          "  }\n"
+          "\n\n"
+          "  nLoaded = page.offset + nResults;\n"
+          "  nTotal = page.total;\n"
+          "\n\n"
+          "  /*  Re-observing the sentinel makes the observer report it again even\n"
+          "      if it never left the viewport, so short pages keep loading.\n"
+          "  */\n"
+          "\n"
+          "  if (Observer)\n"
+          "  {\n"
+          "    Observer.unobserve (Sentinel);\n"
+          "  }\n"
+          "\n"
+          "  if ((nLoaded < nTotal) && (nResults > 0))\n"
+          "  {\n"
+          "    ResultsDiv.append (Sentinel);\n"
+          "\n"
+          "    if (Observer)\n"
+          "    {\n"
+          "      Observer.observe (Sentinel);\n"
+          "    }\n"
+          "    else\n"
+          "    {\n"
+          "      LoadMore ();\n"
+          "    }\n"
+          "  }\n"
+          "  else\n"
+          "  {\n"
+          "    Sentinel.remove ();\n"
+          "  }\n"
+          "}\n"
+          "\n\n\n"
+          "function LoadMore\n"
+          "    ()\n"
+          "\n"
+          "{\n"
+          "  if (fLoading)\n"
+          "    return;\n"
+          "\n"
+          "  let gen = Generation;\n"
+          "  let sort = (SortMode === \"byname\") ? \"name\" : \"section\";\n"
+          "  let query = encodeURIComponent (AproposQuery);\n"
+          "\n"
+          "  fLoading = true;\n"
+          "\n"
+          "  fetch (`/api/apropos?q=${query}&mode=regex&sort=${sort}`\n"
+          "           + `&offset=${nLoaded}&limit=${AproposPageSize}`)\n"
+          "    .then (function (response)\n"
+          "           {\n"
+          "             if (!response.ok)\n"
+          "               throw new Error (response.statusText);\n"
+          "\n"
+          "             return response.json ();\n"
+          "           })\n"
+          "    .then (function (page)\n"
+          "           {\n"
+          "             if (gen != Generation)\n"
+          "               return;\n"
+          "\n"
+          "             fLoading = false;\n"
+          "             AppendResults (page);\n"
+          "           })\n"
+          "    .catch (function (error)\n"
+          "            {\n"
+          "              if (gen == Generation)\n"
+          "              {\n"
+          "                fLoading = false;\n"
+          "              }\n"
+          "            });\n"
+          "}\n"
+          "\n\n\n"
+          "function OnSentinelVisible\n"
+          "    (entries)\n"
+          "\n"
+          "{\n"
+          "  for (let entry of entries)\n"
+          "  {\n"
+          "    if (entry.isIntersecting)\n"
+          "    {\n"
+          "      LoadMore ();\n"
+          "      return;\n"
+          "    }\n"
+          "  }\n"
+          "}\n"
+          "\n\n\n"
+          "function SetSortMode\n"
+          "   (mode)\n"
+          "\n"
+          "{\n"
+          "  let fBySection;\n"
+          "\n"
+          "  switch (mode)\n"
+          "  {\n"
+          "    case \"bysection\":   fBySection = true;   break;\n"
+          "    case \"byname\":      fBySection = false;  break;\n"
+          "    default:            return;\n"
+          "  }\n"
+          "\n"
+          "  if (SortMode === mode)\n"
+          "    return;\n"
+          "\n"
+          "  SortMode = mode;\n"
+          "\n\n"
+          "  if (fBySection)\n"
+          "  {\n"
+          "    ShowAllBtn.removeAttribute (\"Disabled\");\n"
+          "    HideAllBtn.removeAttribute (\"Disabled\");\n"
+          "    ByNameBtn.removeAttribute (\"Active\");\n"
+          "    BySectionBtn.setAttribute (\"Active\", \"1\");\n"
+          "  }\n"
+          "  else\n"
+          "  {\n"
+          "    ShowAllBtn.setAttribute (\"Disabled\", \"1\");\n"
+          "    HideAllBtn.setAttribute (\"Disabled\", \"1\");\n"
+          "    BySectionBtn.removeAttribute (\"Active\");\n"
+          "    ByNameBtn.setAttribute (\"Active\", \"1\");\n"
+          "  }\n"
+          "\n\n"
+          "  let elts = [... ResultsDiv.children];\n"
+          "  for (let i = elts.length - 1; i >= 0; i--)\n"
+          "  {\n"
+          "    ResultsDiv.removeChild (elts [i]);\n"
+          "  }\n"
+          "\n"
+          "  Generation++;\n"
+          "  fLoading = false;\n"
+          "  nLoaded = 0;\n"
+          "  nSections = 0;\n"
+          "  PrevSection = null;\n"
+          "  CurrentTable = null;\n"
+          "  CurrentContainer = null;\n"
+          "\n\n"
+          "  if (fBySection)\n"
+          "  {\n"
+          "    AppendResults (FirstPage);\n"
+          "  }\n"
+          "  else\n"
+          "  {\n"
+          "    CurrentTable = document.createElement (\"table\");\n"
+          "    CurrentTable.className = \"AproposTable\";\n"
+          "    ResultsDiv.append (CurrentTable);\n"
+          "\n"
+          "    AppendTableHeader (CurrentTable);\n"
+          "    LoadMore ();\n"
+          "  }\n"
+          "}\n"
+          "\n\n"
+          "ByNameBtn.onclick = function (event) { SetSortMode (\"byname\"); };\n"
+          "BySectionBtn.onclick = function (event) { SetSortMode (\"bysection\"); };\n"
+          "ShowAllBtn.onclick = ShowAll;\n"
+          "HideAllBtn.onclick = HideAll;\n"
+          "\n\n"
+          "SetSortMode (\"bysection\");\n"
+          "\n\n"
+          "let n = FirstPage.sections;\n"
+          "let text = (FirstPage.total == 1)\n"
+          "             ? \"1 page\" : `${FirstPage.total} pages in ${n} section${(n == 1) ? \"\" : \"s\"}`;\n"
+          "\n"
+          "document.getElementById (\"Nav-Apropos-NResults\").innerHTML\n"
+          "      = \"<span Label=\\\"\\\">Results:</span>\" + text;\n";
+
+
@@ -0,0 +1,19 @@
+static const unsigned char FavIcon [318]
+   = {0, 0, 1, 0, 1, 0, 16, 16, 16, 0, 1, 0, 4, 0, 40, 1, 0, 0, 22, 0, 0, 0,
+      40, 0, 0, 0, 16, 0, 0, 0, 32, 0, 0, 0, 1, 0, 4, 0, 0, 0, 0, 0, 128, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 5,
+      171, 5, 0, 80, 80, 80, 0, 223, 242, 255, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 34,
+      34, 34, 34, 34, 34, 34, 32, 33, 35, 51, 51, 51, 51, 51, 32, 33, 18, 51,
+      51, 51, 51, 51, 32, 33, 17, 35, 51, 51, 51, 51, 32, 33, 17, 18, 51, 51,
+      51, 51, 32, 33, 17, 17, 35, 51, 51, 51, 32, 33, 17, 17, 18, 51, 51, 51,
+      32, 33, 17, 17, 17, 35, 51, 51, 32, 33, 17, 17, 18, 51, 51, 51, 32, 33,
+      17, 17, 35, 51, 51, 51, 32, 33, 17, 18, 51, 51, 51, 51, 32, 33, 17, 35,
+      51, 51, 51, 51, 32, 33, 18, 51, 51, 51, 51, 51, 32, 33, 35, 51, 51, 51,
+      51, 51, 32, 34, 34, 34, 34, 34, 34, 34, 32, 255, 255, 0, 0, 0, 1, 0, 0,
+      0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0,
+      0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0,
+      0, 1, 0, 0, 0, 1, 0, 0};
+
+
@@ -0,0 +1,236 @@
+
+
+const char ManPageScript []
+        = "const SectionList = document.getElementById (\"SectionList\");\n"
+          "const fChrome = (/Chrome/i).test (window.navigator.userAgent);\n"
+          "\n\n"
+          "let idTimeout = -1;\n"
+          "\n\n\n"
+          "function ShowSection\n"
+          "    (n,\n"
+          "     state)\n"
+          "\n"
+          "{\n"
+          "  let idSection = `Sec${n}`;\n"
+          "  let content = document.getElementById (idSection);\n"
+          "  let fCurrentState = (content.getAttribute (\"State\") != \"HIDDEN\");\n"
+          "  let fShow;\n"
+          "\n"
+          "  switch (state)\n"
+          "  {\n"
+          "    case \"show\":     fShow = true;            break;\n"
+          "    case \"hide\":     fShow = false;           break;\n"
+          "    case \"toggle\":   fShow = !fCurrentState;  break;\n"
+          "    default:         return;\n"
+          "  }\n"
+          "\n"
+          "  if (fShow == fCurrentState)\n"
+          "    return;\n"
+          "\n\n"
+          "  if (fShow && content.hasAttribute (\"Lazy\"))\n"
+          "  {\n"
+          "    LoadSection (n, content);\n"
+          "  }\n"
+          "\n\n"
+          "  let header = document.getElementById (idSection + \"_Header\");\n"
+          "  let button = document.getElementById (idSection + \"_ShowBtn\");\n"
+          "\n"
+          "  let v = fShow ? [ \"SHOWN\", `${content.scrollHeight}px`]\n"
+          "                : [ \"HIDDEN\", \"0px\" ];\n"
+          "\n\n"
+          "  content.setAttribute (\"State\", v [0]);\n"
+          "  content.style.maxHeight = v [1];\n"
+          "\n"
+          "  header.setAttribute (\"State\", v [0]);\n"
+          "  button.setAttribute (\"State\", v [0]);\n"
+          "}\n"
+          "\n\n\n"
+          "/*  Sections marked \"Lazy\" were left out of the page, and are fetched\n"
+          "    the first time they are shown.\n"
+          "*/\n"
+          "\n"
+          "function LoadSection\n"
+          "    (n,\n"
+          "     content)\n"
+          "\n"
+          "{\n"
+          "  content.removeAttribute (\"Lazy\");\n"
+          "\n"
+          "  fetch (`${window.location.pathname}/section/${n}`)\n"
+          "    .then (function (response)\n"
+          "           {\n"
+          "             if (!response.ok)\n"
+          "               throw new Error (response.statusText);\n"
+          "\n"
+          "             return response.text ();\n"
+          "           })\n"
+          "    .then (function (text)\n"
+          "           {\n"
+          "             content.innerHTML = text;\n"
+          "\n"
+          "             if (content.getAttribute (\"State\") == \"SHOWN\")\n"
+          "             {\n"
+          "               content.style.maxHeight = `${content.scrollHeight}px`;\n"
+          "             }\n"
+          "           })\n"
+          "    .catch (function (error)\n"
+          "            {\n"
+          "              content.setAttribute (\"Lazy\", \"\");\n"
+          "            });\n"
+          "}\n"
+          "\n\n\n"
+          "function GoToSection\n"
+          "    (n)\n"
+          "\n"
+          "{\n"
+          "  let header = document.getElementById (`Sec${n}_Header`);\n"
+          "  let y = Math.max (0, header.offsetTop - header.clientHeight - 15);\n"
+          "\n\n"
+          "  if (fChrome)\n"
+          "  {\n"
+          "    window.scrollTo (0, y);\n"
+          "  }\n"
+          "  else\n"
+          "  {\n"
+          "    window.scrollTo ({ top: y, left: 0, behavior: \"smooth\" });\n"
+          "  }\n"
+          "\n"
+          "  ShowSection (n, \"show\");\n"
+          "}\n"
+          "\n\n"
+          "function ShowAll\n"
+          "    (event)\n"
+          "\n"
+          "{\n"
+          "  for (let i = 1; i <= nSections; i++)\n"
+          "  {\n"
+          "    ShowSection (i, \"show\");\n"
+          "  }\n"
+          "}\n"
+          "\n\n"
+          "function HideAll\n"
+          "    (event)\n"
+          "\n"
+          "{\n"
+          "  for (let i = 1; i <= nSections; i++)\n"
+          "  {\n"
+          "    ShowSection (i, \"hide\");\n"
+          "  }\n"
+          "}\n"
+          "\n\n"
+          "function HandleSelection\n"
+          "    (event)\n"
+          "\n"
+          "{\n"
+          "  let idSection = +(this.value);\n"
+          "  if (!idSection || (idSection == NaN) || (idSection <= 0))\n"
+          "    return;\n"
+          "\n"
+          "  GoToSection (idSection);\n"
+          "\n\n"
+          "  if (idTimeout > 0)\n"
+          "  {\n"
+          "    window.clearTimeout (idTimeout);\n"
+          "  }\n"
+          "\n"
+          "  idTimeout = window.setTimeout\n"
+          "                  (function () {  SectionList.value = \"x\";  idTimeout = -1;  },\n"
+          "                   3000);\n"
+          "}\n"
+          "\n\n\n"
+          "/*  The pages that refer to this one come from the backlink index, and\n"
+          "    are listed after the last section (the way SEE ALSO lists the ones\n"
+          "    it refers to) if there are any.\n"
+          "*/\n"
+          "\n"
+          "function LoadBacklinks\n"
+          "    ()\n"
+          "\n"
+          "{\n"
+          "  let path = window.location.pathname;\n"
+          "  let title = decodeURIComponent (path.substring (path.indexOf (\"/man/\") + 5));\n"
+          "\n"
+          "  fetch (`/api/backlinks?page=${encodeURIComponent (title)}`)\n"
+          "    .then (function (response)\n"
+          "           {\n"
+          "             if (!response.ok)\n"
+          "               throw new Error (response.statusText);\n"
+          "\n"
+          "             return response.json ();\n"
+          "           })\n"
+          "    .then (function (answer)\n"
+          "           {\n"
+          "             if (answer.total > 0)\n"
+          "             {\n"
+          "               ShowBacklinks (answer.results);\n"
+          "             }\n"
+          "           })\n"
+          "    .catch (function (error)\n"
+          "            {\n"
+          "            });\n"
+          "}\n"
+          "\n\n\n"
+          "function ShowBacklinks\n"
+          "    (results)\n"
+          "\n"
+          "{\n"
+          "  let container = document.getElementById (\"Backlinks\");\n"
+          "  let header = document.createElement (\"div\");\n"
+          "  let body = document.createElement (\"div\");\n"
+          "  let pre = document.createElement (\"pre\");\n"
+          "  let column = 7;\n"
+          "\n"
+          "  header.className = \"HeaderBar\";\n"
+          "  header.textContent = \"Referenced by\";\n"
+          "  body.className = \"Collapsible\";\n"
+          "  pre.append (\"       \");\n"
+          "\n"
+          "  for (let i = 0; i < results.length; i++)\n"
+          "  {\n"
+          "    let [name, section] = results [i];\n"
+          "    let text = `${name}(${section})`;\n"
+          "    let prefix = (name.indexOf (\":\") >= 0) ? document.baseURI : \"\";\n"
+          "\n"
+          "    if (i > 0)\n"
+          "    {\n"
+          "      let fWrap = (column + text.length + 2 > 78);\n"
+          "\n"
+          "      pre.append (fWrap ? \",\\n       \" : \", \");\n"
+          "      column = fWrap ? 7 : column + 2;\n"
+          "    }\n"
+          "\n"
+          "    let link = document.createElement (\"a\");\n"
+          "    link.textContent = text;\n"
+          "    link.setAttribute (\"href\", `${prefix}man/${name}(${section})`);\n"
+          "    link.setAttribute (\"RefType\", \"manpage\");\n"
+          "    pre.append (link);\n"
+          "\n"
+          "    column += text.length;\n"
+          "  }\n"
+          "\n"
+          "  body.append (pre);\n"
+          "  container.append (header, body);\n"
+          "  container.hidden = false;\n"
+          "}\n"
+          "\n\n\n"
+          "for (let e of document.getElementsByClassName (\"Collapsible\"))\n"
+          "{\n"
+          "  let state = e.hasAttribute (\"Lazy\") ? \"HIDDEN\" : \"SHOWN\";\n"
+          "\n"
+          "  e.setAttribute (\"State\", state);\n"
+          "  document.getElementById (e.id + \"_Header\").setAttribute (\"State\", state);\n"
+          "  document.getElementById (e.id + \"_ShowBtn\").setAttribute (\"State\", state);\n"
+          "\n"
+          "  if (state == \"HIDDEN\")\n"
+          "  {\n"
+          "    e.style.maxHeight = \"0px\";\n"
+          "  }\n"
+          "}\n"
+          "\n"
+          "document.getElementById (\"ShowAllBtn\").addEventListener (\"click\", ShowAll, false);\n"
+          "document.getElementById (\"HideAllBtn\").addEventListener (\"click\", HideAll, false);\n"
+          "SectionList.addEventListener (\"input\", HandleSelection, false);\n"
+          "\n"
+          "LoadBacklinks ();\n";
+
+
@@ -0,0 +1,163 @@
+
+
+const char SplashText []
+        = "<div class=\"PageTitle\" style=\"margin-bottom: 50px;\">\n"
+          "This is MANHTTP.\n"
+          "</div>\n"
+          "\n"
+          "<div class=\"Splash\">\n"
+          "<p style=\"margin-bottom: 25px;\">\n"
+          "MANHTTP is an HTTP server that lets you browse and search your system's\n"
+          "online documentation &mdash; man pages and Info documents &mdash;\n"
+          "using a web browser.  It is a web-based frontend for\n"
+          "<a href=\"man/man(1)\">man(1)</a>,\n"
+          "<a href=\"man/info(1)\">info(1)</a>, and\n"
+          "<a href=\"man/apropos(1)\">apropos(1)</a>.\n"
+          "</p>\n"
+          "\n"
+          "<input id=\"SearchInput\" autofocus type=\"text\" list=\"PageNames\" autocomplete=\"off\" style=\"width: 180px;\">\n"
+          "<datalist id=\"PageNames\"></datalist>\n"
+          "&ensp;\n"
+          "<select id=\"Mode\">\n"
+          "  <option value=\"m\">Manual page</option>\n"
+          "  <option value=\"i\">Info</option>\n"
+          "  <option value=\"a\">Apropos search</option>\n"
+          "  <option value=\"s\">Full-text search</option>\n"
+          "  <option value=\"x\">Info index search</option>\n"
+          "</select>\n"
+          "\n"
+          "<div class=\"Divider\"></div>\n"
+          "\n"
+          "<p style=\"margin-bottom: 10px;\">\n"
+          "To access manual pages, info documents, and apropos results\n"
+          "directly, you can point your browser to the following URLs.\n"
+          "</p>\n"
+          "To view a manual page:\n"
+          "<div class=\"Code\" style=\"margin-left: 6px;\" URI=\"1\">man/<span Var=\"1\">page-title</span>\n"
+          "</div>\n"
+          "<br>\n"
+          "To view an info document:\n"
+          "<div class=\"Code\" style=\"margin-left: 6px;\" URI=\"1\">info/<span Var=\"1\">package-or-command-name</span></div>\n"
+          "<br>\n"
+          "To perform an apropos search:\n"
+          "<div class=\"Code\" style=\"margin-left: 6px;\" URI=\"1\">apropos/<span Var=\"1\">search-term</span></div>\n"
+          "<br>\n"
+          "To search the text of the manual pages:\n"
+          "<div class=\"Code\" style=\"margin-left: 6px;\" URI=\"1\">search?q=<span Var=\"1\">words</span></div>\n"
+          "<br>\n"
+          "To search the indices of the info documents:\n"
+          "<div class=\"Code\" style=\"margin-left: 6px;\" URI=\"1\">info-search?q=<span Var=\"1\">text</span></div>\n"
+          "\n"
+          "<div style=\"margin-top: 20px; display: flex; flex-direction: row-reverse;\">\n"
+          "  <div style=\"font-size: 70%;\">\n"
+          "    <a href=\"https://www.github.com/jstewart3530/manhttp\">GitHub</a>\n"
+          "  </div>\n"
+          "</div>\n"
+          "</div>\n"
+          "\n\n"
+          "<script>\n"
+          "\"use strict\";\n"
+          "const BaseURL = document.head.getElementsByTagName (\"base\") [0].href;\n"
+          "const SearchInput = document.getElementById (\"SearchInput\");\n"
+          "const ModeSelect = document.getElementById (\"Mode\");\n"
+          "const PageNameList = document.getElementById (\"PageNames\");\n"
+          "\n"
+          "let nCompletionRequests = 0;\n"
+          "\n\n"
+          "function HandleKeyPress\n"
+          "   (event)\n"
+          "\n"
+          "{\n"
+          "  if (event.isComposing || event.keyCode === 229)\n"
+          "    return;\n"
+          "\n"
+          "  if (event.code === \"Enter\")\n"
+          "  {\n"
+          "    let text, prefix;\n"
+          "\n"
+          "    if ((text = SearchInput.value.trim ()) === \"\")\n"
+          "      return;\n"
+          "\n"
+          "    if (ModeSelect.value === \"s\")\n"
+          "    {\n"
+          "      window.open (`${BaseURL}search?q=${encodeURIComponent (text)}`, \"_self\");\n"
+          "      return;\n"
+          "    }\n"
+          "\n"
+          "    if (ModeSelect.value === \"x\")\n"
+          "    {\n"
+          "      window.open (`${BaseURL}info-search?q=${encodeURIComponent (text)}`, \"_self\");\n"
+          "      return;\n"
+          "    }\n"
+          "\n"
+          "    switch (ModeSelect.value)\n"
+          "    {\n"
+          "      case \"m\":  prefix = \"man\";      break;\n"
+          "      case \"i\":  prefix = \"info\";     break;\n"
+          "      case \"a\":  prefix = \"apropos\";  break;\n"
+          "      default:   return;\n"
+          "    }\n"
+          "\n"
+          "    window.open (`${BaseURL}${prefix}/${text}`, \"_self\");\n"
+          "  }\n"
+          "}\n"
+          "\n\n"
+          "/*  Offers the names of manual pages that begin with what has been typed\n"
+          "    so far.  A reply that arrives after a later keystroke is ignored.\n"
+          "*/\n"
+          "\n"
+          "function UpdateCompletions\n"
+          "   (event)\n"
+          "\n"
+          "{\n"
+          "  let text = SearchInput.value.trim ();\n"
+          "  let n = ++nCompletionRequests;\n"
+          "\n"
+          "  if ((ModeSelect.value !== \"m\") || (text === \"\"))\n"
+          "  {\n"
+          "    PageNameList.replaceChildren ();\n"
+          "    return;\n"
+          "  }\n"
+          "\n"
+          "  fetch (`${BaseURL}api/complete?prefix=${encodeURIComponent (text)}`)\n"
+          "    .then (function (response)\n"
+          "           {\n"
+          "             if (!response.ok)\n"
+          "               throw new Error (response.statusText);\n"
+          "\n"
+          "             return response.json ();\n"
+          "           })\n"
+          "    .then (function (reply)\n"
+          "           {\n"
+          "             if (n != nCompletionRequests)\n"
+          "               return;\n"
+          "\n"
+          "             let options = [];\n"
+          "\n"
+          "             for (let [name, section] of reply.results)\n"
+          "             {\n"
+          "               let option = document.createElement (\"option\");\n"
+          "               option.value = `${name}(${section})`;\n"
+          "               options.push (option);\n"
+          "             }\n"
+          "\n"
+          "             PageNameList.replaceChildren (... options);\n"
+          "           })\n"
+          "    .catch (function (error)\n"
+          "            {\n"
+          "            });\n"
+          "}\n"
+          "\n\n"
+          "for (let elt of document.querySelectorAll (\"*[URI]\"))\n"
+          "{\n"
+          "  elt.innerHTML = BaseURL + elt.innerHTML;\n"
+          "}\n"
+          "\n\n"
+          "ModeSelect.value = \"m\";\n"
+          "\n\n"
+          "document.addEventListener (\"keydown\", HandleKeyPress, false);\n"
+          "SearchInput.addEventListener (\"input\", UpdateCompletions, false);\n"
+          "ModeSelect.addEventListener (\"change\", UpdateCompletions, false);\n"
+          "</script>\n";
+
+
@@ -0,0 +1,191 @@
+
+
+const char DefaultStylesheet []
+        = "body { background: #fff2df; color: #454545; }\n"
+          "\n"
+          "pre { font-family: Hack, \"Ubuntu Mono\", \"DejaVu Sans Mono\", Monaco, \"Lucida Console\", monospace; font-size: 15px; }\n"
+          "\n"
+          "span[Bold] { font-weight: bold; }\n"
+          "\n"
+          "span[Ital] { font-style: italic; }\n"
+          "\n"
+          "a[RefType=\"uri\"], a[RefType=\"uri\"]:visited { color: #006500; text-decoration: none; }\n"
+          "\n"
+          "a[RefType=\"uri\"]:hover { text-decoration: 1px underline solid; }\n"
+          "\n"
+          ".HideButton { display: inline-block; cursor: default; height: inherit; line-height: inherit; border: none; font-family: Roboto, "
+            "\"Amazon Ember\", \"Clear Sans\", Lato, \"Source Sans Pro\", sans-serif; font-size: 12px; font-style: normal; background: inheri"
+            "t; color: inherit; float: right; margin-left: 40px; margin-right: 10px; }\n"
+          "\n"
+          ".HideButton:hover { text-decoration: underline solid; }\n"
+          "\n"
+          ".HideButton[State=\"SHOWN\"]::after { content: \"[Hide\\00a0\\25b2]\"; }\n"
+          "\n"
+          ".HideButton[State=\"HIDDEN\"]::after { content: \"[Show\\00a0\\25bc]\"; }\n"
+          "\n"
+          "#NavBar { display: flex; flex-flow: row wrap; justify-content: flex-start; position: fixed; top: 0; width: 100%; min-height: 40p"
+            "x; line-height: 40px; margin-left: -10px; margin-right: 0px; padding-left: 15px; padding-right: 15px; font-family: \"Roboto Cond"
+            "ensed\", Roboto, \"Amazon Ember\", \"Clear Sans\", Lato, \"Source Sans Pro\", sans-serif; font-style: normal; font-weight: norma"
+            "l; font-size: 14px; color: #ffffff; background: #404040; text-align: left; border-bottom: 1px solid #000000; }\n"
+          "\n"
+          "#NavBar > div { height: 40px; line-height: 40px; padding-left: 16px; padding-right: 5px; margin-left: 16px; border-left: 1px sol"
+            "id #909090; }\n"
+          "\n"
+          "#NavBar > div:nth-child(1) { border-left: none; padding-left: 0px; margin-left: 0px; }\n"
+          "\n"
+          "#NavBar span[Label] { color: #909090; font-style: italic; }\n"
+          "\n"
+          "#NavBar span[Label]::after { content: \"\\00a0\\00a0\"; }\n"
+          "\n"
+          "#NavBar a, #NavBar a:visited { color: #ffff00; text-decoration: none; }\n"
+          "\n"
+          "#NavBar a:hover { text-decoration: underline; }\n"
+          "\n"
+          "#NavBar .Button { display: inline-block; cursor: default; border: 1px solid #909090; height: 24px; line-height: 24px; padding-le"
+            "ft: 6px; padding-right: 6px; color: white; background: #535353; text-align: center; }\n"
+          "\n"
+          "#NavBar .Button:hover { background: green; }\n"
+          "\n"
+          "#NavBar .Button[Disabled], #NavBar .Button[Disabled]:hover { color: #757575; background: #535353; }\n"
+          "\n"
+          "#NavBar .Button[Active]::before { content: \"[\"; }\n"
+          "\n"
+          "#NavBar .Button[Active]::after { content: \"]\"; }\n"
+          "\n"
+          "#NavBar select { background: inherit; color: #ffffff; border: 1px solid #909090; font-size: 85%; }\n"
+          "\n"
+          "#NavBar select:hover { background: #707070; }\n"
+          "\n"
+          "body[Type=\"man\"] #Main { margin-left: 64px; margin-top: 80px; padding-bottom: 80px; }\n"
+          "\n"
+          "body[Type=\"man\"] pre { padding-left: 4px; }\n"
+          "\n"
+          "body[Type=\"man\"] pre a[RefType=\"manpage\"] { color: inherit; background: #ffe0b3; text-decoration: none; }\n"
+          "\n"
+          "body[Type=\"man\"] pre a[RefType=\"manpage\"]:hover { color: #006500; text-decoration: 1px underline solid; }\n"
+          "\n"
+          "body[Type=\"man\"] .PageTitle { display: inline-block; height: 50px; line-height: 50px; font-family: \"Roboto Condensed\", Robot"
+            "o, \"Amazon Ember\", \"Clear Sans\", Lato, \"Source Sans Pro\", sans-serif; font-style: italic; font-weight: bold; font-size: 40"
+            "px; color: #405d27; margin-left: 4px; margin-bottom: 60px; }\n"
+          "\n"
+          "body[Type=\"man\"] #Prologue { margin-bottom: 35px; }\n"
+          "\n"
+          "body[Type=\"man\"] div.Collapsible { overflow: hidden; margin-top: 5px; margin-bottom: 35px; }\n"
+          "\n"
+          "body[Type=\"man\"] div.Collapsible[State=\"HIDDEN\"] { margin-top: 0px; margin-bottom: 0px; }\n"
+          "\n"
+          "body[Type=\"man\"] .HeaderBar { display: inline-block; font-family: \"Roboto Condensed\", Roboto, \"Amazon Ember\", \"Clear Sans"
+            "\", Lato, \"Source Sans Pro\", sans-serif; font-size: 20px; font-style: italic; font-weight: normal; color: white; background: #"
+            "405d27; width: 680px; height: 38px; line-height: 38px; padding-left: 14px; text-align: left; margin-top: 0px; }\n"
+          "\n"
+          "body[Type=\"man\"] .HeaderBar[State=\"HIDDEN\"] { border-bottom: 1px solid #fff2df; }\n"
+          "\n"
+          "body[Type=\"info\"] #Main { margin-left: 64px; margin-top: 80px; padding-bottom: 80px; }\n"
+          "\n"
+          "body[Type=\"info\"] pre a[RefType=\"info\"] { color: #031f84; text-decoration: none; }\n"
+          "\n"
+          "body[Type=\"info\"] pre a[RefType=\"info\"]:hover { text-decoration: 1px underline solid; }\n"
+          "\n"
+          "body[Type=\"info\"] .InfoTitle { display: inline-block; max-width: 500px; font-family: \"Roboto Condensed\", Roboto, \"Amazon Em"
+            "ber\", \"Clear Sans\", Lato, \"Source Sans Pro\", sans-serif; font-style: italic; font-weight: normal; color: white; background:"
+            " #405d27; padding-left: 30px; padding-right: 30px; margin-bottom: 40px; font-size: 18px; padding-top: 5px; padding-bottom: 5px; "
+            "}\n"
+          "\n"
+          "body[Type=\"info\"] .InfoTitle > span[Number] { color: white; font-family: Roboto, \"Amazon Ember\", \"Clear Sans\", Lato, \"Sou"
+            "rce Sans Pro\", sans-serif; font-weight: bold; }\n"
+          "\n"
+          "body[Type=\"info\"] .InfoTitle > span[Number]::after { content: \"\\00a0\\00a0\\00a0\"; }\n"
+          "\n"
+          "body[Type=\"info\"] .InfoTitle[ULType=\"star\"], body[Type=\"info\"] .InfoTitle[ULType=\"equals\"] { font-size: 25px; padding-to"
+            "p: 5px; padding-bottom: 5px; }\n"
+          "\n"
+          "body[Type=\"info\"] .InfoFootnotes { margin-top: 10px; }\n"
+          "\n"
+          "body[Type=\"info\"] .InfoFootnotes > .Separator { display: inline-block; width: 200px; border-top: 1px solid #c3c3c3; margin-bot"
+            "tom: 15px; }\n"
+          "\n"
+          "body[Type=\"info\"] .InfoFootnotes > pre { font-size: 80%; }\n"
+          "\n"
+          "body[Type=\"apropos\"] { font-family: Roboto, \"Amazon Ember\", \"Clear Sans\", Lato, \"Source Sans Pro\", sans-serif; font-size"
+            ": 15px; }\n"
+          "\n"
+          "body[Type=\"apropos\"] #Main { width: calc(100% - 160px); margin-left: 80px; margin-top: 80px; padding-bottom: 80px; }\n"
+          "\n"
+          "body[Type=\"apropos\"] #ByNameButton, body[Type=\"apropos\"] #BySectionButton { width: 5em; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposSectionBar { display: inline-block; font-family: \"Roboto Condensed\", Roboto, \"Amazon Ember\", "
+            "\"Clear Sans\", Lato, \"Source Sans Pro\", sans-serif; font-size: 20px; font-style: italic; font-weight: normal; color: white; b"
+            "ackground: #405d27; width: calc(100% - 12px); height: 38px; line-height: 38px; padding-left: 14px; text-align: left; margin-top:"
+            " 0px; margin-left: 2px; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposSectionBar[State=\"HIDDEN\"] { border-bottom: 1px solid #fff2df; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposContainer { width: 100%; margin-top: 0px; margin-bottom: 45px; margin-left: 0px; margin-right: 0p"
+            "x; padding-left: 0px; padding-right: 0px; padding-top: 0px; padding-bottom: 0px; border-style: none; overflow: hidden; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposContainer[State=\"HIDDEN\"] { margin-bottom: 0px; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposTable { font-family: Roboto, \"Amazon Ember\", \"Clear Sans\", Lato, \"Source Sans Pro\", sans-se"
+            "rif; font-size: 15px; border-collapse: separate; border-bottom: 2px solid #a2836e; width: 100%; margin-left: 0px; margin-top: 0p"
+            "x; padding-left: 0px; padding-right: 0px; padding-top: 0px; padding-bottom: 0px; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposTableHeader { font-family: inherit; font-style: italic; font-weight: bold; font-size: 15px; color"
+            ": #454545; background: #ffe0b3; text-align: left; margin-left: 0px; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposTableHeader > th { padding-top: 6px; padding-bottom: 6px; padding-left: 10px; border-top: 2px sol"
+            "id #a2836e; border-bottom: 2px solid #a2836e; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposTableHeader > th[Column=\"page\"] { width: 2in; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposTableHeader > th[Column=\"description\"] { width: 5in; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposTableRow { color: #454545; margin-left: 0px; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposTableRow:nth-child(even) { background: #ffe0b3; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposTableRow:nth-child(odd) { background: #fff2df; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposTableRow > td { font-size: 15px; padding-left: 8px; padding-right: 8px; padding-bottom: 4px; padd"
+            "ing-top: 4px; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposTableRow > td a { color: #006500; text-decoration: none; }\n"
+          "\n"
+          "body[Type=\"apropos\"] .AproposTableRow > td a:hover { text-decoration: 1px underline solid; }\n"
+          "\n"
+          "body[Type=\"splash\"] { font-family: Roboto, \"Amazon Ember\", \"Clear Sans\", Lato, \"Source Sans Pro\", sans-serif; font-size:"
+            " 16px; margin-left: 75px; margin-top: 75px; }\n"
+          "\n"
+          "body[Type=\"splash\"] > .PageTitle { font-family: \"Roboto Condensed\", Roboto, \"Amazon Ember\", \"Clear Sans\", Lato, \"Source"
+            " Sans Pro\", sans-serif; font-size: 48px; font-style: italic; font-weight: bold; color: #c3c3c3; margin-bottom: 20px; }\n"
+          "\n"
+          "body[Type=\"splash\"] .Splash { width: 80%; max-width: 7.5in; padding-left: 24px; padding-right: 24px; padding-top: 18px; paddin"
+            "g-bottom: 20px; margin-bottom: 50px; color: #454545; background: #ffe0b3; border-left: 5px solid #a2836e; }\n"
+          "\n"
+          "body[Type=\"splash\"] .Splash[IsError] { width: 500px; max-width: 500px; }\n"
+          "\n"
+          "body[Type=\"splash\"] .Splash pre[ErrorInfo] { font-family: inherit; font-style: inherit; font-weight: inherit; font-size: 85%; "
+            "margin-left: 10px; }\n"
+          "\n"
+          "body[Type=\"splash\"] .Splash > p[Heading] { font-size: 24px; font-weight: bold; font-style: italic; margin-top: 0px; margin-bot"
+            "tom: 15px; }\n"
+          "\n"
+          "body[Type=\"splash\"] .Splash > .Divider { margin-top: 18px; margin-bottom: 18px; border-bottom: 1px dashed #a2836e; }\n"
+          "\n"
+          "body[Type=\"splash\"] .Splash input { height: 25px; border: 1px solid #454545; border-radius: 0px; padding-left: 8px; padding-ri"
+            "ght: 8px; }\n"
+          "\n"
+          "body[Type=\"splash\"] .Splash select { height: 30px; background: #404040; color: #ffffff; border: 1px solid #909090; }\n"
+          "\n"
+          "body[Type=\"splash\"] .Splash .Filename { color: #000000; font-style: italic; }\n"
+          "\n"
+          "body[Type=\"splash\"] .Splash .Code { font-family: \"Roboto Condensed\", Roboto, \"Amazon Ember\", \"Clear Sans\", Lato, \"Sourc"
+            "e Sans Pro\", sans-serif; display: inline-block; color: #505050; background: #eeeeee; margin-top: 4px; margin-bottom: 4px; paddi"
+            "ng: 8px; border: 1px dashed #505050; }\n"
+          "\n"
+          "body[Type=\"splash\"] .Splash .Code > span[Var] { color: #00a0a0; font-style: italic; }\n"
+          "\n"
+          "body[Type=\"splash\"] .Splash a, body[Type=\"splash\"] .Splash a:visited { color: #006500; text-decoration: none; }\n"
+          "\n"
+          "body[Type=\"splash\"] .Splash a:hover { text-decoration: 1px underline solid; }\n";
+
+
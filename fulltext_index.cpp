@@ -0,0 +1,1467 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#include <stdlib.h>                    /*  C/C++ RTL headers.  */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "utility.h"                   /*  Application headers.  */
+#include "arena.h"
+#include "documentation_api.h"
+#include "manualpagetohtml.h"
+#include "name_index.h"
+#include "index_file.h"
+#include "backlink_index.h"
+#include "fulltext_index.h"
+
+
+
+#define INDEX_MAGIC          "MHFTX002"
+
+#define MAX_INDEX_AGE        (24 * 3600)   /*  Seconds.  */
+
+#define MIN_TERM_LENGTH      2
+#define MAX_TERM_LENGTH      48
+#define MAX_QUERY_TERMS      16
+
+#define BUILD_THREADS        2
+
+#define NAME_WEIGHT          4             /*  Term count multipliers.  */
+#define SYNOPSIS_WEIGHT      2
+
+#define BM25_K1              1.2
+#define BM25_B               0.75
+
+#define SNIPPET_SIZE         320
+#define EXCERPT_SIZE         640
+
+
+
+/*  While an index is being built, each page's words are counted on 
+*   their own, then added to the shared term table and posting list 
+*   under BuildLock.  Postings are collected unsorted, since the pages
+*   are done by several threads at once, and sorted when the file is 
+*   written.  Each page's excerpt (see IndexPage()) is kept with its
+*   length, to be written out with the names.  If there is a backlink 
+*   file to build too, each page's text is also given to pBacklinks.
+*/
+
+struct BUILDPOSTING
+{
+  uint32_t  term;
+  uint32_t  doc;
+  uint32_t  count;
+};
+
+
+struct BUILDSTATE
+{
+  char             *pIndexFile;         /*  Either may be NULL.  */
+  char             *pBacklinkFile;
+  const NAMEINDEX  *pNames;
+  int               iNextDoc;
+  uint32_t         *pDocLengths;
+  char            **ppExcerpts;
+  char             *pTermText;
+  size_t            cbTermText;
+  size_t            cbTermTextAllocated;
+  uint32_t         *pTermOffsets;
+  int               nTerms;
+  int               nTermsAllocated;
+  uint32_t         *pTermHash;          /*  Term number + 1, or 0.  */
+  int               cTermHash;
+  BUILDPOSTING     *pPostings;
+  size_t            nPostings;
+  size_t            nPostingsAllocated;
+  PAGEHASHSET       PageHashes;         /*  To skip pages seen under another name.  */
+  BACKLINKBUILDER  *pBacklinks;
+  pthread_mutex_t   BuildLock;
+};
+
+
+struct PAGETERM
+{
+  const char  *pTerm;
+  int          cbTerm;
+  uint32_t     hash;
+  uint32_t     count;
+};
+
+
+
+/*  Function prototypes.
+*/
+
+static bool BuildNewIndex (void*, void**);
+static void* BuildWorker (void*);
+static void IndexPage (BUILDSTATE*, int, ARENA*);
+static uint32_t InternTerm (BUILDSTATE*, const char*, int, uint32_t);
+static bool WriteIndexFile (BUILDSTATE*, const char*);
+static int CompareTermOrder (const void*, const void*, void*);
+static int ComparePostings (const void*, const void*);
+static void* LoadIndexFile (const char*);
+static bool ValidateIndex (const FULLTEXTINDEX*, size_t);
+static void FreeIndex (void*);
+static int FindTerm (const FULLTEXTINDEX*, const char*);
+static int GetQueryTerms (const char*, char [] [MAX_TERM_LENGTH + 1]);
+static int CompareHits (const void*, const void*);
+static uint32_t HashBytes (const char*, int);
+
+
+
+static SHAREDINDEX Index = SHARED_INDEX_INITIALIZER (FreeIndex, MAX_INDEX_AGE);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              IsWordChar
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Words are runs of letters, digits and underscores, so that names like
+*   SO_REUSEPORT stay whole.  Bytes of multibyte characters count as 
+*   letters.
+*/
+
+static inline
+bool IsWordChar
+   (unsigned char  c)
+
+{
+  return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'))
+           || ((c >= '0') && (c <= '9')) || (c == '_') || (c >= 0x80);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               FoldWord
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Copies a word, lowercasing ASCII letters.  pDest must have room for
+*   cbWord + 1 bytes.
+*/
+
+static inline
+void FoldWord
+   (const char  *pWord,
+    int          cbWord,
+    char        *pDest)
+
+{
+  int i;
+  unsigned char c;
+
+
+  for (i = 0; i < cbWord; i++)
+  {
+    c = pWord [i];
+    pDest [i] = ((c >= 'A') && (c <= 'Z')) ? (c + ('a' - 'A')) : c;
+  }
+
+  pDest [cbWord] = '\0';
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               PutVarint
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Postings are stored seven bits to a byte, low bits first, with the 
+*   high bit set on every byte but the last.  Returns the number of 
+*   bytes written (at most 5).
+*/
+
+static inline
+int PutVarint
+   (unsigned char  *pDest,
+    uint32_t        value)
+
+{
+  int n = 0;
+
+
+  while (value >= 0x80)
+  {
+    pDest [n++] = (unsigned char) (value | 0x80);
+    value >>= 7;
+  }
+
+  pDest [n++] = (unsigned char) value;
+  return n;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               GetVarint
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns NULL if the number runs past pEnd or is too long.
+*/
+
+static inline
+const unsigned char* GetVarint
+   (const unsigned char  *p,
+    const unsigned char  *pEnd,
+    uint32_t             *pValueOut)
+
+{
+  uint32_t value = 0;
+  int shift;
+
+
+  for (shift = 0; (p < pEnd) && (shift < 35); shift += 7)
+  {
+    value |= (uint32_t) (*p & 0x7f) << shift;
+
+    if ((*p++ & 0x80) == 0)
+    {
+      *pValueOut = value;
+      return p;
+    }
+  }
+
+  return NULL;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                  StartFullTextIndexBuild
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  The first call maps the existing index files, if there are usable 
+*   ones, so that searches and backlinks work right away.  Then, unless
+*   both files are less than MAX_INDEX_AGE seconds old, new ones are 
+*   built on a thread of their own.  Building renders every page in the
+*   page name index once, for both indexes, so it waits for that index 
+*   to be ready and takes several minutes.  Either file may be NULL, to
+*   do without that index.  After a build fails (most often because a 
+*   file can't be written), no other is started for MAX_INDEX_AGE 
+*   seconds, whatever the state of the files.
+*/
+
+void StartFullTextIndexBuild
+    (const char  *pIndexFile,
+     const char  *pBacklinkFile)
+
+{
+  BUILDSTATE *pState;
+  bool fCurrent;
+
+
+  fCurrent = ((pBacklinkFile == NULL)
+                || (LoadBacklinkIndex (pBacklinkFile) 
+                      && IsIndexFileCurrent (pBacklinkFile, MAX_INDEX_AGE)))
+             && ((pIndexFile == NULL) 
+                || (LoadSharedIndex (&Index, LoadIndexFile, pIndexFile)
+                      && IsIndexFileCurrent (pIndexFile, MAX_INDEX_AGE)));
+
+  if (fCurrent)
+    return;
+
+
+  pState = (BUILDSTATE*) calloc (1, sizeof (BUILDSTATE));
+  pState->pIndexFile     = (pIndexFile != NULL) ? strdup (pIndexFile) : NULL;
+  pState->pBacklinkFile  = (pBacklinkFile != NULL) ? strdup (pBacklinkFile) : NULL;
+
+  if (!StartSharedIndexBuild (&Index, BuildNewIndex, pState))
+  {
+    free (pState->pIndexFile);
+    free (pState->pBacklinkFile);
+    free (pState);
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                     AcquireFullTextIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+const FULLTEXTINDEX* AcquireFullTextIndex
+    (void)
+
+{
+  return (const FULLTEXTINDEX*) AcquireSharedIndex (&Index);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                     ReleaseFullTextIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void ReleaseFullTextIndex
+    (const FULLTEXTINDEX  *pIndex)
+
+{
+  ReleaseSharedIndex (&Index, pIndex);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      SearchFullTextIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Ranks the pages that contain any of the words in pQuery by BM25, 
+*   using the weighted term counts stored in the index.  *ppHitsOut 
+*   receives the matching pages, best first, in memory allocated from
+*   pArena; the number of them is returned.
+*/
+
+int SearchFullTextIndex
+    (const FULLTEXTINDEX   *pIndex,
+     ARENA                 *pArena,
+     const char            *pQuery,
+     FULLTEXTHIT          **ppHitsOut)
+
+{
+  int i, k, iTerm, nTerms, nDocs, nHits;
+  uint32_t doc, gap, count;
+  double idf, tf, norm;
+  float *pScores;
+  FULLTEXTHIT *pHits;
+  const FULLTEXTTERM *pTerm;
+  const unsigned char *p, *pEnd;
+  char terms [MAX_QUERY_TERMS] [MAX_TERM_LENGTH + 1];
+
+
+  *ppHitsOut = NULL;
+
+  nDocs = pIndex->pHeader->nDocs;
+  nTerms = GetQueryTerms (pQuery, terms);
+
+  if ((nTerms == 0) || (nDocs == 0))
+    return 0;
+
+
+  pScores = (float*) ArenaAlloc (pArena, sizeof (float) * nDocs);
+  memset (pScores, 0, sizeof (float) * nDocs);
+
+  pEnd = (const unsigned char*) pIndex->pBase + pIndex->pHeader->TextOffset;
+
+
+  for (k = 0; k < nTerms; k++)
+  {
+    if ((iTerm = FindTerm (pIndex, terms [k])) < 0)
+      continue;
+
+    pTerm = pIndex->pTerms + iTerm;
+    idf = log (1.0 + (nDocs - pTerm->nDocs + 0.5) / (pTerm->nDocs + 0.5));
+
+    p = (const unsigned char*) pIndex->pBase + pTerm->postings;
+    doc = 0;
+
+    for (i = 0; i < (int) pTerm->nDocs; i++)
+    {
+      if (((p = GetVarint (p, pEnd, &gap)) == NULL)
+             || ((p = GetVarint (p, pEnd, &count)) == NULL)
+             || ((doc += gap) >= (uint32_t) nDocs))
+        break;
+
+      tf = count;
+      norm = 1.0 - BM25_B + BM25_B * pIndex->pDocs [doc].length / pIndex->AverageLength;
+      pScores [doc] += idf * tf * (BM25_K1 + 1.0) / (tf + BM25_K1 * norm);
+    }
+  }
+
+
+  for (i = nHits = 0; i < nDocs; i++)
+  {
+    nHits += (pScores [i] > 0.0f);
+  }
+
+  pHits = (FULLTEXTHIT*) ArenaAlloc (pArena, sizeof (FULLTEXTHIT) * (nHits + 1));
+
+  for (i = k = 0; i < nDocs; i++)
+  {
+    if (pScores [i] > 0.0f)
+    {
+      pHits [k].iDoc = i;
+      pHits [k].score = pScores [i];
+      k++;
+    }
+  }
+
+  qsort (pHits, nHits, sizeof (FULLTEXTHIT), CompareHits);
+
+
+  *ppHitsOut = pHits;
+  return nHits;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         GetSearchSnippet
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Picks out the line of a page's excerpt that contains the most of 
+*   the query's words (and then the most occurrences of them), along 
+*   with the line after it if the first is short.  If no line matches,
+*   the first one--the page's description from its NAME section--is 
+*   used.  Returns the snippet with its spacing normalized, allocated 
+*   from pArena, or NULL if the page has no excerpt.  Nothing is 
+*   rendered here; the excerpts were taken when the index was built.
+*/
+
+char* GetSearchSnippet
+    (const FULLTEXTINDEX  *pIndex,
+     int                   iDoc,
+     ARENA                *pArena,
+     const char           *pQuery)
+
+{
+  int i, k, nTerms, cbLine, cbWord, iWord, score, BestScore = 0;
+  unsigned int found;
+  const char *pExcerpt, *pLine, *pNext, *pBest, *pBestEnd;
+  char word [MAX_TERM_LENGTH + 1], snippet [SNIPPET_SIZE];
+  char terms [MAX_QUERY_TERMS] [MAX_TERM_LENGTH + 1];
+
+
+  pExcerpt = pIndex->pBase + pIndex->pDocs [iDoc].excerpt;
+
+  if (*pExcerpt == '\0')
+    return NULL;
+
+  nTerms = GetQueryTerms (pQuery, terms);
+
+  pBest = pExcerpt;
+  pBestEnd = strchrnul (pExcerpt, '\n');
+
+
+  for (pLine = pExcerpt; *pLine != '\0'; pLine = (*pNext == '\n') ? (pNext + 1) : pNext)
+  {
+    pNext = strchrnul (pLine, '\n');
+    cbLine = pNext - pLine;
+
+    found = 0;
+    score = 0;
+
+    for (i = 0; i < cbLine; i += iWord + cbWord)
+    {
+      if ((cbWord = NextSearchToken (pLine + i, cbLine - i, &iWord)) == 0)
+        break;
+
+      if (cbWord > MAX_TERM_LENGTH)
+        continue;
+
+      FoldWord (pLine + i + iWord, cbWord, word);
+
+      for (k = 0; k < nTerms; k++)
+      {
+        if (strcmp (word, terms [k]) == 0)
+        {
+          found |= 1u << k;
+          score++;
+        }
+      }
+    }
+
+    score += 1000 * __builtin_popcount (found);
+
+    if (score > BestScore)
+    {
+      BestScore = score;
+      pBest = pLine;
+      pBestEnd = pNext;
+    }
+  }
+
+
+  /*  Carry on into the next line if this one is short.
+  */
+
+  if ((pBestEnd - pBest < 60) && (*pBestEnd == '\n'))
+  {
+    pBestEnd = strchrnul (pBestEnd + 1, '\n');
+  }
+
+  NormalizeSpaces (ArenaStrndup (pArena, pBest, pBestEnd - pBest), snippet, sizeof (snippet));
+
+  return ArenaStrndup (pArena, snippet, strlen (snippet));
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          NextSearchToken
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Finds the next word in the text, the same way the indexer does.  
+*   Stores its offset in *piStartOut and returns its length, or 0 if 
+*   there are no more words.  Words shorter than MIN_TERM_LENGTH are
+*   skipped; the caller should skip those longer than MAX_TERM_LENGTH, 
+*   which aren't indexed either.
+*/
+
+int NextSearchToken
+    (const char  *pText,
+     int          cbText,
+     int         *piStartOut)
+
+{
+  int i = 0, iStart;
+
+
+  while (i < cbText)
+  {
+    while ((i < cbText) && !IsWordChar (pText [i]))
+    {
+      i++;
+    }
+
+    iStart = i;
+
+    while ((i < cbText) && IsWordChar (pText [i]))
+    {
+      i++;
+    }
+
+    if (i - iStart >= MIN_TERM_LENGTH)
+    {
+      *piStartOut = iStart;
+      return i - iStart;
+    }
+  }
+
+  *piStartOut = cbText;
+  return 0;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            BuildNewIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Builds new index files and puts them in place of the current 
+*   indexes.  The files are written under temporary names and renamed 
+*   into place, so a reader never sees half of one.  If anything fails,
+*   the current index stays as it is.
+*/
+
+static
+bool BuildNewIndex
+   (void   *pContext,
+    void  **ppIndexOut)
+
+{
+  int i, nDocs;
+  BUILDSTATE *pState = (BUILDSTATE*) pContext;
+  const NAMEINDEX *pNames;
+  pthread_t threads [BUILD_THREADS];
+  bool fWritten = false, fSucceeded = false;
+
+
+  /*  Wait (up to ten minutes) for the page name index.
+  */
+
+  for (i = 0; ((pNames = AcquireNameIndex ()) == NULL) && (i < 600); i++)
+  {
+    sleep (1);
+  }
+
+
+  if (pNames != NULL)
+  {
+    nDocs = pNames->nEntries;
+
+    pState->pNames       = pNames;
+    pState->pDocLengths  = (uint32_t*) calloc (nDocs + 1, sizeof (uint32_t));
+    pState->ppExcerpts   = (char**) calloc (nDocs + 1, sizeof (char*));
+    pState->cTermHash    = 1 << 16;
+    pState->pTermHash    = (uint32_t*) calloc (pState->cTermHash, sizeof (uint32_t));
+
+    InitPageHashSet (&pState->PageHashes, nDocs);
+    pthread_mutex_init (&pState->BuildLock, NULL);
+
+    if (pState->pBacklinkFile != NULL)
+    {
+      pState->pBacklinks = BeginBacklinkBuild (pNames);
+    }
+
+
+    for (i = 0; i < BUILD_THREADS; i++)
+    {
+      pthread_create (&threads [i], NULL, BuildWorker, pState);
+    }
+
+    for (i = 0; i < BUILD_THREADS; i++)
+    {
+      pthread_join (threads [i], NULL);
+    }
+
+
+    fSucceeded = true;
+
+    if (pState->pIndexFile != NULL)
+    {
+      fWritten = WriteIndexFile (pState, pState->pIndexFile);
+      fSucceeded = fWritten;
+    }
+
+    if (pState->pBacklinks != NULL)
+    {
+      fSucceeded = FinishBacklinkBuild (pState->pBacklinks, pState->pBacklinkFile) 
+                     && fSucceeded;
+    }
+
+    ReleaseNameIndex (pNames);
+    pthread_mutex_destroy (&pState->BuildLock);
+
+    for (i = 0; i < nDocs; i++)
+    {
+      free (pState->ppExcerpts [i]);
+    }
+
+    free (pState->pDocLengths);
+    free (pState->ppExcerpts);
+    free (pState->pTermText);
+    free (pState->pTermOffsets);
+    free (pState->pTermHash);
+    free (pState->pPostings);
+    FreePageHashSet (&pState->PageHashes);
+  }
+
+
+  if (fWritten)
+  {
+    *ppIndexOut = LoadIndexFile (pState->pIndexFile);
+    fSucceeded = fSucceeded && (*ppIndexOut != NULL);
+  }
+
+  free (pState->pIndexFile);
+  free (pState->pBacklinkFile);
+  free (pState);
+  return fSucceeded;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              BuildWorker
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Takes pages one at a time until there are none left.  Most of the 
+*   time goes to waiting for man(1), which is why there are several of
+*   these.
+*/
+
+static
+void* BuildWorker
+   (void  *pContext)
+
+{
+  BUILDSTATE *pState = (BUILDSTATE*) pContext;
+  ARENA *pArena;
+  int iDoc;
+
+
+  for (;;)
+  {
+    pthread_mutex_lock (&pState->BuildLock);
+    iDoc = pState->iNextDoc++;
+    pthread_mutex_unlock (&pState->BuildLock);
+
+    if (iDoc >= pState->pNames->nEntries)
+      break;
+
+    pArena = AcquireArena ();
+    IndexPage (pState, iDoc, pArena);
+    ReleaseArena (pArena);
+  }
+
+  return NULL;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                IndexPage
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Renders one page and adds its words to the index.  Words in the NAME
+*   and SYNOPSIS sections count several times over, so that a page about
+*   a thing outranks pages that merely mention it.  Section titles 
+*   themselves are not indexed.  A page whose text is the same as one 
+*   already indexed (usually the same page under another name) is left
+*   out, of the backlinks as well, so that it isn't listed twice as 
+*   referring to the same pages.  The references in the page's text are
+*   found for the backlink index while the text is at hand.
+*
+*   The lines of the NAME and DESCRIPTION sections, up to EXCERPT_SIZE
+*   bytes of them, are kept as the page's excerpt: one line of text to
+*   a line, with the spacing normalized.  GetSearchSnippet() picks from
+*   these, so that showing results doesn't mean rendering every page.
+*/
+
+static
+void IndexPage
+   (BUILDSTATE  *pState,
+    int          iDoc,
+    ARENA       *pArena)
+
+{
+  int i, h, cbRaw, cbText, cbLine, cbWord, iWord, cHash, nPageTerms = 0, weight = 1;
+  int cbExcerpt = 0;
+  uint32_t hash, term, *pHashTable, nWords = 0;
+  uint64_t PageHash;
+  size_t cb;
+  char *pRaw, *pText, *pLine, *pNext, *pExcerpt, c;
+  const char *pName, *pSection;
+  PAGETERM *pPageTerms, *pPageTerm;
+  BUILDPOSTING *pPosting;
+  bool fExcerpt = false;
+  char word [MAX_TERM_LENGTH + 1], excerpt [EXCERPT_SIZE];
+  PROCESSERRORINFO error;
+
+
+  pName = pState->pNames->pText + pState->pNames->pEntries [iDoc].name;
+  pSection = pState->pNames->pText + pState->pNames->pEntries [iDoc].section;
+
+  if (!GetManPageContent (pName, pSection, &pRaw, &cbRaw, &error))
+    return;
+
+  pText = ManualPageToText (pArena, pRaw, cbRaw, &cbText);
+  free (pRaw);
+
+
+  PageHash = HashPageText (pText, cbText);
+
+
+  /*  A page has at most one distinct word for every three bytes of 
+  *   text, so the table below never gets more than half full.
+  */
+
+  for (cHash = 64; cHash < 2 * (cbText / 3 + 1); cHash *= 2)
+    ;
+
+  pHashTable = (uint32_t*) ArenaAlloc (pArena, sizeof (uint32_t) * cHash);
+  memset (pHashTable, 0, sizeof (uint32_t) * cHash);
+
+  pPageTerms = (PAGETERM*) ArenaAlloc (pArena, sizeof (PAGETERM) * (cbText / 3 + 1));
+
+
+  for (pLine = pText; pLine < pText + cbText; pLine = pNext)
+  {
+    pNext = (char*) memchr (pLine, '\n', pText + cbText - pLine);
+    pNext = (pNext == NULL) ? (pText + cbText) : (pNext + 1);
+    cbLine = pNext - pLine;
+
+
+    /*  Section titles are the lines that aren't indented.
+    */
+
+    if ((*pLine != ' ') && (*pLine != '\t') && (*pLine != '\n'))
+    {
+      if ((cbLine <= 5) && (memcmp (pLine, "NAME", 4) == 0))
+        weight = NAME_WEIGHT;
+      else if ((cbLine <= 9) && (cbLine >= 8) && (memcmp (pLine, "SYNOPSIS", 8) == 0))
+        weight = SYNOPSIS_WEIGHT;
+      else
+        weight = 1;
+
+      fExcerpt = (weight == NAME_WEIGHT)
+                   || ((cbLine <= 12) && (cbLine >= 11) && (memcmp (pLine, "DESCRIPTION", 11) == 0));
+      continue;
+    }
+
+
+    /*  The line is cut off at its newline for the moment, to be copied
+    *   into the excerpt.
+    */
+
+    if (fExcerpt && (cbExcerpt < EXCERPT_SIZE - 2))
+    {
+      c = pLine [cbLine - 1];
+      pLine [cbLine - 1] = (c == '\n') ? '\0' : c;
+
+      if ((i = NormalizeSpaces (pLine, excerpt + cbExcerpt, EXCERPT_SIZE - cbExcerpt - 1)) > 0)
+      {
+        cbExcerpt += i;
+        excerpt [cbExcerpt++] = '\n';
+      }
+
+      pLine [cbLine - 1] = c;
+    }
+
+
+    for (i = 0; i < cbLine; i += iWord + cbWord)
+    {
+      if ((cbWord = NextSearchToken (pLine + i, cbLine - i, &iWord)) == 0)
+        break;
+
+      if (cbWord > MAX_TERM_LENGTH)
+        continue;
+
+      FoldWord (pLine + i + iWord, cbWord, word);
+      hash = HashBytes (word, cbWord);
+      nWords++;
+
+
+      for (h = hash & (cHash - 1); pHashTable [h] != 0; h = (h + 1) & (cHash - 1))
+      {
+        pPageTerm = pPageTerms + pHashTable [h] - 1;
+
+        if ((pPageTerm->hash == hash) && (pPageTerm->cbTerm == cbWord)
+               && (memcmp (pPageTerm->pTerm, word, cbWord) == 0))
+          break;
+      }
+
+      if (pHashTable [h] == 0)
+      {
+        pPageTerm = pPageTerms + nPageTerms++;
+        pPageTerm->pTerm   = ArenaStrndup (pArena, word, cbWord);
+        pPageTerm->cbTerm  = cbWord;
+        pPageTerm->hash    = hash;
+        pPageTerm->count   = 0;
+
+        pHashTable [h] = nPageTerms;
+      }
+
+      pPageTerm = pPageTerms + pHashTable [h] - 1;
+      pPageTerm->count += weight;
+    }
+  }
+
+  if (nWords == 0)
+    return;
+
+  pExcerpt = strndup (excerpt, (cbExcerpt > 0) ? (cbExcerpt - 1) : 0);
+
+
+  /*  Add the page's words to the shared tables.
+  */
+
+  pthread_mutex_lock (&pState->BuildLock);
+
+  if (!AddPageHash (&pState->PageHashes, PageHash))
+  {
+    pthread_mutex_unlock (&pState->BuildLock);
+    free (pExcerpt);
+    return;
+  }
+
+  if (pState->nPostings + nPageTerms > pState->nPostingsAllocated)
+  {
+    cb = pState->nPostingsAllocated + pState->nPostingsAllocated / 2 + nPageTerms + 4096;
+
+    pState->pPostings = (BUILDPOSTING*) realloc (pState->pPostings, sizeof (BUILDPOSTING) * cb);
+    pState->nPostingsAllocated = cb;
+  }
+
+  for (i = 0; i < nPageTerms; i++)
+  {
+    term = InternTerm (pState, pPageTerms [i].pTerm, pPageTerms [i].cbTerm, 
+                       pPageTerms [i].hash);
+
+    pPosting = pState->pPostings + pState->nPostings++;
+    pPosting->term   = term;
+    pPosting->doc    = iDoc;
+    pPosting->count  = pPageTerms [i].count;
+  }
+
+  pState->pDocLengths [iDoc] = nWords;
+  pState->ppExcerpts [iDoc] = pExcerpt;
+
+  pthread_mutex_unlock (&pState->BuildLock);
+
+
+  if (pState->pBacklinks != NULL)
+  {
+    AddPageBacklinks (pState->pBacklinks, iDoc, pText, cbText, pArena);
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               InternTerm
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the number of a term, adding it to the term table if it is
+*   new.  The hash table is doubled whenever it gets half full.  The 
+*   caller must hold BuildLock.
+*/
+
+static
+uint32_t InternTerm
+   (BUILDSTATE  *pState,
+    const char  *pTerm,
+    int          cbTerm,
+    uint32_t     hash)
+
+{
+  int i, h, mask;
+  uint32_t n, *pOldHash;
+  const char *pText;
+  size_t cb;
+
+
+  mask = pState->cTermHash - 1;
+
+  for (h = hash & mask; (n = pState->pTermHash [h]) != 0; h = (h + 1) & mask)
+  {
+    pText = pState->pTermText + pState->pTermOffsets [n - 1];
+
+    if ((memcmp (pText, pTerm, cbTerm) == 0) && (pText [cbTerm] == '\0'))
+      return n - 1;
+  }
+
+
+  /*  A new term.
+  */
+
+  if (pState->cbTermText + cbTerm + 1 > pState->cbTermTextAllocated)
+  {
+    cb = pState->cbTermTextAllocated + pState->cbTermTextAllocated / 2 + 65536;
+
+    pState->pTermText = (char*) realloc (pState->pTermText, cb);
+    pState->cbTermTextAllocated = cb;
+  }
+
+  if (pState->nTerms >= pState->nTermsAllocated)
+  {
+    pState->nTermsAllocated += pState->nTermsAllocated / 2 + 4096;
+    pState->pTermOffsets = (uint32_t*) realloc (pState->pTermOffsets, 
+                                                sizeof (uint32_t) * pState->nTermsAllocated);
+  }
+
+  pState->pTermOffsets [pState->nTerms] = pState->cbTermText;
+  memcpy (pState->pTermText + pState->cbTermText, pTerm, cbTerm);
+  pState->pTermText [pState->cbTermText + cbTerm] = '\0';
+  pState->cbTermText += cbTerm + 1;
+
+  pState->pTermHash [h] = ++pState->nTerms;
+
+
+  if (2 * pState->nTerms >= pState->cTermHash)
+  {
+    pOldHash = pState->pTermHash;
+
+    pState->cTermHash *= 2;
+    pState->pTermHash = (uint32_t*) calloc (pState->cTermHash, sizeof (uint32_t));
+    mask = pState->cTermHash - 1;
+
+    for (i = 0; i < pState->nTerms; i++)
+    {
+      pText = pState->pTermText + pState->pTermOffsets [i];
+
+      for (h = HashBytes (pText, strlen (pText)) & mask; 
+           pState->pTermHash [h] != 0; 
+           h = (h + 1) & mask)
+        ;
+
+      pState->pTermHash [h] = i + 1;
+    }
+
+    free (pOldHash);
+  }
+
+  return pState->nTerms - 1;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           WriteIndexFile
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Sorts the terms and postings and writes out the index file in the 
+*   layout described in fulltext_index.h.
+*/
+
+static
+bool WriteIndexFile
+   (BUILDSTATE  *pState,
+    const char  *pIndexFile)
+
+{
+  int i, r, nDocs = pState->pNames->nEntries, nTerms = pState->nTerms;
+  uint32_t *pOrder, *pRank, doc;
+  uint64_t cbFile, TotalLength = 0;
+  size_t j, cbPostings, cbText;
+  unsigned char *pPostings;
+  char *pText, *pStr;
+  const char *pName, *pSection;
+  FULLTEXTHEADER header;
+  FULLTEXTDOC *pDocs;
+  FULLTEXTTERM *pTerms;
+  INDEXFILEPART parts [5];
+  bool fSuccess;
+
+
+  /*  Number the terms in sorted order, then sort the postings by term
+  *   and document.
+  */
+
+  pOrder = (uint32_t*) malloc (sizeof (uint32_t) * (nTerms + 1));
+  pRank = (uint32_t*) malloc (sizeof (uint32_t) * (nTerms + 1));
+
+  for (i = 0; i < nTerms; i++)
+  {
+    pOrder [i] = i;
+  }
+
+  qsort_r (pOrder, nTerms, sizeof (uint32_t), CompareTermOrder, pState);
+
+  for (r = 0; r < nTerms; r++)
+  {
+    pRank [pOrder [r]] = r;
+  }
+
+  for (j = 0; j < pState->nPostings; j++)
+  {
+    pState->pPostings [j].term = pRank [pState->pPostings [j].term];
+  }
+
+  qsort (pState->pPostings, pState->nPostings, sizeof (BUILDPOSTING), ComparePostings);
+
+
+  /*  Lay out the text: the names, sections and excerpts first, then 
+  *   the terms.  A page that wasn't indexed has an empty excerpt.
+  */
+
+  for (i = 0, cbText = pState->cbTermText; i < nDocs; i++)
+  {
+    cbText += strlen (pState->pNames->pText + pState->pNames->pEntries [i].name) + 1;
+    cbText += strlen (pState->pNames->pText + pState->pNames->pEntries [i].section) + 1;
+    cbText += (pState->ppExcerpts [i] != NULL) ? (strlen (pState->ppExcerpts [i]) + 1) : 1;
+  }
+
+  pText = (char*) malloc (cbText + 1);
+  pDocs = (FULLTEXTDOC*) malloc (sizeof (FULLTEXTDOC) * (nDocs + 1));
+  pTerms = (FULLTEXTTERM*) malloc (sizeof (FULLTEXTTERM) * (nTerms + 1));
+  pPostings = (unsigned char*) malloc (10 * pState->nPostings + 1);
+
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, INDEX_MAGIC, sizeof (header.magic));
+  header.nDocs           = nDocs;
+  header.nTerms          = nTerms;
+  header.DocsOffset      = sizeof (FULLTEXTHEADER);
+  header.TermsOffset     = header.DocsOffset + sizeof (FULLTEXTDOC) * nDocs;
+  header.PostingsOffset  = header.TermsOffset + sizeof (FULLTEXTTERM) * nTerms;
+
+
+  /*  Encode each term's postings as gaps between document numbers.
+  */
+
+  for (r = 0, j = 0, cbPostings = 0; r < nTerms; r++)
+  {
+    pTerms [r].postings = header.PostingsOffset + cbPostings;
+    pTerms [r].nDocs = 0;
+
+    for (doc = 0; (j < pState->nPostings) && (pState->pPostings [j].term == (uint32_t) r); j++)
+    {
+      cbPostings += PutVarint (pPostings + cbPostings, pState->pPostings [j].doc - doc);
+      cbPostings += PutVarint (pPostings + cbPostings, pState->pPostings [j].count);
+      doc = pState->pPostings [j].doc;
+      pTerms [r].nDocs++;
+    }
+  }
+
+
+  cbFile = (uint64_t) header.PostingsOffset + cbPostings + cbText;
+
+  if (cbFile > UINT32_MAX)
+  {
+    fSuccess = false;
+    goto Done;
+  }
+
+  header.TextOffset = header.PostingsOffset + cbPostings;
+  header.cbFile = (uint32_t) cbFile;
+
+
+  pStr = pText;
+
+  for (i = 0; i < nDocs; i++)
+  {
+    pName = pState->pNames->pText + pState->pNames->pEntries [i].name;
+    pSection = pState->pNames->pText + pState->pNames->pEntries [i].section;
+
+    pDocs [i].name = header.TextOffset + (pStr - pText);
+    pStr = stpcpy (pStr, pName) + 1;
+    pDocs [i].section = header.TextOffset + (pStr - pText);
+    pStr = stpcpy (pStr, pSection) + 1;
+    pDocs [i].excerpt = header.TextOffset + (pStr - pText);
+    pStr = stpcpy (pStr, (pState->ppExcerpts [i] != NULL) ? pState->ppExcerpts [i] : "") + 1;
+    pDocs [i].length = pState->pDocLengths [i];
+
+    TotalLength += pState->pDocLengths [i];
+  }
+
+  for (r = 0; r < nTerms; r++)
+  {
+    pTerms [r].text = header.TextOffset + (pStr - pText);
+    pStr = stpcpy (pStr, pState->pTermText + pState->pTermOffsets [pOrder [r]]) + 1;
+  }
+
+  header.TotalLength = (TotalLength > UINT32_MAX) ? UINT32_MAX : (uint32_t) TotalLength;
+
+
+  parts [0].pData = &header;
+  parts [0].cbData = sizeof (header);
+  parts [1].pData = pDocs;
+  parts [1].cbData = sizeof (FULLTEXTDOC) * nDocs;
+  parts [2].pData = pTerms;
+  parts [2].cbData = sizeof (FULLTEXTTERM) * nTerms;
+  parts [3].pData = pPostings;
+  parts [3].cbData = cbPostings;
+  parts [4].pData = pText;
+  parts [4].cbData = cbText;
+
+  fSuccess = ReplaceIndexFile (pIndexFile, parts, 5);
+
+
+Done:
+  free (pOrder);
+  free (pRank);
+  free (pText);
+  free (pDocs);
+  free (pTerms);
+  free (pPostings);
+
+  return fSuccess;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         CompareTermOrder
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+int CompareTermOrder
+   (const void  *pLeft,
+    const void  *pRight,
+    void        *pContext)
+
+{
+  const BUILDSTATE *pState = (const BUILDSTATE*) pContext;
+
+
+  return strcmp (pState->pTermText + pState->pTermOffsets [*(const uint32_t*) pLeft],
+                 pState->pTermText + pState->pTermOffsets [*(const uint32_t*) pRight]);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          ComparePostings
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+int ComparePostings
+   (const void  *pLeft,
+    const void  *pRight)
+
+{
+  const BUILDPOSTING *pA = (const BUILDPOSTING*) pLeft;
+  const BUILDPOSTING *pB = (const BUILDPOSTING*) pRight;
+
+
+  if (pA->term != pB->term)
+    return (pA->term < pB->term) ? -1 : 1;
+
+  return (pA->doc < pB->doc) ? -1 : (pA->doc > pB->doc);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            LoadIndexFile
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Maps an index file into memory.  Returns NULL if the file doesn't
+*   exist or isn't a valid index.
+*/
+
+static
+void* LoadIndexFile
+   (const char  *pIndexFile)
+
+{
+  uint32_t i, nNonEmpty;
+  const char *pBase;
+  size_t cbFile;
+  FULLTEXTINDEX *pIndex;
+
+
+  if ((pBase = MapIndexFile (pIndexFile, sizeof (FULLTEXTHEADER), &cbFile)) == NULL)
+    return NULL;
+
+  pIndex = (FULLTEXTINDEX*) malloc (sizeof (FULLTEXTINDEX));
+  pIndex->pBase    = pBase;
+  pIndex->pHeader  = (const FULLTEXTHEADER*) pBase;
+
+  if (!ValidateIndex (pIndex, cbFile))
+  {
+    UnmapIndexFile (pBase, cbFile);
+    free (pIndex);
+    return NULL;
+  }
+
+  pIndex->pDocs = (const FULLTEXTDOC*) (pIndex->pBase + pIndex->pHeader->DocsOffset);
+  pIndex->pTerms = (const FULLTEXTTERM*) (pIndex->pBase + pIndex->pHeader->TermsOffset);
+
+
+  for (i = nNonEmpty = 0; i < pIndex->pHeader->nDocs; i++)
+  {
+    nNonEmpty += (pIndex->pDocs [i].length > 0);
+  }
+
+  pIndex->AverageLength = (nNonEmpty > 0) 
+                            ? ((double) pIndex->pHeader->TotalLength / nNonEmpty) 
+                            : 1.0;
+
+  if (pIndex->AverageLength < 1.0)
+  {
+    pIndex->AverageLength = 1.0;
+  }
+
+  return pIndex;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            ValidateIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Checks that every offset in the file points where it should, so that
+*   a damaged or truncated file can't make a search read outside the 
+*   mapping, which is cbFile bytes long.  (Posting lists are 
+*   bounds-checked as they are decoded.)
+*/
+
+static
+bool ValidateIndex
+   (const FULLTEXTINDEX  *pIndex,
+    size_t                cbFile)
+
+{
+  uint32_t i;
+  const char *pBase = pIndex->pBase;
+  const FULLTEXTHEADER *pHeader = pIndex->pHeader;
+  const FULLTEXTDOC *pDocs;
+  const FULLTEXTTERM *pTerms;
+
+
+  if ((memcmp (pHeader->magic, INDEX_MAGIC, sizeof (pHeader->magic)) != 0)
+         || (pHeader->cbFile != cbFile)
+         || (pHeader->DocsOffset != sizeof (FULLTEXTHEADER))
+         || (pHeader->TermsOffset != pHeader->DocsOffset + (uint64_t) sizeof (FULLTEXTDOC) * pHeader->nDocs)
+         || (pHeader->PostingsOffset != pHeader->TermsOffset + (uint64_t) sizeof (FULLTEXTTERM) * pHeader->nTerms)
+         || (pHeader->TextOffset < pHeader->PostingsOffset)
+         || (pHeader->TextOffset > pHeader->cbFile))
+    return false;
+
+  if ((pHeader->nDocs + pHeader->nTerms > 0)
+         && ((pHeader->TextOffset == pHeader->cbFile) 
+                || (pBase [pHeader->cbFile - 1] != '\0')))
+    return false;
+
+
+  pDocs = (const FULLTEXTDOC*) (pBase + pHeader->DocsOffset);
+
+  for (i = 0; i < pHeader->nDocs; i++)
+  {
+    if ((pDocs [i].name < pHeader->TextOffset) || (pDocs [i].name >= pHeader->cbFile)
+          || (pDocs [i].section < pHeader->TextOffset) || (pDocs [i].section >= pHeader->cbFile)
+          || (pDocs [i].excerpt < pHeader->TextOffset) || (pDocs [i].excerpt >= pHeader->cbFile))
+      return false;
+  }
+
+
+  pTerms = (const FULLTEXTTERM*) (pBase + pHeader->TermsOffset);
+
+  for (i = 0; i < pHeader->nTerms; i++)
+  {
+    if ((pTerms [i].text < pHeader->TextOffset) || (pTerms [i].text >= pHeader->cbFile)
+          || (pTerms [i].postings < pHeader->PostingsOffset) 
+          || (pTerms [i].postings > pHeader->TextOffset))
+      return false;
+  }
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                FreeIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void FreeIndex
+   (void  *pIndex)
+
+{
+  FULLTEXTINDEX *pFullText = (FULLTEXTINDEX*) pIndex;
+
+
+  UnmapIndexFile (pFullText->pBase, pFullText->pHeader->cbFile);
+  free (pFullText);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                 FindTerm
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the number of a term, or -1 if no page contains it.
+*/
+
+static
+int FindTerm
+   (const FULLTEXTINDEX  *pIndex,
+    const char           *pTerm)
+
+{
+  int lo = 0, hi = pIndex->pHeader->nTerms, mid, t;
+
+
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+    t = strcmp (pIndex->pBase + pIndex->pTerms [mid].text, pTerm);
+
+    if (t == 0)
+      return mid;
+
+    if (t < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return -1;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            GetQueryTerms
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Splits a query into distinct, lowercased words, as the indexer would.
+*   Returns the number of them (at most MAX_QUERY_TERMS).
+*/
+
+static
+int GetQueryTerms
+   (const char  *pQuery,
+    char         terms [] [MAX_TERM_LENGTH + 1])
+
+{
+  int i, k, cbWord, iWord, nTerms = 0, cbQuery = strlen (pQuery);
+
+
+  for (i = 0; nTerms < MAX_QUERY_TERMS; i += iWord + cbWord)
+  {
+    if ((cbWord = NextSearchToken (pQuery + i, cbQuery - i, &iWord)) == 0)
+      break;
+
+    if (cbWord > MAX_TERM_LENGTH)
+      continue;
+
+    FoldWord (pQuery + i + iWord, cbWord, terms [nTerms]);
+
+    for (k = 0; (k < nTerms) && (strcmp (terms [k], terms [nTerms]) != 0); k++)
+      ;
+
+    if (k == nTerms)
+    {
+      nTerms++;
+    }
+  }
+
+  return nTerms;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              CompareHits
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Best score first; ties go to the page that comes first by name.
+*/
+
+static
+int CompareHits
+   (const void  *pLeft,
+    const void  *pRight)
+
+{
+  const FULLTEXTHIT *pA = (const FULLTEXTHIT*) pLeft;
+  const FULLTEXTHIT *pB = (const FULLTEXTHIT*) pRight;
+
+
+  if (pA->score != pB->score)
+    return (pA->score > pB->score) ? -1 : 1;
+
+  return pA->iDoc - pB->iDoc;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                HashBytes
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  32-bit FNV-1a.
+*/
+
+static
+uint32_t HashBytes
+   (const char  *pData,
+    int          cbData)
+
+{
+  uint32_t hash = 2166136261u;
+  int i;
+
+
+  for (i = 0; i < cbData; i++)
+  {
+    hash = (hash ^ (unsigned char) pData [i]) * 16777619u;
+  }
+
+  return hash;
+}
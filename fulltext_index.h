@@ -0,0 +1,153 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#ifndef __FULLTEXT_INDEX_H_
+#define __FULLTEXT_INDEX_H_
+
+
+#include <stdint.h>
+
+#include "arena.h"                 /*  For ARENA type.  */
+
+
+
+/*  The layout of an index file, which is mapped into memory as is.  All
+*   offsets are from the start of the file.  The file is only ever read
+*   on the machine that wrote it, so numbers are in native byte order.
+*
+*     FULLTEXTHEADER
+*     FULLTEXTDOC   [nDocs]      One per manual page.
+*     FULLTEXTTERM  [nTerms]     Sorted by term (strcmp order).
+*     Postings                   For each term, its documents in order,
+*                                as varint pairs (gap from the previous
+*                                document number, weighted term count).
+*     Text                       NUL-terminated names, sections, 
+*                                excerpts, terms.
+*/
+
+struct FULLTEXTHEADER
+{
+  char      magic [8];
+  uint32_t  nDocs;
+  uint32_t  nTerms;
+  uint32_t  TotalLength;       /*  Of all documents, in words.  */
+  uint32_t  DocsOffset;
+  uint32_t  TermsOffset;
+  uint32_t  PostingsOffset;
+  uint32_t  TextOffset;
+  uint32_t  cbFile;
+};
+
+
+struct FULLTEXTDOC
+{
+  uint32_t  name;              /*  Offsets of the name and section.  */
+  uint32_t  section;
+  uint32_t  length;            /*  In words.  */
+  uint32_t  excerpt;           /*  Lines of text, separated by '\n'.  */
+};
+
+
+struct FULLTEXTTERM
+{
+  uint32_t  text;
+  uint32_t  postings;
+  uint32_t  nDocs;
+};
+
+
+
+/*  An index that has been mapped into memory.
+*/
+
+struct FULLTEXTINDEX
+{
+  const char            *pBase;
+  const FULLTEXTHEADER  *pHeader;
+  const FULLTEXTDOC     *pDocs;
+  const FULLTEXTTERM    *pTerms;
+  double                 AverageLength;
+};
+
+
+
+/*  One document that matched a search.
+*/
+
+struct FULLTEXTHIT
+{
+  int    iDoc;
+  float  score;
+};
+
+
+
+/*  StartFullTextIndexBuild() loads the index file the first time it is
+*   called, then rebuilds the file in the background if it is missing
+*   or out of date.  The backlink file (see backlink_index.h) is built
+*   by the same pass over the pages.  Until an index is available, 
+*   AcquireFullTextIndex() returns NULL.  All of the functions are 
+*   thread-safe.
+*/
+
+extern "C"
+{
+extern void StartFullTextIndexBuild
+    (const char  *pIndexFile,
+     const char  *pBacklinkFile);
+
+
+extern const FULLTEXTINDEX* AcquireFullTextIndex
+    (void);
+
+
+extern void ReleaseFullTextIndex
+    (const FULLTEXTINDEX  *pIndex);
+
+
+extern int SearchFullTextIndex
+    (const FULLTEXTINDEX   *pIndex,
+     ARENA                 *pArena,
+     const char            *pQuery,
+     FULLTEXTHIT          **ppHitsOut);
+
+
+extern char* GetSearchSnippet
+    (const FULLTEXTINDEX  *pIndex,
+     int                   iDoc,
+     ARENA                *pArena,
+     const char           *pQuery);
+
+
+extern int NextSearchToken
+    (const char  *pText,
+     int          cbText,
+     int         *piStartOut);
+}
+
+
+#endif
@@ -28,138 +28,339 @@
 #include <stdlib.h>                    /*  C/C++ RTL headers.  */
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 
-#include <tre/tre.h>                   /*  Library headers.  */
+#if defined (__x86_64__) || defined (__i386__)
+#include <immintrin.h>                 /*  Compiler intrinsics.  */
+#endif
 
-#include "html_formatting.h"           /*  Application headers.  */
+#include "utility.h"                   /*  Application headers.  */
+#include "arena.h"
+#include "html_formatting.h"
 #include "infotohtml.h"
 
 
 
-static regex_t UriRegex, PageRefRegex;
+/*  Character classes used by the hyperlink scanner.  CC_URI and
+*   CC_URI_END correspond to the two bracket expressions in the URI
+*   pattern; CC_PAGE_NAME is the set of characters allowed in the name
+*   part of a manual page reference.
+*/
+
+enum
+{
+  CC_WORD         = 1,
+  CC_URI          = 2,
+  CC_URI_END      = 4,
+  CC_PAGE_NAME    = 8,
+  CC_DIGIT        = 16,
+  CC_ALPHA        = 32
+};
+
+
+static const unsigned char CharClasses [256]
+        = {
+            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    /*  00-0f  */
+            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    /*  10-1f  */
+            0,  2,  0,  6,  0,  6,  6,  0,  0,  0,  0, 14,  2, 10, 10,  6,    /*  20-2f  */
+           31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 10,  2,  0,  6,  0,  2,    /*  30-3f  */
+            6, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47,    /*  40-4f  */
+           47, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47,  0,  0,  0,  0, 15,    /*  50-5f  */
+            0, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47,    /*  60-6f  */
+           47, 47, 47, 47, 47, 47, 47, 47, 47, 47, 47,  0,  6,  0,  6,  0,    /*  70-7f  */
+            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    /*  80-8f  */
+            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    /*  90-9f  */
+            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    /*  a0-af  */
+            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    /*  b0-bf  */
+            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    /*  c0-cf  */
+            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    /*  d0-df  */
+            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,    /*  e0-ef  */
+            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0     /*  f0-ff  */
+          };
+
+
+#define MAX_PAGE_NAME_LENGTH      32
+#define MAX_SECTION_DIGITS        3
+#define MAX_SECTION_LETTERS       4
+
+#define MAX_PENDING_RANGES        64
+
+
+
+/*  A change to the attributes of a range of a span list (a link found by
+*   ScanForHyperlinks(), or whitespace found by NormalizeSpanWhitespace())
+*   that has not yet been applied.
+*/
+
+struct LINKRANGE
+{
+  int             iStart;
+  int             iEnd;
+  TEXTATTRIBUTES  LinkType;
+};
+
+
+/*  The ranges waiting to be applied to a span list.  They are kept in
+*   Local until there are more than MAX_PENDING_RANGES, and then in the
+*   list's arena, so that they can all be applied in a single pass
+*   however many there are.
+*/
+
+struct RANGEQUEUE
+{
+  LINKRANGE  *pRanges;
+  int         nRanges;
+  int         nAllocated;
+  LINKRANGE   Local [MAX_PENDING_RANGES];
+};
 
 
 
 /*  Function prototypes.
 */
 
-static char* CreateManPageLinkTag (const char*, const TEXTATTRIBUTES*, const HTMLFORMATINFO*);
-static char* CreateInfoLinkTag (const char*, const TEXTATTRIBUTES*, const HTMLFORMATINFO*);
-static char* CreateUriLinkTag (const char*, const TEXTATTRIBUTES*, const HTMLFORMATINFO*);
+static inline bool HTMLizeTextLoop (OUTPUTBUFFER*, const char*, int, const TEXTATTRIBUTES*, 
+                                    const HTMLFORMATINFO*, int, HTMLIZESTATE*, bool, bool);
+static inline bool HTMLizeSpansLoop (OUTPUTBUFFER*, const char*, int, const ATTRSPANLIST*, 
+                                     const HTMLFORMATINFO*, int, bool);
+static int FindRunEnd (const char*, const TEXTATTRIBUTES*, int, TEXTATTRIBUTES, TEXTATTRIBUTES, char);
+static bool WriteAttributeChanges (OUTPUTBUFFER*, const char*, const TEXTATTRIBUTES*, TEXTATTRIBUTES,
+                                   const HTMLFORMATINFO*, HTMLIZESTATE*);
+static bool WriteSpanAttributeChanges (OUTPUTBUFFER*, const char*, int, const ATTRSPANLIST*, int, int,
+                                       TEXTATTRIBUTES, const HTMLFORMATINFO*, HTMLIZESTATE*);
+static bool WriteManPageLinkTag (OUTPUTBUFFER*, const char*, const TEXTATTRIBUTES*, const HTMLFORMATINFO*);
+static bool WriteInfoLinkTag (OUTPUTBUFFER*, const char*, const TEXTATTRIBUTES*, const HTMLFORMATINFO*);
+static bool WriteUriLinkTag (OUTPUTBUFFER*, const char*, const TEXTATTRIBUTES*, const HTMLFORMATINFO*);
+static bool AppendTag (OUTPUTBUFFER*, const char*, int);
+static int ScanForHyperlinks (const char*, int, TEXTATTRIBUTES*, ATTRSPANLIST*, TEXTATTRIBUTES);
+static void MarkLink (TEXTATTRIBUTES*, ATTRSPANLIST*, RANGEQUEUE*, int, int, TEXTATTRIBUTES);
+static void InitRangeQueue (RANGEQUEUE*);
+static void QueueRange (ATTRSPANLIST*, RANGEQUEUE*, int, int, TEXTATTRIBUTES);
+static void ApplyRanges (ATTRSPANLIST*, const LINKRANGE*, int, TEXTATTRIBUTES);
+static int MatchUri (const char*, int, int);
+static void ReserveAttrSpans (ATTRSPANLIST*, int);
+static int MatchPageRefSuffix (const char*, int, int);
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                    htmlInitializeRegexes
+                                                  NormalizeSpanWhitespace
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-void htmlInitializeRegexes
-   (void)
+/*  Removes attr from the spaces and tabs at the end of each run of text
+*   that has it, for text whose attributes are in a span list.  The 
+*   changes are applied together once all the runs have been looked at.
+*/
+
+void NormalizeSpanWhitespace 
+   (const char      *pText, 
+    ATTRSPANLIST    *pSpans,
+    TEXTATTRIBUTES   attr)
 
 {
-  int error;
+  int i, k, iRunStart, iRunEnd;
+  const ATTRSPAN *pSpan;
+  RANGEQUEUE queue;
 
-  
-  /*  See: http://www.regexguru.com/2008/11/detecting-urls-in-a-block-of-text/
-  */
-   
-  error = tre_regcomp 
-              (&UriRegex, 
-               "\\b(https?|ftp)://[-A-Z0-9+&@#/%?=~_|!:,.;]*[A-Z0-9+&@#/%=~_|]", 
-               REG_EXTENDED | REG_ICASE);
 
-  if (error != 0)
+  InitRangeQueue (&queue);
+
+  iRunStart = -1;
+  for (k = 0; k <= pSpans->nSpans; k++)
   {
-    fprintf (stderr, "FATAL ERROR: tre_regcomp() failed for UriRegex.  (Error %d)\n", 
-             error);
-    exit (100);
-  }
+    pSpan = pSpans->pSpans + k;
+
+    if ((k < pSpans->nSpans) && ((pSpan->attrs & attr) == attr))
+    {
+      if (iRunStart < 0)
+      {
+        iRunStart = pSpan->iStart;
+      }
+      continue;
+    }
+
+    if (iRunStart < 0)
+      continue;
 
 
-  error = tre_regcomp 
-              (&PageRefRegex, 
-               "[a-z0-9.+_:-]{1,32}\\([0-9]{1,3}[a-z]{0,4}\\)", 
-               REG_EXTENDED | REG_ICASE);
+    iRunEnd = (k < pSpans->nSpans) 
+                  ? pSpan->iStart 
+                  : (pSpan [-1].iStart + pSpan [-1].length);
+
+    for (i = iRunEnd - 1
+           ; (i >= iRunStart) && ((pText [i] == ' ') || (pText [i] == '\t'))
+           ; i--)
+    { /* Empty loop. */ }
+
+    if ((i >= iRunStart) && (i + 1 < iRunEnd))
+    {
+      QueueRange (pSpans, &queue, i + 1, iRunEnd, 0);
+    }
+
+    iRunStart = -1;
+  }
 
-  if (error != 0)
+  if (queue.nRanges > 0)
   {
-    fprintf (stderr, "FATAL ERROR: tre_regcomp() failed for PageRefRegex.  (Error %d)\n", 
-             error);
-    exit (100);
+    ApplyRanges (pSpans, queue.pRanges, queue.nRanges, attr);
   }
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                          NormalizeAttributesOfWhitespace
+                                                           HTMLEscapeText
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-void NormalizeAttributesOfWhitespace 
-   (const char      *pText, 
-    TEXTATTRIBUTES  *pAttributes,
-    int              length,    
-    TEXTATTRIBUTES   attr)
+/*  Copies text to pDest (cbMax bytes, always null-terminated) with its
+*   "&", "<" and ">" escaped, for the many short strings (titles, names,
+*   messages) that need nothing else.  Carriage returns are dropped.  
+*   Returns true if the output was truncated.
+*/
+
+bool HTMLEscapeText 
+   (char        *pDest,
+    int          cbMax,
+    const char  *pText, 
+    int          cbText)
 
 {
-  int i, j, iFirst;
-  char c;
+  int i, cbRun, cbOut, cbEscape;
+  const char *pEscape;
+  bool fTruncated = false;
 
 
-  iFirst = -1;
-  for (i = 0;; i++)
+  if (cbMax <= 0)
+    return true;
+
+  if (cbText < 0)
+  {
+    cbText = strlen (pText);
+  }
+
+
+  i = cbOut = 0;
+  while (i < cbText)
   {
-    c = ((length >= 0) && (i >= length)) ? '\0' : pText [i];
+    cbRun = FindRunEnd (pText + i, NULL, cbText - i, 0, 0, '\0');
 
-    if ((c == '\0') || ((pAttributes [i] & attr) != attr))
+    if (cbOut + cbRun >= cbMax)
     {
-      if (iFirst >= 0)
-      {
-        for (j = iFirst + 1; j < i; j++)
-        {
-          pAttributes [j] &= ~attr;
-        }
+      memcpy (pDest + cbOut, pText + i, cbMax - cbOut - 1);
+      cbOut = cbMax - 1;
+      fTruncated = true;
+      break;
+    }
 
-        iFirst = -1;
-      }
+    memcpy (pDest + cbOut, pText + i, cbRun);
+    cbOut += cbRun;
+    i += cbRun;
 
-      if (c == '\0')
-        break;
+    if (i >= cbText)
+      break;
+
+
+    switch (pText [i])
+    {
+      case '&':   pEscape = "&amp;";  cbEscape = 5;  break;
+      case '<':   pEscape = "&lt;";   cbEscape = 4;  break;
+      case '>':   pEscape = "&gt;";   cbEscape = 4;  break;
+      case '\r':  pEscape = "";       cbEscape = 0;  break;
+      default:    pEscape = NULL;     cbEscape = 0;
     }
-    else if ((c != ' ') && (c != '\t'))
+
+    if (pEscape == NULL)
+      break;
+
+    if (cbOut + cbEscape >= cbMax)
     {
-      iFirst = i;
+      fTruncated = true;
+      break;
     }
+
+    memcpy (pDest + cbOut, pEscape, cbEscape);
+    cbOut += cbEscape;
+    i++;
+  }
+
+  pDest [cbOut] = '\0';
+
+  return fTruncated;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                   HTMLizeTextIncremental
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Converts a piece of a larger block of text with one attribute byte 
+*   per character, appending the markup to pOutput (which is kept 
+*   null-terminated).  Open tags are carried over
+*   to the next call in *pState and are closed only when fFinal is true
+*   (a null-terminated piece, with cbText < 0, is always the last).
+*   Returns true if the output was truncated.
+*/
+
+bool HTMLizeTextIncremental 
+   (OUTPUTBUFFER          *pOutput,
+  	const char            *pText, 
+    int                    cbText, 
+    const TEXTATTRIBUTES  *pAttributes,
+    const HTMLFORMATINFO  *pFmtInfo,
+    int                    nLeadingSpacesToTrim,
+    HTMLIZESTATE          *pState,
+    bool                   fFinal)
+
+{
+  if (cbText < 0)
+  {
+    cbText = strlen (pText);
+    fFinal = true;
   }
+
+
+  return (nLeadingSpacesToTrim > 0)
+            ? HTMLizeTextLoop (pOutput, pText, cbText, pAttributes, pFmtInfo, 
+                               nLeadingSpacesToTrim, pState, fFinal, true)
+            : HTMLizeTextLoop (pOutput, pText, cbText, pAttributes, pFmtInfo, 
+                               0, pState, fFinal, false);
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                              HTMLizeText
+                                                          HTMLizeTextLoop
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-bool HTMLizeText 
-   (char                  *pDest,
-    int                    cbMax,
+/*  The body of HTMLizeTextIncremental().  It is always inlined, and 
+*   fTrim is a constant at each call, so the usual untrimmed case gets
+*   its own copy of the loop without the tests it doesn't need.  cbText
+*   must not be negative.
+*/
+
+static inline __attribute__ ((always_inline))
+bool HTMLizeTextLoop 
+   (OUTPUTBUFFER          *pOutput,
   	const char            *pText, 
     int                    cbText, 
     const TEXTATTRIBUTES  *pAttributes,
     const HTMLFORMATINFO  *pFmtInfo,
-    int                    nLeadingSpacesToTrim)
+    int                    nLeadingSpacesToTrim,
+    HTMLIZESTATE          *pState,
+    bool                   fFinal,
+    bool                   fTrim)
 
 {
-  int index, cbOutput, cbEscape, length;
+  int index, cbEscape, cbRun;
   int IndentState, nSpaces;
-  char c, *pTag;
+  char c;
   const char *pEscape;
-  bool fInLink = false;
-  TEXTATTRIBUTES attrs, CurrentAttrs, StartAttrs, EndAttrs, mask;
+  TEXTATTRIBUTES attrs, mask;
 
 
-  CurrentAttrs = 0;
-  cbOutput = 0;
-  IndentState = nSpaces = 0;
+  IndentState = pState->IndentState;
+  nSpaces = pState->nSpaces;
 
   mask = (pFmtInfo == NULL)
             ? TEXT_ATTR_APPEARANCE_MASK
@@ -168,12 +369,21 @@ bool HTMLizeText
 
   for (index = 0;; index++)
   {
-    c = ((cbText < 0) || (index < cbText)) ? pText [index] : '\0';
-    if (c == '\r')
-      continue;
+    if (index >= cbText)
+    {
+      c = '\0';
+      if (!fFinal)
+        break;
+    }
+    else
+    {
+      c = pText [index];
+      if (c == '\r')
+        continue;
+    }
 
 
-    if (nLeadingSpacesToTrim > 0)
+    if (fTrim)
     {
       switch (c)
       {
@@ -197,234 +407,694 @@ bool HTMLizeText
     }
 
     
-    attrs = ((c == '\0') || (pAttributes == NULL)) 
-                 ? 0 : (pAttributes [index] & mask);
+    attrs = (c == '\0') ? 0 : (pAttributes [index] & mask);
 
-    StartAttrs = attrs & ~CurrentAttrs;
-    EndAttrs = ~attrs & CurrentAttrs;
+    if ((attrs != pState->CurrentAttrs)
+          && !WriteAttributeChanges (pOutput, pText + index, pAttributes + index,
+                                     attrs, pFmtInfo, pState))
+      break;
 
 
-    /*  Generate end tags as necessary.
+    /*  Exit the loop if we've reached the end of the text.
     */
 
-    if (fInLink && (EndAttrs & TEXT_ATTR_LINK_MASK))
-    {
-      if (cbMax - cbOutput < 5)
-        break;
-      memcpy (pDest + cbOutput, "</a>", 4);
-      cbOutput += 4;
+    if (c == '\0')
+      break;
 
-      fInLink = false;
-      CurrentAttrs &= ~TEXT_ATTR_LINK_MASK;
-    }
 
-    if (EndAttrs & TEXT_ATTR_ITALIC)
-    {
-      if (cbMax - cbOutput < 8)
-        break;
-      memcpy (pDest + cbOutput, "</span>", 7);
-      cbOutput += 7;
+    /*  Add the character to the output, substituting an HTML entity if
+    *   the character is "&", "<", or ">".
+    */  
 
-      CurrentAttrs &= ~TEXT_ATTR_ITALIC;
+    switch (c)
+    {
+      case '&':  pEscape = "&amp;";  cbEscape = 5;  break;
+      case '<':  pEscape = "&lt;";   cbEscape = 4;  break;
+      case '>':  pEscape = "&gt;";   cbEscape = 4;  break;
+      default:   pEscape = NULL;     cbEscape = 1;
     }
 
-    if (EndAttrs & TEXT_ATTR_BOLD)
+    if (!ReserveOutputSpace (pOutput, cbEscape + 1))
+      break;
+ 
+    if (pEscape == NULL)
     {
-      if (cbMax - cbOutput < 8)
-        break;
-      memcpy (pDest + cbOutput, "</span>", 7);
-      cbOutput += 7;
-      
-      CurrentAttrs &= ~TEXT_ATTR_BOLD;
+      pOutput->pData [pOutput->cbData] = c;
+    }
+    else
+    {
+      memcpy (pOutput->pData + pOutput->cbData, pEscape, cbEscape);
     }
 
-
-    /*  Exit the loop if we've reached the end of the text.
-    */
-
-    if (c == '\0')
-      break;
+    pOutput->cbData += cbEscape;
 
 
-    /*  Generate start tags as necessary.  Note that the attributes appear in the 
-    *   order opposite of the order above.
+    /*  Copy any run of ordinary characters that follows with the same
+    *   attributes without going through all of the above.  Newlines
+    *   matter only when trimming.
     */
 
-    if (StartAttrs & TEXT_ATTR_BOLD)
+    if (!fTrim || (IndentState != 0))
     {
-      if (cbMax - cbOutput < 14)
-        break;
-      memcpy (pDest + cbOutput, "<span Bold=\"\">", 14);
-      cbOutput += 14;
+      cbRun = FindRunEnd (pText + index + 1, 
+                          pAttributes + index + 1,
+                          cbText - index - 1, mask, pState->CurrentAttrs,
+                          fTrim ? '\n' : '\0');
+
+      if (!ReserveOutputSpace (pOutput, cbRun + 1))
+      {
+        cbRun = pOutput->cbAllocated - pOutput->cbData - 1;
+      }
+
+      memcpy (pOutput->pData + pOutput->cbData, pText + index + 1, cbRun);
+      pOutput->cbData += cbRun;
+      index += cbRun;
     }
+  }
+
+
+  if (ReserveOutputSpace (pOutput, 1))
+  {
+    pOutput->pData [pOutput->cbData] = '\0';
+  }
+
+  pState->IndentState = IndentState;
+  pState->nSpaces = nSpaces;
+
+  return (c != '\0') || (fFinal && (pState->CurrentAttrs != 0));
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             HTMLizeSpans
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Converts a block of text whose attributes are in a span list, 
+*   appending the markup to pOutput.  The output is the same as that of 
+*   HTMLizeTextIncremental() given the same attributes one per character,
+*   but tags are only considered at span boundaries.  Returns true if the
+*   output was truncated.
+*/
+
+bool HTMLizeSpans 
+   (OUTPUTBUFFER          *pOutput,
+    const char            *pText,
+    int                    cbText, 
+    const ATTRSPANLIST    *pSpans,
+    const HTMLFORMATINFO  *pFmtInfo,
+    int                    nLeadingSpacesToTrim)
+
+{
+  return (nLeadingSpacesToTrim > 0)
+            ? HTMLizeSpansLoop (pOutput, pText, cbText, pSpans, pFmtInfo, 
+                                nLeadingSpacesToTrim, true)
+            : HTMLizeSpansLoop (pOutput, pText, cbText, pSpans, pFmtInfo, 
+                                0, false);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         HTMLizeSpansLoop
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  The body of HTMLizeSpans(), inlined with fTrim constant in the same
+*   way as HTMLizeTextLoop().
+*/
+
+static inline __attribute__ ((always_inline))
+bool HTMLizeSpansLoop 
+   (OUTPUTBUFFER          *pOutput,
+    const char            *pText,
+    int                    cbText, 
+    const ATTRSPANLIST    *pSpans,
+    const HTMLFORMATINFO  *pFmtInfo,
+    int                    nLeadingSpacesToTrim,
+    bool                   fTrim)
+
+{
+  int k, index, iEnd, cbEscape, cbRun;
+  int IndentState = 0, nSpaces = 0;
+  char c;
+  const char *pEscape;
+  bool fTruncated = false;
+  TEXTATTRIBUTES attrs, mask;
+  HTMLIZESTATE state;
+
+
+  memset (&state, 0, sizeof (state));
+
+  mask = (pFmtInfo == NULL)
+            ? TEXT_ATTR_APPEARANCE_MASK
+            : (TEXT_ATTR_APPEARANCE_MASK | TEXT_ATTR_LINK_MASK);
 
 
-    if (StartAttrs & TEXT_ATTR_ITALIC)
+  for (k = 0; (k < pSpans->nSpans) && !fTruncated; k++)
+  {
+    attrs = pSpans->pSpans [k].attrs & mask;
+    index = pSpans->pSpans [k].iStart;
+    iEnd = index + pSpans->pSpans [k].length;
+
+    if (iEnd > cbText)
     {
-      if (cbMax - cbOutput < 14)
-        break;
-      memcpy (pDest + cbOutput, "<span Ital=\"\">", 14);
-      cbOutput += 14;
+      iEnd = cbText;
     }
 
-
-    if ((StartAttrs & TEXT_ATTR_URI)
-           && ((pTag = CreateUriLinkTag (pText + index, pAttributes + index, pFmtInfo)) != NULL))
+    for (; index < iEnd; index++)
     {
-      length = strlen (pTag);
-      if (cbMax - cbOutput < length + 1)
+      c = pText [index];
+      if (c == '\r')
+        continue;
+
+
+      if (fTrim)
       {
-        free (pTag);
-        break;
+        switch (c)
+        {
+          case ' ':
+          case '\t':
+            if (IndentState == 0)
+            {
+              if (++nSpaces <= nLeadingSpacesToTrim)           
+                continue;
+              IndentState = 1;
+            }
+            break;
+
+          case '\n':
+            IndentState = nSpaces = 0;
+            break;
+
+          default:
+            IndentState = 2;
+        }
       }
-                 
-      memcpy (pDest + cbOutput, pTag, length);
-      free (pTag);
-
-      cbOutput += length;
-      fInLink = true;
-    }
 
 
-    if ((StartAttrs & TEXT_ATTR_MAN_PAGE_REF)
-           && ((pTag = CreateManPageLinkTag (pText + index, pAttributes + index, pFmtInfo)) != NULL))
-    {
-      length = strlen (pTag);
-      if (cbMax - cbOutput < length + 1)
+      if ((attrs != state.CurrentAttrs)
+            && !WriteSpanAttributeChanges (pOutput, pText, cbText, pSpans, k, 
+                                           index, attrs, pFmtInfo, &state))
       {
-        free (pTag);
+        fTruncated = true;
         break;
       }
-                 
-      memcpy (pDest + cbOutput, pTag, length);
-      free (pTag);
 
-      cbOutput += length;
-      fInLink = true;
-    }
 
+      switch (c)
+      {
+        case '&':  pEscape = "&amp;";  cbEscape = 5;  break;
+        case '<':  pEscape = "&lt;";   cbEscape = 4;  break;
+        case '>':  pEscape = "&gt;";   cbEscape = 4;  break;
+        default:   pEscape = NULL;     cbEscape = 1;
+      }
 
-    if ((StartAttrs & TEXT_ATTR_INFO_LINK)
-           && ((pTag = CreateInfoLinkTag (pText + index, pAttributes + index, pFmtInfo)) != NULL))
-    {
-      length = strlen (pTag);
-      if (cbMax - cbOutput < length + 1)
+      if (!ReserveOutputSpace (pOutput, cbEscape + 1))
       {
-        free (pTag);
+        fTruncated = true;
         break;
       }
-                 
-      memcpy (pDest + cbOutput, pTag, length);
-      free (pTag);
+   
+      if (pEscape == NULL)
+      {
+        pOutput->pData [pOutput->cbData] = c;
+      }
+      else
+      {
+        memcpy (pOutput->pData + pOutput->cbData, pEscape, cbEscape);
+      }
 
-      cbOutput += length;
-      fInLink = true;
-    }
+      pOutput->cbData += cbEscape;
 
-    CurrentAttrs |= StartAttrs;
 
+      /*  The rest of the span needs no attention up to the next special
+      *   character.
+      */
 
-    /*  Add the character to the output, substituting an HTML entity if
-    *   the character is "&", "<", or ">".
-    */  
+      if (!fTrim || (IndentState != 0))
+      {
+        cbRun = FindRunEnd (pText + index + 1, NULL, iEnd - index - 1, 
+                            0, 0, fTrim ? '\n' : '\0');
 
-    switch (c)
-    {
-      case '&':  pEscape = "&amp;";  cbEscape = 5;  break;
-      case '<':  pEscape = "&lt;";   cbEscape = 4;  break;
-      case '>':  pEscape = "&gt;";   cbEscape = 4;  break;
-      default:   pEscape = NULL;     cbEscape = 1;
-    }
+        if (!ReserveOutputSpace (pOutput, cbRun + 1))
+        {
+          cbRun = pOutput->cbAllocated - pOutput->cbData - 1;
+        }
 
-    if (cbMax - cbOutput < cbEscape + 1)
-      break;
- 
-    if (pEscape == NULL)
-    {
-      pDest [cbOutput] = c;
-    }
-    else
-    {
-      memcpy (pDest + cbOutput, pEscape, cbEscape);
+        memcpy (pOutput->pData + pOutput->cbData, pText + index + 1, cbRun);
+        pOutput->cbData += cbRun;
+        index += cbRun;
+      }
     }
-
-    cbOutput += cbEscape;
   }
 
 
-  pDest [cbOutput] = '\0';
+  if (!fTruncated
+        && !WriteAttributeChanges (pOutput, pText + cbText, NULL, 0, pFmtInfo, &state))
+  {
+    fTruncated = true;
+  }
+
+  if (ReserveOutputSpace (pOutput, 1))
+  {
+    pOutput->pData [pOutput->cbData] = '\0';
+  }
 
-  return (c != '\0') || (CurrentAttrs != 0);
+  return fTruncated;
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                     CreateManPageLinkTag
+                                                               FindRunEnd
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Returns the length of the run of characters at the start of pText 
+*   that can be copied to the output as they are: the offset of the first
+*   "&", "<", ">", carriage return, null or cExtra, or of the first
+*   character whose attributes (masked) differ from attrs.  pAttributes
+*   may be NULL.  Uses AVX2 when the processor supports it, SSE2 
+*   otherwise, and plain C on other architectures.
+*/
+
+#if defined (__x86_64__) || defined (__i386__)
+
+/*  Checks 32 characters at a time, and stops at the first one that ends
+*   the run or at the first that it didn't check.
+*/
+
+__attribute__ ((target ("avx2")))
 static
-char* CreateManPageLinkTag
+int FindRunEndAVX2
    (const char            *pText,
     const TEXTATTRIBUTES  *pAttributes,
-    const HTMLFORMATINFO  *pFmtInfo)
+    int                    cbText,
+    TEXTATTRIBUTES         mask,
+    TEXTATTRIBUTES         attrs,
+    char                   cExtra)
 
 {
-  unsigned int i, j;
-  bool fNeedAbsoluteURL = false;
-  TEXTATTRIBUTES attrs;
-  char c, *pTag = NULL;
-  char target [80];
+  int i;
+  unsigned int bits;
+  const __m256i vAmp = _mm256_set1_epi8 ('&'), vGt = _mm256_set1_epi8 ('>');
+  const __m256i vCR = _mm256_set1_epi8 ('\r'), vExtra = _mm256_set1_epi8 (cExtra);
+  const __m256i vTwo = _mm256_set1_epi8 (2), vZero = _mm256_setzero_si256 ();
+  const __m256i vMask = _mm256_set1_epi8 (mask), vAttrs = _mm256_set1_epi8 (attrs);
+  __m256i block, hits;
 
 
-  for (i = j = 0
-  	     ; ((c = pText [i]) != '\0') 
-               && ((attrs = pAttributes [i]) & TEXT_ATTR_MAN_PAGE_REF)
-               && (j < sizeof (target) - 1)
-  	     ; i++)
+  for (i = 0; i + 32 <= cbText; i += 32)
   {
-    if (attrs & TEXT_ATTR_LINK_SKIP)
-      continue;
+    /*  "<" and ">" differ only in bit 1.
+    */
 
-    if (c == ':')
+    block = _mm256_loadu_si256 ((const __m256i*) (pText + i));
+    hits = _mm256_or_si256 (_mm256_or_si256 (_mm256_cmpeq_epi8 (block, vAmp),
+                                             _mm256_cmpeq_epi8 (_mm256_or_si256 (block, vTwo), vGt)),
+                            _mm256_or_si256 (_mm256_or_si256 (_mm256_cmpeq_epi8 (block, vCR),
+                                                              _mm256_cmpeq_epi8 (block, vExtra)),
+                                             _mm256_cmpeq_epi8 (block, vZero)));
+    bits = (unsigned int) _mm256_movemask_epi8 (hits);
+
+    if (pAttributes != NULL)
     {
-      fNeedAbsoluteURL = true;
+      block = _mm256_loadu_si256 ((const __m256i*) (pAttributes + i));
+      bits |= ~(unsigned int) _mm256_movemask_epi8 
+                                 (_mm256_cmpeq_epi8 (_mm256_and_si256 (block, vMask), vAttrs));
     }
 
-    target [j++] = c;
+    if (bits != 0)
+      return i + __builtin_ctz (bits);
   }
 
-  target [j] = '\0';
-
-
-  asprintf (&pTag, "<a %s href=\"%sman/%s\">", 
-            pFmtInfo->pManPageLinkAttrs,
-            fNeedAbsoluteURL ? pFmtInfo->pUriPrefix : "",
-            target);
-
-  return pTag;
+  return i;
 }
 
+#endif
 
 
-/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                        CreateInfoLinkTag
--~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
-
 static
-char* CreateInfoLinkTag
+int FindRunEnd
    (const char            *pText,
     const TEXTATTRIBUTES  *pAttributes,
-    const HTMLFORMATINFO  *pFmtInfo)
+    int                    cbText,
+    TEXTATTRIBUTES         mask,
+    TEXTATTRIBUTES         attrs,
+    char                   cExtra)
 
 {
-  int k, iTargetFirst = -1, iTargetLast = -1, cbTarget;
-  int iFileFirst = -1, iFileLast = -1, cbContext;
-  char *pEncodedName, *pTag = NULL;
-  const char *pTarget, *pContext;
+  int i = 0;
+  char c;
 
 
-  for (k = 0
+#if defined (__x86_64__) || defined (__i386__)
+  static const bool fHaveAVX2 = __builtin_cpu_supports ("avx2");
+
+  if (fHaveAVX2 && (cbText >= 64))
+  {
+    i = FindRunEndAVX2 (pText, pAttributes, cbText, mask, attrs, cExtra);
+  }
+#endif
+
+
+#if defined (__SSE2__)
+  unsigned int bits;
+  const __m128i vAmp = _mm_set1_epi8 ('&'), vGt = _mm_set1_epi8 ('>');
+  const __m128i vCR = _mm_set1_epi8 ('\r'), vExtra = _mm_set1_epi8 (cExtra);
+  const __m128i vTwo = _mm_set1_epi8 (2), vZero = _mm_setzero_si128 ();
+  const __m128i vMask = _mm_set1_epi8 (mask), vAttrs = _mm_set1_epi8 (attrs);
+  __m128i block, hits;
+
+  for (; i + 16 <= cbText; i += 16)
+  {
+    block = _mm_loadu_si128 ((const __m128i*) (pText + i));
+    hits = _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (block, vAmp),
+                                       _mm_cmpeq_epi8 (_mm_or_si128 (block, vTwo), vGt)),
+                         _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (block, vCR),
+                                                     _mm_cmpeq_epi8 (block, vExtra)),
+                                       _mm_cmpeq_epi8 (block, vZero)));
+    bits = (unsigned int) _mm_movemask_epi8 (hits);
+
+    if (pAttributes != NULL)
+    {
+      block = _mm_loadu_si128 ((const __m128i*) (pAttributes + i));
+      bits |= 0xffff & ~(unsigned int) _mm_movemask_epi8 
+                                          (_mm_cmpeq_epi8 (_mm_and_si128 (block, vMask), vAttrs));
+    }
+
+    if (bits != 0)
+      return i + __builtin_ctz (bits);
+  }
+#endif
+
+
+  for (; i < cbText; i++)
+  {
+    c = pText [i];
+    if ((c == '&') || (c == '<') || (c == '>') || (c == '\r') 
+          || (c == '\0') || (c == cExtra))
+      return i;
+
+    if ((pAttributes != NULL) && ((pAttributes [i] & mask) != attrs))
+      return i;
+  }
+
+  return cbText;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                WriteSpanAttributeChanges
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  WriteAttributeChanges() for HTMLizeSpans().  The link tag writers 
+*   want attributes one per character, so those of a link that starts
+*   here are spelled out for them.
+*/
+
+static
+bool WriteSpanAttributeChanges
+   (OUTPUTBUFFER          *pOutput,
+    const char            *pText,
+    int                    cbText,
+    const ATTRSPANLIST    *pSpans,
+    int                    iSpan,
+    int                    index,
+    TEXTATTRIBUTES         attrs,
+    const HTMLFORMATINFO  *pFmtInfo,
+    HTMLIZESTATE          *pState)
+
+{
+  int k, i, iEnd, cbLink;
+  bool fResult;
+  TEXTATTRIBUTES *pLinkAttrs;
+  TEXTATTRIBUTES buffer [256];
+
+
+  if (!(attrs & ~pState->CurrentAttrs & TEXT_ATTR_LINK_MASK))
+    return WriteAttributeChanges (pOutput, pText + index, NULL, attrs, 
+                                  pFmtInfo, pState);
+
+
+  for (k = iSpan
+         ; (k < pSpans->nSpans) 
+              && (pSpans->pSpans [k].attrs & TEXT_ATTR_LINK_MASK)
+              && (pSpans->pSpans [k].iStart < cbText)
+         ; k++)
+  { /* Empty loop. */ }
+
+  iEnd = (k > iSpan) ? (pSpans->pSpans [k - 1].iStart + pSpans->pSpans [k - 1].length) 
+                     : index;
+
+  if (iEnd > cbText)
+  {
+    iEnd = cbText;
+  }
+
+  cbLink = iEnd - index;
+
+  pLinkAttrs = (cbLink < (int) sizeof (buffer)) 
+                  ? buffer 
+                  : (TEXTATTRIBUTES*) malloc (cbLink + 1);
+
+  for (k = iSpan, i = index; i < iEnd; i++)
+  {
+    while (i >= pSpans->pSpans [k].iStart + pSpans->pSpans [k].length)
+    {
+      k++;
+    }
+
+    pLinkAttrs [i - index] = pSpans->pSpans [k].attrs;
+  }
+
+  pLinkAttrs [cbLink] = 0;
+
+
+  fResult = WriteAttributeChanges (pOutput, pText + index, pLinkAttrs, attrs, 
+                                   pFmtInfo, pState);
+
+  if (pLinkAttrs != buffer)
+  {
+    free (pLinkAttrs);
+  }
+
+  return fResult;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                    WriteAttributeChanges
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Writes the end and start tags needed to go from the attributes in
+*   *pState to attrs, at the character pText (whose attributes, along 
+*   with those of the characters after it, are at pAttributes).  Returns
+*   false if the output is full.
+*/
+
+static
+bool WriteAttributeChanges
+   (OUTPUTBUFFER          *pOutput,
+    const char            *pText,
+    const TEXTATTRIBUTES  *pAttributes,
+    TEXTATTRIBUTES         attrs,
+    const HTMLFORMATINFO  *pFmtInfo,
+    HTMLIZESTATE          *pState)
+
+{
+  TEXTATTRIBUTES StartAttrs = attrs & ~pState->CurrentAttrs;
+  TEXTATTRIBUTES EndAttrs = ~attrs & pState->CurrentAttrs;
+
+
+  /*  Generate end tags as necessary.
+  */
+
+  if (pState->fInLink && (EndAttrs & TEXT_ATTR_LINK_MASK))
+  {
+    if (!AppendTag (pOutput, "</a>", 4))
+      return false;
+
+    pState->fInLink = false;
+    pState->CurrentAttrs &= ~TEXT_ATTR_LINK_MASK;
+  }
+
+  if (EndAttrs & TEXT_ATTR_ITALIC)
+  {
+    if (!AppendTag (pOutput, "</span>", 7))
+      return false;
+
+    pState->CurrentAttrs &= ~TEXT_ATTR_ITALIC;
+  }
+
+  if (EndAttrs & TEXT_ATTR_BOLD)
+  {
+    if (!AppendTag (pOutput, "</span>", 7))
+      return false;
+    
+    pState->CurrentAttrs &= ~TEXT_ATTR_BOLD;
+  }
+
+
+  /*  Generate start tags as necessary.  Note that the attributes appear in the 
+  *   order opposite of the order above.
+  */
+
+  if (StartAttrs & TEXT_ATTR_BOLD)
+  {
+    if (!AppendTag (pOutput, "<span Bold=\"\">", 14))
+      return false;
+  }
+
+
+  if (StartAttrs & TEXT_ATTR_ITALIC)
+  {
+    if (!AppendTag (pOutput, "<span Ital=\"\">", 14))
+      return false;
+  }
+
+
+  if (StartAttrs & TEXT_ATTR_URI)
+  {
+    if (!WriteUriLinkTag (pOutput, pText, pAttributes, pFmtInfo))
+      return false;
+
+    pState->fInLink = true;
+  }
+
+
+  if (StartAttrs & TEXT_ATTR_MAN_PAGE_REF)
+  {
+    if (!WriteManPageLinkTag (pOutput, pText, pAttributes, pFmtInfo))
+      return false;
+
+    pState->fInLink = true;
+  }
+
+
+  if (StartAttrs & TEXT_ATTR_INFO_LINK)
+  {
+    if (!WriteInfoLinkTag (pOutput, pText, pAttributes, pFmtInfo))
+      return false;
+
+    pState->fInLink = true;
+  }
+
+  pState->CurrentAttrs |= StartAttrs;
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                AppendTag
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Appends markup to the output, leaving room for the terminating null.
+*/
+
+static
+bool AppendTag
+   (OUTPUTBUFFER  *pOutput,
+    const char    *pTag,
+    int            length)
+
+{
+  if (!ReserveOutputSpace (pOutput, length + 1))
+    return false;
+
+  memcpy (pOutput->pData + pOutput->cbData, pTag, length);
+  pOutput->cbData += length;
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      WriteManPageLinkTag
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  The Write...LinkTag() functions append an opening <a> tag for the 
+*   link starting at pText to the output.  They return false, leaving
+*   the output as it was, if the tag would not fit.
+*/
+
+static
+bool WriteManPageLinkTag
+   (OUTPUTBUFFER          *pOutput,
+    const char            *pText,
+    const TEXTATTRIBUTES  *pAttributes,
+    const HTMLFORMATINFO  *pFmtInfo)
+
+{
+  unsigned int i, j;
+  int cbStart = pOutput->cbData;
+  bool fNeedAbsoluteURL = false;
+  TEXTATTRIBUTES attrs;
+  char c;
+  char target [80];
+
+
+  for (i = j = 0
+  	     ; ((c = pText [i]) != '\0') 
+               && ((attrs = pAttributes [i]) & TEXT_ATTR_MAN_PAGE_REF)
+               && (j < sizeof (target) - 1)
+  	     ; i++)
+  {
+    if (attrs & TEXT_ATTR_LINK_SKIP)
+      continue;
+
+    if (c == ':')
+    {
+      fNeedAbsoluteURL = true;
+    }
+
+    target [j++] = c;
+  }
+
+
+  if (AppendToOutputBuffer (pOutput, "<a ", 3)
+        && AppendToOutputBuffer (pOutput, pFmtInfo->pManPageLinkAttrs, -1)
+        && AppendToOutputBuffer (pOutput, " href=\"", 7)
+        && (!fNeedAbsoluteURL
+               || AppendToOutputBuffer (pOutput, pFmtInfo->pUriPrefix, -1))
+        && AppendToOutputBuffer (pOutput, "man/", 4)
+        && AppendToOutputBuffer (pOutput, target, j)
+        && AppendToOutputBuffer (pOutput, "\">", 2)
+        && ReserveOutputSpace (pOutput, 1))
+  {
+    return true;
+  }
+
+  pOutput->cbData = cbStart;
+
+  return false;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         WriteInfoLinkTag
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+bool WriteInfoLinkTag
+   (OUTPUTBUFFER          *pOutput,
+    const char            *pText,
+    const TEXTATTRIBUTES  *pAttributes,
+    const HTMLFORMATINFO  *pFmtInfo)
+
+{
+  int k, iTargetFirst = -1, iTargetLast = -1, cbTarget;
+  int iFileFirst = -1, iFileLast = -1, cbContext;
+  int cbStart = pOutput->cbData, cbEncodedName;
+  const char *pTarget, *pContext;
+
+
+  for (k = 0
          ; (pText [k] != '\0') 
                 && (pAttributes [k] & TEXT_ATTR_INFO_LINK)
          ; k++)
@@ -478,37 +1148,59 @@ char* CreateInfoLinkTag
   }
 
 
-  pEncodedName = EncodeInfoNodeName (pTarget, cbTarget);
-  if (pEncodedName == NULL)
-  	return NULL;
+  /*  Encoding never adds or removes colons, so the target can be checked
+  *   for one before it is encoded.
+  */
+
+  if (!AppendToOutputBuffer (pOutput, "<a ", 3)
+        || !AppendToOutputBuffer (pOutput, pFmtInfo->pInfoLinkAttrs, -1)
+        || !AppendToOutputBuffer (pOutput, " href=\"", 7)
+        || ((memchr (pTarget, ':', cbTarget) != NULL)
+               && !AppendToOutputBuffer (pOutput, pFmtInfo->pUriPrefix, -1))
+        || !AppendToOutputBuffer (pOutput, "info/", 5)
+        || !AppendToOutputBuffer (pOutput, pContext, strnlen (pContext, cbContext))
+        || !AppendToOutputBuffer (pOutput, "/", 1))
+  {
+    pOutput->cbData = cbStart;
+    return false;
+  }
+
+  ReserveOutputSpace (pOutput, cbTarget * 3 + 1);
+
+  cbEncodedName = EncodeInfoNodeNameInto (pOutput->pData + pOutput->cbData, 
+                                          pOutput->cbAllocated - pOutput->cbData,
+                                          pTarget, cbTarget);
+  if (cbEncodedName >= 0)
+  {
+    pOutput->cbData += cbEncodedName;
 
-  asprintf (&pTag, "<a %s href=\"%sinfo/%.*s/%s\">", 
-            pFmtInfo->pInfoLinkAttrs,
-            (strchr (pEncodedName, ':') != NULL)
-                 ? pFmtInfo->pUriPrefix : "",
-            cbContext, pContext,
-            pEncodedName);
+    if (AppendToOutputBuffer (pOutput, "\">", 2)
+          && ReserveOutputSpace (pOutput, 1))
+    {
+      return true;
+    }
+  }
 
-  free (pEncodedName);
+  pOutput->cbData = cbStart;
 
-  return pTag;
+  return false;
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                         CreateUriLinkTag
+                                                          WriteUriLinkTag
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
 static
-char* CreateUriLinkTag
-   (const char            *pText,
+bool WriteUriLinkTag
+   (OUTPUTBUFFER          *pOutput,
+    const char            *pText,
     const TEXTATTRIBUTES  *pAttributes,
     const HTMLFORMATINFO  *pFmtInfo)
 
 {
-  int k;
-  char *pTag = NULL;
+  int k, cbStart = pOutput->cbData;
 
 
   for (k = 0
@@ -517,11 +1209,19 @@ char* CreateUriLinkTag
   { /* Empty loop. */ }
 
 
-  asprintf (&pTag, "<a %s href=\"%.*s\">", 
-            pFmtInfo->pWebLinkAttrs,
-            k, pText);
+  if (AppendToOutputBuffer (pOutput, "<a ", 3)
+        && AppendToOutputBuffer (pOutput, pFmtInfo->pWebLinkAttrs, -1)
+        && AppendToOutputBuffer (pOutput, " href=\"", 7)
+        && AppendToOutputBuffer (pOutput, pText, k)
+        && AppendToOutputBuffer (pOutput, "\">", 2)
+        && ReserveOutputSpace (pOutput, 1))
+  {
+    return true;
+  }
+
+  pOutput->cbData = cbStart;
 
-  return pTag;
+  return false;
 }
 
 
@@ -536,90 +1236,653 @@ int RecognizeURIs
     TEXTATTRIBUTES  *pAttrs)
 
 {
-  int i, index, iStart, iEnd, count;
-  regmatch_t match;
+  return RecognizeHyperlinks (pText, length, pAttrs, TEXT_ATTR_URI);
+}
 
 
-  if (length < 0)
-  {
-    length = strlen (pText);
-  }
 
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                     RecognizeManPageRefs
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+int RecognizeManPageRefs 
+   (const char      *pText, 
+    int              length,
+    TEXTATTRIBUTES  *pAttrs)
 
-  index = count = 0; 
-  while ((index < length)
-            && !tre_regnexec (&UriRegex, pText + index, length - index, 1, &match, 0))
-  {
-    iStart = index + match.rm_so;
-    iEnd = index + match.rm_eo;
+{
+  return RecognizeHyperlinks (pText, length, pAttrs, TEXT_ATTR_MAN_PAGE_REF);
+}
 
-    for (i = iStart; i < iEnd; i++)
-    {
-      pAttrs [i] = (pAttrs [i] & ~TEXT_ATTR_APPEARANCE_MASK)
-                      | TEXT_ATTR_URI;
-    }
 
-    count++;
-    index = iEnd;
-  }
 
-  return count;
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      RecognizeHyperlinks
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Recognizes web URIs and/or manual page references (as selected by
+*   LinkTypes) in a single left-to-right pass.  The results are the same
+*   as those of the regular expressions
+*
+*     \b(https?|ftp)://[-A-Z0-9+&@#/%?=~_|!:,.;]*[A-Z0-9+&@#/%=~_|]
+*     [a-z0-9.+_:-]{1,32}\([0-9]{1,3}[a-z]{0,4}\)
+*
+*   (both case-insensitive) applied with leftmost-longest semantics, and
+*   a manual page reference is rejected if it overlaps a URI or an Info
+*   link.
+*/
+
+int RecognizeHyperlinks 
+   (const char      *pText, 
+    int              length,
+    TEXTATTRIBUTES  *pAttrs,
+    TEXTATTRIBUTES   LinkTypes)
+
+{
+  return ScanForHyperlinks (pText, length, pAttrs, NULL, LinkTypes);
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                     RecognizeManPageRefs
+                                                  RecognizeSpanHyperlinks
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-int RecognizeManPageRefs 
+/*  Same as RecognizeHyperlinks(), but marks the links in a span list.
+*/
+
+int RecognizeSpanHyperlinks 
    (const char      *pText, 
     int              length,
-    TEXTATTRIBUTES  *pAttrs)
+    ATTRSPANLIST    *pSpans,
+    TEXTATTRIBUTES   LinkTypes)
+
+{
+  return ScanForHyperlinks (pText, length, NULL, pSpans, LinkTypes);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                        ScanForHyperlinks
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  The scanner behind the Recognize...() functions.  The attributes are
+*   either one per character (pAttrs) or a span list (pSpans); the other
+*   pointer is NULL.  Links found in a span list are collected and 
+*   applied together at the end, so that marking them does not shift the
+*   rest of the list once per link.
+*/
+
+static
+int ScanForHyperlinks 
+   (const char      *pText, 
+    int              length,
+    TEXTATTRIBUTES  *pAttrs,
+    ATTRSPANLIST    *pSpans,
+    TEXTATTRIBUTES   LinkTypes)
 
 {
-  int i, index, iStart, iEnd, count;
+  int i, j, iStart, iEnd, iRunStart, iUriEnd, count;
+  unsigned char c, cc;
+  RANGEQUEUE PendingLinks;
   bool fValidLink;
-  regmatch_t match;
+  bool fFindUris = (LinkTypes & TEXT_ATTR_URI) != 0;
+  bool fFindPageRefs = (LinkTypes & TEXT_ATTR_MAN_PAGE_REF) != 0;
+
 
-  
   if (length < 0)
   {
     length = strlen (pText);
   }
 
 
-  index = count = 0; 
-  while ((index < length)
-            && !tre_regnexec (&PageRefRegex, pText + index, length - index, 1, &match, 0))
-  {
-    iStart = index + match.rm_so;
-    iEnd = index + match.rm_eo;
+  InitRangeQueue (&PendingLinks);
+
+  count = 0;
+  iRunStart = iUriEnd = 0;
 
+  for (i = 0; i < length; i++)
+  {
+    c = (unsigned char) pText [i];
+    cc = CharClasses [c];
 
-    fValidLink = true;
-    for (i = iStart; i < iEnd; i++)
+    if (cc & CC_PAGE_NAME)
     {
-      if (pAttrs [i] & (TEXT_ATTR_URI | TEXT_ATTR_INFO_LINK))
+      /*  A URI can begin only with "h" or "f" at the start of a word.
+      */
+
+      if (fFindUris
+            && (((c | 0x20) == 'h') || ((c | 0x20) == 'f'))
+            && (i >= iUriEnd)
+            && ((i == 0) || !(CharClasses [(unsigned char) pText [i - 1]] & CC_WORD))
+            && ((iEnd = MatchUri (pText, length, i)) > 0))
       {
-        fValidLink = false;
-        break;
+        MarkLink (pAttrs, pSpans, &PendingLinks, i, iEnd, TEXT_ATTR_URI);
+        count++;
+        iUriEnd = iEnd;
       }
+
+      continue;
     }
 
-    
-    if (fValidLink)
+
+    /*  A manual page reference ends with a parenthesized section number
+    *   that directly follows a run of name characters.  If the run is
+    *   longer than the maximum name length, the match begins inside it.
+    */
+
+    if (fFindPageRefs
+          && (c == '(')
+          && (i > iRunStart)
+          && ((iEnd = MatchPageRefSuffix (pText, length, i)) > 0))
     {
-      for (i = iStart; i < iEnd; i++)
+      iStart = (i - iRunStart > MAX_PAGE_NAME_LENGTH)
+                    ? (i - MAX_PAGE_NAME_LENGTH) : iRunStart;
+
+      fValidLink = true;
+
+      if (pSpans != NULL)
+      {
+        /*  URIs found by this scan may still be pending, but they cannot
+        *   overlap the reference unless the last one ends inside it.
+        */
+
+        if (iUriEnd > iStart)
+        {
+          fValidLink = false;
+        }
+
+        for (j = FindAttrSpan (pSpans, iStart)
+               ; fValidLink && (j < pSpans->nSpans) && (pSpans->pSpans [j].iStart < iEnd)
+               ; j++)
+        {
+          if (pSpans->pSpans [j].attrs & (TEXT_ATTR_URI | TEXT_ATTR_INFO_LINK))
+          {
+            fValidLink = false;
+            break;
+          }
+        }
+      }
+      else
+      {
+        for (j = iStart; j < iEnd; j++)
+        {
+          if (pAttrs [j] & (TEXT_ATTR_URI | TEXT_ATTR_INFO_LINK))
+          {
+            fValidLink = false;
+            break;
+          }
+        }
+      }
+
+      if (fValidLink)
       {
-        pAttrs [i] = (pAttrs [i] & ~TEXT_ATTR_APPEARANCE_MASK)
-                        | TEXT_ATTR_MAN_PAGE_REF;
+        MarkLink (pAttrs, pSpans, &PendingLinks,
+                  iStart, iEnd, TEXT_ATTR_MAN_PAGE_REF);
+        count++;
       }
-      count++;
+
+      i = iEnd - 1;
     }
 
-    index = iEnd;
+    iRunStart = i + 1;
+  }
+
+  if (PendingLinks.nRanges > 0)
+  {
+    ApplyRanges (pSpans, PendingLinks.pRanges, PendingLinks.nRanges,
+                 TEXT_ATTR_APPEARANCE_MASK);
   }
 
   return count;
 }
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                 MarkLink
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Gives the characters from iStart up to iEnd the link attribute 
+*   LinkType.  Link text is never shown bold or italic.  For a span list
+*   the link is only queued in pPending.
+*/
+
+static
+void MarkLink
+   (TEXTATTRIBUTES  *pAttrs,
+    ATTRSPANLIST    *pSpans,
+    RANGEQUEUE      *pPending,
+    int              iStart,
+    int              iEnd,
+    TEXTATTRIBUTES   LinkType)
+
+{
+  int j;
+
+
+  if (pSpans != NULL)
+  {
+    QueueRange (pSpans, pPending, iStart, iEnd, LinkType);
+    return;
+  }
+
+  for (j = iStart; j < iEnd; j++)
+  {
+    pAttrs [j] = (pAttrs [j] & ~TEXT_ATTR_APPEARANCE_MASK) | LinkType;
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           InitRangeQueue
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void InitRangeQueue
+   (RANGEQUEUE  *pQueue)
+
+{
+  pQueue->pRanges = pQueue->Local;
+  pQueue->nRanges = 0;
+  pQueue->nAllocated = MAX_PENDING_RANGES;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               QueueRange
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Adds a range to the queue, moving the queue into the span list's 
+*   arena when it outgrows its local array.
+*/
+
+static
+void QueueRange
+   (ATTRSPANLIST    *pSpans,
+    RANGEQUEUE      *pQueue,
+    int              iStart,
+    int              iEnd,
+    TEXTATTRIBUTES   attrs)
+
+{
+  LINKRANGE *pRange, *pRanges;
+
+
+  if (pQueue->nRanges == pQueue->nAllocated)
+  {
+    if (pQueue->pRanges == pQueue->Local)
+    {
+      pRanges = (LINKRANGE*) ArenaAlloc (pSpans->pArena, 
+                                         4 * sizeof (LINKRANGE) * pQueue->nAllocated);
+      memcpy (pRanges, pQueue->Local, sizeof (LINKRANGE) * pQueue->nRanges);
+    }
+    else
+    {
+      pRanges = (LINKRANGE*) ArenaRealloc (pSpans->pArena, pQueue->pRanges,
+                                           sizeof (LINKRANGE) * pQueue->nAllocated,
+                                           4 * sizeof (LINKRANGE) * pQueue->nAllocated);
+    }
+
+    pQueue->pRanges = pRanges;
+    pQueue->nAllocated *= 4;
+  }
+
+  pRange = pQueue->pRanges + pQueue->nRanges++;
+  pRange->iStart   = iStart;
+  pRange->iEnd     = iEnd;
+  pRange->LinkType = attrs;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              ApplyRanges
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Applies the given ranges (sorted, not overlapping) to a span list in 
+*   one pass: inside a range, the bits in clear are removed and the 
+*   range's LinkType is added.  The old spans are first moved to the end
+*   of the list; the new ones, of which there are at most two more per
+*   range, are written from the start and never catch up with the old 
+*   ones still unread.
+*/
+
+static
+void ApplyRanges
+   (ATTRSPANLIST     *pSpans,
+    const LINKRANGE  *pLinks,
+    int               nLinks,
+    TEXTATTRIBUTES    clear)
+
+{
+  int k, m, nOldSpans, iPos, iSpanEnd, iPieceEnd;
+  ATTRSPAN span, *pOldSpans;
+  TEXTATTRIBUTES attrs;
+
+
+  nOldSpans = pSpans->nSpans;
+  ReserveAttrSpans (pSpans, 2 * nLinks);
+
+  pOldSpans = pSpans->pSpans + 2 * nLinks;
+  memmove (pOldSpans, pSpans->pSpans, sizeof (ATTRSPAN) * nOldSpans);
+  pSpans->nSpans = 0;
+
+  for (k = m = 0; k < nOldSpans; k++)
+  {
+    span = pOldSpans [k];
+    iPos = span.iStart;
+    iSpanEnd = span.iStart + span.length;
+
+    while (iPos < iSpanEnd)
+    {
+      while ((m < nLinks) && (pLinks [m].iEnd <= iPos))
+      {
+        m++;
+      }
+
+      if ((m < nLinks) && (pLinks [m].iStart <= iPos))
+      {
+        iPieceEnd = (pLinks [m].iEnd < iSpanEnd) ? pLinks [m].iEnd : iSpanEnd;
+        attrs = (span.attrs & ~clear) | pLinks [m].LinkType;
+      }
+      else
+      {
+        iPieceEnd = ((m < nLinks) && (pLinks [m].iStart < iSpanEnd))
+                        ? pLinks [m].iStart : iSpanEnd;
+        attrs = span.attrs;
+      }
+
+      AppendAttrSpan (pSpans, iPieceEnd - iPos, attrs);
+      iPos = iPieceEnd;
+    }
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                 MatchUri
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the end of the longest URI starting at iStart, or -1 if there
+*   is none.
+*/
+
+static
+int MatchUri
+   (const char  *pText,
+    int          length,
+    int          iStart)
+
+{
+  int i, iEnd = -1;
+
+
+  if ((iStart + 6 <= length) && (strncasecmp (pText + iStart, "ftp://", 6) == 0))
+  {
+    i = iStart + 6;
+  }
+  else if ((iStart + 7 <= length) && (strncasecmp (pText + iStart, "http://", 7) == 0))
+  {
+    i = iStart + 7;
+  }
+  else if ((iStart + 8 <= length) && (strncasecmp (pText + iStart, "https://", 8) == 0))
+  {
+    i = iStart + 8;
+  }
+  else
+    return -1;
+
+
+  for (; (i < length) && (CharClasses [(unsigned char) pText [i]] & CC_URI); i++)
+  {
+    if (CharClasses [(unsigned char) pText [i]] & CC_URI_END)
+    {
+      iEnd = i + 1;
+    }
+  }
+
+  return iEnd;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       MatchPageRefSuffix
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Matches a section suffix such as "(3)" or "(3pm)" beginning with the
+*   parenthesis at iParen.  Returns the end of the suffix, or -1.
+*/
+
+static
+int MatchPageRefSuffix
+   (const char  *pText,
+    int          length,
+    int          iParen)
+
+{
+  int i, n;
+
+
+  i = iParen + 1;
+
+  for (n = 0; (i < length) && (CharClasses [(unsigned char) pText [i]] & CC_DIGIT); n++)
+  {
+    i++;
+  }
+
+  if ((n < 1) || (n > MAX_SECTION_DIGITS))
+    return -1;
+
+  for (n = 0; (i < length) && (CharClasses [(unsigned char) pText [i]] & CC_ALPHA); n++)
+  {
+    i++;
+  }
+
+  if ((n > MAX_SECTION_LETTERS) || (i >= length) || (pText [i] != ')'))
+    return -1;
+
+  return i + 1;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            InitAttrSpans
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void InitAttrSpans
+   (ATTRSPANLIST  *pSpans,
+    ARENA         *pArena)
+
+{
+  pSpans->pSpans = NULL;
+  pSpans->nSpans = 0;
+  pSpans->nAllocated = 0;
+  pSpans->pArena = pArena;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           AppendAttrSpan
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Adds length characters with the given attributes to the end of the
+*   list, extending the last span if it has the same attributes.
+*/
+
+void AppendAttrSpan
+   (ATTRSPANLIST    *pSpans,
+    int              length,
+    TEXTATTRIBUTES   attrs)
+
+{
+  ATTRSPAN *pLast;
+
+
+  if (length <= 0)
+    return;
+
+  if (pSpans->nSpans > 0)
+  {
+    pLast = pSpans->pSpans + pSpans->nSpans - 1;
+
+    if (pLast->attrs == attrs)
+    {
+      pLast->length += length;
+      return;
+    }
+  }
+
+  ReserveAttrSpans (pSpans, 1);
+
+  pLast = pSpans->pSpans + pSpans->nSpans++;
+  pLast->iStart = (pSpans->nSpans > 1) ? (pLast [-1].iStart + pLast [-1].length) : 0;
+  pLast->length = length;
+  pLast->attrs  = attrs;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             FindAttrSpan
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the index of the span containing the character at iPos, or
+*   the number of spans if iPos is past the end.
+*/
+
+int FindAttrSpan
+   (const ATTRSPANLIST  *pSpans,
+    int                  iPos)
+
+{
+  int lo = 0, hi = pSpans->nSpans, mid;
+
+
+  while (lo < hi)
+  {
+    mid = (lo + hi) / 2;
+
+    if (pSpans->pSpans [mid].iStart + pSpans->pSpans [mid].length <= iPos)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            CopyAttrSpans
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Replaces the contents of pDest with the spans of the characters from
+*   iStart up to iEnd in pSource, renumbered to start at 0.
+*/
+
+void CopyAttrSpans
+   (ATTRSPANLIST        *pDest,
+    const ATTRSPANLIST  *pSource,
+    int                  iStart,
+    int                  iEnd)
+
+{
+  int k, iSpanStart, iSpanEnd;
+  const ATTRSPAN *pSpan;
+
+
+  pDest->nSpans = 0;
+
+  for (k = FindAttrSpan (pSource, iStart); k < pSource->nSpans; k++)
+  {
+    pSpan = pSource->pSpans + k;
+
+    if (pSpan->iStart >= iEnd)
+      break;
+
+    iSpanStart = (pSpan->iStart > iStart) ? pSpan->iStart : iStart;
+    iSpanEnd = pSpan->iStart + pSpan->length;
+
+    if (iSpanEnd > iEnd)
+    {
+      iSpanEnd = iEnd;
+    }
+
+    AppendAttrSpan (pDest, iSpanEnd - iSpanStart, pSpan->attrs);
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         DiscardAttrSpans
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Removes the first cbDiscard characters' worth of spans, renumbering
+*   the rest.
+*/
+
+void DiscardAttrSpans
+   (ATTRSPANLIST  *pSpans,
+    int            cbDiscard)
+
+{
+  int k, n;
+  ATTRSPAN *pSpan;
+
+
+  k = FindAttrSpan (pSpans, cbDiscard);
+  n = pSpans->nSpans - k;
+
+  memmove (pSpans->pSpans, pSpans->pSpans + k, sizeof (ATTRSPAN) * n);
+  pSpans->nSpans = n;
+
+  for (pSpan = pSpans->pSpans; pSpan < pSpans->pSpans + n; pSpan++)
+  {
+    if (pSpan->iStart < cbDiscard)
+    {
+      pSpan->length -= cbDiscard - pSpan->iStart;
+      pSpan->iStart = cbDiscard;
+    }
+
+    pSpan->iStart -= cbDiscard;
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         ReserveAttrSpans
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void ReserveAttrSpans
+   (ATTRSPANLIST  *pSpans,
+    int            nMore)
+
+{
+  int nOldAllocated = pSpans->nAllocated;
+
+
+  if (pSpans->nSpans + nMore > pSpans->nAllocated)
+  {
+    pSpans->nAllocated = 2 * (pSpans->nSpans + nMore) + 16;
+
+    pSpans->pSpans = (ATTRSPAN*) ArenaRealloc (pSpans->pArena, pSpans->pSpans,
+                                               sizeof (ATTRSPAN) * nOldAllocated,
+                                               sizeof (ATTRSPAN) * pSpans->nAllocated);
+  }
+}
@@ -85,27 +85,79 @@ struct HTMLFORMATINFO
 
 
 
+/*  Attributes stored as runs rather than one byte per character.  The
+*   spans of a list are in order and together cover the text from 
+*   offset 0 without gaps.  A list allocates from its arena and never
+*   frees.
+*/
+
+struct ARENA;
+
+struct ATTRSPAN
+{
+  int             iStart;
+  int             length;
+  TEXTATTRIBUTES  attrs;
+};
+
+
+struct ATTRSPANLIST
+{
+  ATTRSPAN  *pSpans;
+  int        nSpans;
+  int        nAllocated;
+  ARENA     *pArena;
+};
+
+
+
+/*  State carried between calls to HTMLizeTextIncremental().  Zero it 
+*   before the first call.
+*/
+
+struct HTMLIZESTATE
+{
+  TEXTATTRIBUTES  CurrentAttrs;
+  bool            fInLink;
+  int             IndentState;
+  int             nSpaces;
+};
+
+
+
 extern "C"
 {
 
-extern void htmlInitializeRegexes
-   (void);
+extern bool HTMLEscapeText 
+   (char        *pDest,
+    int          cbMax,
+    const char  *pText,
+    int          cbText);
 
 
-extern bool HTMLizeText 
-   (char                  *pDest,
-    int                    cbMax,
-  	const char            *pText,
+extern bool HTMLizeTextIncremental 
+   (OUTPUTBUFFER          *pOutput,
+    const char            *pText,
     int                    cbText, 
     const TEXTATTRIBUTES  *pAttributes,
     const HTMLFORMATINFO  *pFmtInfo,
+    int                    nLeadingSpacesToTrim,
+    HTMLIZESTATE          *pState,
+    bool                   fFinal);
+
+
+extern bool HTMLizeSpans 
+   (OUTPUTBUFFER          *pOutput,
+    const char            *pText,
+    int                    cbText, 
+    const ATTRSPANLIST    *pSpans,
+    const HTMLFORMATINFO  *pFmtInfo,
     int                    nLeadingSpacesToTrim);
 
 
-extern void NormalizeAttributesOfWhitespace 
+extern void NormalizeSpanWhitespace 
    (const char      *pText, 
-    TEXTATTRIBUTES  *pAttributes,
-    int              length,
+    ATTRSPANLIST    *pSpans,
     TEXTATTRIBUTES   attr);
 
 
@@ -120,6 +172,48 @@ extern int RecognizeManPageRefs
     int              length,
     TEXTATTRIBUTES  *pAttrs);
 
+
+extern int RecognizeHyperlinks 
+   (const char      *pText, 
+    int              length,
+    TEXTATTRIBUTES  *pAttrs,
+    TEXTATTRIBUTES   LinkTypes);
+
+
+extern int RecognizeSpanHyperlinks 
+   (const char      *pText, 
+    int              length,
+    ATTRSPANLIST    *pSpans,
+    TEXTATTRIBUTES   LinkTypes);
+
+
+extern void InitAttrSpans
+   (ATTRSPANLIST  *pSpans,
+    ARENA         *pArena);
+
+
+extern void AppendAttrSpan
+   (ATTRSPANLIST    *pSpans,
+    int              length,
+    TEXTATTRIBUTES   attrs);
+
+
+extern int FindAttrSpan
+   (const ATTRSPANLIST  *pSpans,
+    int                  iPos);
+
+
+extern void CopyAttrSpans
+   (ATTRSPANLIST        *pDest,
+    const ATTRSPANLIST  *pSource,
+    int                  iStart,
+    int                  iEnd);
+
+
+extern void DiscardAttrSpans
+   (ATTRSPANLIST  *pSpans,
+    int            cbDiscard);
+
 }
 
 #endif
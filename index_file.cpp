@@ -0,0 +1,616 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+#include <stdlib.h>                    /*  C/C++ RTL headers.  */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "index_file.h"                /*  Application headers.  */
+
+
+
+/*  What a build thread is to do.
+*/
+
+struct BUILDREQUEST
+{
+  SHAREDINDEX     *pShared;
+  INDEXBUILDPROC   pfnBuild;
+  void            *pContext;
+};
+
+
+
+/*  Function prototypes.
+*/
+
+static void* BuildThread (void*);
+static INDEXVERSION* MakeCurrent (SHAREDINDEX*, void*);
+static void FreeVersion (SHAREDINDEX*, INDEXVERSION*);
+static void CreateParentDirectories (const char*);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       AcquireSharedIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the current version of the index, which must be given back
+*   with ReleaseSharedIndex(), or NULL if there isn't one yet.
+*/
+
+const void* AcquireSharedIndex
+    (SHAREDINDEX  *pShared)
+
+{
+  const void *pIndex = NULL;
+
+
+  pthread_mutex_lock (&pShared->Lock);
+
+  if (pShared->pCurrent != NULL)
+  {
+    pShared->pCurrent->nRefs++;
+    pIndex = pShared->pCurrent->pIndex;
+  }
+
+  pthread_mutex_unlock (&pShared->Lock);
+
+  return pIndex;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       ReleaseSharedIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Gives back a version acquired with AcquireSharedIndex(), and frees
+*   it if it has been replaced and this was its last holder.  The 
+*   replaced versions still held are few (usually none), so they are
+*   simply searched for it.
+*/
+
+void ReleaseSharedIndex
+    (SHAREDINDEX  *pShared,
+     const void   *pIndex)
+
+{
+  INDEXVERSION *pVersion = NULL, **ppLink;
+
+
+  if (pIndex == NULL)
+    return;
+
+  pthread_mutex_lock (&pShared->Lock);
+
+  if ((pShared->pCurrent != NULL) && (pShared->pCurrent->pIndex == pIndex))
+  {
+    pShared->pCurrent->nRefs--;
+  }
+  else
+  {
+    for (ppLink = &pShared->pRetired; (*ppLink)->pIndex != pIndex; ppLink = &(*ppLink)->pNext)
+      ;
+
+    if (--(*ppLink)->nRefs == 0)
+    {
+      pVersion = *ppLink;
+      *ppLink = pVersion->pNext;
+    }
+  }
+
+  pthread_mutex_unlock (&pShared->Lock);
+
+  FreeVersion (pShared, pVersion);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       ReplaceSharedIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Makes pIndex the current version.  The old one is freed once the 
+*   last caller holding it has released it.
+*/
+
+void ReplaceSharedIndex
+    (SHAREDINDEX  *pShared,
+     void         *pIndex)
+
+{
+  INDEXVERSION *pOldVersion;
+
+
+  pthread_mutex_lock (&pShared->Lock);
+  pOldVersion = MakeCurrent (pShared, pIndex);
+  pthread_mutex_unlock (&pShared->Lock);
+
+  FreeVersion (pShared, pOldVersion);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          LoadSharedIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  The first time it is called, loads the index from a file with 
+*   pfnLoad (which returns NULL if there is no usable file) and makes 
+*   it current, so that the index can be used before it is rebuilt.
+*   Returns true if there is a current version.
+*/
+
+bool LoadSharedIndex
+    (SHAREDINDEX    *pShared,
+     INDEXLOADPROC   pfnLoad,
+     const char     *pIndexFile)
+
+{
+  void *pIndex;
+  INDEXVERSION *pOldVersion = NULL;
+  bool fLoaded;
+
+
+  pthread_mutex_lock (&pShared->Lock);
+
+  if (!pShared->fLoadAttempted)
+  {
+    pShared->fLoadAttempted = true;
+
+    if ((pIndex = pfnLoad (pIndexFile)) != NULL)
+    {
+      pOldVersion = MakeCurrent (pShared, pIndex);
+    }
+  }
+
+  fLoaded = (pShared->pCurrent != NULL);
+
+  pthread_mutex_unlock (&pShared->Lock);
+
+  FreeVersion (pShared, pOldVersion);
+  return fLoaded;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                    StartSharedIndexBuild
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Runs pfnBuild on a thread of its own and makes the index it returns
+*   current.  Returns false, without running it, if a build is already
+*   under way or the last one failed less than RetryDelay seconds ago;
+*   pContext is then still the caller's to free.
+*/
+
+bool StartSharedIndexBuild
+    (SHAREDINDEX     *pShared,
+     INDEXBUILDPROC   pfnBuild,
+     void            *pContext)
+
+{
+  pthread_t thread;
+  pthread_attr_t attributes;
+  BUILDREQUEST *pRequest;
+  bool fStarted;
+
+
+  pthread_mutex_lock (&pShared->Lock);
+
+  if (pShared->fBuilding 
+        || ((pShared->FailureTime != 0) 
+              && (time (NULL) - pShared->FailureTime < pShared->RetryDelay)))
+  {
+    pthread_mutex_unlock (&pShared->Lock);
+    return false;
+  }
+
+  pShared->fBuilding = true;
+  pthread_mutex_unlock (&pShared->Lock);
+
+
+  pRequest = (BUILDREQUEST*) malloc (sizeof (BUILDREQUEST));
+  pRequest->pShared   = pShared;
+  pRequest->pfnBuild  = pfnBuild;
+  pRequest->pContext  = pContext;
+
+  pthread_attr_init (&attributes);
+  pthread_attr_setdetachstate (&attributes, PTHREAD_CREATE_DETACHED);
+
+  fStarted = (pthread_create (&thread, &attributes, BuildThread, pRequest) == 0);
+
+  pthread_attr_destroy (&attributes);
+
+
+  if (!fStarted)
+  {
+    free (pRequest);
+
+    pthread_mutex_lock (&pShared->Lock);
+    pShared->fBuilding = false;
+    pthread_mutex_unlock (&pShared->Lock);
+  }
+
+  return fStarted;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             MapIndexFile
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Maps an index file into memory, returning its address and putting 
+*   its size in *pcbFileOut.  Returns NULL if the file doesn't exist, 
+*   can't be mapped, or is too short to hold a header of cbHeader bytes.
+*   (Offsets in index files are 32 bits, so a longer file isn't valid
+*   either.)  The caller checks the contents.
+*/
+
+const char* MapIndexFile
+    (const char  *pIndexFile,
+     size_t       cbHeader,
+     size_t      *pcbFileOut)
+
+{
+  int fd;
+  void *pBase;
+  struct stat info;
+
+
+  if ((fd = open (pIndexFile, O_RDONLY)) < 0)
+    return NULL;
+
+  if ((fstat (fd, &info) != 0)
+         || (info.st_size < (off_t) cbHeader)
+         || (info.st_size > (off_t) UINT32_MAX))
+  {
+    close (fd);
+    return NULL;
+  }
+
+  pBase = mmap (NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+
+  if (pBase == MAP_FAILED)
+    return NULL;
+
+  *pcbFileOut = info.st_size;
+  return (const char*) pBase;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           UnmapIndexFile
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void UnmapIndexFile
+    (const char  *pBase,
+     size_t       cbFile)
+
+{
+  munmap ((void*) pBase, cbFile);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       IsIndexFileCurrent
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns true if the file exists and is less than MaxAge seconds old.
+*/
+
+bool IsIndexFileCurrent
+    (const char  *pIndexFile,
+     int          MaxAge)
+
+{
+  struct stat info;
+
+
+  return (stat (pIndexFile, &info) == 0) && (time (NULL) - info.st_mtime < MaxAge);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         ReplaceIndexFile
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Writes the parts one after another under a temporary name, then 
+*   renames the result into place, so a reader never sees half of a 
+*   file.  Any missing directories on the way to it are created first.
+*   Returns false (leaving the old file as it was) if anything fails.
+*/
+
+bool ReplaceIndexFile
+    (const char           *pIndexFile,
+     const INDEXFILEPART  *pParts,
+     int                   nParts)
+
+{
+  int i;
+  char *pTempFile;
+  FILE *pFile;
+  bool fSuccess = true;
+
+
+  CreateParentDirectories (pIndexFile);
+
+  if (asprintf (&pTempFile, "%s.%d.tmp", pIndexFile, (int) getpid ()) < 0)
+    return false;
+
+  if ((pFile = fopen (pTempFile, "wb")) == NULL)
+  {
+    free (pTempFile);
+    return false;
+  }
+
+  for (i = 0; (i < nParts) && fSuccess; i++)
+  {
+    fSuccess = (fwrite (pParts [i].pData, 1, pParts [i].cbData, pFile) == pParts [i].cbData);
+  }
+
+  fSuccess = (fclose (pFile) == 0) && fSuccess;
+  fSuccess = fSuccess && (rename (pTempFile, pIndexFile) == 0);
+
+  if (!fSuccess)
+  {
+    unlink (pTempFile);
+  }
+
+  free (pTempFile);
+  return fSuccess;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          InitPageHashSet
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void InitPageHashSet
+    (PAGEHASHSET  *pSet,
+     int           nPages)
+
+{
+  for (pSet->cHashes = 64; pSet->cHashes < 2 * nPages; pSet->cHashes *= 2)
+    ;
+
+  pSet->pHashes = (uint64_t*) calloc (pSet->cHashes, sizeof (uint64_t));
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          FreePageHashSet
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void FreePageHashSet
+    (PAGEHASHSET  *pSet)
+
+{
+  free (pSet->pHashes);
+  pSet->pHashes = NULL;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             HashPageText
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  64-bit FNV-1a of a page's rendered text.
+*/
+
+uint64_t HashPageText
+    (const char  *pText,
+     int          cbText)
+
+{
+  uint64_t hash = 14695981039346656037ULL;
+  int i;
+
+
+  for (i = 0; i < cbText; i++)
+  {
+    hash = (hash ^ (unsigned char) pText [i]) * 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              AddPageHash
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Records a page's hash.  Returns false if it was already there.
+*/
+
+bool AddPageHash
+    (PAGEHASHSET  *pSet,
+     uint64_t      hash)
+
+{
+  int h, mask = pSet->cHashes - 1;
+
+
+  if (hash == 0)
+  {
+    hash = 1;
+  }
+
+  for (h = (int) (hash & mask); pSet->pHashes [h] != 0; h = (h + 1) & mask)
+  {
+    if (pSet->pHashes [h] == hash)
+      return false;
+  }
+
+  pSet->pHashes [h] = hash;
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              BuildThread
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Runs a build started by StartSharedIndexBuild().
+*/
+
+static
+void* BuildThread
+   (void  *pContext)
+
+{
+  BUILDREQUEST *pRequest = (BUILDREQUEST*) pContext;
+  SHAREDINDEX *pShared = pRequest->pShared;
+  INDEXVERSION *pOldVersion = NULL;
+  void *pIndex = NULL;
+  bool fSucceeded;
+
+
+  fSucceeded = pRequest->pfnBuild (pRequest->pContext, &pIndex);
+
+  pthread_mutex_lock (&pShared->Lock);
+
+  pShared->FailureTime = fSucceeded ? 0 : time (NULL);
+
+  if (pIndex != NULL)
+  {
+    pOldVersion = MakeCurrent (pShared, pIndex);
+  }
+
+  pShared->fBuilding = false;
+
+  pthread_mutex_unlock (&pShared->Lock);
+
+
+  FreeVersion (pShared, pOldVersion);
+  free (pRequest);
+  return NULL;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              MakeCurrent
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Puts a new version in place of the current one, which keeps going
+*   on the retired list while anyone holds it.  Returns the old version
+*   if it is to be freed, for the caller to do after it releases Lock.
+*   The caller must hold Lock.
+*/
+
+static
+INDEXVERSION* MakeCurrent
+   (SHAREDINDEX  *pShared,
+    void         *pIndex)
+
+{
+  INDEXVERSION *pVersion, *pOldVersion;
+
+
+  pVersion = (INDEXVERSION*) malloc (sizeof (INDEXVERSION));
+  pVersion->pIndex  = pIndex;
+  pVersion->nRefs   = 1;
+  pVersion->pNext   = NULL;
+
+  pOldVersion = pShared->pCurrent;
+  pShared->pCurrent = pVersion;
+
+  if ((pOldVersion != NULL) && (--pOldVersion->nRefs > 0))
+  {
+    pOldVersion->pNext = pShared->pRetired;
+    pShared->pRetired = pOldVersion;
+    pOldVersion = NULL;
+  }
+
+  return pOldVersion;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              FreeVersion
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void FreeVersion
+   (SHAREDINDEX   *pShared,
+    INDEXVERSION  *pVersion)
+
+{
+  if (pVersion == NULL)
+    return;
+
+  pShared->pfnFree (pVersion->pIndex);
+  free (pVersion);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                  CreateParentDirectories
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Creates any missing directories on the way to a file, like 
+*   "mkdir -p".  Errors are ignored; the caller will find out when it 
+*   tries to create the file.
+*/
+
+static
+void CreateParentDirectories
+   (const char  *pPath)
+
+{
+  char *pCopy = strdup (pPath), *p;
+
+
+  for (p = strchr (pCopy + 1, '/'); p != NULL; p = strchr (p + 1, '/'))
+  {
+    *p = '\0';
+    mkdir (pCopy, 0755);
+    *p = '/';
+  }
+
+  free (pCopy);
+}
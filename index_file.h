@@ -0,0 +1,189 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+#ifndef __INDEX_FILE_H_
+#define __INDEX_FILE_H_
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+
+
+/*  Builds a new version of an index, returning false if it failed.
+*   *ppIndexOut receives the new index, or NULL to keep the current one.
+*   The procedure frees pContext, if it needs freeing.
+*/
+
+typedef bool (*INDEXBUILDPROC) (void *pContext, void **ppIndexOut);
+
+typedef void* (*INDEXLOADPROC) (const char *pIndexFile);
+
+typedef void (*INDEXFREEPROC) (void *pIndex);
+
+
+
+/*  One version of a shared index, with the number of holders it has: 
+*   the SHAREDINDEX (while the version is current) and every caller
+*   that has acquired it but not yet released it.
+*/
+
+struct INDEXVERSION
+{
+  void          *pIndex;
+  int            nRefs;
+  INDEXVERSION  *pNext;
+};
+
+
+
+/*  An index that is rebuilt now and then while requests go on using the
+*   version they acquired.  pRetired lists the replaced versions that 
+*   are still held.  After a failed build, no other is started for 
+*   RetryDelay seconds.  Declare one with SHARED_INDEX_INITIALIZER and
+*   use it only through the functions below.
+*/
+
+struct SHAREDINDEX
+{
+  INDEXFREEPROC     pfnFree;
+  int               RetryDelay;
+  pthread_mutex_t   Lock;
+  INDEXVERSION     *pCurrent;
+  INDEXVERSION     *pRetired;
+  bool              fBuilding;
+  bool              fLoadAttempted;
+  time_t            FailureTime;
+};
+
+#define SHARED_INDEX_INITIALIZER(pfnFree, RetryDelay) \
+  { (pfnFree), (RetryDelay), PTHREAD_MUTEX_INITIALIZER, NULL, NULL, false, false, 0 }
+
+
+
+/*  One piece of an index file that is being written.
+*/
+
+struct INDEXFILEPART
+{
+  const void  *pData;
+  size_t       cbData;
+};
+
+
+
+/*  The hashes of the pages seen so far while building an index, so 
+*   that a page installed under several names is only indexed once.
+*   The set has room for twice the number of pages it was made for; it
+*   is not grown.
+*/
+
+struct PAGEHASHSET
+{
+  uint64_t  *pHashes;
+  int        cHashes;
+};
+
+
+
+/*  The shared index functions are thread-safe.  The rest are helpers
+*   for the indexes that are built by rendering every manual page and 
+*   kept in files of their own; they don't lock anything.
+*/
+
+extern "C"
+{
+extern const void* AcquireSharedIndex
+    (SHAREDINDEX  *pShared);
+
+
+extern void ReleaseSharedIndex
+    (SHAREDINDEX  *pShared,
+     const void   *pIndex);
+
+
+extern void ReplaceSharedIndex
+    (SHAREDINDEX  *pShared,
+     void         *pIndex);
+
+
+extern bool LoadSharedIndex
+    (SHAREDINDEX    *pShared,
+     INDEXLOADPROC   pfnLoad,
+     const char     *pIndexFile);
+
+
+extern bool StartSharedIndexBuild
+    (SHAREDINDEX     *pShared,
+     INDEXBUILDPROC   pfnBuild,
+     void            *pContext);
+
+
+extern const char* MapIndexFile
+    (const char  *pIndexFile,
+     size_t       cbHeader,
+     size_t      *pcbFileOut);
+
+
+extern void UnmapIndexFile
+    (const char  *pBase,
+     size_t       cbFile);
+
+
+extern bool IsIndexFileCurrent
+    (const char  *pIndexFile,
+     int          MaxAge);
+
+
+extern bool ReplaceIndexFile
+    (const char           *pIndexFile,
+     const INDEXFILEPART  *pParts,
+     int                   nParts);
+
+
+extern void InitPageHashSet
+    (PAGEHASHSET  *pSet,
+     int           nPages);
+
+
+extern void FreePageHashSet
+    (PAGEHASHSET  *pSet);
+
+
+extern uint64_t HashPageText
+    (const char  *pText,
+     int          cbText);
+
+
+extern bool AddPageHash
+    (PAGEHASHSET  *pSet,
+     uint64_t      hash);
+}
+
+
+#endif
@@ -0,0 +1,879 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#include <stdlib.h>                    /*  C/C++ RTL headers.  */
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "utility.h"                   /*  Application headers.  */
+#include "installation.h"
+#include "documentation_api.h"
+#include "index_file.h"
+#include "info_index.h"
+
+
+
+/*  makeinfo marks an index node with "\0\b[index\0\b]", which Info 
+*   readers don't display.  ReadCompressedFile() turns the NULs into 
+*   spaces, so only the rest is looked for.
+*/
+
+#define INDEX_COOKIE      "\b[index"
+#define CB_INDEX_COOKIE   (sizeof (INDEX_COOKIE) - 1)
+
+#define INDIRECT_TABLE     "\x1f\nIndirect:\n"
+#define CB_INDIRECT_TABLE  (sizeof (INDIRECT_TABLE) - 1)
+
+
+
+/*  The entries collected so far while an index is being built.  The 
+*   names of the manuals already read are kept so that a manual found 
+*   in more than one directory is only read from the first.
+*/
+
+struct BUILDSTATE
+{
+  char            *pText;
+  size_t           cbText;
+  size_t           cbTextAllocated;
+  INFOINDEXENTRY  *pEntries;
+  int              nEntries;
+  int              nEntriesAllocated;
+  uint32_t        *pManuals;
+  int              nManuals;
+  int              nManualsAllocated;
+};
+
+
+
+/*  Function prototypes.
+*/
+
+static bool BuildNewIndex (void*, void**);
+static void IndexDirectory (BUILDSTATE*, const char*);
+static void IndexManual (BUILDSTATE*, const char*, const char*, uint32_t);
+static bool ReadSubfile (const char*, const char*, int, char**, int*);
+static void IndexNodes (BUILDSTATE*, const char*, int, uint32_t);
+static void IndexEntries (BUILDSTATE*, const char*, const char*, uint32_t);
+static uint32_t AddText (BUILDSTATE*, const char*, int);
+static INFOINDEX* FinishIndex (BUILDSTATE*);
+static int CompareEntries (const void*, const void*, void*);
+static bool ContainsFolded (const char*, const char*, int);
+static void FreeIndex (void*);
+
+
+
+static SHAREDINDEX Index = SHARED_INDEX_INITIALIZER (FreeIndex, 0);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      StartInfoIndexBuild
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Does nothing if a build is already under way.
+*/
+
+void StartInfoIndexBuild
+    (void)
+
+{
+  StartSharedIndexBuild (&Index, BuildNewIndex, NULL);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         AcquireInfoIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+const INFOINDEX* AcquireInfoIndex
+    (void)
+
+{
+  return (const INFOINDEX*) AcquireSharedIndex (&Index);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         ReleaseInfoIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void ReleaseInfoIndex
+    (const INFOINDEX  *pIndex)
+
+{
+  ReleaseSharedIndex (&Index, pIndex);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          SearchInfoIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Finds the entries that contain pQuery, ignoring ASCII case.  Those 
+*   equal to it come first, then those that begin with it, then the 
+*   rest, each in the index's order.  The entry numbers are returned in
+*   *ppEntriesOut, which the caller must free, and the number of them
+*   is returned.
+*
+*   The entries that begin with the query are consecutive (with those 
+*   equal to it first, since they are shorter), so two binary searches 
+*   find them; the others take a pass over the whole index.
+*/
+
+int SearchInfoIndex
+    (const INFOINDEX   *pIndex,
+     const char        *pQuery,
+     int              **ppEntriesOut)
+
+{
+  int i, n, cbQuery, lo, hi, mid, iFirst, iEnd, nAllocated;
+  int *pMatches;
+  const char *pText = pIndex->pText;
+  const INFOINDEXENTRY *pEntries = pIndex->pEntries;
+
+
+  *ppEntriesOut = NULL;
+
+  if ((cbQuery = strlen (pQuery)) == 0)
+    return 0;
+
+
+  lo = 0;
+  hi = pIndex->nEntries;
+
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+
+    if (ComparePrefix (pText + pEntries [mid].text, pQuery, cbQuery) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  iFirst = lo;
+  hi = pIndex->nEntries;
+
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+
+    if (ComparePrefix (pText + pEntries [mid].text, pQuery, cbQuery) <= 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  iEnd = lo;
+
+
+  nAllocated = iEnd - iFirst + 64;
+  pMatches = (int*) malloc (sizeof (int) * nAllocated);
+
+  for (i = iFirst, n = 0; i < iEnd; i++)
+  {
+    pMatches [n++] = i;
+  }
+
+  for (i = 0; i < pIndex->nEntries; i++)
+  {
+    if ((i == iFirst) && (iEnd > iFirst))
+    {
+      i = iEnd - 1;
+      continue;
+    }
+
+    if (!ContainsFolded (pText + pEntries [i].text, pQuery, cbQuery))
+      continue;
+
+    if (n == nAllocated)
+    {
+      nAllocated *= 2;
+      pMatches = (int*) realloc (pMatches, sizeof (int) * nAllocated);
+    }
+
+    pMatches [n++] = i;
+  }
+
+
+  if (n == 0)
+  {
+    free (pMatches);
+    return 0;
+  }
+
+  *ppEntriesOut = pMatches;
+  return n;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            BuildNewIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Reads every manual in the directories in $INFOPATH (separated by 
+*   colons, as in $PATH) and then those in InfoDirectories [].
+*/
+
+static
+bool BuildNewIndex
+   (void   *pContext,
+    void  **ppIndexOut)
+
+{
+  int i;
+  char *pPath, *pDirectory, *pNext;
+  BUILDSTATE state;
+
+
+  memset (&state, 0, sizeof (state));
+
+  if ((pPath = getenv ("INFOPATH")) != NULL)
+  {
+    pPath = strdup (pPath);
+
+    for (pDirectory = pPath; pDirectory != NULL; pDirectory = pNext)
+    {
+      if ((pNext = strchr (pDirectory, ':')) != NULL)
+      {
+        *(pNext++) = '\0';
+      }
+
+      if (pDirectory [0] != '\0')
+      {
+        IndexDirectory (&state, pDirectory);
+      }
+    }
+
+    free (pPath);
+  }
+
+  for (i = 0; InfoDirectories [i] != NULL; i++)
+  {
+    IndexDirectory (&state, InfoDirectories [i]);
+  }
+
+  *ppIndexOut = FinishIndex (&state);
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           IndexDirectory
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Reads each manual in a directory: the files named "manual.info", 
+*   compressed or not.  (The others are the subfiles of split manuals,
+*   which are read along with their main files, and things like "dir".)
+*/
+
+static
+void IndexDirectory
+   (BUILDSTATE  *pState,
+    const char  *pDirectory)
+
+{
+  int i, k, t, cbStem;
+  uint32_t manual;
+  const char *pName, *pExtension;
+  DIR *pDir;
+  struct dirent *pDirEntry;
+
+
+  if ((pDir = opendir (pDirectory)) == NULL)
+    return;
+
+  while ((pDirEntry = readdir (pDir)) != NULL)
+  {
+    pName = pDirEntry->d_name;
+    cbStem = strlen (pName);
+
+    for (i = 0; (pExtension = Decompressors [i]) != NULL; i += 2)
+    {
+      t = strlen (pExtension);
+      if ((cbStem > t) && (strcmp (pName + cbStem - t, pExtension) == 0))
+      {
+        cbStem -= t;
+        break;
+      }
+    }
+
+    if ((cbStem <= 5) || (strncmp (pName + cbStem - 5, ".info", 5) != 0))
+      continue;
+
+    cbStem -= 5;
+
+
+    for (k = 0; k < pState->nManuals; k++)
+    {
+      if ((strncmp (pState->pText + pState->pManuals [k], pName, cbStem) == 0)
+             && (pState->pText [pState->pManuals [k] + cbStem] == '\0'))
+        break;
+    }
+
+    if (k < pState->nManuals)
+      continue;
+
+
+    if (pState->nManuals == pState->nManualsAllocated)
+    {
+      pState->nManualsAllocated += pState->nManualsAllocated / 2 + 64;
+      pState->pManuals = (uint32_t*) realloc (pState->pManuals, 
+                                              sizeof (uint32_t) * pState->nManualsAllocated);
+    }
+
+    manual = AddText (pState, pName, cbStem);
+    pState->pManuals [pState->nManuals++] = manual;
+
+    IndexManual (pState, pDirectory, pName, manual);
+  }
+
+  closedir (pDir);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              IndexManual
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  A large manual is split into subfiles, which are listed (one per 
+*   line, as "name: offset") in the main file's "Indirect:" table.
+*/
+
+static
+void IndexManual
+   (BUILDSTATE  *pState,
+    const char  *pDirectory,
+    const char  *pFile,
+    uint32_t     manual)
+
+{
+  int cbData, cbSubfile;
+  bool fRead;
+  char *pPath, *pData, *pSubfile;
+  const char *p, *pEnd, *pLineEnd, *pColon;
+
+
+  asprintf (&pPath, "%s/%s", pDirectory, pFile);
+  fRead = ReadCompressedFile (pPath, &pData, &cbData);
+  free (pPath);
+
+  if (!fRead)
+    return;
+
+
+  pEnd = pData + cbData;
+  p = (const char*) memmem (pData, cbData, INDIRECT_TABLE, CB_INDIRECT_TABLE);
+
+  if (p == NULL)
+  {
+    IndexNodes (pState, pData, cbData, manual);
+    free (pData);
+    return;
+  }
+
+
+  for (p += CB_INDIRECT_TABLE; (p < pEnd) && (*p != '\x1f'); p = pLineEnd + 1)
+  {
+    if ((pLineEnd = (const char*) memchr (p, '\n', pEnd - p)) == NULL)
+    {
+      pLineEnd = pEnd;
+    }
+
+    pColon = (const char*) memchr (p, ':', pLineEnd - p);
+
+    if ((pColon != NULL) && (pColon > p)
+           && (memchr (p, '/', pColon - p) == NULL)
+           && ReadSubfile (pDirectory, p, pColon - p, &pSubfile, &cbSubfile))
+    {
+      IndexNodes (pState, pSubfile, cbSubfile, manual);
+      free (pSubfile);
+    }
+  }
+
+  free (pData);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              ReadSubfile
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  The Indirect table gives a subfile's name without any compression 
+*   extension, so each is tried in turn.
+*/
+
+static
+bool ReadSubfile
+   (const char   *pDirectory,
+    const char   *pName,
+    int           cbName,
+    char        **ppDataOut,
+    int          *pcbDataOut)
+
+{
+  int i;
+  bool fRead;
+  char *pPath;
+  struct stat info;
+
+
+  for (i = -2; (i < 0) || (Decompressors [i] != NULL); i += 2)
+  {
+    asprintf (&pPath, "%s/%.*s%s", 
+              pDirectory, cbName, pName, 
+              (i < 0) ? "" : Decompressors [i]);
+
+    fRead = (stat (pPath, &info) == 0)
+               && ((info.st_mode & S_IFMT) == S_IFREG)
+               && ReadCompressedFile (pPath, ppDataOut, pcbDataOut);
+
+    free (pPath);
+
+    if (fRead)
+      return true;
+  }
+
+  return false;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               IndexNodes
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Each node begins with a ^_ (unit separator) and a header line, 
+*   "File: manual.info,  Node: name,  Next: ...".  A node is taken to be
+*   an index if makeinfo marked it as one, or if its name ends with
+*   "Index" (the test NodeTypeFromName() in infotohtml.cpp uses).
+*/
+
+static
+void IndexNodes
+   (BUILDSTATE  *pState,
+    const char  *pData,
+    int          cbData,
+    uint32_t     manual)
+
+{
+  int cbName;
+  bool fIndex;
+  const char *p, *pNext, *pEnd, *pNodeEnd, *pHeaderEnd, *pName, *pNameEnd;
+
+
+  pEnd = pData + cbData;
+
+  for (p = (const char*) memchr (pData, '\x1f', cbData); p != NULL; p = pNext)
+  {
+    p++;
+    pNext = (const char*) memchr (p, '\x1f', pEnd - p);
+    pNodeEnd = (pNext == NULL) ? pEnd : pNext;
+
+    while ((p < pNodeEnd) && ((*p == '\f') || (*p == '\n')))
+    {
+      p++;
+    }
+
+    if ((pHeaderEnd = (const char*) memchr (p, '\n', pNodeEnd - p)) == NULL)
+      continue;
+
+    if ((pName = (const char*) memmem (p, pHeaderEnd - p, "Node:", 5)) == NULL)
+      continue;
+
+
+    for (pName += 5; (*pName == ' ') || (*pName == '\t'); pName++)
+      ;
+
+    if (*pName == '\x7f')
+    {
+      pName++;
+      pNameEnd = (const char*) memchr (pName, '\x7f', pHeaderEnd - pName);
+    }
+    else
+    {
+      for (pNameEnd = pName; 
+           (pNameEnd < pHeaderEnd) && (*pNameEnd != ',') && (*pNameEnd != '\t');
+           pNameEnd++)
+        ;
+    }
+
+    if (pNameEnd == NULL)
+      continue;
+
+    cbName = pNameEnd - pName;
+
+
+    fIndex = (memmem (pHeaderEnd, pNodeEnd - pHeaderEnd, INDEX_COOKIE, CB_INDEX_COOKIE) != NULL)
+               || ((cbName >= 5) && (strncasecmp (pNameEnd - 5, "Index", 5) == 0));
+
+    if (fIndex)
+    {
+      IndexEntries (pState, pHeaderEnd + 1, pNodeEnd, manual);
+    }
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             IndexEntries
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  An index entry is a menu item, "* text: node.  (line  n)", where the 
+*   line number may be on a line of its own when the rest is long.  The
+*   text or node name is quoted with DELs (^?) when it contains a colon
+*   or period.  A repeated text has " <2>", " <3>" and so on added to 
+*   it, which is removed here.  Items of the "* node::" form are skipped;
+*   they are links to other index nodes, not entries.
+*/
+
+static
+void IndexEntries
+   (BUILDSTATE  *pState,
+    const char  *pText,
+    const char  *pEnd,
+    uint32_t     manual)
+
+{
+  uint32_t line;
+  const char *p, *q, *r, *pLineEnd, *pNextEnd, *pLabel, *pLabelEnd, *pNode, *pNodeEnd;
+  INFOINDEXENTRY *pEntry;
+
+
+  for (p = pText; p < pEnd; p = pLineEnd + 1)
+  {
+    if ((pLineEnd = (const char*) memchr (p, '\n', pEnd - p)) == NULL)
+    {
+      pLineEnd = pEnd;
+    }
+
+    if ((pLineEnd - p < 4) || (p [0] != '*') || (p [1] != ' '))
+      continue;
+
+
+    /*  The entry's text...
+    */
+
+    pLabel = p + 2;
+
+    if (*pLabel == '\x7f')
+    {
+      pLabel++;
+      if ((pLabelEnd = (const char*) memchr (pLabel, '\x7f', pLineEnd - pLabel)) == NULL)
+        continue;
+
+      q = pLabelEnd + 1;
+    }
+    else
+    {
+      if ((pLabelEnd = (const char*) memchr (pLabel, ':', pLineEnd - pLabel)) == NULL)
+        continue;
+
+      q = pLabelEnd;
+    }
+
+    if ((q >= pLineEnd - 1) || (q [0] != ':') || (q [1] == ':'))
+      continue;
+
+    while ((pLabelEnd > pLabel) && (pLabelEnd [-1] == ' '))
+    {
+      pLabelEnd--;
+    }
+
+    if ((pLabelEnd > pLabel) && (pLabelEnd [-1] == '>'))
+    {
+      for (r = pLabelEnd - 2; (r > pLabel) && (*r >= '0') && (*r <= '9'); r--)
+        ;
+
+      if ((*r == '<') && (r < pLabelEnd - 2) && (r > pLabel) && (r [-1] == ' '))
+      {
+        pLabelEnd = r - 1;
+      }
+    }
+
+    if (pLabelEnd == pLabel)
+      continue;
+
+
+    /*  ...the node...
+    */
+
+    for (pNode = q + 1; (pNode < pLineEnd) && ((*pNode == ' ') || (*pNode == '\t')); pNode++)
+      ;
+
+    if ((pNode < pLineEnd) && (*pNode == '\x7f'))
+    {
+      pNode++;
+      if ((pNodeEnd = (const char*) memchr (pNode, '\x7f', pLineEnd - pNode)) == NULL)
+        continue;
+
+      q = pNodeEnd + 1;
+    }
+    else
+    {
+      for (pNodeEnd = pNode; pNodeEnd < pLineEnd; pNodeEnd++)
+      {
+        if ((*pNodeEnd == ',') || (*pNodeEnd == '\t')
+              || ((*pNodeEnd == '.') 
+                    && ((pNodeEnd + 1 == pLineEnd) || (pNodeEnd [1] == ' '))))
+          break;
+      }
+
+      q = pNodeEnd;
+    }
+
+    if (pNodeEnd == pNode)
+      continue;
+
+
+    /*  ...and the line number.
+    */
+
+    if ((r = (const char*) memmem (q, pLineEnd - q, "(line", 5)) == NULL)
+    {
+      if ((pLineEnd + 1 < pEnd) && (pLineEnd [1] != '*'))
+      {
+        if ((pNextEnd = (const char*) memchr (pLineEnd + 1, '\n', pEnd - pLineEnd - 1)) == NULL)
+        {
+          pNextEnd = pEnd;
+        }
+
+        if ((r = (const char*) memmem (pLineEnd, pNextEnd - pLineEnd, "(line", 5)) != NULL)
+        {
+          pLineEnd = pNextEnd;
+        }
+      }
+    }
+
+    line = 0;
+
+    if (r != NULL)
+    {
+      for (r += 5; (r < pLineEnd) && (*r == ' '); r++)
+        ;
+
+      for ( ; (r < pLineEnd) && (*r >= '0') && (*r <= '9'); r++)
+      {
+        line = line * 10 + (*r - '0');
+      }
+    }
+
+
+    if (pState->nEntries == pState->nEntriesAllocated)
+    {
+      pState->nEntriesAllocated += pState->nEntriesAllocated / 2 + 4096;
+      pState->pEntries = (INFOINDEXENTRY*) realloc (pState->pEntries, 
+                                                    sizeof (INFOINDEXENTRY) * pState->nEntriesAllocated);
+    }
+
+    pEntry = pState->pEntries + pState->nEntries++;
+    pEntry->text = AddText (pState, pLabel, pLabelEnd - pLabel);
+    pEntry->manual = manual;
+    pEntry->node = AddText (pState, pNode, pNodeEnd - pNode);
+    pEntry->line = line;
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                  AddText
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Copies a string into the index's text and returns its offset.
+*/
+
+static
+uint32_t AddText
+   (BUILDSTATE  *pState,
+    const char  *pStr,
+    int          cbStr)
+
+{
+  uint32_t offset;
+  size_t cb;
+
+
+  if (pState->cbText + cbStr + 1 > pState->cbTextAllocated)
+  {
+    cb = pState->cbTextAllocated + pState->cbTextAllocated / 2 + cbStr + 65536;
+
+    pState->pText = (char*) realloc (pState->pText, cb);
+    pState->cbTextAllocated = cb;
+  }
+
+  offset = pState->cbText;
+
+  memcpy (pState->pText + offset, pStr, cbStr);
+  pState->pText [offset + cbStr] = '\0';
+  pState->cbText += cbStr + 1;
+
+  return offset;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              FinishIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Sorts the entries, drops any that are listed twice (in two index 
+*   nodes of a manual, say), and hands the text and entries over to a 
+*   new index.
+*/
+
+static
+INFOINDEX* FinishIndex
+   (BUILDSTATE  *pState)
+
+{
+  int i, n;
+  INFOINDEX *pIndex;
+
+
+  qsort_r (pState->pEntries, pState->nEntries, sizeof (INFOINDEXENTRY), 
+           CompareEntries, pState->pText);
+
+  for (i = n = 0; i < pState->nEntries; i++)
+  {
+    if ((n == 0) 
+          || (CompareEntries (pState->pEntries + i, pState->pEntries + n - 1, 
+                              pState->pText) != 0))
+    {
+      pState->pEntries [n++] = pState->pEntries [i];
+    }
+  }
+
+
+  pIndex = (INFOINDEX*) malloc (sizeof (INFOINDEX));
+  pIndex->pText = (char*) realloc (pState->pText, pState->cbText + 1);
+  pIndex->pEntries = (INFOINDEXENTRY*) realloc (pState->pEntries, 
+                                                sizeof (INFOINDEXENTRY) * (n + 1));
+  pIndex->nEntries = n;
+  pIndex->nManuals = pState->nManuals;
+
+  free (pState->pManuals);
+
+  return pIndex;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           CompareEntries
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Orders entries by text, ignoring case (which must agree with 
+*   ComparePrefix() for the binary searches), then by the rest.
+*/
+
+static
+int CompareEntries
+   (const void  *pLeft,
+    const void  *pRight,
+    void        *pContext)
+
+{
+  const INFOINDEXENTRY *pA = (const INFOINDEXENTRY*) pLeft;
+  const INFOINDEXENTRY *pB = (const INFOINDEXENTRY*) pRight;
+  const char *pText = (const char*) pContext;
+  int t;
+
+
+  if ((t = ComparePrefix (pText + pA->text, pText + pB->text, 
+                          strlen (pText + pB->text) + 1)) != 0)
+    return t;
+
+  if ((t = strcmp (pText + pA->text, pText + pB->text)) != 0)
+    return t;
+
+  if ((t = strcmp (pText + pA->manual, pText + pB->manual)) != 0)
+    return t;
+
+  if ((t = strcmp (pText + pA->node, pText + pB->node)) != 0)
+    return t;
+
+  return (pA->line > pB->line) - (pA->line < pB->line);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           ContainsFolded
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+bool ContainsFolded
+   (const char  *pStr,
+    const char  *pSubstring,
+    int          cbSubstring)
+
+{
+  int c = FoldChar (pSubstring [0]);
+
+
+  for ( ; *pStr != '\0'; pStr++)
+  {
+    if ((FoldChar (*pStr) == c) 
+          && (ComparePrefix (pStr, pSubstring, cbSubstring) == 0))
+      return true;
+  }
+
+  return false;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                FreeIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void FreeIndex
+   (void  *pIndex)
+
+{
+  INFOINDEX *pInfo = (INFOINDEX*) pIndex;
+
+
+  free (pInfo->pText);
+  free (pInfo->pEntries);
+  free (pInfo);
+}
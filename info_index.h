@@ -0,0 +1,94 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#ifndef __INFO_INDEX_H_
+#define __INFO_INDEX_H_
+
+
+#include <stdint.h>
+
+
+
+/*  One entry from the index node of an Info manual.  The strings are 
+*   offsets into the index's text.  line is the line within the node 
+*   that the entry refers to, counting from 1, or 0 if the manual 
+*   doesn't say.
+*/
+
+struct INFOINDEXENTRY
+{
+  uint32_t  text;
+  uint32_t  manual;
+  uint32_t  node;
+  uint32_t  line;
+};
+
+
+
+/*  The entries of the indices of every Info manual that was found, 
+*   sorted by their text (ignoring ASCII case), then by manual, node
+*   and line.  An index is never changed once it has been built.
+*/
+
+struct INFOINDEX
+{
+  char            *pText;
+  INFOINDEXENTRY  *pEntries;
+  int              nEntries;
+  int              nManuals;
+};
+
+
+
+/*  StartInfoIndexBuild() reads the Info files in the background and 
+*   puts the new index in place of the old one when it is done.  Until 
+*   the first build finishes, AcquireInfoIndex() returns NULL.  All of 
+*   the functions are thread-safe.
+*/
+
+extern "C"
+{
+extern void StartInfoIndexBuild
+    (void);
+
+
+extern const INFOINDEX* AcquireInfoIndex
+    (void);
+
+
+extern void ReleaseInfoIndex
+    (const INFOINDEX  *pIndex);
+
+
+extern int SearchInfoIndex
+    (const INFOINDEX   *pIndex,
+     const char        *pQuery,
+     int              **ppEntriesOut);
+}
+
+
+#endif
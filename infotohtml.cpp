@@ -32,14 +32,14 @@
 #include <tre/tre.h>                   /*  Library headers.  */
 
 #include "utility.h"                   /*  Application headers.  */
+#include "arena.h"
 #include "html_formatting.h"
+#include "page_builder.h"
 #include "infotohtml.h"
-#include "common_js.h"
+#include "assets.h"
 
 
 
-#define HTML_EXPANSION_FACTOR     10
-
 
 #define HEX_ESCAPE_CHAR           '~'
 
@@ -87,8 +87,66 @@ struct NAVIGATIONLINKS
 
 
 
-static regex_t LinkRegex1, LinkRegex2, TitleRegex, DirLinkRegex;
-static regex_t NoteLinkRegex, NoteLinkRegex2;
+/*  A link found by one of the Match...Link() functions.  The match runs
+*   from iStart to iEnd; the other pairs are the parts of it that are the
+*   link, the file name and the target node.  A part that is absent is
+*   empty.
+*/
+
+struct INFOLINKMATCH
+{
+  int  iStart;
+  int  iEnd;
+  int  iLinkStart;
+  int  iLinkEnd;
+  int  iFileStart;
+  int  iFileEnd;
+  int  iTargetStart;
+  int  iTargetEnd;
+};
+
+
+
+/*  Character classes used by the link scanner.  CC_SPACE is the POSIX
+*   [:space:] class; each of the others is the set of characters allowed
+*   in one part of a link, and includes the ASCII letters and digits.
+*/
+
+enum
+{
+  CC_SPACE        = 1,
+  CC_MENU_NAME    = 2,
+  CC_NOTE_NODE    = 4,
+  CC_FILE_NAME    = 8,
+  CC_DIR_ENTRY    = 16,
+  CC_DIR_FILE     = 32,
+  CC_DIR_NODE     = 64
+};
+
+
+static const unsigned char CharClasses [256]
+        = {
+             0,   0,   0,   0,   0,   0,   0,   0,   0,  87,  87,  87,  87,  87,   0,   0,    /*  00-0f  */
+             0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,    /*  10-1f  */
+            87,   0,   0,   0,   0,   0,   0,   0,  66,  66,   0,  94,   0, 126,  58,  66,    /*  20-2f  */
+           126, 126, 126, 126, 126, 126, 126, 126, 126, 126,   0,   0,   0,   0,   0,  66,    /*  30-3f  */
+             0, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126,    /*  40-4f  */
+           126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126,   0,   0,   0,   0, 126,    /*  50-5f  */
+             0, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126,    /*  60-6f  */
+           126, 126, 126, 126, 126, 126, 126, 126, 126, 126, 126,   0,   0,   0,   0,   0,    /*  70-7f  */
+             0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,    /*  80-8f  */
+             0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,    /*  90-9f  */
+             0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,    /*  a0-af  */
+             0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,    /*  b0-bf  */
+             0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,    /*  c0-cf  */
+             0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,    /*  d0-df  */
+             0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,    /*  e0-ef  */
+             0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0     /*  f0-ff  */
+          };
+
+
+
+static regex_t TitleRegex;
 
 
 
@@ -96,19 +154,23 @@ static regex_t NoteLinkRegex, NoteLinkRegex2;
 */
 
 static INFONODETYPE NodeTypeFromName (const char*);
-static void GenerateNavBar (FILE*, const NAVIGATIONLINKS*, const HTMLFORMATINFO*);
-static void GenerateScript (FILE*, const NAVIGATIONLINKS*, const HTMLFORMATINFO*);
-static void GenerateTitle (FILE*, const char*, int, char, bool);
-static void ClassifyLines (const char*, int, INFOLINE**, int*);
-static void ParseHeaderLine (const char*, int, const char*, const char*, NAVIGATIONLINKS*);
+static void GenerateNavBar (PAGEBUILDER*, const NAVIGATIONLINKS*, const HTMLFORMATINFO*);
+static void GenerateScript (PAGEBUILDER*, const NAVIGATIONLINKS*, const HTMLFORMATINFO*);
+static void GenerateTitle (PAGEBUILDER*, const char*, int, char, bool);
+static void ClassifyLines (ARENA*, const char*, int, INFOLINE**, int*);
+static void ParseHeaderLine (ARENA*, const char*, int, const char*, const char*, NAVIGATIONLINKS*);
+static char* MakeNodeUri (ARENA*, const char*, const char*, const char*);
 static void RecognizeLinks (INFONODETYPE, const char*, int, TEXTATTRIBUTES*);
-static int RecognizeInfoLinks (const char*, int, TEXTATTRIBUTES*);
-static int RecognizeInfoIndexLinks (const char*, int, TEXTATTRIBUTES*);
-static int RecognizeDirLinks (const char*, int, TEXTATTRIBUTES*);
-static int RecognizeNoteLinks (const char*, int, TEXTATTRIBUTES*);
-static int RecognizeNoteLinks2 (const char*, int, TEXTATTRIBUTES*);
+static bool MatchMenuLink (const char*, int, int, INFOLINKMATCH*);
+static bool MatchNoteLink (const char*, int, int, bool, INFOLINKMATCH*);
+static bool MatchNoteTarget (const char*, int, int, INFOLINKMATCH*);
+static bool MatchNoteFileTarget (const char*, int, int, INFOLINKMATCH*);
+static bool MatchIndexLink (const char*, int, int, INFOLINKMATCH*);
+static bool MatchDirLink (const char*, int, int, INFOLINKMATCH*);
+static void MarkInfoLink (TEXTATTRIBUTES*, const INFOLINKMATCH*, TEXTATTRIBUTES);
 static bool IsFootnotesLine (const char*, int);
 static bool IsUnderline (const char*, int);
+static inline bool IsInfoSpace (char);
 static int ValueFromHexDigit (char);
 
 
@@ -138,81 +200,6 @@ void infoInitializeRegexes
              error);
     exit (100);
   }    
-
-
-  /*  Two regular expressions for recognizing hyperlinks in ordinary Info nodes.
-  */
-
-  error = tre_regcomp 
-              (&LinkRegex1, 
-               "\\*[[:space:]]*(?:note[[:space:]]+)?([[:alnum:][:space:]+_./?()-]{1,64}?)::", 
-               REG_EXTENDED | REG_ICASE);
-
-  if (error != 0)
-  {
-    fprintf (stderr, "\ntre_regcomp() failed for LinkRegex1 (result code %d).\n\n",
-    	       error);
-    exit (100);
-  }
-
-
-  error = tre_regcomp 
-              (&LinkRegex2, 
-               "\\*[[:space:]]*([^:]+:[[:space:]]*([[:alnum:][:space:]+_./?()-]{1,64}))\\.", 
-               REG_EXTENDED | REG_ICASE | REG_NEWLINE);
-
-  if (error != 0)
-  {
-    fprintf (stderr, "\ntre_regcomp() failed for LinkRegex2 (result code %d).\n\n",
-    	       error);
-    exit (100);
-  }  
-
-
-  /*  Two regular expressions for recognizing "*Note" links.
-  */
-
-  error = tre_regcomp 
-              (&NoteLinkRegex, 
-               "\\*Note[[:space:]][^:*]{0,99}?[^[:space:]]:[[:space:]]+([[:alnum:][:space:]_+-]{1,64})\\.", 
-               REG_EXTENDED);
-
-  if (error != 0)
-  {
-    fprintf (stderr, "\ntre_regcomp() failed for NoteLinkRegex (result code %d).\n\n",
-             error);
-    exit (100);
-  }
-
-
-  error = tre_regcomp 
-              (&NoteLinkRegex2, 
-               "\\*Note[[:space:]][^:*]{0,99}?[^[:space:]]:[[:space:]]+(\\([[:alnum:]._+-]{1,32}\\))([[:alnum:]._+-]{1,64})", 
-               REG_EXTENDED);
-
-  if (error != 0)
-  {
-    fprintf (stderr, "\ntre_regcomp() failed for NoteLinkRegex2 (result code %d).\n\n",
-             error);
-    exit (100);
-  }
-
-
-  /*  Regular expression for recognizing the specially formatted links in index
-  *   and directory nodes.
-  */
-
-  error = tre_regcomp 
-              (&DirLinkRegex, 
-               "^[[:space:]]*\\*[[:space:]]+([[:alnum:][:space:]._+-]+):[[:space:]]+\\(([[:alnum:]._-]+)\\)([[:alnum:][:space:]+_/?()-]*)\\.", 
-               REG_EXTENDED | REG_ICASE | REG_NEWLINE);
-
-  if (error != 0)
-  {
-    fprintf (stderr, "\ntre_regcomp() failed for DirLinkRegex (result code %d).\n\n",
-             error);
-    exit (100);
-  }    
 }
 
 
@@ -221,21 +208,25 @@ void infoInitializeRegexes
                                                                InfoToHTML
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Renders an Info node.  Working memory comes from pArena.
+*/
+
 void InfoToHTML
-    (FILE          *stream,
+    (PAGEBUILDER   *pPage,
+     ARENA         *pArena,
      const char    *pInfoFile,
      const char    *pNodeName,
      const char    *pUriPrefix,
-     const char    *pStylesheet,
+     const char    *pStylesheetUri,
      const char    *pContent,
      int            cbContent)
 
 {
-  int iLine, nLines, iFirst, iLast, length, cbMax;
-  int cbAttributes, nTitles = 0;
+  int iLine, nLines, iFirst, iLast, length;
+  int nTitles = 0;
   const char *pText;
-  char *pHtml;
   bool fIsFootnote;
+  HTMLIZESTATE state;
   TEXTATTRIBUTES *pAttributes;
   INFOLINE *pLines;
   INFONODETYPE NodeType;
@@ -254,7 +245,7 @@ void InfoToHTML
 
   NodeType = NodeTypeFromName (pNodeName);
 
-  ClassifyLines (pContent, cbContent, &pLines, &nLines);
+  ClassifyLines (pArena, pContent, cbContent, &pLines, &nLines);
 
 
   iLine = 0;
@@ -266,7 +257,8 @@ void InfoToHTML
 
 
   ParseHeaderLine 
-        (pContent + pLines [iLine].StartOffset,
+        (pArena,
+         pContent + pLines [iLine].StartOffset,
          pLines [iLine].EffectiveLength,
          pUriPrefix,
          pInfoFile,
@@ -275,30 +267,30 @@ void InfoToHTML
   iLine++;
 
 
-  fprintf (stream, 
-           "<!DOCTYPE html>\n\n"
-           "<html>\n"
-           "<head>\n"
-           "<title>%s</title>\n"
-           "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
-           "<base href=\"%s\">\n"
-           "<style>\n%s\n</style>\n"
-           "</head>\n"
-           "<body Type=\"info\">\n",
-           pNodeName, 
-           pUriPrefix,
-           pStylesheet);
+  PagePrintf (pPage, 
+              "<!DOCTYPE html>\n\n"
+              "<html>\n"
+              "<head>\n"
+              "<title>%s</title>\n"
+              "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
+              "<base href=\"%s\">\n"
+              "<link rel=\"stylesheet\" href=\"%s\">\n"
+              "</head>\n"
+              "<body Type=\"info\">\n",
+              pNodeName, 
+              pUriPrefix,
+              pStylesheetUri);
 
  
-  GenerateNavBar (stream, &NavLinks, &FormatInfo);
+  GenerateNavBar (pPage, &NavLinks, &FormatInfo);
 
 
-  fprintf (stream, "<div id=\"Main\">\n");
+  PageAppendStatic (pPage, "<div id=\"Main\">\n", -1);
 
 
   if (NodeType == INFO_NODE_DIRECTORY)
   {
-    GenerateTitle (stream, "Info Directory", -1, '*', true);
+    GenerateTitle (pPage, "Info Directory", -1, '*', true);
     nTitles = 1;
   }
 
@@ -335,41 +327,34 @@ void InfoToHTML
         length = pLines [iLast].EndOffset - pLines [iFirst].StartOffset;
         pText = pContent + pLines [iFirst].StartOffset;
    
-        cbAttributes = sizeof (TEXTATTRIBUTES) * length;
-        pAttributes = (TEXTATTRIBUTES*) malloc (cbAttributes);
-        memset (pAttributes, 0, cbAttributes);
+        pAttributes = (TEXTATTRIBUTES*) ArenaAlloc (pArena, length);
+        memset (pAttributes, 0, length);
   
         RecognizeLinks (NodeType, pText, length, pAttributes);
 
-        cbMax = length * HTML_EXPANSION_FACTOR;
-        pHtml = (char*) malloc (cbMax);
-        HTMLizeText (pHtml, cbMax, pText, length, pAttributes, &FormatInfo, 0);
-
-        if (fIsFootnote)
-        {
-          fprintf (stream, 
-                   "<div class=\"InfoFootnotes\">\n"
-                   "<div class=\"Separator\"></div>\n"
-                   "<pre>\n"
-                   "%s\n"
-                   "</pre>\n"
-                   "</div>\n\n\n",
-                   pHtml);
-        }
-        else
-        {
-          fprintf (stream, 
-                   "<pre>\n%s\n</pre>\n\n\n",
-                   pHtml);
-        }
-
-        free (pHtml);
-        free (pAttributes);
+        PageAppendStatic (pPage, 
+                          fIsFootnote
+                             ? "<div class=\"InfoFootnotes\">\n"
+                               "<div class=\"Separator\"></div>\n"
+                               "<pre>\n"
+                             : "<pre>\n", 
+                          -1);
+
+        memset (&state, 0, sizeof (state));
+        HTMLizeTextIncremental (PageGetOutputBuffer (pPage), pText, length, 
+                                pAttributes, &FormatInfo, 0, &state, true);
+
+        PageAppendStatic (pPage, 
+                          fIsFootnote
+                             ? "\n</pre>\n"
+                               "</div>\n\n\n"
+                             : "\n</pre>\n\n\n", 
+                          -1);
         break;
 
 
       case INFO_LINE_TITLE:
-        GenerateTitle (stream,
+        GenerateTitle (pPage,
                        pContent + pLines [iLine].StartOffset,
                        pLines [iLine].EffectiveLength,
                        pLines [iLine].UnderlineChar,
@@ -384,28 +369,20 @@ void InfoToHTML
     }               
   }
 
-  fprintf (stream, "</div>\n");
-
-
-  fprintf (stream, "\n\n<script>\n\"use strict\";\n");
+  PageAppendStatic (pPage, "</div>\n", -1);
 
-  fprintf (stream, "%s", AdjustMarginCode);
 
-  GenerateScript (stream, &NavLinks, &FormatInfo);
+  PagePrintf (pPage, 
+              "\n\n<script src=\"%s\"></script>\n"
+              "<script>\n\"use strict\";\n",
+              AssetUri (ASSET_COMMON_SCRIPT));
 
-  fprintf (stream, 
-           "</script>\n\n"
-           "</body>\n"
-           "</html>\n");
+  GenerateScript (pPage, &NavLinks, &FormatInfo);
 
-
-  free (pLines);
-  free (NavLinks.pPreviousNode);
-  free (NavLinks.pPreviousNodeUri);
-  free (NavLinks.pNextNode);
-  free (NavLinks.pNextNodeUri);
-  free (NavLinks.pUpNode);
-  free (NavLinks.pUpNodeUri);
+  PageAppendStatic (pPage, 
+                    "</script>\n\n"
+                    "</body>\n"
+                    "</html>\n", -1);
 }
 
 
@@ -419,10 +396,44 @@ char* EncodeInfoNodeName
      int          length)
 
 {
-  int i, n;
+  int n;
   char *pStrDest;
+
+
+  if (length < 0)
+  {
+    length = strlen (pStr);
+  }
+
+  
+  pStrDest = (char*) malloc (length * 3 + 1);
+
+  n = EncodeInfoNodeNameInto (pStrDest, length * 3 + 1, pStr, length);
+
+  return (char*) realloc (pStrDest, n + 1);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                   EncodeInfoNodeNameInto
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Same as EncodeInfoNodeName(), but writes the result to a caller-
+*   supplied buffer.  Returns the length of the encoded name, or -1 if 
+*   it (plus the terminating null) does not fit in cbMax bytes.
+*/
+
+int EncodeInfoNodeNameInto
+    (char        *pDest,
+     int          cbMax,
+     const char  *pStr,
+     int          length)
+
+{
+  int i, n;
   unsigned char c;
-  bool fSpace = false;
+  bool fSpace = false, fEscape;
 
   static const char HexDigits [] = "0123456789abcdef";
 
@@ -432,8 +443,6 @@ char* EncodeInfoNodeName
     length = strlen (pStr);
   }
 
-  
-  pStrDest = (char*) malloc (length * 3 + 1);
 
   for (i = n = 0; i < length; i++)
   {
@@ -444,36 +453,44 @@ char* EncodeInfoNodeName
       continue;
     }
 
+    fEscape = (c == HEX_ESCAPE_CHAR)
+                 || (c == '_')
+                 || (c == '?')
+                 || (c == '/')
+                 || (c == '%')
+                 || (c == '&')
+                 || (c == '#');
+
+    if (cbMax - n < (fEscape ? 3 : 1) + ((fSpace && (n > 0)) ? 1 : 0) + 1)
+      return -1;
+
     if (fSpace)
     {
       if (n > 0)
       {  
-        pStrDest [n++] = '_';
+        pDest [n++] = '_';
       }
       fSpace = false;
     }
 
-    if ((c == HEX_ESCAPE_CHAR)
-          || (c == '_')
-          || (c == '?')
-          || (c == '/')
-          || (c == '%')
-          || (c == '&')
-          || (c == '#'))
+    if (fEscape)
     {
-      pStrDest [n++] = HEX_ESCAPE_CHAR;
-      pStrDest [n++] = HexDigits [c >> 4];
-      pStrDest [n++] = HexDigits [c & 0x0F];
+      pDest [n++] = HEX_ESCAPE_CHAR;
+      pDest [n++] = HexDigits [c >> 4];
+      pDest [n++] = HexDigits [c & 0x0F];
     }
     else
     {
-      pStrDest [n++] = (char) c;
+      pDest [n++] = (char) c;
     }  
   }
 
-  pStrDest [n] = '\0';
+  if (cbMax - n < 1)
+    return -1;
 
-  return (char*) realloc (pStrDest, n + 1);
+  pDest [n] = '\0';
+
+  return n;
 }
 
 
@@ -585,87 +602,69 @@ INFONODETYPE NodeTypeFromName
 
 static
 void ClassifyLines
-   (const char   *pContent,
+   (ARENA        *pArena,
+    const char   *pContent,
    	int           cbContent,
     INFOLINE    **ppLinesOut,
     int          *pnLinesOut)
 
 {
-  int nLines, nMaxLines, length, EffectiveLength;
-  int offset, cbPrevLine, cbRemaining;
+  int i, nLines, offset, length, EffectiveLength, cbPrevLine;
   bool fHeaderLineFound = false;
-  char c;
-  const char *pCurrentLine, *pNextLine, *pPrevLine;
+  const char *pCurrentLine, *pPrevLine;
+  LINEINDEX *pIndex;
   INFOLINE *pLines;
 
 
-  nLines = 0;
-  nMaxLines = 16;
-  pLines = (INFOLINE*) malloc (sizeof (INFOLINE) * nMaxLines);
+  nLines = CountLines (pContent, cbContent);
 
-  
-  for (pNextLine = pContent
-         ; (pCurrentLine = pNextLine) != NULL
-         ; nLines++)
-  {
-    offset = pCurrentLine - pContent;
-  	cbRemaining = cbContent - offset;
-    pNextLine = (const char*) memchr (pCurrentLine, '\n', cbRemaining);
-    length = (pNextLine == NULL)
-                ? cbRemaining
-                : (pNextLine++ - pCurrentLine);
-
-
-    EffectiveLength = length;
-    while ((EffectiveLength > 0) 
-              && (c = pCurrentLine [EffectiveLength - 1], 
-                    ((c == ' ') || (c == '\t')
-                      || (c == '\n') || (c == '\r'))))
-    {
-      EffectiveLength--;
-    }
+  pIndex = (LINEINDEX*) ArenaAlloc (pArena, sizeof (LINEINDEX) * nLines);
+  pLines = (INFOLINE*) ArenaAlloc (pArena, sizeof (INFOLINE) * nLines);
 
+  IndexLines (pContent, cbContent, 0, pIndex, nLines);
 
-    if (nLines == nMaxLines)
-    {
-      nMaxLines *= 2;
-      pLines = (INFOLINE*) realloc (pLines, sizeof (INFOLINE) * nMaxLines);
-    }
+  
+  for (i = 0; i < nLines; i++)
+  {
+    offset           = pIndex [i].offset;
+    length           = pIndex [i].length;
+    EffectiveLength  = pIndex [i].TrimmedLength;
+    pCurrentLine     = pContent + offset;
 
  
-    pLines [nLines].UnderlineChar    = '\0';
-    pLines [nLines].StartOffset      = offset;
-    pLines [nLines].EndOffset        = offset + length + 1;
-    pLines [nLines].EffectiveLength  = EffectiveLength;
+    pLines [i].UnderlineChar    = '\0';
+    pLines [i].StartOffset      = offset;
+    pLines [i].EndOffset        = offset + length + 1;
+    pLines [i].EffectiveLength  = EffectiveLength;
 
 
     if (EffectiveLength == 0)
     {
-      pLines [nLines].type = fHeaderLineFound ? INFO_LINE_BLANK : INFO_LINE_IGNORABLE;
+      pLines [i].type = fHeaderLineFound ? INFO_LINE_BLANK : INFO_LINE_IGNORABLE;
       continue;
     }
 
 
     if (IsFootnotesLine (pCurrentLine, EffectiveLength))
     {
-      pLines [nLines].type = fHeaderLineFound ? INFO_LINE_FOOTNOTES : INFO_LINE_IGNORABLE;
+      pLines [i].type = fHeaderLineFound ? INFO_LINE_FOOTNOTES : INFO_LINE_IGNORABLE;
       continue;
     }
 
 
-    if ((nLines >= 1)
-           && (pLines [nLines - 1].type == INFO_LINE_TEXT)
+    if ((i >= 1)
+           && (pLines [i - 1].type == INFO_LINE_TEXT)
            && IsUnderline (pCurrentLine, EffectiveLength))
     {
-      pPrevLine = pContent + pLines [nLines - 1].StartOffset;
-      cbPrevLine = pLines [nLines - 1].EffectiveLength;
+      pPrevLine = pContent + pLines [i - 1].StartOffset;
+      cbPrevLine = pLines [i - 1].EffectiveLength;
 
       if (CountCharsUTF8 (pPrevLine, cbPrevLine) == EffectiveLength)
       {
-        pLines [nLines - 1].type           = INFO_LINE_TITLE;
-        pLines [nLines - 1].UnderlineChar  = pCurrentLine [EffectiveLength - 1];
+        pLines [i - 1].type           = INFO_LINE_TITLE;
+        pLines [i - 1].UnderlineChar  = pCurrentLine [EffectiveLength - 1];
 
-        pLines [nLines].type = INFO_LINE_IGNORABLE;
+        pLines [i].type = INFO_LINE_IGNORABLE;
         continue;
       }
     }
@@ -674,16 +673,16 @@ void ClassifyLines
     if (!fHeaderLineFound)
     {
       fHeaderLineFound = true;      
-      pLines [nLines].type = INFO_LINE_HEADER;
+      pLines [i].type = INFO_LINE_HEADER;
       continue;
     }
 
 
-    pLines [nLines].type = INFO_LINE_TEXT;
+    pLines [i].type = INFO_LINE_TEXT;
   }
 
 
-  *ppLinesOut = (INFOLINE*) realloc (pLines, sizeof (INFOLINE) * nLines);
+  *ppLinesOut = pLines;
   *pnLinesOut = nLines;
 }
 
@@ -760,7 +759,8 @@ bool IsFootnotesLine
 
 static
 void ParseHeaderLine
-   (const char       *pText,
+   (ARENA            *pArena,
+    const char       *pText,
     int               cbText,
     const char       *pPrefix,
     const char       *pContextName,
@@ -769,7 +769,7 @@ void ParseHeaderLine
 {
   int length;
   const char *pLabel, *pComma;
-  char *pNodeName, *pEncodedName, *pUri;
+  char *pNodeName;
 
 
   pLinksOut->pPreviousNode     = NULL;
@@ -789,15 +789,10 @@ void ParseHeaderLine
     pText = (pComma == NULL) ? NULL : (pComma + 1);
 
     length = (pComma == NULL) ? (cbText - (pLabel - pText)) : (pComma - pLabel);
-    pNodeName = strndup (pLabel, length); 
-
-
-    pEncodedName = EncodeInfoNodeName (pNodeName, -1);
-    asprintf (&pUri, "%sinfo/%s/%s", pPrefix, pContextName, pEncodedName);
-    free (pEncodedName);
+    pNodeName = ArenaStrndup (pArena, pLabel, length); 
 
     pLinksOut->pNextNode     = pNodeName;
-    pLinksOut->pNextNodeUri  = pUri;
+    pLinksOut->pNextNodeUri  = MakeNodeUri (pArena, pPrefix, pContextName, pNodeName);
   }
 
 
@@ -810,15 +805,10 @@ void ParseHeaderLine
     pText = (pComma == NULL) ? NULL : (pComma + 1);
 
     length = (pComma == NULL) ? (cbText - (pLabel - pText)) : (pComma - pLabel);
-    pNodeName = strndup (pLabel, length); 
-
-
-    pEncodedName = EncodeInfoNodeName (pNodeName, -1);
-    asprintf (&pUri, "%sinfo/%s/%s", pPrefix, pContextName, pEncodedName);
-    free (pEncodedName);
+    pNodeName = ArenaStrndup (pArena, pLabel, length); 
 
     pLinksOut->pPreviousNode     = pNodeName;
-    pLinksOut->pPreviousNodeUri  = pUri;
+    pLinksOut->pPreviousNodeUri  = MakeNodeUri (pArena, pPrefix, pContextName, pNodeName);
   }
 
 
@@ -828,24 +818,48 @@ void ParseHeaderLine
     pLabel += 4;
 
     length = cbText - (pLabel - pText);
-    pNodeName = strndup (pLabel, length); 
-
-
-    pEncodedName = EncodeInfoNodeName (pNodeName, -1);
-    asprintf (&pUri, "%sinfo/%s/%s", pPrefix, pContextName, pEncodedName);
-    free (pEncodedName);
+    pNodeName = ArenaStrndup (pArena, pLabel, length); 
 
     pLinksOut->pUpNode     = pNodeName;
-    pLinksOut->pUpNodeUri  = pUri;
+    pLinksOut->pUpNodeUri  = MakeNodeUri (pArena, pPrefix, pContextName, pNodeName);
   }
 }
 
 
 
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              MakeNodeUri
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+char* MakeNodeUri
+   (ARENA       *pArena,
+    const char  *pPrefix,
+    const char  *pContextName,
+    const char  *pNodeName)
+
+{
+  int length = strlen (pNodeName);
+  char *pEncodedName = (char*) ArenaAlloc (pArena, length * 3 + 1);
+
+
+  EncodeInfoNodeNameInto (pEncodedName, length * 3 + 1, pNodeName, length);
+
+  return ArenaPrintf (pArena, "%sinfo/%s/%s", pPrefix, pContextName, pEncodedName);
+}
+
+
+
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
                                                            RecognizeLinks
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Finds the links in a block of text in a single pass over its '*'
+*   characters, since every form of Info link begins with one.  Each form
+*   keeps its own resume point, so a link of one form may begin inside a
+*   link of another just as if the forms were scanned separately.
+*/
+
 static
 void RecognizeLinks
    (INFONODETYPE     NodeType,
@@ -854,363 +868,621 @@ void RecognizeLinks
     TEXTATTRIBUTES  *pAttributes)
 
 {
-  switch (NodeType)
+  int i;
+  int iNextMenu = 0, iNextNote = 0, iNextNote2 = 0, iNextOther = 0;
+  const char *pStar;
+  INFOLINKMATCH match;
+
+
+  if (NodeType == INFO_NODE_NORMAL)
   {
-  	case INFO_NODE_NORMAL:
-      RecognizeURIs (pText, length, pAttributes);
-      RecognizeInfoLinks (pText, length, pAttributes);
-      RecognizeNoteLinks2 (pText, length, pAttributes);
-      RecognizeNoteLinks (pText, length, pAttributes);
-      break;
-
-  	case INFO_NODE_INDEX:
-  	  RecognizeInfoIndexLinks (pText, length, pAttributes);
-      break;
-
-    case INFO_NODE_DIRECTORY:
-      RecognizeDirLinks (pText, length, pAttributes);
+    RecognizeURIs (pText, length, pAttributes);
+  }
+
+
+  for (i = 0
+         ; (i < length)
+             && ((pStar = (const char*) memchr (pText + i, '*', length - i)) != NULL)
+         ; i++)
+  {
+    i = pStar - pText;
+
+    switch (NodeType)
+    {
+      case INFO_NODE_NORMAL:
+        if (i >= iNextMenu)
+        {
+          if (MatchMenuLink (pText, length, i, &match))
+          {
+            MarkInfoLink (pAttributes, &match, 0);
+          }
+          iNextMenu = match.iEnd;
+        }
+
+        if (i >= iNextNote2)
+        {
+          if (MatchNoteLink (pText, length, i, true, &match))
+          {
+            MarkInfoLink (pAttributes, &match, TEXT_ATTR_INFO_LINK | TEXT_ATTR_URI);
+          }
+          iNextNote2 = match.iEnd;
+        }
+
+        if (i >= iNextNote)
+        {
+          if (MatchNoteLink (pText, length, i, false, &match))
+          {
+            MarkInfoLink (pAttributes, &match, TEXT_ATTR_INFO_LINK | TEXT_ATTR_URI);
+          }
+          iNextNote = match.iEnd;
+        }
+        break;
+
+
+      case INFO_NODE_INDEX:
+        if (i >= iNextOther)
+        {
+          if (MatchIndexLink (pText, length, i, &match))
+          {
+            MarkInfoLink (pAttributes, &match, TEXT_ATTR_URI);
+          }
+          iNextOther = match.iEnd;
+        }
+        break;
+
+
+      case INFO_NODE_DIRECTORY:
+        if (i >= iNextOther)
+        {
+          if (MatchDirLink (pText, length, i, &match))
+          {
+            MarkInfoLink (pAttributes, &match, TEXT_ATTR_URI);
+          }
+          iNextOther = match.iEnd;
+        }
+    }
   }
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                       RecognizeInfoLinks
+                                                            MatchMenuLink
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Matches a menu entry or cross reference of the form "* Name::" or 
+*   "*note Name::" (in any case), where the name is at most 64 characters
+*   long.  A name made only of whitespace is allowed, as it was when 
+*   these were found with a regular expression.
+*/
+
 static
-int RecognizeInfoLinks
-   (const char      *pText,
-    int              length,
-    TEXTATTRIBUTES  *pAttributes)
+bool MatchMenuLink
+   (const char     *pText,
+    int             length,
+    int             iStar,
+    INFOLINKMATCH  *pMatch)
 
 {
-  int i, index, iStart, iEnd, count;
-  regmatch_t match [2];
+  int i, iNameEnd, iNameStart = -1, iAfterNote;
 
 
-  if (length < 0)
-  {
-    length = strlen (pText);
-  }
+  for (iNameEnd = iStar + 1
+         ; (iNameEnd < length) && (CharClasses [(unsigned char) pText [iNameEnd]] & CC_MENU_NAME)
+         ; iNameEnd++)
+    ;
 
+  pMatch->iEnd = iNameEnd;
 
-  index = count = 0; 
-  while ((index < length)
-            && !tre_regnexec (&LinkRegex1, pText + index, length - index, 2, match, 0))
+  if ((iNameEnd + 1 >= length) 
+        || (pText [iNameEnd] != ':') || (pText [iNameEnd + 1] != ':'))
+    return false;
+
+
+  /*  The name follows any whitespace, and then "note" and more 
+  *   whitespace if they are there.  If that leaves nothing, the name is 
+  *   the last whitespace character before it.
+  */
+
+  for (i = iStar + 1; (i < iNameEnd) && IsInfoSpace (pText [i]); i++)
+    ;
+
+  if ((iNameEnd - i > 4)
+        && (strncasecmp (pText + i, "note", 4) == 0)
+        && IsInfoSpace (pText [i + 4]))
   {
-    iStart = index + match [1].rm_so;
-    iEnd = index + match [1].rm_eo;
+    for (iAfterNote = i + 5; (iAfterNote < iNameEnd) && IsInfoSpace (pText [iAfterNote]); iAfterNote++)
+      ;
 
-    for (i = iStart; i < iEnd; i++)
+    if (iAfterNote < iNameEnd)
     {
-      pAttributes [i] = (pAttributes [i] & ~TEXT_ATTR_APPEARANCE_MASK)
-                            | TEXT_ATTR_INFO_LINK;
+      iNameStart = iAfterNote;
     }
+    else if (iAfterNote - 1 > i + 4)
+    {
+      iNameStart = iAfterNote - 1;
+    }
+  }
 
-    count++;
-    index += match [0].rm_eo;
+  if (iNameStart < 0)
+  {
+    if (i < iNameEnd)
+    {
+      iNameStart = i;
+    }
+    else if (i > iStar + 1)
+    {
+      iNameStart = i - 1;
+    }
+    else
+      return false;
   }
 
-  return count;
+  if (iNameEnd - iNameStart > 64)
+    return false;
+
+
+  pMatch->iStart        = iStar;
+  pMatch->iEnd          = iNameEnd + 2;
+  pMatch->iLinkStart    = iNameStart;
+  pMatch->iLinkEnd      = iNameEnd;
+  pMatch->iFileStart    = pMatch->iFileEnd = 0;
+  pMatch->iTargetStart  = pMatch->iTargetEnd = 0;
+
+  return true;
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                  RecognizeInfoIndexLinks
+                                                            MatchNoteLink
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Matches a cross reference with a label, either "*Note Label: Node." or
+*   (if fOtherFile is set) "*Note Label: (file)Node".  The label may be
+*   up to 100 characters long and ends with the first ':' or '*' in it;
+*   the whole reference is the link.
+*/
+
 static
-int RecognizeInfoIndexLinks
-   (const char      *pText,
-    int              length,
-    TEXTATTRIBUTES  *pAttributes)
+bool MatchNoteLink
+   (const char     *pText,
+    int             length,
+    int             iStar,
+    bool            fOtherFile,
+    INFOLINKMATCH  *pMatch)
 
 {
-  int i, index, iStart, iEnd, count, flags;
-  int iStart2, iEnd2;
-  bool fValidLink;
-  regmatch_t match [3];
+  int i, iLabel, iColon;
 
 
-  if (length < 0)
-  {
-    length = strlen (pText);
-  }
+  pMatch->iEnd = iStar + 1;
 
+  if ((iStar + 6 > length)
+        || (memcmp (pText + iStar, "*Note", 5) != 0)
+        || !IsInfoSpace (pText [iStar + 5]))
+    return false;
 
-  index = count = flags = 0;
-  
-  while ((index < length)
-              && !tre_regnexec (&LinkRegex2, pText + index, length - index, 3, match, flags))
+
+  iLabel = iStar + 6;
+  for (i = iLabel
+         ; (i < length) && (i - iLabel <= 100) && (pText [i] != ':') && (pText [i] != '*')
+         ; i++)
+    ;
+
+  if ((i >= length) || (i - iLabel > 100))
+    return false;
+
+
+  /*  The label's last character may be the ':' or '*' itself, in which
+  *   case the colon that follows the label is the next character.
+  */
+
+  for (iColon = i; iColon <= i + 1; iColon++)
   {
-    iStart = index + match [1].rm_so;
-    iEnd = index + match [1].rm_eo;
+    if ((iColon == i)
+          && ((i == iLabel) || IsInfoSpace (pText [i - 1]) || (pText [i] != ':')))
+      continue;
 
+    if ((iColon == i + 1) 
+          && ((i - iLabel > 99) || (iColon >= length) || (pText [iColon] != ':')))
+      continue;
 
-    fValidLink = true;
-    for (i = iStart; i < iEnd; i++)
+    if (fOtherFile 
+          ? MatchNoteFileTarget (pText, length, iColon, pMatch)
+          : MatchNoteTarget (pText, length, iColon, pMatch))
     {
-      if (pAttributes [i] & TEXT_ATTR_URI)
-      {
-        fValidLink = false;
-        break;
-      }
+      pMatch->iStart      = iStar;
+      pMatch->iLinkStart  = iStar;
+      pMatch->iLinkEnd    = pMatch->iEnd;
+      return true;
     }
+  }
 
+  pMatch->iEnd = iStar + 1;
+  return false;
+}
 
-    if (fValidLink)
-    {
-      for (i = iStart; i < iEnd; i++)
-      {
-        pAttributes [i] = (pAttributes [i] & ~TEXT_ATTR_APPEARANCE_MASK)
-                              | TEXT_ATTR_INFO_LINK;
-      }
-  
-      iStart2 = index + match [2].rm_so;
-      iEnd2 = index + match [2].rm_eo;
-      for (i = iStart2; i < iEnd2; i++)
-      {
-        pAttributes [i] |= TEXT_ATTR_INFO_TARGET;
-      }
-  
-      count++;
-    }
 
 
-    index += match [0].rm_eo;
-    flags = REG_NOTBOL;
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          MatchNoteTarget
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Matches the " Node." that follows the colon of a "*Note" reference.
+*/
+
+static
+bool MatchNoteTarget
+   (const char     *pText,
+    int             length,
+    int             iColon,
+    INFOLINKMATCH  *pMatch)
+
+{
+  int i, iNode, iNodeEnd;
+
+
+  if ((iColon + 1 >= length) || !IsInfoSpace (pText [iColon + 1]))
+    return false;
+
+  for (i = iColon + 2; (i < length) && IsInfoSpace (pText [i]); i++)
+    ;
+
+  for (iNodeEnd = i
+         ; (iNodeEnd < length) && (CharClasses [(unsigned char) pText [iNodeEnd]] & CC_NOTE_NODE)
+         ; iNodeEnd++)
+    ;
+
+  if ((iNodeEnd >= length) || (pText [iNodeEnd] != '.'))
+    return false;
+
+
+  /*  A node made only of whitespace is the last whitespace character.
+  */
+
+  if (i < iNodeEnd)
+  {
+    iNode = i;
+  }
+  else if (i - 1 > iColon + 1)
+  {
+    iNode = i - 1;
   }
+  else
+    return false;
 
-  return count;
+  if (iNodeEnd - iNode > 64)
+    return false;
+
+
+  pMatch->iEnd          = iNodeEnd + 1;
+  pMatch->iFileStart    = pMatch->iFileEnd = 0;
+  pMatch->iTargetStart  = iNode;
+  pMatch->iTargetEnd    = iNodeEnd;
+
+  return true;
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                       RecognizeNoteLinks
+                                                      MatchNoteFileTarget
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Matches the " (file)Node" that follows the colon of a "*Note" 
+*   reference.  A period at the end of the node is not part of the 
+*   target.
+*/
+
 static
-int RecognizeNoteLinks
-   (const char      *pText,
-    int              length,
-    TEXTATTRIBUTES  *pAttributes)
+bool MatchNoteFileTarget
+   (const char     *pText,
+    int             length,
+    int             iColon,
+    INFOLINKMATCH  *pMatch)
 
 {
-  int i, index, iStart, iEnd, count;
-  int iStart2, iEnd2;
-  bool fValidLink;
-  regmatch_t match [2];
+  int i, iFile, iFileEnd, iNode, iNodeEnd;
 
 
-  if (length < 0)
-  {
-    length = strlen (pText);
-  }
+  if ((iColon + 1 >= length) || !IsInfoSpace (pText [iColon + 1]))
+    return false;
 
+  for (i = iColon + 2; (i < length) && IsInfoSpace (pText [i]); i++)
+    ;
 
-  index = count = 0;
-  
-  while ((index < length)
-              && !tre_regnexec (&NoteLinkRegex, pText + index, length - index, 2, match, 0))
+  if ((i >= length) || (pText [i] != '('))
+    return false;
+
+
+  iFile = i + 1;
+  for (iFileEnd = iFile
+         ; (iFileEnd < length) && (CharClasses [(unsigned char) pText [iFileEnd]] & CC_FILE_NAME)
+         ; iFileEnd++)
+    ;
+
+  if ((iFileEnd == iFile) || (iFileEnd - iFile > 32) 
+        || (iFileEnd >= length) || (pText [iFileEnd] != ')'))
+    return false;
+
+
+  iNode = iFileEnd + 1;
+  for (iNodeEnd = iNode
+         ; (iNodeEnd < length) && (iNodeEnd - iNode < 64)
+             && (CharClasses [(unsigned char) pText [iNodeEnd]] & CC_FILE_NAME)
+         ; iNodeEnd++)
+    ;
+
+  if (iNodeEnd == iNode)
+    return false;
+
+
+  pMatch->iEnd          = iNodeEnd;
+  pMatch->iFileStart    = iFile;
+  pMatch->iFileEnd      = iFileEnd;
+  pMatch->iTargetStart  = iNode;
+  pMatch->iTargetEnd    = (pText [iNodeEnd - 1] == '.') ? (iNodeEnd - 1) : iNodeEnd;
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           MatchIndexLink
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Matches an index entry, "* Entry: Node.", where the entry is on one
+*   line and the node is at most 64 characters long.  The link is the 
+*   entry and node together.  When there is no match, no other entry can
+*   begin before the colon (or end of line) that ended the attempt, except
+*   at a '*' followed only by whitespace, so pMatch->iEnd is set there.
+*/
+
+static
+bool MatchIndexLink
+   (const char     *pText,
+    int             length,
+    int             iStar,
+    INFOLINKMATCH  *pMatch)
+
+{
+  int i, j, iEntry, iColon, iStart, iNode, iNodeEnd, iRunEnd, iLast;
+
+
+  for (i = iStar + 1; (i < length) && IsInfoSpace (pText [i]); i++)
+    ;
+
+  for (iColon = i
+         ; (iColon < length) && (pText [iColon] != ':') && (pText [iColon] != '\n')
+         ; iColon++)
+    ;
+
+  pMatch->iEnd = iColon;
+
+  if ((iColon >= length) || (pText [iColon] != ':'))
   {
-    iStart = index + match [0].rm_so;
-    iEnd = index + match [0].rm_eo;
+    for (j = iColon - 1; (j > iStar) && IsInfoSpace (pText [j]); j--)
+      ;
 
-  
-    fValidLink = true;
-    for (i = iStart; i < iEnd; i++)
+    if ((j > iStar) && (pText [j] == '*'))
     {
-      if (pAttributes [i] & (TEXT_ATTR_INFO_LINK | TEXT_ATTR_URI))
-      {
-        fValidLink = false;
-        break;
-      }
+      pMatch->iEnd = j;
     }
 
+    return false;
+  }
+
+  if (i < iColon)
+  {
+    iEntry = i;
+  }
+  else if ((i - 1 > iStar) && (pText [i - 1] != '\n'))
+  {
+    iEntry = i - 1;
+  }
+  else
+    return false;
+
 
-    if (fValidLink)
+  /*  The node is the longest run of up to 64 characters that is 
+  *   followed by a period (which may itself be part of the run).  If 
+  *   there is none, the run may begin instead with the last whitespace
+  *   character before it.
+  */
+
+  for (i = iColon + 1; (i < length) && IsInfoSpace (pText [i]); i++)
+    ;
+
+  for (iRunEnd = i
+         ; (iRunEnd < length) && (CharClasses [(unsigned char) pText [iRunEnd]] & CC_MENU_NAME)
+         ; iRunEnd++)
+    ;
+
+  iNode = iNodeEnd = -1;
+
+  for (iStart = i; (iNodeEnd < 0) && (iStart >= i - 1) && (iStart > iColon); iStart--)
+  {
+    iLast = (iRunEnd - iStart < 64) ? iRunEnd : (iStart + 64);
+    for (j = iLast; j > iStart; j--)
     {
-      for (i = iStart; i < iEnd; i++)
+      if ((j < length) && (pText [j] == '.'))
       {
-        pAttributes [i] = (pAttributes [i] & ~TEXT_ATTR_APPEARANCE_MASK)
-                              | TEXT_ATTR_INFO_LINK;
-      }
-  
-      iStart2 = index + match [1].rm_so;
-      iEnd2 = index + match [1].rm_eo;
-      for (i = iStart2; i < iEnd2; i++)
-      {
-        pAttributes [i] |= TEXT_ATTR_INFO_TARGET;
+        iNode = iStart;
+        iNodeEnd = j;
+        break;
       }
-  
-      count++;
     }
+  }
 
+  if (iNodeEnd < 0)
+    return false;
 
-    index += match [0].rm_eo;
-  }
 
-  return count;
+  pMatch->iStart        = iStar;
+  pMatch->iEnd          = iNodeEnd + 1;
+  pMatch->iLinkStart    = iEntry;
+  pMatch->iLinkEnd      = iNodeEnd;
+  pMatch->iFileStart    = pMatch->iFileEnd = 0;
+  pMatch->iTargetStart  = iNode;
+  pMatch->iTargetEnd    = iNodeEnd;
+
+  return true;
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                      RecognizeNoteLinks2
+                                                             MatchDirLink
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Matches a directory entry, "* Entry: (file)Node.", which must be the
+*   first thing on its line.  The node may be empty.
+*/
+
 static
-int RecognizeNoteLinks2
-   (const char      *pText,
-    int              length,
-    TEXTATTRIBUTES  *pAttributes)
+bool MatchDirLink
+   (const char     *pText,
+    int             length,
+    int             iStar,
+    INFOLINKMATCH  *pMatch)
 
 {
-  int i, index, iStart, iEnd, iStart2, iEnd2, count;
-  bool fValidLink;
-  regmatch_t match [3];
+  int i, iEntry, iColon, iFile, iFileEnd, iNodeEnd;
 
 
-  if (length < 0)
+  pMatch->iEnd = iStar + 1;
+
+  for (i = iStar - 1; (i >= 0) && (pText [i] != '\n'); i--)
   {
-    length = strlen (pText);
+    if (!IsInfoSpace (pText [i]))
+      return false;
   }
 
 
-  index = count = 0;
-  
-  while ((index < length)
-              && !tre_regnexec (&NoteLinkRegex2, pText + index, length - index, 3, match, 0))
+  for (i = iStar + 1; (i < length) && IsInfoSpace (pText [i]); i++)
+    ;
+
+  for (iColon = i
+         ; (iColon < length) && (CharClasses [(unsigned char) pText [iColon]] & CC_DIR_ENTRY)
+         ; iColon++)
+    ;
+
+  if ((i == iStar + 1) || (iColon >= length) || (pText [iColon] != ':'))
+    return false;
+
+  if (i < iColon)
   {
-    iStart = index + match [0].rm_so;
-    iEnd = index + match [0].rm_eo;
-    fValidLink = true;
-    for (i = iStart; i < iEnd; i++)
-    {
-      if (pAttributes [i] & (TEXT_ATTR_INFO_LINK | TEXT_ATTR_URI))
-      {
-        fValidLink = false;
-        break;
-      }
-    }
+    iEntry = i;
+  }
+  else if (i - 1 > iStar + 1)
+  {
+    iEntry = i - 1;
+  }
+  else
+    return false;
 
 
-    if (fValidLink)
-    {
-      for (i = iStart; i < iEnd; i++)
-      {
-        pAttributes [i] = (pAttributes [i] & ~TEXT_ATTR_APPEARANCE_MASK)
-                              | TEXT_ATTR_INFO_LINK;
-      }
-  
-      iStart2 = index + match [1].rm_so + 1;
-      iEnd2 = index + match [1].rm_eo - 2;
-      for (i = iStart2; i <= iEnd2; i++)
-      {
-        pAttributes [i] |= TEXT_ATTR_INFO_FILENAME;
-      }
+  if ((iColon + 1 >= length) || !IsInfoSpace (pText [iColon + 1]))
+    return false;
 
+  for (i = iColon + 2; (i < length) && IsInfoSpace (pText [i]); i++)
+    ;
 
-      iStart2 = index + match [2].rm_so;
-      iEnd2 = index + match [2].rm_eo - 1;
+  if ((i >= length) || (pText [i] != '('))
+    return false;
 
-      if (pText [iEnd2] == '.')
-      {
-      	iEnd2--;
-      }
 
-      for (i = iStart2; i <= iEnd2; i++)
-      {
-        pAttributes [i] |= TEXT_ATTR_INFO_TARGET;
-      }
-  
-      count++;
-    }
+  iFile = i + 1;
+  for (iFileEnd = iFile
+         ; (iFileEnd < length) && (CharClasses [(unsigned char) pText [iFileEnd]] & CC_DIR_FILE)
+         ; iFileEnd++)
+    ;
 
+  if ((iFileEnd == iFile) || (iFileEnd >= length) || (pText [iFileEnd] != ')'))
+    return false;
 
-    index += match [0].rm_eo;
-  }
+  for (iNodeEnd = iFileEnd + 1
+         ; (iNodeEnd < length) && (CharClasses [(unsigned char) pText [iNodeEnd]] & CC_DIR_NODE)
+         ; iNodeEnd++)
+    ;
+
+  if ((iNodeEnd >= length) || (pText [iNodeEnd] != '.'))
+    return false;
+
+
+  pMatch->iStart        = iStar;
+  pMatch->iEnd          = iNodeEnd + 1;
+  pMatch->iLinkStart    = iEntry;
+  pMatch->iLinkEnd      = iNodeEnd;
+  pMatch->iFileStart    = iFile;
+  pMatch->iFileEnd      = iFileEnd;
+  pMatch->iTargetStart  = iFileEnd + 1;
+  pMatch->iTargetEnd    = iNodeEnd;
 
-  return count;
+  return true;
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                        RecognizeDirLinks
+                                                             MarkInfoLink
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Sets the attributes of a link, unless any of its characters already
+*   has one of the attributes in RejectAttrs.
+*/
+
 static
-int RecognizeDirLinks
-   (const char      *pText,
-    int              length,
-    TEXTATTRIBUTES  *pAttributes)
+void MarkInfoLink
+   (TEXTATTRIBUTES       *pAttributes,
+    const INFOLINKMATCH  *pMatch,
+    TEXTATTRIBUTES        RejectAttrs)
 
 {
-  int i, index, iStart, iEnd, count, flags;
-  bool fValidLink;
-  regmatch_t match [4];
+  int i;
 
 
-  if (length < 0)
+  if (RejectAttrs != 0)
   {
-    length = strlen (pText);
+    for (i = pMatch->iStart; i < pMatch->iEnd; i++)
+    {
+      if (pAttributes [i] & RejectAttrs)
+        return;
+    }
   }
 
 
-  index = count = flags = 0;
-  
-  while ((index < length)
-              && !tre_regnexec (&DirLinkRegex, pText + index, length - index, 4, match, flags))
+  for (i = pMatch->iLinkStart; i < pMatch->iLinkEnd; i++)
   {
-    iStart = index + match [0].rm_so;
-    iEnd = index + match [0].rm_eo;
-    fValidLink = true;
-    for (i = iStart; i < iEnd; i++)
-    {
-      if (pAttributes [i] & TEXT_ATTR_URI)
-      {
-        fValidLink = false;
-        break;
-      }
-    }
+    pAttributes [i] = (pAttributes [i] & ~TEXT_ATTR_APPEARANCE_MASK)
+                          | TEXT_ATTR_INFO_LINK;
+  }
 
+  for (i = pMatch->iFileStart; i < pMatch->iFileEnd; i++)
+  {
+    pAttributes [i] |= TEXT_ATTR_INFO_FILENAME;
+  }
 
-    if (fValidLink)
-    {
-      iStart = index + match [1].rm_so;
-      iEnd = index + match [3].rm_eo;
-      for (i = iStart; i < iEnd; i++)
-      {
-        pAttributes [i] |= TEXT_ATTR_INFO_LINK;
-      }
+  for (i = pMatch->iTargetStart; i < pMatch->iTargetEnd; i++)
+  {
+    pAttributes [i] |= TEXT_ATTR_INFO_TARGET;
+  }
+}
 
-      iStart = index + match [2].rm_so;
-      iEnd = index + match [2].rm_eo;
-      for (i = iStart; i < iEnd; i++)
-      {
-        pAttributes [i] |= TEXT_ATTR_INFO_FILENAME;
-      }
-  
-      iStart = index + match [3].rm_so;
-      iEnd = index + match [3].rm_eo;
-      for (i = iStart; i < iEnd; i++)
-      {
-        pAttributes [i] |= TEXT_ATTR_INFO_TARGET;
-      }
-  
-      count++;
-    }
 
 
-    index += match [0].rm_eo;
-    flags = REG_NOTBOL;
-  }
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              IsInfoSpace
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-  return count;
+static inline
+bool IsInfoSpace
+   (char  c)
+
+{
+  return (CharClasses [(unsigned char) c] & CC_SPACE) != 0;
 }
 
 
@@ -1221,7 +1493,7 @@ int RecognizeDirLinks
 
 static
 void GenerateNavBar
-   (FILE                   *stream,
+   (PAGEBUILDER            *pPage,
     const NAVIGATIONLINKS  *pNavLinks,
     const HTMLFORMATINFO   *pFormat)
 
@@ -1229,8 +1501,8 @@ void GenerateNavBar
   char buffer [256];
 
 
-  fprintf (stream,
-           "<div id=\"NavBar\">\n");
+  PageAppendStatic (pPage,
+                    "<div id=\"NavBar\">\n", -1);
 
 
   /*  Previous node link.
@@ -1239,21 +1511,21 @@ void GenerateNavBar
   if ((pNavLinks->pPreviousNode == NULL)
          || (pNavLinks->pPreviousNodeUri == NULL))
   {
-    fprintf (stream, 
-             "<div id=\"Nav-Info-Prev\">\n"
-             "<span Label=\"1\">Prev:</span>none\n"
-             "</div>\n");
+    PageAppendStatic (pPage, 
+                      "<div id=\"Nav-Info-Prev\">\n"
+                      "<span Label=\"1\">Prev:</span>none\n"
+                      "</div>\n", -1);
   }
   else
   {
-    HTMLizeText (buffer, sizeof (buffer), pNavLinks->pPreviousNode, -1, NULL, NULL, 0);
-
-    fprintf (stream, 
-             "<div id=\"Nav-Info-Prev\">\n"
-             "<span Label=\"1\">Prev:</span><a href=\"%s\">%s</a>\n"
-             "</div>\n",           
-             pNavLinks->pPreviousNodeUri,
-             buffer);
+    HTMLEscapeText (buffer, sizeof (buffer), pNavLinks->pPreviousNode, -1);
+
+    PagePrintf (pPage, 
+                "<div id=\"Nav-Info-Prev\">\n"
+                "<span Label=\"1\">Prev:</span><a href=\"%s\">%s</a>\n"
+                "</div>\n",           
+                pNavLinks->pPreviousNodeUri,
+                buffer);
   }
 
 
@@ -1263,21 +1535,21 @@ void GenerateNavBar
   if ((pNavLinks->pUpNode == NULL)
          || (pNavLinks->pUpNodeUri == NULL))
   {
-    fprintf (stream, 
-             "<div id=\"Nav-Info-Up\">\n"
-             "<span Label=\"1\">Up:</span>none\n"
-             "</div>\n");
+    PageAppendStatic (pPage, 
+                      "<div id=\"Nav-Info-Up\">\n"
+                      "<span Label=\"1\">Up:</span>none\n"
+                      "</div>\n", -1);
   }
   else
   {
-    HTMLizeText (buffer, sizeof (buffer), pNavLinks->pUpNode, -1, NULL, NULL, 0);
-
-    fprintf (stream, 
-             "<div id=\"Nav-Info-Up\">\n"
-             "<span Label=\"1\">Up:</span><a href=\"%s\">%s</a>\n"
-             "</div>\n",           
-             pNavLinks->pUpNodeUri,
-             buffer);
+    HTMLEscapeText (buffer, sizeof (buffer), pNavLinks->pUpNode, -1);
+
+    PagePrintf (pPage, 
+                "<div id=\"Nav-Info-Up\">\n"
+                "<span Label=\"1\">Up:</span><a href=\"%s\">%s</a>\n"
+                "</div>\n",           
+                pNavLinks->pUpNodeUri,
+                buffer);
   }
 
 
@@ -1287,24 +1559,24 @@ void GenerateNavBar
   if ((pNavLinks->pNextNode == NULL)
          || (pNavLinks->pNextNodeUri == NULL))
   {
-    fprintf (stream, 
-             "<div id=\"Nav-Info-Next\">\n"
-             "<span Label=\"1\">Next:</span>none\n"
-             "</div>\n");
+    PageAppendStatic (pPage, 
+                      "<div id=\"Nav-Info-Next\">\n"
+                      "<span Label=\"1\">Next:</span>none\n"
+                      "</div>\n", -1);
   }
   else
   {
-    HTMLizeText (buffer, sizeof (buffer), pNavLinks->pNextNode, -1, NULL, NULL, 0);
-
-    fprintf (stream, 
-             "<div id=\"Nav-Info-Next\">\n"
-             "<span Label=\"1\">Next:</span><a href=\"%s\">%s</a>\n"
-             "</div>\n",           
-             pNavLinks->pNextNodeUri,
-             buffer);
+    HTMLEscapeText (buffer, sizeof (buffer), pNavLinks->pNextNode, -1);
+
+    PagePrintf (pPage, 
+                "<div id=\"Nav-Info-Next\">\n"
+                "<span Label=\"1\">Next:</span><a href=\"%s\">%s</a>\n"
+                "</div>\n",           
+                pNavLinks->pNextNodeUri,
+                buffer);
   }
 
-  fprintf (stream, "</div>\n\n");
+  PageAppendStatic (pPage, "</div>\n\n", -1);
 }
 
 
@@ -1315,7 +1587,7 @@ void GenerateNavBar
 
 static
 void GenerateScript
-   (FILE                   *stream,
+   (PAGEBUILDER            *pPage,
     const NAVIGATIONLINKS  *pNavLinks,
     const HTMLFORMATINFO   *pFormat)
 
@@ -1326,46 +1598,46 @@ void GenerateScript
     return;
 
 
-  fprintf (stream, 
-           "function HandleKeyPress\n"
-           "    (event)\n"
-           "{\n"
-           "  if (!event || event.isComposing || event.altKey || event.ctrlKey)\n"
-           "    return;\n"
-           "  switch (event.which || event.keyCode)\n"
-           "  {\n");
+  PageAppendStatic (pPage, 
+                    "function HandleKeyPress\n"
+                    "    (event)\n"
+                    "{\n"
+                    "  if (!event || event.isComposing || event.altKey || event.ctrlKey)\n"
+                    "    return;\n"
+                    "  switch (event.which || event.keyCode)\n"
+                    "  {\n", -1);
 
   if (pNavLinks->pPreviousNodeUri != NULL)
   {
-    fprintf (stream, 
-             "    case 91:\n"
-             "      window.open (\"%s\", \"_self\");\n"
-             "      break;\n",
-             pNavLinks->pPreviousNodeUri);
+    PagePrintf (pPage, 
+                "    case 91:\n"
+                "      window.open (\"%s\", \"_self\");\n"
+                "      break;\n",
+                pNavLinks->pPreviousNodeUri);
   }	
 
   if (pNavLinks->pNextNodeUri != NULL)
   {
-    fprintf (stream, 
-             "    case 93:\n"
-             "      window.open (\"%s\", \"_self\");\n"
-             "      break;\n",
-             pNavLinks->pNextNodeUri);
+    PagePrintf (pPage, 
+                "    case 93:\n"
+                "      window.open (\"%s\", \"_self\");\n"
+                "      break;\n",
+                pNavLinks->pNextNodeUri);
   }	
 
   if (pNavLinks->pUpNodeUri != NULL)
   {
-    fprintf (stream, 
-             "    case 61:\n"
-             "      window.open (\"%s\", \"_self\");\n"
-             "      break;\n",
-             pNavLinks->pUpNodeUri);
+    PagePrintf (pPage, 
+                "    case 61:\n"
+                "      window.open (\"%s\", \"_self\");\n"
+                "      break;\n",
+                pNavLinks->pUpNodeUri);
   }	
 
-  fprintf (stream, 
-           "  }\n"
-           "}\n\n"
-           "document.addEventListener (\"keypress\", HandleKeyPress, false);\n"); 
+  PageAppendStatic (pPage, 
+                    "  }\n"
+                    "}\n\n"
+                    "document.addEventListener (\"keypress\", HandleKeyPress, false);\n", -1); 
 }
 
 
@@ -1376,7 +1648,7 @@ void GenerateScript
 
 static
 void GenerateTitle
-   (FILE        *stream,
+   (PAGEBUILDER *pPage,
     const char  *pText,
     int          length,
     char         cUnderline,
@@ -1410,7 +1682,7 @@ void GenerateTitle
   }
 
 
-  HTMLizeText (buffer, sizeof (buffer), pText, length, NULL, NULL, 0);
+  HTMLEscapeText (buffer, sizeof (buffer), pText, length);
 
   switch (cUnderline)
   {
@@ -1421,11 +1693,11 @@ void GenerateTitle
     default:   pULTypeAttr = "";
   }
 
-  fprintf (stream,
-           "<div class=\"InfoTitle\"%s%s%s>\n%s%s\n</div>\n\n",
-           pULTypeAttr,
-           (NumberStr [0] == '\0') ? "" : " HasNumber=\"\"",
-           fIsFirst ? " First=\"\"" : "",
-           NumberStr,
-           buffer);
+  PagePrintf (pPage,
+              "<div class=\"InfoTitle\"%s%s%s>\n%s%s\n</div>\n\n",
+              pULTypeAttr,
+              (NumberStr [0] == '\0') ? "" : " HasNumber=\"\"",
+              fIsFirst ? " First=\"\"" : "",
+              NumberStr,
+              buffer);
 }
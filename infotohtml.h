@@ -29,6 +29,12 @@
 #define __INFOTOHTML_H_
 
 
+#include "page_builder.h"          /*  For PAGEBUILDER type.  */
+
+
+struct ARENA;
+
+
 
 extern "C"
 {
@@ -38,11 +44,12 @@ extern void infoInitializeRegexes
     
 
 extern void InfoToHTML
-    (FILE          *stream,
+    (PAGEBUILDER   *pPage,
+     ARENA         *pArena,
      const char    *pInfoFile,
      const char    *pNodeName,
      const char    *pUriPrefix,
-     const char    *pStylesheet,
+     const char    *pStylesheetUri,
      const char    *pContent,
      int            cbContent);
 
@@ -52,6 +59,13 @@ extern char* EncodeInfoNodeName
      int          length);
 
 
+extern int EncodeInfoNodeNameInto
+    (char        *pDest,
+     int          cbMax,
+     const char  *pStr,
+     int          length);
+
+
 extern char* DecodeInfoNodeName
     (const char  *pStr,
      int          length);
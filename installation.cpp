@@ -66,3 +66,46 @@ const char *AproposPath  = "/usr/bin/apropos";
 
 const char *InfoPath     = "/usr/bin/info";
 
+
+
+/*  Mapping from manual page hierarchies to the directories in which
+*   man-db keeps the corresponding preformatted ("cat") pages.  This
+*   mirrors the MANDB_MAP entries in /etc/manpath.config.
+*/
+
+const char *CatPageDirectories []
+     /*   Manual page hierarchy      Cat page hierarchy         */
+       = {"/usr/share/man",          "/var/cache/man",
+          "/usr/local/share/man",    "/var/cache/man/local",
+          "/usr/local/man",          "/var/cache/man/oldlocal",
+          "/usr/X11R6/man",          "/var/cache/man/X11R6",
+          "/opt/man",                "/var/cache/man/opt",
+          "/usr/man",                "/var/cache/man/fsstnd",
+          NULL};               /*  Required NULL terminator--do not remove!  */
+
+
+
+/*  Programs used to decompress manual pages and cat pages, keyed by
+*   file extension.
+*/
+
+const char *Decompressors []
+     /*   Extension   Program                     */
+       = {".gz",      "/usr/bin/zcat",
+          ".bz2",     "/usr/bin/bzcat",
+          ".xz",      "/usr/bin/xzcat",
+          ".lzma",    "/usr/bin/lzcat",
+          ".Z",       "/usr/bin/zcat",
+          NULL};               /*  Required NULL terminator--do not remove!  */
+
+
+
+/*  Directories searched for Info files, after any given in $INFOPATH.
+*/
+
+const char *InfoDirectories []
+       = {"/usr/share/info",
+          "/usr/local/share/info",
+          "/usr/info",
+          "/usr/local/info",
+          NULL};               /*  Required NULL terminator--do not remove!  */
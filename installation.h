@@ -33,6 +33,9 @@ extern const char *ManualSections [];
 extern const char *ManPath;
 extern const char *AproposPath;
 extern const char *InfoPath;
+extern const char *CatPageDirectories [];
+extern const char *Decompressors [];
+extern const char *InfoDirectories [];
 
 
 #endif
@@ -28,6 +28,12 @@ function ShowSection
     return;
 
 
+  if (fShow && content.hasAttribute ("Lazy"))
+  {
+    LoadSection (n, content);
+  }
+
+
   let header = document.getElementById (idSection + "_Header");
   let button = document.getElementById (idSection + "_ShowBtn");
 
@@ -44,6 +50,42 @@ function ShowSection
 
 
 
+/*  Sections marked "Lazy" were left out of the page, and are fetched
+    the first time they are shown.
+*/
+
+function LoadSection
+    (n,
+     content)
+
+{
+  content.removeAttribute ("Lazy");
+
+  fetch (`${window.location.pathname}/section/${n}`)
+    .then (function (response)
+           {
+             if (!response.ok)
+               throw new Error (response.statusText);
+
+             return response.text ();
+           })
+    .then (function (text)
+           {
+             content.innerHTML = text;
+
+             if (content.getAttribute ("State") == "SHOWN")
+             {
+               content.style.maxHeight = `${content.scrollHeight}px`;
+             }
+           })
+    .catch (function (error)
+            {
+              content.setAttribute ("Lazy", "");
+            });
+}
+
+
+
 function GoToSection
     (n)
 
@@ -110,21 +152,101 @@ function HandleSelection
 
 
 
-for (let e of document.getElementsByClassName ("Collapsible"))
+/*  The pages that refer to this one come from the backlink index, and
+    are listed after the last section (the way SEE ALSO lists the ones
+    it refers to) if there are any.
+*/
+
+function LoadBacklinks
+    ()
+
 {
-  e.setAttribute ("State", "SHOWN");
+  let path = window.location.pathname;
+  let title = decodeURIComponent (path.substring (path.indexOf ("/man/") + 5));
+
+  fetch (`/api/backlinks?page=${encodeURIComponent (title)}`)
+    .then (function (response)
+           {
+             if (!response.ok)
+               throw new Error (response.statusText);
+
+             return response.json ();
+           })
+    .then (function (answer)
+           {
+             if (answer.total > 0)
+             {
+               ShowBacklinks (answer.results);
+             }
+           })
+    .catch (function (error)
+            {
+            });
 }
 
-for (let e of document.getElementsByClassName ("HeaderBar"))
+
+
+function ShowBacklinks
+    (results)
+
 {
-  e.setAttribute ("State", "SHOWN");
+  let container = document.getElementById ("Backlinks");
+  let header = document.createElement ("div");
+  let body = document.createElement ("div");
+  let pre = document.createElement ("pre");
+  let column = 7;
+
+  header.className = "HeaderBar";
+  header.textContent = "Referenced by";
+  body.className = "Collapsible";
+  pre.append ("       ");
+
+  for (let i = 0; i < results.length; i++)
+  {
+    let [name, section] = results [i];
+    let text = `${name}(${section})`;
+    let prefix = (name.indexOf (":") >= 0) ? document.baseURI : "";
+
+    if (i > 0)
+    {
+      let fWrap = (column + text.length + 2 > 78);
+
+      pre.append (fWrap ? ",\n       " : ", ");
+      column = fWrap ? 7 : column + 2;
+    }
+
+    let link = document.createElement ("a");
+    link.textContent = text;
+    link.setAttribute ("href", `${prefix}man/${name}(${section})`);
+    link.setAttribute ("RefType", "manpage");
+    pre.append (link);
+
+    column += text.length;
+  }
+
+  body.append (pre);
+  container.append (header, body);
+  container.hidden = false;
 }
 
-for (let e of document.getElementsByClassName ("HideButton"))
+
+
+for (let e of document.getElementsByClassName ("Collapsible"))
 {
-  e.setAttribute ("State", "SHOWN");
+  let state = e.hasAttribute ("Lazy") ? "HIDDEN" : "SHOWN";
+
+  e.setAttribute ("State", state);
+  document.getElementById (e.id + "_Header").setAttribute ("State", state);
+  document.getElementById (e.id + "_ShowBtn").setAttribute ("State", state);
+
+  if (state == "HIDDEN")
+  {
+    e.style.maxHeight = "0px";
+  }
 }
 
 document.getElementById ("ShowAllBtn").addEventListener ("click", ShowAll, false);
 document.getElementById ("HideAllBtn").addEventListener ("click", HideAll, false);
 SectionList.addEventListener ("input", HandleSelection, false);
+
+LoadBacklinks ();
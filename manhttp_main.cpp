@@ -52,6 +52,7 @@
 #include <stdarg.h>
 #include <errno.h>
 #include <syslog.h>
+#include <limits.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -64,11 +65,22 @@
 #include <microhttpd.h>
 
 #include "utility.h"                   /*  Application headers.  */
+#include "arena.h"
 #include "html_formatting.h"
+#include "page_builder.h"
 #include "documentation_api.h"
 #include "manualpagetohtml.h"
 #include "apropostohtml.h"
 #include "infotohtml.h"
+#include "assets.h"
+#include "section_cache.h"
+#include "apropos_cache.h"
+#include "name_index.h"
+#include "apropos_index.h"
+#include "fulltext_index.h"
+#include "backlink_index.h"
+#include "info_index.h"
+#include "searchtohtml.h"
 
 
 
@@ -83,12 +95,46 @@
 
 #define MAX_THREADS     100
 
+#define THREADS_PER_CPU      4
+
+#define DEFAULT_BACKLOG      64
+
+#define ASSET_CACHE_POLICY   "public, max-age=31536000, immutable"
+
+#define STREAM_READ_SIZE     (16 * 1024)
+
+#define STREAM_BLOCK_SIZE    (32 * 1024)
+
+#define COMPLETE_LIMIT       15
+
+#define MAX_COMPLETE_LIMIT   100
+
+#define NAME_INDEX_REFRESH   3600    /*  Seconds.  */
+
+#define MAX_SUGGESTIONS      8
+
 
 
 typedef struct sockaddr_in INETADDRESS;
 
 
 
+/*  A manual page that is sent while man(1) is still producing it.
+*/
+
+struct MANPAGESTREAMINFO
+{
+  MANPAGESTREAM     stream;
+  ARENA            *pArena;
+  MANPAGERENDERER   renderer;
+  PAGEBUILDER       page;
+  char              CanonicalID [80];
+  bool              fEndOfInput;
+  char              buffer [STREAM_READ_SIZE];
+};
+
+
+
 /*  Text displayed along with the POPT help info.
 */
 
@@ -103,27 +149,48 @@ static const char HelpIntro []
 
 static bool fReadyToQuit = false;
 static int fUseSyslog = 0;
+static int fStreamPages = 0;
+static int nLazySections = -1;
 static char CachePolicy [64];
 static char *pUriPrefix;
-static const char *pStylesheet;
 static const char *pFontDirectory = NULL;
+static bool fFullTextSearch = false;
+static bool fBacklinks = false;
 
 
 
 /*  Function prototypes.
 */ 
 
+static bool ParseIoMode (const char*, unsigned int*, char*, int);
 static void OnSignal (int, siginfo_t*, void*);
 static void ReportError (const char*, ...)
        __attribute__ ((format (printf, 1, 2)));
 static int HandleRequest (void*, struct MHD_Connection*, const char*, const char*,
                           const char*, const char*, size_t*, void**);
 static void HandleFontRequest (struct MHD_Connection*, const char*);
+static void HandleAssetRequest (struct MHD_Connection*, const char*);
 static const char* FontTypeFromFilename (const char*);
 static void HandleManPageRequest (struct MHD_Connection*, const char*);
+static void HandleManPageSectionRequest (struct MHD_Connection*, const char*, const char*,
+                                         const char*, int);
+static void RenderManPage (PAGEBUILDER*, ARENA*, const char*, int, const char*, int);
+static void StreamManPage (struct MHD_Connection*, const char*, const char*, const char*);
+static ssize_t ReadManPageResponse (void*, uint64_t, char*, size_t);
+static void FreeManPageResponse (void*);
+static void ReportManPageError (struct MHD_Connection*, const PROCESSERRORINFO*, 
+                                const char*, const char*, const char*);
 static void HandleInfoRequest (struct MHD_Connection*, const char*); 
 static void HandleAproposRequest (struct MHD_Connection*, const char*); 
+static void HandleAproposApiRequest (struct MHD_Connection*, const char*); 
+static void HandleCompleteRequest (struct MHD_Connection*, const char*); 
+static void HandleBacklinksRequest (struct MHD_Connection*, const char*); 
+static void HandleSearchRequest (struct MHD_Connection*, const char*); 
+static void HandleInfoSearchRequest (struct MHD_Connection*, const char*); 
+static bool GetIntegerArgument (struct MHD_Connection*, const char*, int, int, int, int*);
+static void GenerateJSONError (struct MHD_Connection*, int, const char*);
 static void GenerateSplashPage (struct MHD_Connection*, const char*);
+static char* MakeAbsolutePath (const char*);
 static void HandleInternalError (struct MHD_Connection*, const PROCESSERRORINFO*);
 static void GenerateErrorPage (struct MHD_Connection*, const char*, 
                                int, const char*, ...)
@@ -146,15 +213,18 @@ int main
   struct sigaction action;
   INETADDRESS address;
   poptContext context;
-  char location [128], hostname [64];
+  char location [128], hostname [64], message [128];
 
 
   /*  Process the command-line arguments.
   */
 
-  int port = 0, nThreads = 16, MaxAge = 0, timeout = 0, nMaxConns = 16;
-  int fUseNumericAddrs = 0, fLocalOnly = 0;
-  const char *pStylesheetFile = NULL, *pAddress = NULL;
+  int port = 0, nThreads = 0, MaxAge = 0, timeout = 0, nMaxConns = 16;
+  int backlog = DEFAULT_BACKLOG, fUseNumericAddrs = 0, fLocalOnly = 0, fUseCatPages = 0;
+  unsigned int DaemonFlags;
+  const char *pStylesheetFile = NULL, *pAddress = NULL, *pStylesheet;
+  const char *pIoMode = "select,pool";
+  char *pSearchIndexFile = NULL, *pBacklinkFile = NULL;
 
   poptOption options []
          = {{"addr", 'a', POPT_ARG_STRING, &pAddress, 0,
@@ -171,7 +241,14 @@ int main
             {"maxconns", '\0', POPT_ARG_INT, &nMaxConns, 0,
              "Maximum number of concurrent connections", "n"},
           	{"threads", '\0', POPT_ARG_INT, &nThreads, 0,
-             "Number of threads in the thread pool", "n"},
+             "Number of threads in the thread pool (default: four for each"
+                " CPU available)", "n"},
+            {"io-mode", '\0', POPT_ARG_STRING, &pIoMode, 0,
+             "How connections are served: select, poll, epoll or auto;"
+                " pool or per-connection; and optionally turbo"
+                " (default: select,pool)", "mode,..."},
+            {"backlog", '\0', POPT_ARG_INT, &backlog, 0,
+             "Length of the queue of connections waiting to be accepted", "n"},
             {"max-age", '\0', POPT_ARG_INT, &MaxAge, 0,
              "Maximum time (in minutes) to keep pages in cache", "m"},
             {"syslog", '\0', POPT_ARG_NONE, &fUseSyslog, 0,
@@ -180,6 +257,19 @@ int main
              "CSS stylesheet to use", "file"},
             {"fontdir", 'f', POPT_ARG_STRING, &pFontDirectory, 0,
              "Directory for font files (must be fully-qualified)", "path"},
+            {"catpages", '\0', POPT_ARG_NONE, &fUseCatPages, 0,
+             "Use man-db's preformatted cat pages when they are up to date", NULL},
+            {"stream", '\0', POPT_ARG_NONE, &fStreamPages, 0,
+             "Send manual pages while man(1) is still formatting them", NULL},
+            {"lazy-sections", '\0', POPT_ARG_INT, &nLazySections, 0,
+             "Send only the first n sections of each manual page; the others"
+                " are fetched when they are expanded", "n"},
+            {"search-index", '\0', POPT_ARG_STRING, &pSearchIndexFile, 0,
+             "File holding the full-text search index (enables full-text"
+                " search)", "file"},
+            {"backlink-index", '\0', POPT_ARG_STRING, &pBacklinkFile, 0,
+             "File holding the index of which pages refer to which"
+                " (enables backlinks)", "file"},
             {"help", 'h', POPT_ARG_NONE, NULL, 100,
              "Show help (this message) and exit", NULL},
             {NULL, '\0', 0, NULL, 0, NULL, NULL}};
@@ -226,12 +316,24 @@ int main
   	return 1;
   }
 
-  if (nThreads <= 0)
+  if (nThreads < 0)
   {
   	fprintf (stderr, "\nInvalid number of threads.\n\n");
   	return 1;
   }
 
+  if (backlog <= 0)
+  {
+    fprintf (stderr, "\nInvalid backlog.\n\n");
+    return 1;
+  }
+
+  if (!ParseIoMode (pIoMode, &DaemonFlags, message, sizeof (message)))
+  {
+    fprintf (stderr, "\n%s\n\n", message);
+    return 1;
+  }
+
   if (timeout < 0)
   {
     fprintf (stderr, "\nInvalid timeout.\n\n");
@@ -244,6 +346,12 @@ int main
     return 1;
   }
 
+  if (nLazySections < -1)
+  {
+    fprintf (stderr, "\nInvalid number of sections.\n\n");
+    return 1;
+  }
+
   if (fLocalOnly)
   {
     IPAddress = htonl (INADDR_LOOPBACK);
@@ -331,7 +439,7 @@ int main
     return 2;
   }
 
-  listen (fdSocket, 64);
+  listen (fdSocket, backlog);
 
 
   /*  Call getsockname() to obtain the actual address and port number
@@ -391,14 +499,63 @@ int main
     pStylesheet = pText;
   }
 
+  InitializeAssets (pStylesheet);
+
 
   /*  Do miscellaneous initialization.
   */
 
-  htmlInitializeRegexes ();
   manInitializeRegexes ();
   infoInitializeRegexes ();
 
+  manEnableCatPages (fUseCatPages != 0);
+
+  StartNameIndexBuild ();
+  StartInfoIndexBuild ();
+
+
+  /*  The full-text and backlink indexes are built only if they are 
+  *   asked for, since building them renders every page on the system.
+  *   They are built together, from one pass over the pages.  Their 
+  *   files are rewritten long after the chdir() below, so relative 
+  *   paths are made absolute now.
+  */
+
+  if ((pSearchIndexFile != NULL) && (pSearchIndexFile [0] != '\0'))
+  {
+    pSearchIndexFile = MakeAbsolutePath (pSearchIndexFile);
+    fFullTextSearch = true;
+  }
+  else
+  {
+    pSearchIndexFile = NULL;
+  }
+
+  if ((pBacklinkFile != NULL) && (pBacklinkFile [0] != '\0'))
+  {
+    pBacklinkFile = MakeAbsolutePath (pBacklinkFile);
+    fBacklinks = true;
+  }
+  else
+  {
+    pBacklinkFile = NULL;
+  }
+
+  if ((pSearchIndexFile != NULL) || (pBacklinkFile != NULL))
+  {
+    StartFullTextIndexBuild (pSearchIndexFile, pBacklinkFile);
+  }
+
+
+  /*  Handling a request mostly means waiting for man(1) or info(1), 
+  *   so by default there are several threads for every CPU that this 
+  *   process may use.
+  */
+
+  if (nThreads == 0)
+  {
+    nThreads = THREADS_PER_CPU * CountAvailableCPUs ();
+  }
 
   if (nThreads > MAX_THREADS)
   {
@@ -429,11 +586,12 @@ int main
   sigaction (SIGINT, &action, NULL);
 
 
-  /*  Start the server.
+  /*  Start the server.  With a thread per connection there is no pool
+  *   (a pool size of 0 means none).
   */
 
   pDaemon = MHD_start_daemon 
-                  (MHD_USE_INTERNAL_POLLING_THREAD,
+                  (DaemonFlags,
                    port,
                    NULL,
                    NULL,
@@ -442,7 +600,7 @@ int main
                    MHD_OPTION_LISTEN_SOCKET,
                    (MHD_socket) fdSocket,
                    MHD_OPTION_THREAD_POOL_SIZE,
-                   nThreads,
+                   (DaemonFlags & MHD_USE_THREAD_PER_CONNECTION) ? 0 : nThreads,
                    MHD_OPTION_CONNECTION_TIMEOUT,
                    timeout,
                    MHD_OPTION_CONNECTION_LIMIT,
@@ -469,12 +627,26 @@ int main
   }   
 
 
-  /*  Sleep until a SIGINT signal comes along.
+  /*  Sleep until a SIGINT signal comes along, rebuilding the page name,
+  *   apropos and Info indexes now and then so that they pick up newly 
+  *   installed pages.  (The full-text and backlink indexes are only 
+  *   rebuilt once they are a day old.)
   */
 
   while (!fReadyToQuit)
   {
-    sleep (3600);
+    sleep (NAME_INDEX_REFRESH);
+
+    if (!fReadyToQuit)
+    {
+      StartNameIndexBuild ();
+      StartInfoIndexBuild ();
+
+      if ((pSearchIndexFile != NULL) || (pBacklinkFile != NULL))
+      {
+        StartFullTextIndexBuild (pSearchIndexFile, pBacklinkFile);
+      }
+    }
   }
 
 
@@ -491,6 +663,125 @@ int main
 
 
 
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              ParseIoMode
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Translates the --io-mode argument, a comma-separated list of words,
+*   into libmicrohttpd daemon flags.  The words are
+*
+*     select, poll, epoll, auto    How sockets are waited on ("auto" 
+*                                  picks the best one available).
+*     pool, per-connection         A fixed pool of threads, each serving
+*                                  many connections, or a thread for 
+*                                  every connection.
+*     turbo                        libmicrohttpd's optimistic reads and
+*                                  writes (MHD_USE_TURBO).
+*
+*   The default is "select,pool".  Returns false, with a message in
+*   pError, if a word is unknown, contradicts another one, or asks for 
+*   something this libmicrohttpd can't do.
+*/
+
+static
+bool ParseIoMode
+   (const char    *pMode,
+    unsigned int  *pFlagsOut,
+    char          *pError,
+    int            cbError)
+
+{
+  unsigned int flags = MHD_USE_INTERNAL_POLLING_THREAD, poller = 0;
+  bool fPoller = false, fThreading = false;
+  char *pCopy, *pWord, *pSave;
+
+
+  pCopy = strdup (pMode);
+
+  for (pWord = strtok_r (pCopy, ",", &pSave)
+         ; pWord != NULL
+         ; pWord = strtok_r (NULL, ",", &pSave))
+  {
+    if ((strcmp (pWord, "select") == 0) || (strcmp (pWord, "poll") == 0)
+          || (strcmp (pWord, "epoll") == 0) || (strcmp (pWord, "auto") == 0))
+    {
+      if (fPoller)
+      {
+        snprintf (pError, cbError, "More than one polling method in I/O mode \"%s\".", pMode);
+        free (pCopy);
+        return false;
+      }
+
+      fPoller = true;
+
+      if (strcmp (pWord, "poll") == 0)
+      {
+        poller = MHD_USE_POLL;
+      }
+      else if (strcmp (pWord, "epoll") == 0)
+      {
+        poller = MHD_USE_EPOLL;
+      }
+      else if (strcmp (pWord, "auto") == 0)
+      {
+        poller = MHD_USE_AUTO;
+      }
+    }
+    else if ((strcmp (pWord, "pool") == 0) || (strcmp (pWord, "per-connection") == 0))
+    {
+      if (fThreading)
+      {
+        snprintf (pError, cbError, "More than one threading model in I/O mode \"%s\".", pMode);
+        free (pCopy);
+        return false;
+      }
+
+      fThreading = true;
+
+      if (strcmp (pWord, "per-connection") == 0)
+      {
+        flags |= MHD_USE_THREAD_PER_CONNECTION;
+      }
+    }
+    else if (strcmp (pWord, "turbo") == 0)
+    {
+      flags |= MHD_USE_TURBO;
+    }
+    else
+    {
+      snprintf (pError, cbError, "Unknown I/O mode \"%s\".", pWord);
+      free (pCopy);
+      return false;
+    }
+  }
+
+  free (pCopy);
+
+
+  if ((poller == MHD_USE_POLL) && !MHD_is_feature_supported (MHD_FEATURE_POLL))
+  {
+    snprintf (pError, cbError, "This libmicrohttpd does not support poll().");
+    return false;
+  }
+
+  if ((poller == MHD_USE_EPOLL) && !MHD_is_feature_supported (MHD_FEATURE_EPOLL))
+  {
+    snprintf (pError, cbError, "This libmicrohttpd does not support epoll.");
+    return false;
+  }
+
+  if ((poller == MHD_USE_EPOLL) && (flags & MHD_USE_THREAD_PER_CONNECTION))
+  {
+    snprintf (pError, cbError, "epoll cannot be used with a thread per connection.");
+    return false;
+  }
+
+  *pFlagsOut = flags | poller;
+  return true;
+}
+
+
+
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
                                                                  OnSignal
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
@@ -599,6 +890,16 @@ int HandleRequest
   }
 
 
+  /*  Handle requests for the stylesheet and scripts.
+  */
+
+  if (memcmp (pPath, "/static/", 8) == 0)
+  {
+    HandleAssetRequest (pConn, pPath);
+    return MHD_YES;
+  }
+
+
   /*  Handle requests for the page icon.
   */
 
@@ -626,6 +927,17 @@ int HandleRequest
   }
 
 
+  /*  Handle Info index searches.  (This must come before the check for
+  *   info requests, which would take it for one.)
+  */
+
+  if (strcmp (pPath, "/info-search") == 0)
+  {
+    HandleInfoSearchRequest (pConn, pPath);
+    return MHD_YES;
+  }
+
+
   /*  Handle info requests.
   */
 
@@ -646,6 +958,46 @@ int HandleRequest
   }
 
 
+  /*  Handle requests for pages of apropos results.
+  */
+
+  if (strcmp (pPath, "/api/apropos") == 0)
+  {
+    HandleAproposApiRequest (pConn, pPath);
+    return MHD_YES;
+  }
+
+
+  /*  Handle page name completion requests.
+  */
+
+  if (strcmp (pPath, "/api/complete") == 0)
+  {
+    HandleCompleteRequest (pConn, pPath);
+    return MHD_YES;
+  }
+
+
+  /*  Handle requests for the pages that refer to a page.
+  */
+
+  if (strcmp (pPath, "/api/backlinks") == 0)
+  {
+    HandleBacklinksRequest (pConn, pPath);
+    return MHD_YES;
+  }
+
+
+  /*  Handle full-text search requests.
+  */
+
+  if (strcmp (pPath, "/search") == 0)
+  {
+    HandleSearchRequest (pConn, pPath);
+    return MHD_YES;
+  }
+
+
   /*  If we've reached this point, the URL isn't a recognized one,
   *   Display the MANHTTP splash page.
   */
@@ -666,21 +1018,42 @@ void HandleManPageRequest
     const char      *pPath)
 
 {
-  int cbPageContent;
+  int cbPageContent, iSection = 0;
   bool fSuccess;
-  size_t cbResponse = 0;
-  char *pPageContent, *pResponse = NULL;
-  FILE *stream;
+  char *pPageContent;
+  const char *pSectionPath;
+  ARENA *pArena;
+  PAGEBUILDER html;
   struct MHD_Response *pResp;
   PROCESSERRORINFO error;
-  char page [64], section [8], CanonicalID [80];
+  char title [128], page [64], section [8], CanonicalID [80];
  
 
+  /*  Requests for a single (deferred) section of a page look like
+  *   "/man/<title>/section/<n>".
+  */
+
+  if (pPath [4] != '/')
+  {
+    GenerateErrorPage (pConn, "Invalid", 400, "Invalid manual page specification.");
+    return;
+  }
+
+  strncpy (title, pPath + 5, sizeof (title));
+  title [sizeof (title) - 1] = '\0';
+
+  if ((pSectionPath = strstr (title, "/section/")) != NULL)
+  {
+    iSection = atoi (pSectionPath + 9);
+    title [pSectionPath - title] = '\0';
+  }
+
+
   /*  Parse the title into the page name and section components.
   */  
 
-  if ((pPath [4] != '/')
-         || !ParseManPageTitle (pPath + 5, page, sizeof (page), section, sizeof (section)))
+  if (((pSectionPath != NULL) && (iSection <= 0))
+         || !ParseManPageTitle (title, page, sizeof (page), section, sizeof (section)))
   {
     GenerateErrorPage (pConn, "Invalid", 400, "Invalid manual page specification.");
     return;
@@ -700,6 +1073,19 @@ void HandleManPageRequest
   }
 
 
+  if (iSection > 0)
+  {
+    HandleManPageSectionRequest (pConn, page, section, CanonicalID, iSection);
+    return;
+  }
+
+  if (fStreamPages)
+  {
+    StreamManPage (pConn, page, section, CanonicalID);
+    return;
+  }
+
+
   /*  Obtain the raw manual page text.
   */
 
@@ -713,20 +1099,7 @@ void HandleManPageRequest
 
   if (!fSuccess)
   {
-    if ((error.context == ERRORCTXT_RUNTIME)
-    	     && WIFEXITED (error.ErrorCode)
-           && (WEXITSTATUS (error.ErrorCode) == 16))
-    {
-      GenerateErrorPage 
-              (pConn, "Not found", 404,
-               "No manual page is available for &ldquo;%s&rdquo;.",
-               CanonicalID);
-    }
-    else
-    {
-      HandleInternalError (pConn, &error);
-    }
-
+    ReportManPageError (pConn, &error, page, section, CanonicalID);
   	return;
   }
 
@@ -734,19 +1107,20 @@ void HandleManPageRequest
   /*  Generate the HTML.
   */
 
-  stream = open_memstream (&pResponse, &cbResponse);
-  ManualPageToHTML (stream, CanonicalID, pUriPrefix, pStylesheet, 
-                    pPageContent, cbPageContent);
-  fclose (stream);
+  pArena = AcquireArena ();
 
+  InitPageBuilder (&html);
+  RenderManPage (&html, pArena, CanonicalID, nLazySections, 
+                 pPageContent, cbPageContent);
+
+  ReleaseArena (pArena);
   free (pPageContent);
 
 
   /*  Send the HTML to the client.
   */
 
-  pResp = MHD_create_response_from_buffer
-                (cbResponse, pResponse, MHD_RESPMEM_MUST_FREE);
+  pResp = PageCreateResponse (&html);
     
   MHD_add_response_header (pResp, "Content-Type", "text/html");
   MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
@@ -757,212 +1131,1117 @@ void HandleManPageRequest
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                        HandleInfoRequest
+                                              HandleManPageSectionRequest
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Sends the body of one section of a manual page, as an HTML fragment.
+*   The sections are normally still cached from when the page itself
+*   was sent; if not, the page is formatted again.
+*/
+
 static
-void HandleInfoRequest
+void HandleManPageSectionRequest
    (MHD_Connection  *pConn,
-    const char      *pPath)
+    const char      *pPageTitle,
+    const char      *pSection,
+    const char      *pCanonicalID,
+    int              iSection)
 
 {
-  int result, cbContent;
-  size_t cbResponse = 0;
-  char *pResponse = NULL, *pRedirectUri, *pFile;
-  char *pNodeName, *pContent, *pDecodedName;
-  FILE *stream;
+  int cbPageContent, cbData;
+  bool fFound;
+  char *pPageContent, *pData;
+  ARENA *pArena;
+  PAGEBUILDER html;
+  MANPAGERENDERER renderer;
+  MANPAGESECTIONS *pSections;
   struct MHD_Response *pResp;
   PROCESSERRORINFO error;
-  char keyword [128];
 
 
-  if ((pPath [5] != '/') && (pPath [5] != '\0'))
+  if (!GetCachedManualPageSection (pCanonicalID, iSection, &fFound, 
+                                   &pData, &cbData))
   {
-    GenerateErrorPage 
-          (pConn, "Invalid", 400, "Invalid info page specification.");
-    return;
+    if (!GetManPageContent (pPageTitle, pSection, &pPageContent,
+                            &cbPageContent, &error))
+    {
+      ReportManPageError (pConn, &error, pPageTitle, pSection, pCanonicalID);
+      return;
+    }
+
+    pArena = AcquireArena ();
+
+    InitPageBuilder (&html);
+    BeginManualPage (&renderer, pArena, &html, pCanonicalID, pUriPrefix, 
+                     AssetUri (ASSET_STYLESHEET));
+    DeferManualPageSections (&renderer, 0);
+    RenderManualPageText (&renderer, pPageContent, cbPageContent, true);
+    pSections = EndManualPage (&renderer);
+
+    FreePageBuilder (&html);
+    ReleaseArena (pArena);
+    free (pPageContent);
+
+    fFound = CopyManualPageSection (pSections, iSection, &pData, &cbData);
+    CacheManualPageSections (pCanonicalID, pSections);
   }
 
 
-  if ((pPath [5] == '\0')
-         || (NormalizeSpaces (pPath + 6, keyword, sizeof (keyword)) == 0))
+  if (!fFound)
   {
-    strcpy (keyword, "dir/(dir)");
+    GenerateErrorPage 
+            (pConn, "Not found", 404,
+             "Section %d of &ldquo;%s&rdquo; does not exist.",
+             iSection, pCanonicalID);
+    return;
   }
 
+  pResp = MHD_create_response_from_buffer 
+                      (cbData, pData, MHD_RESPMEM_MUST_FREE);
 
-  if ((pNodeName = strchr (keyword, '/')) != NULL)
-  {
-    *(pNodeName++) = '\0';
-    pDecodedName = DecodeInfoNodeName (pNodeName, -1);
+  MHD_add_response_header (pResp, "Content-Type", "text/html");
+  MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
+  MHD_queue_response (pConn, 200, pResp);
+  MHD_destroy_response (pResp);
+}
 
 
-    if (!GetInfoContent (keyword, pDecodedName, &pContent, &cbContent, &error))
-    {
-      free (pDecodedName);
-      HandleInternalError (pConn, &error);
-      return;    	
-    }
 
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            RenderManPage
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-    if (pContent == NULL)
-    {
-      GenerateErrorPage 
-               (pConn, "Node not found", 404,
-                "The Info file <span class=\"Filename\">%s</span> contains"
-                " no node with the name &ldquo;%s&rdquo;.",
-                keyword, pDecodedName);
+/*  Renders a manual page.  If nInlineSections is not negative, only
+*   that many sections are included in the page, and the rest are 
+*   cached for HandleManPageSectionRequest().
+*/
 
-      free (pDecodedName);
-      return;     
-    }
+static
+void RenderManPage
+   (PAGEBUILDER  *pPage,
+    ARENA        *pArena,
+    const char   *pCanonicalID,
+    int           nInlineSections,
+    const char   *pContent,
+    int           cbContent)
 
+{
+  MANPAGERENDERER renderer;
 
-    stream = open_memstream (&pResponse, &cbResponse);
-    InfoToHTML (stream, keyword, pDecodedName, pUriPrefix, pStylesheet,
-                pContent, cbContent);
-    fclose (stream);
 
-    pResp = MHD_create_response_from_buffer
-                (cbResponse, pResponse, MHD_RESPMEM_MUST_FREE);
-    
-    MHD_add_response_header (pResp, "Content-Type", "text/html");
-    MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
-    MHD_queue_response (pConn, 200, pResp);
-    MHD_destroy_response (pResp);
+  BeginManualPage (&renderer, pArena, pPage, pCanonicalID, pUriPrefix, 
+                   AssetUri (ASSET_STYLESHEET));
 
-    free (pContent);    
-    free (pDecodedName);
-    return;
+  if (nInlineSections >= 0)
+  {
+    DeferManualPageSections (&renderer, nInlineSections);
   }
-    
 
-  result = InfoFileFromKeyword (keyword, &pFile, &error);
-  
-  switch (result)
-  {
+  RenderManualPageText (&renderer, pContent, cbContent, true);
+  CacheManualPageSections (pCanonicalID, EndManualPage (&renderer));
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            StreamManPage
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Sends a manual page while man(1) is still producing it.  The page
+*   header and each section go out as soon as they have been rendered.
+*
+*   The response status has to be chosen before anything is sent, so
+*   we wait for man(1) to produce some output first.  If it exits 
+*   without producing any, its exit status is reported as usual.  
+*/
+
+static
+void StreamManPage
+   (MHD_Connection  *pConn,
+    const char      *pPageTitle,
+    const char      *pSection,
+    const char      *pCanonicalID)
+
+{
+  int cbRead;
+  bool fSuccess;
+  MANPAGESTREAMINFO *pInfo;
+  ARENA *pArena;
+  PAGEBUILDER html;
+  struct MHD_Response *pResp;
+  PROCESSERRORINFO error;
+
+
+  pInfo = (MANPAGESTREAMINFO*) malloc (sizeof (MANPAGESTREAMINFO));
+
+  if (!OpenManPageStream (pPageTitle, pSection, &pInfo->stream, &error))
+  {
+    free (pInfo);
+    HandleInternalError (pConn, &error);
+    return;
+  }
+
+
+  if ((cbRead = ReadManPageStream (&pInfo->stream, pInfo->buffer, 
+                                   sizeof (pInfo->buffer))) == 0)
+  {
+    fSuccess = CloseManPageStream (&pInfo->stream, false, &error);
+    free (pInfo);
+
+    if (!fSuccess)
+    {
+      ReportManPageError (pConn, &error, pPageTitle, pSection, pCanonicalID);
+      return;
+    }
+
+    pArena = AcquireArena ();
+
+    InitPageBuilder (&html);
+    ManualPageToHTML (&html, pArena, pCanonicalID, pUriPrefix, 
+                      AssetUri (ASSET_STYLESHEET), "", 0);
+
+    ReleaseArena (pArena);
+
+    pResp = PageCreateResponse (&html);
+  }
+  else
+  {
+    pInfo->fEndOfInput = false;
+    pInfo->pArena = AcquireArena ();
+    strncpy (pInfo->CanonicalID, pCanonicalID, sizeof (pInfo->CanonicalID));
+    pInfo->CanonicalID [sizeof (pInfo->CanonicalID) - 1] = '\0';
+
+    InitPageBuilder (&pInfo->page);
+    BeginManualPage (&pInfo->renderer, pInfo->pArena, &pInfo->page, 
+                     pCanonicalID, pUriPrefix, AssetUri (ASSET_STYLESHEET));
+
+    if (nLazySections >= 0)
+    {
+      DeferManualPageSections (&pInfo->renderer, nLazySections);
+    }
+
+    RenderManualPageText (&pInfo->renderer, pInfo->buffer, cbRead, false);
+
+    pResp = MHD_create_response_from_callback 
+                 (MHD_SIZE_UNKNOWN, STREAM_BLOCK_SIZE, 
+                  ReadManPageResponse, pInfo, FreeManPageResponse);
+  }
+
+  MHD_add_response_header (pResp, "Content-Type", "text/html");
+  MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
+  MHD_queue_response (pConn, 200, pResp);
+  MHD_destroy_response (pResp);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      ReadManPageResponse
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Content reader for streamed manual pages.  Hands out whatever has 
+*   been rendered, reading more from man(1) when that runs out.  An 
+*   error reported by man(1) after it has produced output can no longer
+*   be shown; the page simply ends (and its deferred sections, if any, 
+*   are not cached).
+*/
+
+static
+ssize_t ReadManPageResponse
+   (void      *pContext,
+    uint64_t   pos,
+    char      *pBuffer,
+    size_t     cbMax)
+
+{
+  int cbOutput, cbRead;
+  PROCESSERRORINFO error;
+  MANPAGESECTIONS *pSections;
+  MANPAGESTREAMINFO *pInfo = (MANPAGESTREAMINFO*) pContext;
+
+
+  for (;;)
+  {
+    if ((cbOutput = PageRead (&pInfo->page, pBuffer, (int) cbMax)) > 0)
+      return cbOutput;
+
+    if (pInfo->fEndOfInput)
+      return MHD_CONTENT_READER_END_OF_STREAM;
+
+
+    cbRead = ReadManPageStream (&pInfo->stream, pInfo->buffer, 
+                                sizeof (pInfo->buffer));
+
+    if (cbRead > 0)
+    {
+      RenderManualPageText (&pInfo->renderer, pInfo->buffer, cbRead, false);
+    }
+    else
+    {
+      pSections = EndManualPage (&pInfo->renderer);
+
+      if (CloseManPageStream (&pInfo->stream, false, &error))
+      {
+        CacheManualPageSections (pInfo->CanonicalID, pSections);
+      }
+      else
+      {
+        FreeManualPageSections (pSections);
+      }
+
+      pInfo->fEndOfInput = true;
+    }
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      FreeManPageResponse
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Called by libmicrohttpd when a streamed page's response is done 
+*   with, including when the client disconnects early.
+*/
+
+static
+void FreeManPageResponse
+   (void  *pContext)
+
+{
+  PROCESSERRORINFO error;
+  MANPAGESTREAMINFO *pInfo = (MANPAGESTREAMINFO*) pContext;
+
+
+  if (!pInfo->fEndOfInput)
+  {
+    CloseManPageStream (&pInfo->stream, true, &error);
+    FreeManualPageSections (EndManualPage (&pInfo->renderer));
+  }
+
+  FreePageBuilder (&pInfo->page);
+  ReleaseArena (pInfo->pArena);
+  free (pInfo);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       ReportManPageError
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  When man couldn't find the page, the 404 page suggests names that 
+*   are close to the one asked for, taken from the page name index (if
+*   it has been built yet).
+*/
+
+static
+void ReportManPageError
+   (MHD_Connection          *pConn,
+    const PROCESSERRORINFO  *pError,
+    const char              *pPageTitle,
+    const char              *pSection,
+    const char              *pCanonicalID)
+
+{
+  int i, cb, cbLink, nSuggestions;
+  const char *pName;
+  const NAMEINDEX *pIndex;
+  int entries [MAX_SUGGESTIONS];
+  char message [4096], name [256], section [64];
+
+
+  if ((pError->context != ERRORCTXT_RUNTIME)
+         || !WIFEXITED (pError->ErrorCode)
+         || (WEXITSTATUS (pError->ErrorCode) != 16))
+  {
+    HandleInternalError (pConn, pError);
+    return;
+  }
+
+
+  cb = snprintf (message, sizeof (message),
+                 "No manual page is available for &ldquo;%s&rdquo;.",
+                 pCanonicalID);
+
+  if ((cb < (int) sizeof (message)) && ((pIndex = AcquireNameIndex ()) != NULL))
+  {
+    nSuggestions = FindSimilarNames (pIndex, pPageTitle, pSection, 
+                                     entries, MAX_SUGGESTIONS);
+
+    if (nSuggestions > 0)
+    {
+      cb += snprintf (message + cb, sizeof (message) - cb,
+                      "<div style=\"height: 1.5em\"></div>Perhaps you meant:<br>");
+    }
+
+    for (i = 0; (i < nSuggestions) && (cb < (int) sizeof (message)); i++)
+    {
+      pName = pIndex->pText + pIndex->pEntries [entries [i]].name;
+
+      HTMLEscapeText (name, sizeof (name), pName, -1);
+      HTMLEscapeText (section, sizeof (section), 
+                      pIndex->pText + pIndex->pEntries [entries [i]].section, -1);
+
+      cbLink = snprintf (message + cb, sizeof (message) - cb,
+                         "<a href=\"%sman/%s(%s)\">%s(%s)</a><br>",
+                         (strchr (pName, ':') != NULL) ? pUriPrefix : "",
+                         name, section, name, section);
+
+      /*  Leave out a link that doesn't fit, rather than cutting it off.
+      */
+
+      if (cb + cbLink >= (int) sizeof (message))
+      {
+        message [cb] = '\0';
+        break;
+      }
+
+      cb += cbLink;
+    }
+
+    ReleaseNameIndex (pIndex);
+  }
+
+
+  GenerateErrorPage (pConn, "Not found", 404, "%s", message);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                        HandleInfoRequest
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void HandleInfoRequest
+   (MHD_Connection  *pConn,
+    const char      *pPath)
+
+{
+  int result, cbContent;
+  char *pRedirectUri, *pFile;
+  char *pNodeName, *pContent, *pDecodedName;
+  ARENA *pArena;
+  PAGEBUILDER page;
+  struct MHD_Response *pResp;
+  PROCESSERRORINFO error;
+  char keyword [128];
+
+
+  if ((pPath [5] != '/') && (pPath [5] != '\0'))
+  {
+    GenerateErrorPage 
+          (pConn, "Invalid", 400, "Invalid info page specification.");
+    return;
+  }
+
+
+  if ((pPath [5] == '\0')
+         || (NormalizeSpaces (pPath + 6, keyword, sizeof (keyword)) == 0))
+  {
+    strcpy (keyword, "dir/(dir)");
+  }
+
+
+  if ((pNodeName = strchr (keyword, '/')) != NULL)
+  {
+    *(pNodeName++) = '\0';
+    pDecodedName = DecodeInfoNodeName (pNodeName, -1);
+
+
+    if (!GetInfoContent (keyword, pDecodedName, &pContent, &cbContent, &error))
+    {
+      free (pDecodedName);
+      HandleInternalError (pConn, &error);
+      return;    	
+    }
+
+
+    if (pContent == NULL)
+    {
+      GenerateErrorPage 
+               (pConn, "Node not found", 404,
+                "The Info file <span class=\"Filename\">%s</span> contains"
+                " no node with the name &ldquo;%s&rdquo;.",
+                keyword, pDecodedName);
+
+      free (pDecodedName);
+      return;     
+    }
+
+
+    pArena = AcquireArena ();
+
+    InitPageBuilder (&page);
+    InfoToHTML (&page, pArena, keyword, pDecodedName, pUriPrefix, 
+                AssetUri (ASSET_STYLESHEET),
+                pContent, cbContent);
+
+    ReleaseArena (pArena);
+
+    pResp = PageCreateResponse (&page);
+    
+    MHD_add_response_header (pResp, "Content-Type", "text/html");
+    MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
+    MHD_queue_response (pConn, 200, pResp);
+    MHD_destroy_response (pResp);
+
+    free (pContent);    
+    free (pDecodedName);
+    return;
+  }
+    
+
+  result = InfoFileFromKeyword (keyword, &pFile, &error);
+  
+  switch (result)
+  {
     case INFO_SUCCESS:
       asprintf (&pRedirectUri, "%sinfo/%s/%s", 
                 pUriPrefix, 
                 pFile, 
                 ((strcasecmp (pFile, keyword) == 0) ? "Top" : keyword));
 
-      pResp = MHD_create_response_from_buffer
-                    (14, (void*) "Redirecting...", MHD_RESPMEM_PERSISTENT);
-      MHD_add_response_header (pResp, "Content-Type", "text/plain");
-      MHD_add_response_header (pResp, "Location", pRedirectUri);
-      MHD_queue_response (pConn, 301, pResp);
-      MHD_destroy_response (pResp);
+      pResp = MHD_create_response_from_buffer
+                    (14, (void*) "Redirecting...", MHD_RESPMEM_PERSISTENT);
+      MHD_add_response_header (pResp, "Content-Type", "text/plain");
+      MHD_add_response_header (pResp, "Location", pRedirectUri);
+      MHD_queue_response (pConn, 301, pResp);
+      MHD_destroy_response (pResp);
+
+      free (pRedirectUri);
+      break;
+
+    case INFO_REDIRECT_TO_MAN_PAGE:
+      asprintf (&pRedirectUri, "%sman/%s", 
+                pUriPrefix, 
+                keyword);
+
+      pResp = MHD_create_response_from_buffer
+                    (29, (void*) "Redirecting to manual page...", 
+                     MHD_RESPMEM_PERSISTENT);
+      MHD_add_response_header (pResp, "Content-Type", "text/plain");
+      MHD_add_response_header (pResp, "Location", pRedirectUri);
+      MHD_queue_response (pConn, 301, pResp);
+      MHD_destroy_response (pResp);
+
+      free (pRedirectUri);
+      break;
+
+    case INFO_NOT_FOUND:
+      GenerateErrorPage 
+           (pConn, "Not found", 404,
+            "No Info file found for &ldquo;%s&rdquo;.",
+            keyword);
+      break;
+
+    case INFO_ERROR:
+      HandleInternalError (pConn, &error);
+  }
+
+  free (pFile);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                     HandleAproposRequest
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void HandleAproposRequest
+   (MHD_Connection  *pConn,
+    const char      *pPath)
+
+{
+  bool fSuccess;
+  const APROPOSRESULTSET *pSet;
+  PAGEBUILDER page;
+  struct MHD_Response *pResp;
+  char keyword [80];
+  PROCESSERRORINFO error;
+
+
+  if ((pPath [8] != '/')
+         || (NormalizeSpaces (pPath + 9, keyword, sizeof (keyword)) == 0))
+  {
+    GenerateErrorPage (pConn, "Invalid", 400, "Invalid apropos request.");
+    return;
+  }
+
+
+  fSuccess = AcquireAproposResults (keyword, APROPOS_REGEX, &pSet, &error);
+
+
+  if (!fSuccess)
+  {
+    if ((error.context == ERRORCTXT_RUNTIME)
+           && WIFEXITED (error.ErrorCode)
+           && (WEXITSTATUS (error.ErrorCode) == 16))
+    {	
+      GenerateErrorPage 
+           (pConn, "Nothing found", 404,
+            "Apropos search for &ldquo;%s&rdquo; returned no results.\n"
+            "<div style=\"height: 1.5em\"></div>\n"
+            "If you keep getting this message, it is likely that the\n"
+            "system's manual page index needs to be updated.  You\n"
+            "(or the system administrator) can do this by running\n"
+            "<a href=\"man/mandb(8)\">mandb(8)</a>.\n",
+            keyword);
+    }
+    else
+    {
+      HandleInternalError (pConn, &error);
+    }
+
+    return;    	
+  }
+
+
+  InitPageBuilder (&page);
+  AproposResultsToHTML (&page, keyword, pUriPrefix, 
+                        AssetUri (ASSET_STYLESHEET), pSet);
+
+  ReleaseAproposResults (pSet);
+
+
+  pResp = PageCreateResponse (&page);
+
+  MHD_add_response_header (pResp, "Content-Type", "text/html");
+  MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
+  MHD_queue_response (pConn, 200, pResp);
+  MHD_destroy_response (pResp);
+} 
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                  HandleAproposApiRequest
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Serves a page of apropos results as JSON, for a request of the form
+*
+*     /api/apropos?q=KEYWORD&mode=MODE&sort=ORDER&offset=N&limit=N
+*
+*   where MODE is regex (the default), wildcard, exact or wildcard-exact,
+*   and ORDER is section (the default) or name.  The search itself is 
+*   done once and cached, so asking for the following pages is cheap.
+*   A search that finds nothing is not an error here; it just has no 
+*   results.
+*/
+
+static
+void HandleAproposApiRequest
+   (MHD_Connection  *pConn,
+    const char      *pPath)
+
+{
+  int i, offset, limit;
+  bool fByName, fNothingFound;
+  APROPOSMODE mode = APROPOS_REGEX;
+  const APROPOSRESULTSET *pSet;
+  APROPOSRESULTSET EmptySet = { NULL, NULL, 0, 0 };
+  const char *pArg;
+  PAGEBUILDER page;
+  struct MHD_Response *pResp;
+  char keyword [80];
+  PROCESSERRORINFO error;
+
+  static const char *ModeNames [] 
+          = { "regex", "wildcard", "exact", "wildcard-exact", NULL };
+
+  static const APROPOSMODE Modes []
+          = { APROPOS_REGEX, APROPOS_WILDCARD, APROPOS_EXACT, APROPOS_WILDCARD_EXACT };
+
+
+  pArg = MHD_lookup_connection_value (pConn, MHD_GET_ARGUMENT_KIND, "q");
+
+  if ((pArg == NULL)
+         || (NormalizeSpaces (pArg, keyword, sizeof (keyword)) == 0))
+  {
+    GenerateJSONError (pConn, 400, "Missing search keyword.");
+    return;
+  }
+
+
+  if ((pArg = MHD_lookup_connection_value (pConn, MHD_GET_ARGUMENT_KIND, "mode")) != NULL)
+  {
+    for (i = 0; (ModeNames [i] != NULL) && (strcmp (pArg, ModeNames [i]) != 0); i++)
+      ;
+
+    if (ModeNames [i] == NULL)
+    {
+      GenerateJSONError (pConn, 400, "Invalid search mode.");
+      return;
+    }
+
+    mode = Modes [i];
+  }
+
+
+  pArg = MHD_lookup_connection_value (pConn, MHD_GET_ARGUMENT_KIND, "sort");
+
+  if ((pArg != NULL) 
+         && (strcmp (pArg, "name") != 0) 
+         && (strcmp (pArg, "section") != 0))
+  {
+    GenerateJSONError (pConn, 400, "Invalid sort order.");
+    return;
+  }
+
+  fByName = (pArg != NULL) && (strcmp (pArg, "name") == 0);
+
+
+  if (!GetIntegerArgument (pConn, "offset", 0, 0, INT_MAX, &offset)
+        || !GetIntegerArgument (pConn, "limit", APROPOS_PAGE_SIZE, 
+                                1, APROPOS_MAX_PAGE_SIZE, &limit))
+  {
+    GenerateJSONError (pConn, 400, "Invalid offset or limit.");
+    return;
+  }
+
+
+  /*  apropos(1) exits with status 16 when it finds nothing, and 
+  *   GetAproposContent() reports 16 itself if none of the output could
+  *   be parsed.
+  */
+
+  if (!AcquireAproposResults (keyword, mode, &pSet, &error))
+  {
+    fNothingFound = (error.context == ERRORCTXT_RUNTIME)
+                      && ((error.ErrorCode == 16)
+                            || (WIFEXITED (error.ErrorCode) 
+                                  && (WEXITSTATUS (error.ErrorCode) == 16)));
+
+    if (!fNothingFound)
+    {
+      GenerateJSONError (pConn, 500, "The apropos search failed.");
+      return;
+    }
+
+    pSet = NULL;
+  }
+
+
+  InitPageBuilder (&page);
+  AproposResultsToJSON (&page, keyword, (pSet != NULL) ? pSet : &EmptySet,
+                        fByName, offset, limit);
+
+  ReleaseAproposResults (pSet);
+
+
+  pResp = PageCreateResponse (&page);
+
+  MHD_add_response_header (pResp, "Content-Type", "application/json");
+  MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
+  MHD_queue_response (pConn, 200, pResp);
+  MHD_destroy_response (pResp);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                    HandleCompleteRequest
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Suggests manual pages whose names begin with what has been typed so 
+*   far, for a request of the form
+*
+*     /api/complete?prefix=TEXT&limit=N
+*
+*   The answer is
+*
+*     { "prefix": "TEXT", "total": 27, "results": [ [ "page", "section" ], ... ] }
+*
+*   where total counts every match, not just the ones returned.  The 
+*   lookup is done in the in-memory name index, without running any 
+*   program, since this is called for every keystroke.
+*/
+
+static
+void HandleCompleteRequest
+   (MHD_Connection  *pConn,
+    const char      *pPath)
+
+{
+  int i, iFirst, nMatches, limit;
+  const char *pPrefix;
+  const NAMEINDEX *pIndex;
+  const NAMEINDEXENTRY *pEntry;
+  PAGEBUILDER page;
+  struct MHD_Response *pResp;
+  char prefix [256], name [256], section [64];
+
+
+  pPrefix = MHD_lookup_connection_value (pConn, MHD_GET_ARGUMENT_KIND, "prefix");
+
+  if ((pPrefix == NULL) || (pPrefix [0] == '\0') || (strlen (pPrefix) > 80))
+  {
+    GenerateJSONError (pConn, 400, "Missing or invalid prefix.");
+    return;
+  }
+
+  if (!GetIntegerArgument (pConn, "limit", COMPLETE_LIMIT, 1, MAX_COMPLETE_LIMIT, &limit))
+  {
+    GenerateJSONError (pConn, 400, "Invalid limit.");
+    return;
+  }
+
+
+  /*  The index is built in the background when the server starts.
+  */
+
+  if ((pIndex = AcquireNameIndex ()) == NULL)
+  {
+    GenerateJSONError (pConn, 503, "The page name index is not ready yet.");
+    return;
+  }
 
-      free (pRedirectUri);
-      break;
 
-    case INFO_REDIRECT_TO_MAN_PAGE:
-      asprintf (&pRedirectUri, "%sman/%s", 
-                pUriPrefix, 
-                keyword);
+  nMatches = FindNamePrefix (pIndex, pPrefix, &iFirst);
 
-      pResp = MHD_create_response_from_buffer
-                    (29, (void*) "Redirecting to manual page...", 
-                     MHD_RESPMEM_PERSISTENT);
-      MHD_add_response_header (pResp, "Content-Type", "text/plain");
-      MHD_add_response_header (pResp, "Location", pRedirectUri);
-      MHD_queue_response (pConn, 301, pResp);
-      MHD_destroy_response (pResp);
+  JSEscapeString (pPrefix, prefix, sizeof (prefix));
 
-      free (pRedirectUri);
-      break;
+  InitPageBuilder (&page);
+  PagePrintf (&page, "{\"prefix\":\"%s\",\"total\":%d,\"results\":[", prefix, nMatches);
 
-    case INFO_NOT_FOUND:
-      GenerateErrorPage 
-           (pConn, "Not found", 404,
-            "No Info file found for &ldquo;%s&rdquo;.",
-            keyword);
-      break;
+  for (i = 0; (i < nMatches) && (i < limit); i++)
+  {
+    pEntry = pIndex->pEntries + iFirst + i;
 
-    case INFO_ERROR:
-      HandleInternalError (pConn, &error);
+    JSEscapeString (pIndex->pText + pEntry->name, name, sizeof (name));
+    JSEscapeString (pIndex->pText + pEntry->section, section, sizeof (section));
+
+    PagePrintf (&page, "%s[\"%s\",\"%s\"]", (i == 0) ? "" : ",", name, section);
   }
 
-  free (pFile);
+  PageAppendStatic (&page, "]}", -1);
+
+  ReleaseNameIndex (pIndex);
+
+
+  pResp = PageCreateResponse (&page);
+
+  MHD_add_response_header (pResp, "Content-Type", "application/json");
+  MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
+  MHD_queue_response (pConn, 200, pResp);
+  MHD_destroy_response (pResp);
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                     HandleAproposRequest
+                                                   HandleBacklinksRequest
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Lists the manual pages that refer to a page, for a request of the 
+*   form
+*
+*     /api/backlinks?page=NAME(SECTION)
+*
+*   The answer is
+*
+*     { "page": "NAME(SECTION)", "total": 3, "results": [ [ "page", "section" ], ... ] }
+*
+*   with the pages in name order.  A page that nothing refers to, or 
+*   that isn't in the index, has no results.  The backlink index is 
+*   built in the background; until it is ready, the request fails with 
+*   a 503.
+*/
+
 static
-void HandleAproposRequest
+void HandleBacklinksRequest
    (MHD_Connection  *pConn,
     const char      *pPath)
 
 {
-  int nResults = 0;
-  bool fSuccess;
-  size_t cbResponse = 0;
-  char *pResponse = NULL;
-  APROPOSRESULT *pResultList = NULL;
-  FILE *stream;
+  int i, nLinks;
+  const char *pTitle;
+  const uint32_t *pSources;
+  const BACKLINKINDEX *pIndex;
+  const BACKLINKPAGE *pPage;
+  PAGEBUILDER page;
   struct MHD_Response *pResp;
-  char keyword [80];
-  PROCESSERRORINFO error;
+  char title [256], name [256], section [64], PageName [64], PageSection [8];
 
 
-  if ((pPath [8] != '/')
-         || (NormalizeSpaces (pPath + 9, keyword, sizeof (keyword)) == 0))
+  pTitle = MHD_lookup_connection_value (pConn, MHD_GET_ARGUMENT_KIND, "page");
+
+  if ((pTitle == NULL) 
+        || (strlen (pTitle) > 80)
+        || !ParseManPageTitle (pTitle, PageName, sizeof (PageName), 
+                               PageSection, sizeof (PageSection)))
   {
-    GenerateErrorPage (pConn, "Invalid", 400, "Invalid apropos request.");
+    GenerateJSONError (pConn, 400, "Missing or invalid page.");
+    return;
+  }
+
+  if (!fBacklinks)
+  {
+    GenerateJSONError (pConn, 404, "Backlinks are not enabled on this server.");
+    return;
+  }
+
+  if ((pIndex = AcquireBacklinkIndex ()) == NULL)
+  {
+    GenerateJSONError (pConn, 503, "The backlink index is not ready yet.");
     return;
   }
 
 
-  fSuccess = GetAproposContent (keyword, APROPOS_REGEX, 
-                                &pResultList, &nResults, &error);
+  nLinks = FindBacklinks (pIndex, PageName, PageSection, &pSources);
 
+  JSEscapeString (pTitle, title, sizeof (title));
 
-  if (!fSuccess)
+  InitPageBuilder (&page);
+  PagePrintf (&page, "{\"page\":\"%s\",\"total\":%d,\"results\":[", 
+              title, (nLinks > 0) ? nLinks : 0);
+
+  for (i = 0; i < nLinks; i++)
   {
-    if ((error.context == ERRORCTXT_RUNTIME)
-           && WIFEXITED (error.ErrorCode)
-           && (WEXITSTATUS (error.ErrorCode) == 16))
-    {	
-      GenerateErrorPage 
-           (pConn, "Nothing found", 404,
-            "Apropos search for &ldquo;%s&rdquo; returned no results.\n"
-            "<div style=\"height: 1.5em\"></div>\n"
-            "If you keep getting this message, it is likely that the\n"
-            "system's manual page index needs to be updated.  You\n"
-            "(or the system administrator) can do this by running\n"
-            "<a href=\"man/mandb(8)\">mandb(8)</a>.\n",
-            keyword);
-    }
-    else
-    {
-      HandleInternalError (pConn, &error);
-    }
+    pPage = pIndex->pPages + pSources [i];
 
-    return;    	
+    JSEscapeString (pIndex->pBase + pPage->name, name, sizeof (name));
+    JSEscapeString (pIndex->pBase + pPage->section, section, sizeof (section));
+
+    PagePrintf (&page, "%s[\"%s\",\"%s\"]", (i == 0) ? "" : ",", name, section);
+  }
+
+  PageAppendStatic (&page, "]}", -1);
+
+  ReleaseBacklinkIndex (pIndex);
+
+
+  pResp = PageCreateResponse (&page);
+
+  MHD_add_response_header (pResp, "Content-Type", "application/json");
+  MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
+  MHD_queue_response (pConn, 200, pResp);
+  MHD_destroy_response (pResp);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      HandleSearchRequest
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Searches the text of the manual pages, for a request of the form
+*
+*     /search?q=WORDS&offset=N
+*
+*   The pages are ranked using the full-text index, which is built in 
+*   the background; until it is ready, the request fails with a 503.
+*/
+
+static
+void HandleSearchRequest
+   (MHD_Connection  *pConn,
+    const char      *pPath)
+
+{
+  int nHits, offset;
+  const char *pQuery;
+  const FULLTEXTINDEX *pIndex;
+  FULLTEXTHIT *pHits;
+  ARENA *pArena;
+  PAGEBUILDER page;
+  struct MHD_Response *pResp;
+  char query [256];
+
+
+  pQuery = MHD_lookup_connection_value (pConn, MHD_GET_ARGUMENT_KIND, "q");
+
+  if ((pQuery == NULL) 
+        || (strlen (pQuery) >= sizeof (query))
+        || (NormalizeSpaces (pQuery, query, sizeof (query)) == 0)
+        || !GetIntegerArgument (pConn, "offset", 0, 0, INT_MAX, &offset))
+  {
+    GenerateErrorPage (pConn, "Invalid", 400, "Invalid search request.");
+    return;
   }
 
 
-  stream = open_memstream (&pResponse, &cbResponse);
-  AproposResultsToHTML (stream, keyword, pUriPrefix, pStylesheet, 
-                        pResultList, nResults);
-  fclose (stream);
+  if (!fFullTextSearch)
+  {
+    GenerateErrorPage 
+         (pConn, "Not enabled", 404,
+          "Full-text search is not enabled on this server.  It can be turned\n"
+          "on with --search-index.\n");
+    return;
+  }
+
+  if ((pIndex = AcquireFullTextIndex ()) == NULL)
+  {
+    GenerateErrorPage 
+         (pConn, "Not ready", 503,
+          "The full-text search index is still being built.  Please try\n"
+          "again in a few minutes.\n");
+    return;
+  }
+
+
+  pArena = AcquireArena ();
+
+  nHits = SearchFullTextIndex (pIndex, pArena, query, &pHits);
 
-  free (pResultList);
+  InitPageBuilder (&page);
+  SearchResultsToHTML (&page, pArena, query, pUriPrefix, 
+                       AssetUri (ASSET_STYLESHEET), pIndex, pHits, nHits, offset);
 
+  ReleaseArena (pArena);
+  ReleaseFullTextIndex (pIndex);
 
-  pResp = MHD_create_response_from_buffer
-              (cbResponse, pResponse, MHD_RESPMEM_MUST_FREE);
+
+  pResp = PageCreateResponse (&page);
 
   MHD_add_response_header (pResp, "Content-Type", "text/html");
   MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
   MHD_queue_response (pConn, 200, pResp);
   MHD_destroy_response (pResp);
-} 
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                  HandleInfoSearchRequest
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Handles /info-search?q=TEXT&offset=N, which looks up the entries of 
+*   the indices of all of the Info manuals at once, without running 
+*   info(1).
+*/
+
+static
+void HandleInfoSearchRequest
+   (MHD_Connection  *pConn,
+    const char      *pPath)
+
+{
+  int nEntries, offset;
+  int *pEntries;
+  const char *pQuery;
+  const INFOINDEX *pIndex;
+  PAGEBUILDER page;
+  struct MHD_Response *pResp;
+  char query [256];
+
+
+  pQuery = MHD_lookup_connection_value (pConn, MHD_GET_ARGUMENT_KIND, "q");
+
+  if ((pQuery == NULL) 
+        || (strlen (pQuery) >= sizeof (query))
+        || (NormalizeSpaces (pQuery, query, sizeof (query)) == 0)
+        || !GetIntegerArgument (pConn, "offset", 0, 0, INT_MAX, &offset))
+  {
+    GenerateErrorPage (pConn, "Invalid", 400, "Invalid search request.");
+    return;
+  }
+
+
+  if ((pIndex = AcquireInfoIndex ()) == NULL)
+  {
+    GenerateErrorPage 
+         (pConn, "Not ready", 503,
+          "The Info index is still being built.  Please try again in a\n"
+          "moment.\n");
+    return;
+  }
+
+
+  nEntries = SearchInfoIndex (pIndex, query, &pEntries);
+
+  InitPageBuilder (&page);
+  InfoSearchResultsToHTML (&page, query, pUriPrefix, AssetUri (ASSET_STYLESHEET), 
+                           pIndex, pEntries, nEntries, offset);
+
+  free (pEntries);
+  ReleaseInfoIndex (pIndex);
+
+
+  pResp = PageCreateResponse (&page);
+
+  MHD_add_response_header (pResp, "Content-Type", "text/html");
+  MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
+  MHD_queue_response (pConn, 200, pResp);
+  MHD_destroy_response (pResp);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       GetIntegerArgument
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Reads a non-negative integer from the request's query string, 
+*   using the default if the argument is missing.  Returns false if it 
+*   isn't a number or is out of range.
+*/
+
+static
+bool GetIntegerArgument
+   (MHD_Connection  *pConn,
+    const char      *pName,
+    int              DefaultValue,
+    int              MinValue,
+    int              MaxValue,
+    int             *pValueOut)
+
+{
+  const char *pArg;
+  char *pEnd;
+  long value;
+
+
+  *pValueOut = DefaultValue;
+
+  if ((pArg = MHD_lookup_connection_value (pConn, MHD_GET_ARGUMENT_KIND, pName)) == NULL)
+    return true;
+
+  if ((*pArg < '0') || (*pArg > '9'))
+    return false;
+
+  errno = 0;
+  value = strtol (pArg, &pEnd, 10);
+
+  if ((*pEnd != '\0') || (errno != 0) 
+         || (value < MinValue) || (value > MaxValue))
+    return false;
+
+  *pValueOut = (int) value;
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                        GenerateJSONError
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void GenerateJSONError
+   (MHD_Connection  *pConn,
+    int              HttpStatus,
+    const char      *pMessage)
+
+{
+  PAGEBUILDER page;
+  struct MHD_Response *pResp;
+  char buffer [256];
+
+
+  JSEscapeString (pMessage, buffer, sizeof (buffer));
+
+  InitPageBuilder (&page);
+  PagePrintf (&page, "{\"error\":\"%s\"}", buffer);
+
+  pResp = PageCreateResponse (&page);
+
+  MHD_add_response_header (pResp, "Content-Type", "application/json");
+  MHD_queue_response (pConn, HttpStatus, pResp);
+  MHD_destroy_response (pResp);
+}
 
 
 
@@ -977,39 +2256,36 @@ void GenerateSplashPage
 
 {
   int status;
-  size_t cbResponse = 0;
-  char *pResponse = NULL;
+  PAGEBUILDER page;
   struct MHD_Response *pResp;
-  FILE *stream;
 
 
-  stream = open_memstream (&pResponse, &cbResponse);
+  InitPageBuilder (&page);
+
+  PagePrintf (&page, 
+              "<!DOCTYPE html>\n\n"
+              "<html>\n"
+              "<head>\n"
+              "<title>MANHTTP</title>\n"
+              "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
+              "<base href=\"%s\">\n"           
+              "<link rel=\"stylesheet\" href=\"%s\">\n"
+              "</head>\n"
+              "<body Type=\"splash\">\n",
+              pUriPrefix,
+              AssetUri (ASSET_STYLESHEET));
 
-  fprintf (stream, 
-           "<!DOCTYPE html>\n\n"
-           "<html>\n"
-           "<head>\n"
-           "<title>MANHTTP</title>\n"
-           "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
-           "<base href=\"%s\">\n"           
-           "<style>\n%s\n</style>\n"
-           "</head>\n"
-           "<body Type=\"splash\">\n"
-           "%s"
-           "</body>\n"
-           "</html>\n",
-           pUriPrefix,
-           pStylesheet,
-           SplashText);
+  PageAppendStatic (&page, SplashText, -1);
 
-  fclose (stream);
+  PageAppendStatic (&page, 
+                    "</body>\n"
+                    "</html>\n", -1);
 
 
   status = ((pPath [0] == '\0') || (strcmp (pPath, "/") == 0))
                ? 200 : 404;
 
-  pResp = MHD_create_response_from_buffer
-              (cbResponse, pResponse, MHD_RESPMEM_MUST_FREE);
+  pResp = PageCreateResponse (&page);
 
   MHD_add_response_header (pResp, "Content-Type", "text/html");
   MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
@@ -1019,6 +2295,37 @@ void GenerateSplashPage
 
 
 
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         MakeAbsolutePath
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns pPath relative to the current directory, allocated with 
+*   malloc().  Paths that are used after the server changes to the 
+*   root directory must be made absolute first.
+*/
+
+static
+char* MakeAbsolutePath
+   (const char  *pPath)
+
+{
+  char *pDirectory, *pAbsolute;
+
+
+  if ((pPath [0] == '/') || ((pDirectory = getcwd (NULL, 0)) == NULL))
+    return strdup (pPath);
+
+  if (asprintf (&pAbsolute, "%s/%s", pDirectory, pPath) < 0)
+  {
+    pAbsolute = strdup (pPath);
+  }
+
+  free (pDirectory);
+  return pAbsolute;
+}
+
+
+
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
                                                         GenerateErrorPage
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
@@ -1032,38 +2339,36 @@ void GenerateErrorPage
     ...)
 
 {
-  size_t cbResponse = 0;
-  char *pResponse = NULL;
-  FILE *stream;
+  PAGEBUILDER page;
   struct MHD_Response *pResp;
   char *pMessage;
   va_list args;
 
 
-  stream = open_memstream (&pResponse, &cbResponse);
+  InitPageBuilder (&page);
 
-  fprintf (stream, 
-           "<!DOCTYPE html>\n\n"
-           "<html>\n"
-           "<head>\n"
-           "<title>%s</title>\n"
-           "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
-           "<base href=\"%s\">\n"                      
-           "<style>\n%s\n</style>\n"
-           "</head>\n"
-           "<body Type=\"splash\">\n",
-           pErrorType,
-           pUriPrefix,
-           pStylesheet);
+  PagePrintf (&page, 
+              "<!DOCTYPE html>\n\n"
+              "<html>\n"
+              "<head>\n"
+              "<title>%s</title>\n"
+              "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
+              "<base href=\"%s\">\n"                      
+              "<link rel=\"stylesheet\" href=\"%s\">\n"
+              "</head>\n"
+              "<body Type=\"splash\">\n",
+              pErrorType,
+              pUriPrefix,
+              AssetUri (ASSET_STYLESHEET));
 
 
-  fprintf (stream, "<div class=\"Splash\" IsError=\"\">\n");
+  PageAppendStatic (&page, "<div class=\"Splash\" IsError=\"\">\n", -1);
 
-  fprintf (stream, "<p Heading=\"\">%s</p>\n", pErrorType);
+  PagePrintf (&page, "<p Heading=\"\">%s</p>\n", pErrorType);
 
   if (strchr (pFormatStr, '%') == NULL)
   {
-    fprintf (stream, "%s\n", pFormatStr);
+    PagePrintf (&page, "%s\n", pFormatStr);
   }
   else
   {
@@ -1071,22 +2376,18 @@ void GenerateErrorPage
     vasprintf (&pMessage, pFormatStr, args);
     va_end (args);
   
-    fprintf (stream, "%s\n", pMessage);
+    PagePrintf (&page, "%s\n", pMessage);
     free (pMessage);
   }
 
 
-  fprintf (stream, 
-           "<p style=\"font-size: 75%%; margin-top: 40px; margin-bottom: 3px;\">\n"
-           "<a href=\"/\">MANHTTP home</a>\n"
-           "</p>\n"
-           "</div>\n</body>\n</html>\n");
+  PageAppendStatic (&page, 
+                    "<p style=\"font-size: 75%; margin-top: 40px; margin-bottom: 3px;\">\n"
+                    "<a href=\"/\">MANHTTP home</a>\n"
+                    "</p>\n"
+                    "</div>\n</body>\n</html>\n", -1);
 
-  fclose (stream);
-
-
-  pResp = MHD_create_response_from_buffer
-              (cbResponse, pResponse, MHD_RESPMEM_MUST_FREE);
+  pResp = PageCreateResponse (&page);
 
   MHD_add_response_header (pResp, "Content-Type", "text/html");
   MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
@@ -1107,10 +2408,9 @@ void HandleInternalError
 
 {
   int cbMax;
-  size_t cbResponse = 0;
-  char *pResponse = NULL, *pErrorHTML = NULL;
+  char *pErrorHTML = NULL;
   const char *pCommandPath, *pCommand, *pMessage;
-  FILE *stream;
+  PAGEBUILDER page;
   struct MHD_Response *pResp;
   char buffer [256] = "";
 
@@ -1120,27 +2420,27 @@ void HandleInternalError
   pCommand = (pCommand == NULL) ? pCommandPath : (pCommand + 1);
 
 
-  stream = open_memstream (&pResponse, &cbResponse);
-
-  fprintf (stream, 
-           "<!DOCTYPE html>\n\n"
-           "<html>\n"
-           "<head>\n"
-           "<title>MANHTTP Internal Error</title>\n"
-           "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
-           "<base href=\"%s\">\n"                      
-           "<style>\n%s\n</style>\n"
-           "</head>\n"
-           "<body Type=\"splash\">\n"
-           "<div class=\"Splash\" IsError=\"\">\n"
-           "<p Heading=\"\">Internal error</p>\n"
-           "MANHTTP encountered an unrecoverable error when running\n"
-           "<span class=\"Filename\">%s</span>.  Detailed error information\n"
-           "follows.\n\n\n"
-           "<pre ErrorInfo=\"\" style=\"margin-top: 1.5em;\">\n",
-           pUriPrefix,
-           pStylesheet,
-           pCommand);
+  InitPageBuilder (&page);
+
+  PagePrintf (&page, 
+              "<!DOCTYPE html>\n\n"
+              "<html>\n"
+              "<head>\n"
+              "<title>MANHTTP Internal Error</title>\n"
+              "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
+              "<base href=\"%s\">\n"                      
+              "<link rel=\"stylesheet\" href=\"%s\">\n"
+              "</head>\n"
+              "<body Type=\"splash\">\n"
+              "<div class=\"Splash\" IsError=\"\">\n"
+              "<p Heading=\"\">Internal error</p>\n"
+              "MANHTTP encountered an unrecoverable error when running\n"
+              "<span class=\"Filename\">%s</span>.  Detailed error information\n"
+              "follows.\n\n\n"
+              "<pre ErrorInfo=\"\" style=\"margin-top: 1.5em;\">\n",
+              pUriPrefix,
+              AssetUri (ASSET_STYLESHEET),
+              pCommand);
 
 
   if ((pError->context == ERRORCTXT_FORK_FAILED)
@@ -1158,56 +2458,52 @@ void HandleInternalError
 
     cbMax = strlen (pMessage) * 5 + 1;
     pErrorHTML = (char*) malloc (cbMax);
-    HTMLizeText (pErrorHTML, cbMax, pMessage, -1, NULL, NULL, 0);
+    HTMLEscapeText (pErrorHTML, cbMax, pMessage, -1);
 
 
     if (pError->context == ERRORCTXT_EXEC_FAILED)
     {
-      fprintf (stream,
-               "Unable to execute <span class=\"Filename\">%s</span>:\n"
-               "%s\n",
-               pCommandPath,
-               pErrorHTML);
+      PagePrintf (&page,
+                  "Unable to execute <span class=\"Filename\">%s</span>:\n"
+                  "%s\n",
+                  pCommandPath,
+                  pErrorHTML);
     }
     else
     {
-      fprintf (stream,
-               "Unable to create a new process:\n%s\n",
-               pErrorHTML);
+      PagePrintf (&page,
+                  "Unable to create a new process:\n%s\n",
+                  pErrorHTML);
     }
 
     free (pErrorHTML);
   }
   else if (WIFEXITED (pError->ErrorCode))
   {
-    fprintf (stream,
-             "<span class=\"Filename\">%s</span> reported an internal error.  (Exit status: %d)\n",
-             pCommandPath,               
-             WEXITSTATUS (pError->ErrorCode));
+    PagePrintf (&page,
+                "<span class=\"Filename\">%s</span> reported an internal error.  (Exit status: %d)\n",
+                pCommandPath,               
+                WEXITSTATUS (pError->ErrorCode));
   }
   else  
   {
-    fprintf (stream,
-             "<span class=\"Filename\">%s</span> crashed, or otherwise terminated due to an\n"
-             "unexpected signal.  (Signal ID: %d)\n",
-             pCommandPath,
-             WTERMSIG (pError->ErrorCode));
+    PagePrintf (&page,
+                "<span class=\"Filename\">%s</span> crashed, or otherwise terminated due to an\n"
+                "unexpected signal.  (Signal ID: %d)\n",
+                pCommandPath,
+                WTERMSIG (pError->ErrorCode));
   }
   
 
 
-  fprintf (stream, 
-           "</pre>\n\n\n"
-           "<p style=\"font-size: 75%%; margin-top: 40px; margin-bottom: 3px;\">\n"
-           "<a href=\"/\">MANHTTP home</a>\n"
-           "</p>\n"
-           "</div>\n</body>\n</html>\n");
-
-  fclose (stream);
-
+  PageAppendStatic (&page, 
+                    "</pre>\n\n\n"
+                    "<p style=\"font-size: 75%; margin-top: 40px; margin-bottom: 3px;\">\n"
+                    "<a href=\"/\">MANHTTP home</a>\n"
+                    "</p>\n"
+                    "</div>\n</body>\n</html>\n", -1);
 
-  pResp = MHD_create_response_from_buffer
-              (cbResponse, pResponse, MHD_RESPMEM_MUST_FREE);
+  pResp = PageCreateResponse (&page);
 
   MHD_add_response_header (pResp, "Content-Type", "text/html");
   MHD_add_response_header (pResp, "Cache-Control", CachePolicy);
@@ -1279,6 +2575,47 @@ void HandleFontRequest
 
 
 
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       HandleAssetRequest
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Serves the stylesheet and scripts.  Asset URIs change whenever the
+*   content does, so the responses can be cached indefinitely.
+*/
+
+static
+void HandleAssetRequest
+   (MHD_Connection  *pConn,
+    const char      *pPath)
+
+{
+  const ASSET *pAsset;
+  struct MHD_Response *pResp;
+
+
+  if ((pAsset = FindAsset (pPath)) == NULL)
+  {
+    pResp = MHD_create_response_from_buffer
+                    (15, (void*) "File not found.", MHD_RESPMEM_PERSISTENT);
+
+    MHD_add_response_header (pResp, "Content-Type", "text/plain");
+    MHD_queue_response (pConn, 404, pResp);
+    MHD_destroy_response (pResp);
+    return;
+  }
+
+  pResp = MHD_create_response_from_buffer 
+                  (pAsset->cbData, (void*) pAsset->pData, 
+                   MHD_RESPMEM_PERSISTENT);
+
+  MHD_add_response_header (pResp, "Content-Type", pAsset->pContentType);
+  MHD_add_response_header (pResp, "Cache-Control", ASSET_CACHE_POLICY);
+  MHD_queue_response (pConn, 200, pResp);
+  MHD_destroy_response (pResp);
+}
+
+
+
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
                                                      FontTypeFromFilename
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
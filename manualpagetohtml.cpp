@@ -29,23 +29,52 @@
 #include <stdio.h>
 #include <string.h>
 
+#if defined (__x86_64__) || defined (__i386__)
+#include <immintrin.h>                 /*  Compiler intrinsics.  */
+#endif
+
 #include <tre/tre.h>                   /*  Library headers.  */
 
 #include "utility.h"                   /*  Application headers.  */
+#include "arena.h"
 #include "html_formatting.h"
+#include "page_builder.h"
 #include "manualpagetohtml.h"
-#include "common_js.h"
+#include "assets.h"
+
+
+
+#define ESCAPE_STYLE_PREFIX       8192
+
+
+/*  Unless the end of the text has been reached, the decoders stop this
+*   far from the end of the text they have been given, so that they
+*   never have to look past it.
+*/
 
+#define DECODE_LOOKAHEAD          8
 
 
-/*  Dynamically-generated headers.
+/*  Once this much decoded text precedes the current text block, it is
+*   discarded.
 */
 
-#include "dynamic/man_page_script.h"
+#define DISCARD_THRESHOLD         (64 * 1024)
 
 
+/*  Lines are indexed this many at a time.
+*/
+
+#define LINE_BATCH_SIZE           128
 
-#define HTML_EXPANSION_FACTOR     10
+
+
+enum
+{
+  ESCAPE_STYLE_UNKNOWN = 0,
+  ESCAPE_STYLE_ANSI,
+  ESCAPE_STYLE_OVERSTRIKE
+};
 
 
  
@@ -77,11 +106,19 @@ struct SECTIONENTRY
 /*  Function prototypes.
 */
 
-static LINECLASSIFICATION ClassifyLine (const char*, const TEXTATTRIBUTES*, int, LINECLASSIFICATION);
-static void GetTextAttributes (const char*, int, char*, TEXTATTRIBUTES*, int, int*);
-static void AnsiGetTextAttributes (const char*, int, char*, TEXTATTRIBUTES*, int, int*);
-static void OldStyleGetTextAttributes (const char*, int, char*, TEXTATTRIBUTES*, int, int*);
-static void HandleSplitLinks (const char*, int, TEXTATTRIBUTES*);
+static LINECLASSIFICATION ClassifyLine (const char*, const ATTRSPANLIST*, int, int, LINECLASSIFICATION);
+static void RenderLines (MANPAGERENDERER*, bool);
+static void BeginSection (MANPAGERENDERER*, const char*);
+static MANPAGESECTIONS* CollectDeferredSections (MANPAGERENDERER*);
+static void AppendInput (MANPAGERENDERER*, const char*, int);
+static void ReserveText (MANPAGERENDERER*, int);
+static bool DecideEscapeStyle (MANPAGERENDERER*, const char*, int, bool);
+static int AnsiGetTextAttributes (const char*, int, bool, char*, ATTRSPANLIST*, int, int*, TEXTATTRIBUTES*);
+static int OldStyleGetTextAttributes (const char*, int, bool, char*, ATTRSPANLIST*, int, int*, TEXTATTRIBUTES*);
+static int CountAnsiEscapes (const char*, int, int);
+static int FindEitherByte (const char*, int, char, char);
+static void HandleSplitLinks (const char*, int, ATTRSPANLIST*);
+static void RenderTextBlock (const char*, ATTRSPANLIST*, int, int, const HTMLFORMATINFO*, PAGEBUILDER*);
 
 
 
@@ -90,94 +127,488 @@ static void HandleSplitLinks (const char*, int, TEXTATTRIBUTES*);
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
 void ManualPageToHTML
-    (FILE          *stream,
+    (PAGEBUILDER   *pPage,
+     ARENA         *pArena,
      const char    *pPageTitle,
      const char    *pUriPrefix,
-     const char    *pStylesheet,
+     const char    *pStylesheetUri,
      const char    *pContent,
      int            cbContent)
 
 {
-  int i, j, length, iLine, iNextLine, cbText, iSectionStart, iSectionEnd;
-  int nSections, indent, MinIndent;
-  char c, *pText;
-  bool fLastLine;
-  LINECLASSIFICATION LineClass;
-  TEXTATTRIBUTES *pAttributes;
-  SECTIONENTRY *pFirstSection, *pLastSection, *pSection, *pNextSection;
+  MANPAGERENDERER renderer;
+
+
+  BeginManualPage (&renderer, pArena, pPage, pPageTitle, pUriPrefix, 
+                   pStylesheetUri);
+  RenderManualPageText (&renderer, pContent, cbContent, true);
+  FreeManualPageSections (EndManualPage (&renderer));
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          BeginManualPage
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Starts rendering a manual page whose text will be supplied, in any
+*   number of pieces, through RenderManualPageText().  The page header
+*   is written immediately.  The renderer's working memory comes from
+*   pArena, which must outlive it.
+*/
+
+void BeginManualPage
+    (MANPAGERENDERER  *pRenderer,
+     ARENA            *pArena,
+     PAGEBUILDER      *pPage,
+     const char       *pPageTitle,
+     const char       *pUriPrefix,
+     const char       *pStylesheetUri)
+
+{
   char buffer [128];
 
 
+  memset (pRenderer, 0, sizeof (MANPAGERENDERER));
+  pRenderer->pArena         = pArena;
+  pRenderer->pPage          = pPage;
+  pRenderer->pOutput        = pPage;
+  pRenderer->pUriPrefix     = pUriPrefix;
+  pRenderer->EscapeStyle    = ESCAPE_STYLE_UNKNOWN;
+  pRenderer->iSectionStart  = -1;
+  pRenderer->iSectionEnd    = -1;
+  pRenderer->LineClass      = LINE_CLASS_NONE;
+
+  InitAttrSpans (&pRenderer->spans, pArena);
+  InitAttrSpans (&pRenderer->BlockSpans, pArena);
+
+
+  HTMLEscapeText (buffer, sizeof (buffer), pPageTitle, -1);
+
+  PagePrintf (pPage, 
+              "<!DOCTYPE html>\n\n"
+              "<html>\n"
+              "<head>\n"
+              "<title>Man page: %s</title>\n"
+              "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
+              "<base href=\"%s\">\n"
+              "<link rel=\"stylesheet\" href=\"%s\">\n"
+              "</head>\n"
+              "<body Type=\"man\">\n"
+              "<div id=\"Main\">\n"
+              "<div class=\"PageTitle\">%s</div>\n\n\n"
+              "<div id=\"Prologue\">\n",
+              buffer, 
+              pUriPrefix,
+              pStylesheetUri,
+              buffer);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                  DeferManualPageSections
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Leaves the bodies of all but the first nInlineSections sections out
+*   of the page; EndManualPage() returns them instead.  Must be called
+*   before any text is supplied.
+*/
+
+void DeferManualPageSections
+    (MANPAGERENDERER  *pRenderer,
+     int               nInlineSections)
+
+{
+  pRenderer->fDeferring = true;
+  pRenderer->nInlineSections = nInlineSections;
+  InitPageBuilder (&pRenderer->deferred);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                     RenderManualPageText
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Supplies the next piece of the raw (formatted) page text.  Each 
+*   section is rendered as soon as its last line has arrived; fFinal
+*   marks the end of the text.  The output does not depend on how the 
+*   text is divided into pieces.
+*/
+
+void RenderManualPageText
+    (MANPAGERENDERER  *pRenderer,
+     const char       *pContent,
+     int               cbContent,
+     bool              fFinal)
+
+{
+  int cbInput, cbConsumed = 0, cbDecoded;
+  bool fBuffered;
+  const char *pInput;
+
+
+  if (pRenderer->fComplete)
+    return;
+
+
+  /*  Text left over from the previous call comes first.
+  */
+
+  fBuffered = (pRenderer->cbInput > 0);
+
+  if (fBuffered)
+  {
+    AppendInput (pRenderer, pContent, cbContent);
+    pInput = pRenderer->pInput;
+    cbInput = pRenderer->cbInput;
+  }
+  else
+  {
+    pInput = pContent;
+    cbInput = cbContent;
+  }
+
+
+  /*  Decode the escape sequences (or overstrikes) once we know which kind
+  *   of formatting the text uses.
+  */
+
+  if (DecideEscapeStyle (pRenderer, pInput, cbInput, fFinal))
+  {
+    ReserveText (pRenderer, cbInput);
+
+    cbConsumed = ((pRenderer->EscapeStyle == ESCAPE_STYLE_ANSI) 
+                      ? AnsiGetTextAttributes 
+                      : OldStyleGetTextAttributes)
+                   (pInput, cbInput, fFinal,
+                    pRenderer->pText + pRenderer->cbText, 
+                    &pRenderer->spans, 
+                    pRenderer->cbTextAllocated - pRenderer->cbText, 
+                    &cbDecoded, &pRenderer->AnsiAttrs);
+
+    pRenderer->cbText += cbDecoded;
+  }
+
+
+  /*  Keep whatever couldn't be decoded yet for the next call.
+  */
+
+  if (fBuffered)
+  {
+    pRenderer->cbInput -= cbConsumed;
+    memmove (pRenderer->pInput, pRenderer->pInput + cbConsumed, 
+             pRenderer->cbInput + 1);
+  }
+  else if (cbConsumed < cbInput)
+  {
+    AppendInput (pRenderer, pInput + cbConsumed, cbInput - cbConsumed);
+  }
+
+
+  RenderLines (pRenderer, fFinal);
+
+  pRenderer->fComplete = fFinal;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            EndManualPage
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Finishes the page (rendering any text not yet rendered).  If 
+*   sections were deferred, returns their bodies, to be freed with 
+*   FreeManualPageSections(); otherwise returns NULL.
+*/
+
+MANPAGESECTIONS* EndManualPage
+    (MANPAGERENDERER  *pRenderer)
+
+{
+  int i;
+  SECTIONENTRY *pSection;
+  MANPAGESECTIONS *pSections = NULL;
+  PAGEBUILDER *pPage = pRenderer->pPage;
+
+
+  RenderManualPageText (pRenderer, "", 0, true);
+
+
+  if (pRenderer->fDeferring)
+  {
+    pSections = CollectDeferredSections (pRenderer);
+  }
+
+
+  /*  man_page.js fills in the list of pages that refer to this one.
+  */
+
+  PageAppendStatic (pPage,
+                    "</div>\n\n"
+                    "<div id=\"Backlinks\" hidden></div>\n"
+                    "</div>\n", -1);
+
+
+  PageAppendStatic (pPage, 
+                    "\n\n<div id=\"NavBar\">\n"
+                    "<div id=\"Nav-Man-GoToSection\">\n"
+                    "<span Label=\"1\">Go to section:</span>\n"
+                    "<select id=\"SectionList\">\n"
+                    "   <option value=\"x\">-----</option>\n", -1);
+
+
+  char SectionTitle [64], SectionTitle2 [64];
+
+  for (pSection = pRenderer->pFirstSection, i = 1
+        ; pSection != NULL
+        ; pSection = pSection->pNext, i++)
+  {
+    EllipsizeString (pSection->pTitle, SectionTitle, 
+                     sizeof (SectionTitle), 24);
+
+    HTMLEscapeText (SectionTitle2, sizeof (SectionTitle2), SectionTitle, -1);
+
+    PagePrintf (pPage, 
+                "   <option value=\"%d\">%s</option>\n",
+                i, SectionTitle2);
+  }
+
+
+  PageAppendStatic (pPage, "</select>\n", -1);
+
+  PageAppendStatic (pPage, 
+                    "&nbsp;\n"
+                    "<span id=\"ShowAllBtn\" class=\"Button\">Show all sections</span>\n"
+                    "&nbsp;\n"
+                    "<span id=\"HideAllBtn\" class=\"Button\">Hide all sections</span>\n"
+                    "</div>\n", -1);
+
+  PageAppendStatic (pPage, "</div>\n\n\n", -1);
+
+
+  PagePrintf (pPage, 
+              "<script src=\"%s\"></script>\n"
+              "<script>\n"
+              "\"use strict\";\n"
+              "const nSections = %d;\n"
+              "</script>\n"
+              "<script src=\"%s\"></script>\n",
+              AssetUri (ASSET_COMMON_SCRIPT),
+              pRenderer->nSections,
+              AssetUri (ASSET_MAN_PAGE_SCRIPT));
+
+  PageAppendStatic (pPage, 
+                    "</body>\n"
+                    "</html>\n", -1);
+
+  return pSections;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                   FreeManualPageSections
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void FreeManualPageSections
+    (MANPAGESECTIONS  *pSections)
+
+{
+  if (pSections == NULL)
+    return;
+
+  free (pSections->pOffsets);
+  free (pSections->pData);
+  free (pSections);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                    CopyManualPageSection
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns a copy (allocated with malloc) of the body of section 
+*   iSection, numbered as on the page.  Returns false if that section
+*   was not deferred.
+*/
+
+bool CopyManualPageSection
+    (const MANPAGESECTIONS  *pSections,
+     int                     iSection,
+     char                  **ppData,
+     int                    *pcbData)
+
+{
+  int i = iSection - pSections->iFirstSection;
+
+
+  if ((i < 0) || (i >= pSections->nSections))
+    return false;
+
+  *pcbData = pSections->pOffsets [i + 1] - pSections->pOffsets [i];
+  *ppData = (char*) malloc (*pcbData + 1);
+  memcpy (*ppData, pSections->pData + pSections->pOffsets [i], *pcbData);
+  (*ppData) [*pcbData] = '\0';
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         ManualPageToText
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Decodes a formatted manual page into plain text, with the escape 
+*   sequences (or overstrikes) that mark bold and underlined text 
+*   removed.  This is what the full-text indexer reads.  The text is
+*   allocated from pArena and NUL-terminated.
+*/
+
+char* ManualPageToText
+    (ARENA       *pArena,
+     const char  *pContent,
+     int          cbContent,
+     int         *pcbTextOut)
+
+{
+  int cbDecoded;
+  char *pText;
+  ATTRSPANLIST spans;
+  MANPAGERENDERER renderer;
+
+
+  memset (&renderer, 0, sizeof (MANPAGERENDERER));
+  renderer.EscapeStyle = ESCAPE_STYLE_UNKNOWN;
+
+  DecideEscapeStyle (&renderer, pContent, cbContent, true);
+
+
+  InitAttrSpans (&spans, pArena);
+  pText = (char*) ArenaAlloc (pArena, cbContent + 1);
+
+  ((renderer.EscapeStyle == ESCAPE_STYLE_ANSI) 
+       ? AnsiGetTextAttributes 
+       : OldStyleGetTextAttributes)
+    (pContent, cbContent, true, pText, &spans, cbContent + 1, 
+     &cbDecoded, &renderer.AnsiAttrs);
+
+  pText [cbDecoded] = '\0';
+
+  *pcbTextOut = cbDecoded;
+  return pText;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                  CollectDeferredSections
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Copies the bodies of the deferred sections into a single block and
+*   frees the builder that held them.
+*/
+
+static
+MANPAGESECTIONS* CollectDeferredSections
+   (MANPAGERENDERER  *pRenderer)
+
+{
+  MANPAGESECTIONS *pSections;
+  int nDeferred = pRenderer->nSections - pRenderer->nInlineSections;
+
+
+  if (nDeferred < 0)
+  {
+    nDeferred = 0;
+  }
+
+  PageFinish (&pRenderer->deferred);
+
+  pSections = (MANPAGESECTIONS*) malloc (sizeof (MANPAGESECTIONS));
+  pSections->iFirstSection = pRenderer->nInlineSections + 1;
+  pSections->nSections = nDeferred;
+
+  pSections->pOffsets = (int*) realloc (pRenderer->pDeferredOffsets, 
+                                        sizeof (int) * (nDeferred + 1));
+  pSections->pOffsets [nDeferred] = pRenderer->deferred.cbTotal;
+
+  pSections->pData = (char*) malloc (pRenderer->deferred.cbTotal + 1);
+  PageRead (&pRenderer->deferred, pSections->pData, pRenderer->deferred.cbTotal);
+  pSections->pData [pRenderer->deferred.cbTotal] = '\0';
+
+  FreePageBuilder (&pRenderer->deferred);
+  pRenderer->pDeferredOffsets = NULL;
+
+  return pSections;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              RenderLines
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Classifies the decoded lines that haven't been looked at yet, and
+*   renders each text block once the line that ends it is known.  Unless
+*   fFinal is set, a line is left for later if it is incomplete or may
+*   turn out to be the last one.
+*/
+
+static
+void RenderLines
+   (MANPAGERENDERER  *pRenderer,
+    bool              fFinal)
+
+{
+  int k, nIndexed, length, iLine, iNextLine, indent, cbDiscard;
+  bool fLastLine = false;
+  char buffer [128];
+  LINEINDEX lines [LINE_BATCH_SIZE];
+
+  char *pText                 = pRenderer->pText;
+  int cbText                  = pRenderer->cbText;
+  int iSectionStart           = pRenderer->iSectionStart;
+  int iSectionEnd             = pRenderer->iSectionEnd;
+  int MinIndent               = pRenderer->MinIndent;
+  LINECLASSIFICATION LineClass = (LINECLASSIFICATION) pRenderer->LineClass;
+
+
   const HTMLFORMATINFO FormatInfo
            = { 
                .pWebLinkAttrs      = "RefType=\"uri\"", 
                .pManPageLinkAttrs  = "RefType=\"manpage\"", 
                .pInfoLinkAttrs     = "", 
                .pInfoContextName   = "",
-               .pUriPrefix         = pUriPrefix
+               .pUriPrefix         = pRenderer->pUriPrefix
              };
 
-
-  HTMLizeText (buffer, sizeof (buffer), pPageTitle, -1, NULL, NULL, 0);
-
-  fprintf (stream, 
-           "<!DOCTYPE html>\n\n"
-           "<html>\n"
-           "<head>\n"
-           "<title>Man page: %s</title>\n"
-           "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
-           "<base href=\"%s\">\n"
-           "<style>\n%s\n</style>\n"
-           "</head>\n"
-           "<body Type=\"man\">\n"
-           "<div id=\"Main\">\n"
-           "<div class=\"PageTitle\">%s</div>\n\n\n"
-           "<div id=\"Prologue\">\n",
-           buffer, 
-           pUriPrefix,
-           pStylesheet, 
-           buffer);
-
-
-  pText = (char*) malloc (cbContent + 1);         
-  pAttributes = (TEXTATTRIBUTES*) malloc (sizeof (TEXTATTRIBUTES) * (cbContent + 1));
-
-  GetTextAttributes (pContent, cbContent, 
-                     pText, pAttributes, cbContent + 1, 
-                     &cbText);
-
-
-  nSections = 0;
-  iSectionStart = iSectionEnd = -1;
-  LineClass = LINE_CLASS_NONE;
-  pFirstSection = pLastSection = NULL;
-  fLastLine = false;
   
-  for (iLine = 0; !fLastLine; iLine = iNextLine)
+  k = nIndexed = 0;
+
+  for (iLine = pRenderer->iLine; !fLastLine; iLine = iNextLine)
   {
-    j = -1;
-    indent = 0;
-    for (i = iLine; (i < cbText) && ((c = pText [i]) != '\n'); i++)
+    if (k == nIndexed)
     {
-      if ((c == ' ') || (c == '\t'))
-      {
-        if (j < 0)
-        {
-          indent++;
-        }
-      }  
-      else
-      {
-        j = i;
-      }
+      nIndexed = IndexLines (pText, cbText, iLine, lines, LINE_BATCH_SIZE);
+      k = 0;
     }
 
-    length = (j >= 0) ? (j - iLine + 1) : 0;
-    iNextLine = i + 1;
+    iNextLine = iLine + lines [k].length + 1;
+    length = lines [k].TrimmedLength;
+    indent = lines [k].indent;
+    k++;
+
+    if (!fFinal && (iNextLine >= cbText))
+      break;
+
     fLastLine = (iNextLine >= cbText);
 
 
-    LineClass = ClassifyLine (pText + iLine, pAttributes + iLine, length, LineClass);
+    LineClass = ClassifyLine (pText, &pRenderer->spans, iLine, length, LineClass);
 
 
     if ((LineClass == LINE_CLASS_BLANK) && !fLastLine)
@@ -206,25 +637,12 @@ void ManualPageToHTML
 
     if (iSectionStart >= 0)
     {
-      int cbSection = iSectionEnd - iSectionStart;
-      int cbMax = cbSection * HTML_EXPANSION_FACTOR;
-      char *pMarkup = (char*) malloc (cbMax);
-      char *pSectionText = pText + iSectionStart;
-      TEXTATTRIBUTES *pSectionAttrs = pAttributes + iSectionStart;
-
-
-      NormalizeAttributesOfWhitespace (pSectionText, pSectionAttrs, cbSection, TEXT_ATTR_BOLD);
-      NormalizeAttributesOfWhitespace (pSectionText, pSectionAttrs, cbSection, TEXT_ATTR_ITALIC);
-
-      RecognizeURIs (pSectionText, cbSection, pSectionAttrs);
-      RecognizeManPageRefs (pSectionText, cbSection, pSectionAttrs);
-      HandleSplitLinks (pSectionText, cbSection, pSectionAttrs);
+      CopyAttrSpans (&pRenderer->BlockSpans, &pRenderer->spans, 
+                     iSectionStart, iSectionEnd);
 
-      HTMLizeText (pMarkup, cbMax, pSectionText, cbSection,
-                   pSectionAttrs, &FormatInfo, MinIndent);
-            
-      fprintf (stream, "<pre>\n%s\n</pre>\n", pMarkup);
-      free (pMarkup);
+      RenderTextBlock (pText + iSectionStart, &pRenderer->BlockSpans,
+                       iSectionEnd - iSectionStart, MinIndent, 
+                       &FormatInfo, pRenderer->pOutput);
 
       iSectionStart = iSectionEnd = -1;
     }
@@ -232,104 +650,179 @@ void ManualPageToHTML
 
     if (LineClass == LINE_CLASS_SECTION_TITLE)
     {
-      nSections++;
-      HTMLizeText (buffer, sizeof (buffer), pText + iLine, length, NULL, NULL, 0);
+      HTMLEscapeText (buffer, sizeof (buffer), pText + iLine, length);
+      BeginSection (pRenderer, buffer);
+    }
+  }
 
-      pSection = (SECTIONENTRY*) malloc (sizeof (SECTIONENTRY));
-      pSection->pNext   = NULL;
-      pSection->pTitle  = strdup (buffer);
 
-      if (pLastSection == NULL)
-      {
-        pFirstSection = pSection;
-      }
-      else
-      {
-        pLastSection->pNext = pSection;
-      }
+  /*  Text before the current block is no longer needed; discard it once
+  *   there is enough of it to be worth moving the rest.
+  */
+
+  cbDiscard = (iSectionStart >= 0) ? iSectionStart : iLine;
 
-      pLastSection = pSection;
+  if (!fFinal && (cbDiscard >= DISCARD_THRESHOLD))
+  {
+    memmove (pText, pText + cbDiscard, cbText - cbDiscard + 1);
+    DiscardAttrSpans (&pRenderer->spans, cbDiscard);
 
+    pRenderer->cbText -= cbDiscard;
+    iLine -= cbDiscard;
 
-      fprintf (stream,   
-               "</div>\n\n\n"            
-               "<div class=\"HeaderBar\" id=\"Sec%d_Header\">\n"
-               "%s\n"                             
-               "<span id=\"Sec%d_ShowBtn\" class=\"HideButton\" onclick=\"ShowSection (%d, 'toggle')\"></span>\n"
-               "</div>\n\n"               
-               "<div class=\"Collapsible\" id=\"Sec%d\">\n",
-               nSections,
-               buffer,                  
-               nSections, nSections, nSections);
+    if (iSectionStart >= 0)
+    {
+      iSectionStart -= cbDiscard;
+      iSectionEnd -= cbDiscard;
     }
   }
 
 
-  free (pAttributes);
-  free (pText);
+  pRenderer->iLine          = iLine;
+  pRenderer->iSectionStart  = iSectionStart;
+  pRenderer->iSectionEnd    = iSectionEnd;
+  pRenderer->MinIndent      = MinIndent;
+  pRenderer->LineClass      = LineClass;
+}
 
 
-  fprintf (stream,
-           "</div>\n"
-           "</div>\n");
 
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             BeginSection
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-  fprintf (stream, 
-           "\n\n<div id=\"NavBar\">\n"
-           "<div id=\"Nav-Man-GoToSection\">\n"
-           "<span Label=\"1\">Go to section:</span>\n"
-           "<select id=\"SectionList\">\n"
-           "   <option value=\"x\">-----</option>\n");
+/*  Writes the header bar for a new section, whose (HTML-escaped) title
+*   is pTitle, and decides where the section's body will go.  The body of
+*   a deferred section goes to the deferred builder, and the section's
+*   div is left empty and marked "Lazy".
+*/
 
+static
+void BeginSection
+   (MANPAGERENDERER  *pRenderer,
+    const char       *pTitle)
 
-  char SectionTitle [64], SectionTitle2 [64];
+{
+  SECTIONENTRY *pSection;
+  int n, iDeferred;
+  bool fDeferred;
 
-  for (pSection = pFirstSection, i = 1
-        ; pSection != NULL
-        ; pSection = pNextSection, i++)
+
+  n = ++pRenderer->nSections;
+
+  pSection = (SECTIONENTRY*) ArenaAlloc (pRenderer->pArena, sizeof (SECTIONENTRY));
+  pSection->pNext   = NULL;
+  pSection->pTitle  = ArenaStrndup (pRenderer->pArena, pTitle, strlen (pTitle));
+
+  if (pRenderer->pLastSection == NULL)
   {
-    EllipsizeString (pSection->pTitle, SectionTitle, 
-                     sizeof (SectionTitle), 24);
+    pRenderer->pFirstSection = pSection;
+  }
+  else
+  {
+    pRenderer->pLastSection->pNext = pSection;
+  }
+
+  pRenderer->pLastSection = pSection;
 
-    HTMLizeText (SectionTitle2, sizeof (SectionTitle2), 
-                 SectionTitle, -1, NULL, NULL, 0);
 
-    fprintf (stream, 
-             "   <option value=\"%d\">%s</option>\n",
-             i, SectionTitle2);
+  fDeferred = pRenderer->fDeferring && (n > pRenderer->nInlineSections);
 
-    pNextSection = pSection->pNext;
-    free (pSection->pTitle);
-    free (pSection);
+  if (fDeferred)
+  {
+    iDeferred = n - pRenderer->nInlineSections - 1;
+
+    if (iDeferred + 2 > pRenderer->nDeferredAllocated)
+    {
+      pRenderer->nDeferredAllocated = 2 * (iDeferred + 2);
+      pRenderer->pDeferredOffsets = (int*) realloc 
+                                       (pRenderer->pDeferredOffsets,
+                                        sizeof (int) * pRenderer->nDeferredAllocated);
+    }
+
+    PageFinish (&pRenderer->deferred);
+    pRenderer->pDeferredOffsets [iDeferred] = pRenderer->deferred.cbTotal;
+    pRenderer->pOutput = &pRenderer->deferred;
   }
 
 
-  fprintf (stream, "</select>\n");
+  PagePrintf (pRenderer->pPage,   
+              "</div>\n\n\n"            
+              "<div class=\"HeaderBar\" id=\"Sec%d_Header\">\n"
+              "%s\n"                             
+              "<span id=\"Sec%d_ShowBtn\" class=\"HideButton\" onclick=\"ShowSection (%d, 'toggle')\"></span>\n"
+              "</div>\n\n"               
+              "<div class=\"Collapsible\" id=\"Sec%d\"%s>\n",
+              n, pTitle, n, n, n,
+              fDeferred ? " Lazy=\"\"" : "");
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              AppendInput
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Adds raw text to the renderer's input buffer, which is kept 
+*   zero-terminated.
+*/
+
+static
+void AppendInput
+   (MANPAGERENDERER  *pRenderer,
+    const char       *pData,
+    int               cbData)
 
-  fprintf (stream, 
-           "&nbsp;\n"
-           "<span id=\"ShowAllBtn\" class=\"Button\">Show all sections</span>\n"
-           "&nbsp;\n"
-           "<span id=\"HideAllBtn\" class=\"Button\">Hide all sections</span>\n"
-           "</div>\n");
+{
+  int cbNeeded = pRenderer->cbInput + cbData + 1;
 
-  fprintf (stream, "</div>\n\n\n");
 
+  if (cbNeeded > pRenderer->cbInputAllocated)
+  {
+    pRenderer->pInput = (char*) ArenaRealloc (pRenderer->pArena, pRenderer->pInput, 
+                                              pRenderer->cbInputAllocated, 2 * cbNeeded);
+    pRenderer->cbInputAllocated = 2 * cbNeeded;
+  }
 
-  fprintf (stream, 
-           "<script>\n"
-           "\"use strict\";\n"
-           "%s\n"
-           "const nSections = %d;\n"
-           "%s"
-           "</script>\n", 
-           AdjustMarginCode,
-           nSections,
-           ScriptCode);
+  if (cbData > 0)
+  {
+    memcpy (pRenderer->pInput + pRenderer->cbInput, pData, cbData);
+  }
 
-  fprintf (stream, 
-           "</body>\n"
-           "</html>\n");
+  pRenderer->cbInput += cbData;
+  pRenderer->pInput [pRenderer->cbInput] = '\0';
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              ReserveText
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Makes room for decoding cbInput more bytes of raw text.  (Decoding
+*   never makes the text longer.)
+*/
+
+static
+void ReserveText
+   (MANPAGERENDERER  *pRenderer,
+    int               cbInput)
+
+{
+  int cbNeeded = pRenderer->cbText + cbInput + 1;
+
+
+  if (cbNeeded > pRenderer->cbTextAllocated)
+  {
+    if (pRenderer->cbTextAllocated > 0)
+    {
+      cbNeeded += cbNeeded / 2;
+    }
+
+    pRenderer->pText = (char*) ArenaRealloc (pRenderer->pArena, pRenderer->pText,
+                                             pRenderer->cbTextAllocated, cbNeeded);
+    pRenderer->cbTextAllocated = cbNeeded;
+  }
 }
 
 
@@ -338,32 +831,39 @@ void ManualPageToHTML
                                                              ClassifyLine
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Classifies the line of the given length starting at offset iLine.  
+*   A section title is a line that is entirely bold and not indented.
+*/
+
 static 
 LINECLASSIFICATION ClassifyLine 
     (const char            *pText, 
-     const TEXTATTRIBUTES  *pAttributes, 
+     const ATTRSPANLIST    *pSpans,
+     int                    iLine,
      int                    length, 
      LINECLASSIFICATION     PreviousLineClass)
 
 {
-  int i;
+  int k;
+  const ATTRSPAN *pSpan;
 
 
   if (length <= 0)
     return LINE_CLASS_BLANK;
 
 
-  if ((pText [0] != ' ') && (pText [0] != '\t'))
+  if ((pText [iLine] != ' ') && (pText [iLine] != '\t'))
   {
-    i = 0;
-    while ((i < length) 
-              && ((pAttributes [i] & TEXT_ATTR_APPEARANCE_MASK) == TEXT_ATTR_BOLD))
+    for (k = FindAttrSpan (pSpans, iLine); k < pSpans->nSpans; k++)
     {
-      i++;
+      pSpan = pSpans->pSpans + k;
+
+      if ((pSpan->attrs & TEXT_ATTR_APPEARANCE_MASK) != TEXT_ATTR_BOLD)
+        break;
+
+      if (pSpan->iStart + pSpan->length >= iLine + length)
+        return LINE_CLASS_SECTION_TITLE;
     }
-  
-    if (i == length)
-      return LINE_CLASS_SECTION_TITLE;
   }
 
   return LINE_CLASS_TEXT;
@@ -372,36 +872,104 @@ LINECLASSIFICATION ClassifyLine
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                        GetTextAttributes
+                                                        DecideEscapeStyle
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+/*  Decides which kind of formatting the text uses by looking at its
+*   beginning.  grotty output contains ANSI escapes within the first 
+*   few lines; if the prefix contains neither escapes nor backspaces,
+*   look at the rest of the text as well.  pText holds all of the text
+*   received so far.  Returns false if more text is needed to decide.
+*/
+
 static
-void GetTextAttributes
-   (const char      *pText,
-    int              cbText,
-    char            *pTextOut,
-    TEXTATTRIBUTES  *pAttrsOut,
-    int              cbMax,
-    int             *pLengthOut)
+bool DecideEscapeStyle
+   (MANPAGERENDERER  *pRenderer,
+    const char       *pText,
+    int               cbText,
+    bool              fFinal)
 
 {
-  int i, nEscapes = 0;
-  bool fIsANSI;
+  int cbPrefix, iEnd;
 
 
-  for (i = 0; i < cbText; i++)
+  if (pRenderer->EscapeStyle != ESCAPE_STYLE_UNKNOWN)
+    return true;
+
+
+  if (pRenderer->iEscapeScan == 0)
   {
-    if ((pText [i] == 0x1b) && (pText [i + 1] == '['))
+    if ((cbText < ESCAPE_STYLE_PREFIX) && !fFinal)
+      return false;
+
+    cbPrefix = (cbText < ESCAPE_STYLE_PREFIX) ? cbText : ESCAPE_STYLE_PREFIX;
+    pRenderer->nEscapes = CountAnsiEscapes (pText, cbPrefix, 5);
+    pRenderer->iEscapeScan = cbPrefix;
+
+    if ((pRenderer->nEscapes < 5)
+           && (memchr (pText, '\b', cbPrefix) != NULL))
     {
-      nEscapes++;
+      pRenderer->EscapeStyle = ESCAPE_STYLE_OVERSTRIKE;
+      return true;
     }
   }
-  
-  fIsANSI = (nEscapes >= 5);
 
 
-  (fIsANSI ? AnsiGetTextAttributes : OldStyleGetTextAttributes)
-      (pText, cbText, pTextOut, pAttrsOut, cbMax, pLengthOut);
+  /*  Count escapes in the rest of the text as it arrives.  The last byte
+  *   is left for next time, since the '[' that follows it may not have
+  *   been received yet.
+  */
+
+  iEnd = fFinal ? cbText : (cbText - 1);
+
+  if ((pRenderer->nEscapes < 5) && (iEnd > pRenderer->iEscapeScan))
+  {
+    pRenderer->nEscapes += CountAnsiEscapes (pText + pRenderer->iEscapeScan, 
+                                             cbText - pRenderer->iEscapeScan, 
+                                             5 - pRenderer->nEscapes);
+    pRenderer->iEscapeScan = iEnd;
+  }
+
+
+  if (pRenderer->nEscapes >= 5)
+  {
+    pRenderer->EscapeStyle = ESCAPE_STYLE_ANSI;
+  }
+  else if (fFinal)
+  {
+    pRenderer->EscapeStyle = ESCAPE_STYLE_OVERSTRIKE;
+  }
+
+  return (pRenderer->EscapeStyle != ESCAPE_STYLE_UNKNOWN);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         CountAnsiEscapes
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+int CountAnsiEscapes
+   (const char  *pText,
+    int          cbText,
+    int          nMax)
+
+{
+  int i, count = 0;
+
+
+  for (i = 0; (count < nMax) && (i < cbText); i++)
+  {
+    i += FindEitherByte (pText + i, cbText - i, 0x1b, 0x1b);
+
+    if ((i < cbText - 1) && (pText [i + 1] == '['))
+    {
+      count++;
+    }
+  }
+
+  return count;
 }
 
 
@@ -411,30 +979,58 @@ void GetTextAttributes
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
 static
-void AnsiGetTextAttributes
+int AnsiGetTextAttributes
    (const char      *pText,
     int              cbText,
+    bool             fFinal,
     char            *pTextOut,
-    TEXTATTRIBUTES  *pAttrsOut,
+    ATTRSPANLIST    *pSpansOut,
     int              cbMax,
-    int             *pLengthOut)
+    int             *pLengthOut,
+    TEXTATTRIBUTES  *pAttrState)
 
 {
-  int i, j, iStart, length, value;
+  int i, j, iStart, length, value, cbRun, cbLimit;
   bool fNumeric;
   TEXTATTRIBUTES attrs;
   char c;
-  unsigned char d;
+  unsigned char d = 0;
 
 
   i = j = 0;
-  attrs = 0;
+  attrs = *pAttrState;
+  cbLimit = fFinal ? cbText : (cbText - DECODE_LOOKAHEAD);
    
-  while ((i < cbText) && (j < cbMax - 1))
+  while ((i < cbLimit) && (j < cbMax - 1))
   {
-    c = pText [i++];
+    /*  Copy the run of ordinary characters preceding the next escape
+    *   or carriage return in bulk.
+    */
+
+    cbRun = FindEitherByte (pText + i, cbText - i, 0x1b, '\r');
+
+    if (cbRun > cbLimit - i)
+    {
+      cbRun = cbLimit - i;
+    }
+
+    if (cbRun > cbMax - 1 - j)
+    {
+      cbRun = cbMax - 1 - j;
+    }
+
+    if (cbRun > 0)
+    {
+      memcpy (pTextOut + j, pText + i, cbRun);
+      AppendAttrSpan (pSpansOut, cbRun, attrs);
+      i += cbRun;
+      j += cbRun;
+      continue;
+    }
 
 
+    c = pText [i++];
+
     if ((c == 0x1b) && (pText [i] == '['))
     {
       iStart = ++i;
@@ -457,6 +1053,16 @@ void AnsiGetTextAttributes
         i++;        
       }
 
+      /*  Leave an escape sequence that hasn't been received in full
+      *   for next time.
+      */
+
+      if ((i >= cbText) && !fFinal)
+      {
+        i = iStart - 2;
+        break;
+      }
+
       length = ++i - iStart;
 
       if ((d == 'm') && fNumeric && (length >= 2))
@@ -476,19 +1082,22 @@ void AnsiGetTextAttributes
 
 
     pTextOut [j] = (c == '\r') ? ' ' : c;
-    pAttrsOut [j] = attrs;
+    AppendAttrSpan (pSpansOut, 1, attrs);
     j++;
   }
 
 
   pTextOut [j] = '\0';
-  pAttrsOut [j] = 0;
 
 
   if (pLengthOut != NULL)
   {
     *pLengthOut = j;
   }
+
+  *pAttrState = attrs;
+
+  return (i < cbText) ? i : cbText;
 }
 
 
@@ -498,24 +1107,59 @@ void AnsiGetTextAttributes
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
 static
-void OldStyleGetTextAttributes
+int OldStyleGetTextAttributes
    (const char      *pText,
     int              cbText,
+    bool             fFinal,
     char            *pTextOut,
-    TEXTATTRIBUTES  *pAttrsOut,
+    ATTRSPANLIST    *pSpansOut,
     int              cbMax,
-    int             *pLengthOut)
+    int             *pLengthOut,
+    TEXTATTRIBUTES  *pAttrState)
 
 {
-  int i, j;
+  int i, j, cbRun, cbLimit;
   char c, c2;
   TEXTATTRIBUTES attr;
 
 
   i = j = 0;
+  cbLimit = fFinal ? cbText : (cbText - DECODE_LOOKAHEAD);
    
-  while ((i < cbText) && (j < cbMax - 1))
+  while ((i < cbLimit) && (j < cbMax - 1))
   {
+    /*  Every character up to (but not including) the one preceding the
+    *   next backspace or carriage return is plain text.  Copy those in 
+    *   bulk.
+    */
+
+    cbRun = FindEitherByte (pText + i, cbText - i, '\b', '\r');
+
+    if ((i + cbRun < cbText) && (pText [i + cbRun] == '\b'))
+    {
+      cbRun--;
+    }
+
+    if (cbRun > cbLimit - i)
+    {
+      cbRun = cbLimit - i;
+    }
+
+    if (cbRun > cbMax - 1 - j)
+    {
+      cbRun = cbMax - 1 - j;
+    }
+
+    if (cbRun > 0)
+    {
+      memcpy (pTextOut + j, pText + i, cbRun);
+      AppendAttrSpan (pSpansOut, cbRun, 0);
+      i += cbRun;
+      j += cbRun;
+      continue;
+    }
+
+
     attr = 0;
     c = pText [i++];
 
@@ -538,18 +1182,153 @@ void OldStyleGetTextAttributes
     }
 
     pTextOut [j] = (c == '\r') ? ' ' : c;
-    pAttrsOut [j] = attr;
+    AppendAttrSpan (pSpansOut, 1, attr);
     j++;
   }
 
 
   pTextOut [j] = '\0';
-  pAttrsOut [j] = 0;
 
   if (pLengthOut != NULL)
   {
     *pLengthOut = j;
   }
+
+  return i;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           FindEitherByte
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the offset of the first occurrence of c1 or c2 in the given
+*   text, or cbText if neither occurs.  Uses AVX2 when the processor
+*   supports it, SSE2 otherwise, and plain C on other architectures.
+*/
+
+#if defined (__x86_64__) || defined (__i386__)
+
+__attribute__ ((target ("avx2")))
+static
+int FindEitherByteAVX2
+   (const char  *pText,
+    int          cbText,
+    char         c1,
+    char         c2)
+
+{
+  int i;
+  unsigned int mask;
+  const __m256i v1 = _mm256_set1_epi8 (c1), v2 = _mm256_set1_epi8 (c2);
+  __m256i block;
+
+
+  for (i = 0; i + 32 <= cbText; i += 32)
+  {
+    block = _mm256_loadu_si256 ((const __m256i*) (pText + i));
+    mask = (unsigned int) _mm256_movemask_epi8 
+                             (_mm256_or_si256 (_mm256_cmpeq_epi8 (block, v1),
+                                               _mm256_cmpeq_epi8 (block, v2)));
+    if (mask != 0)
+      return i + __builtin_ctz (mask);
+  }
+
+  for (; i < cbText; i++)
+  {
+    if ((pText [i] == c1) || (pText [i] == c2))
+      return i;
+  }
+
+  return cbText;
+}
+
+#endif
+
+
+static
+int FindEitherByte
+   (const char  *pText,
+    int          cbText,
+    char         c1,
+    char         c2)
+
+{
+  int i = 0;
+
+
+#if defined (__x86_64__) || defined (__i386__)
+  static const bool fHaveAVX2 = __builtin_cpu_supports ("avx2");
+
+  if (fHaveAVX2 && (cbText >= 64))
+    return FindEitherByteAVX2 (pText, cbText, c1, c2);
+#endif
+
+
+#if defined (__SSE2__)
+  unsigned int mask;
+  const __m128i v1 = _mm_set1_epi8 (c1), v2 = _mm_set1_epi8 (c2);
+  __m128i block;
+
+  for (; i + 16 <= cbText; i += 16)
+  {
+    block = _mm_loadu_si128 ((const __m128i*) (pText + i));
+    mask = (unsigned int) _mm_movemask_epi8 
+                             (_mm_or_si128 (_mm_cmpeq_epi8 (block, v1),
+                                            _mm_cmpeq_epi8 (block, v2)));
+    if (mask != 0)
+      return i + __builtin_ctz (mask);
+  }
+#endif
+
+
+  for (; i < cbText; i++)
+  {
+    if ((pText [i] == c1) || (pText [i] == c2))
+      return i;
+  }
+
+  return cbText;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          RenderTextBlock
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Renders a block of text lines as a <pre> element.  The block's 
+*   attributes are in pSpans, numbered from the start of the block, and 
+*   are modified.  Whitespace normalization and link recognition work on
+*   whole spans, and the markup goes straight into the page's output 
+*   buffer.
+*/
+
+static
+void RenderTextBlock 
+   (const char            *pText,
+    ATTRSPANLIST          *pSpans,
+    int                    cbText,
+    int                    MinIndent,
+    const HTMLFORMATINFO  *pFmtInfo,
+    PAGEBUILDER           *pPage)
+
+{
+  PageAppendStatic (pPage, "<pre>\n", 6);
+
+  NormalizeSpanWhitespace (pText, pSpans, TEXT_ATTR_BOLD);
+  NormalizeSpanWhitespace (pText, pSpans, TEXT_ATTR_ITALIC);
+
+  RecognizeSpanHyperlinks (pText, cbText, pSpans, 
+                           TEXT_ATTR_URI | TEXT_ATTR_MAN_PAGE_REF);
+
+  HandleSplitLinks (pText, cbText, pSpans);
+
+  HTMLizeSpans (PageGetOutputBuffer (pPage), pText, cbText, pSpans, 
+                pFmtInfo, MinIndent);
+
+  PageAppendStatic (pPage, "\n</pre>\n", 8);
 }
 
 
@@ -562,7 +1341,7 @@ static
 void HandleSplitLinks 
    (const char       *pText,
     int               cbText,
-    TEXTATTRIBUTES   *pAttrs)
+    ATTRSPANLIST     *pSpans)
 
 {
   /*  Just a stub for now.  */
@@ -29,15 +29,121 @@
 #define __MANUALPAGETOHTML_H_
 
 
+#include "html_formatting.h"       /*  For TEXTATTRIBUTES, ATTRSPANLIST types.  */
+#include "page_builder.h"          /*  For PAGEBUILDER type.  */
+
+
+
+/*  The bodies of a manual page's deferred sections, which are sent 
+*   separately when the reader expands them.  Section i (counting from 
+*   iFirstSection) occupies pData [pOffsets [i]] through 
+*   pData [pOffsets [i + 1] - 1].
+*/
+
+struct MANPAGESECTIONS
+{
+  int    iFirstSection;
+  int    nSections;
+  int   *pOffsets;
+  char  *pData;
+};
+
+
+
+/*  State for rendering a manual page in pieces, as its text arrives.
+*/
+
+struct SECTIONENTRY;
+
+struct MANPAGERENDERER
+{
+  ARENA            *pArena;
+  PAGEBUILDER      *pPage;
+  const char       *pUriPrefix;
+  int               EscapeStyle;
+  int               nEscapes;
+  int               iEscapeScan;
+  TEXTATTRIBUTES    AnsiAttrs;
+  char             *pInput;             /*  Text not yet decoded.  */
+  int               cbInput;
+  int               cbInputAllocated;
+  char             *pText;              /*  Decoded text.  */
+  ATTRSPANLIST      spans;              /*  Attributes of the decoded text.  */
+  ATTRSPANLIST      BlockSpans;
+  int               cbText;
+  int               cbTextAllocated;
+  int               iLine;
+  int               iSectionStart;
+  int               iSectionEnd;
+  int               MinIndent;
+  int               LineClass;
+  int               nSections;
+  bool              fComplete;
+  SECTIONENTRY     *pFirstSection;
+  SECTIONENTRY     *pLastSection;
+  PAGEBUILDER      *pOutput;            /*  Where section text goes.  */
+  bool              fDeferring;
+  int               nInlineSections;
+  PAGEBUILDER       deferred;           /*  Bodies of later sections.  */
+  int              *pDeferredOffsets;
+  int               nDeferredAllocated;
+};
+
+
+
 extern "C"
 {
 extern void ManualPageToHTML
-    (FILE          *stream,
+    (PAGEBUILDER   *pPage,
+     ARENA         *pArena,
      const char    *pPageTitle,
      const char    *pURIPrefix,
-     const char    *pStylesheet,
+     const char    *pStylesheetUri,
      const char    *pContent,
      int            cbContent);
+
+
+extern void BeginManualPage
+    (MANPAGERENDERER  *pRenderer,
+     ARENA            *pArena,
+     PAGEBUILDER      *pPage,
+     const char       *pPageTitle,
+     const char       *pURIPrefix,
+     const char       *pStylesheetUri);
+
+
+extern void DeferManualPageSections
+    (MANPAGERENDERER  *pRenderer,
+     int               nInlineSections);
+
+
+extern void RenderManualPageText
+    (MANPAGERENDERER  *pRenderer,
+     const char       *pContent,
+     int               cbContent,
+     bool              fFinal);
+
+
+extern MANPAGESECTIONS* EndManualPage
+    (MANPAGERENDERER  *pRenderer);
+
+
+extern void FreeManualPageSections
+    (MANPAGESECTIONS  *pSections);
+
+
+extern bool CopyManualPageSection
+    (const MANPAGESECTIONS  *pSections,
+     int                     iSection,
+     char                  **ppData,
+     int                    *pcbData);
+
+
+extern char* ManualPageToText
+    (ARENA       *pArena,
+     const char  *pContent,
+     int          cbContent,
+     int         *pcbTextOut);
 }
 
 #endif
@@ -0,0 +1,703 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#include <stdlib.h>                    /*  C/C++ RTL headers.  */
+#include <string.h>
+#include <sys/types.h>
+
+#include "utility.h"                   /*  Application headers.  */
+#include "documentation_api.h"
+#include "apropos_index.h"
+#include "index_file.h"
+#include "name_index.h"
+
+
+
+#define MAX_COMPARED_LENGTH   63
+
+
+
+/*  A name found by FindSimilarNames(), with what it is ranked by.
+*/
+
+struct SIMILARNAME
+{
+  int  distance;
+  int  rank;                    /*  How well the section matches.  */
+  int  entry;
+};
+
+
+/*  A name prepared for NameDistance(): Match [c] has bit i set when 
+*   the name's byte i is c (after folding).
+*/
+
+struct NAMEPATTERN
+{
+  uint64_t  Match [256];
+  int       cb;
+};
+
+
+
+/*  Function prototypes.
+*/
+
+static bool BuildNewIndex (void*, void**);
+static NAMEINDEX* BuildIndex (APROPOSRESULT*, int);
+static void FreeIndex (void*);
+static int CompareResults (const void*, const void*);
+static void BuildTree (NAMEINDEX*);
+static void PrepareNamePattern (NAMEPATTERN*, const char*);
+static int NameDistance (const NAMEPATTERN*, const char*);
+static int CompareSimilarNames (const void*, const void*);
+
+
+
+static SHAREDINDEX Index = SHARED_INDEX_INITIALIZER (FreeIndex, 0);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      StartNameIndexBuild
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Starts building a new index on a thread of its own, unless a build
+*   is already under way.  The names come from running apropos(1) on a
+*   regex that matches every entry in the whatis database, which takes 
+*   a second or so on a large system.  The apropos index is rebuilt
+*   from the same results.
+*/
+
+void StartNameIndexBuild
+    (void)
+
+{
+  StartSharedIndexBuild (&Index, BuildNewIndex, NULL);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         AcquireNameIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+const NAMEINDEX* AcquireNameIndex
+    (void)
+
+{
+  return (const NAMEINDEX*) AcquireSharedIndex (&Index);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         ReleaseNameIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void ReleaseNameIndex
+    (const NAMEINDEX  *pIndex)
+
+{
+  ReleaseSharedIndex (&Index, pIndex);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           FindNamePrefix
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Finds the entries whose names begin with pPrefix, ignoring ASCII 
+*   case.  They are consecutive; the first is stored in *piFirstOut and 
+*   the number of them is returned.  The bucket for the prefix's first 
+*   byte narrows the two binary searches to a few hundred entries at 
+*   most.
+*/
+
+int FindNamePrefix
+    (const NAMEINDEX  *pIndex,
+     const char       *pPrefix,
+     int              *piFirstOut)
+
+{
+  int cbPrefix, c, lo, hi, mid, iFirst;
+  const char *pText = pIndex->pText;
+  const NAMEINDEXENTRY *pEntries = pIndex->pEntries;
+
+
+  *piFirstOut = 0;
+
+  if ((cbPrefix = strlen (pPrefix)) == 0)
+    return 0;
+
+
+  c = FoldChar (pPrefix [0]);
+  lo = pIndex->Buckets [c];
+  hi = pIndex->Buckets [c + 1];
+
+
+  /*  The first entry that doesn't sort before the prefix...
+  */
+
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+
+    if (ComparePrefix (pText + pEntries [mid].name, pPrefix, cbPrefix) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  iFirst = lo;
+
+
+  /*  ...and the first one after it that doesn't begin with it.
+  */
+
+  hi = pIndex->Buckets [c + 1];
+
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+
+    if (ComparePrefix (pText + pEntries [mid].name, pPrefix, cbPrefix) <= 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+
+  *piFirstOut = iFirst;
+  return lo - iFirst;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         FindSimilarNames
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Finds the entries whose names are within a few edits of pName (one
+*   for very short names, up to three for long ones), for suggesting 
+*   what a user who asked for a page that doesn't exist may have meant.
+*   Up to nMax entry numbers are stored in pEntriesOut, closest first; 
+*   among equally close ones, those in pSection (if it isn't empty, or
+*   failing that, in the same numbered section) come first.  The entry
+*   for pName in pSection itself is left out.  Returns the number 
+*   stored.
+*
+*   Thanks to the triangle inequality, only the subtrees of the BK-tree
+*   whose distance from their parent is within range of the parent's
+*   distance from pName need to be searched.
+*/
+
+int FindSimilarNames
+    (const NAMEINDEX  *pIndex,
+     const char       *pName,
+     const char       *pSection,
+     int              *pEntriesOut,
+     int               nMax)
+
+{
+  int i, k, d, cbName, MaxDistance, nStack, nFound, nAllocated;
+  int *pStack;
+  const char *pEntryName, *pEntrySection;
+  const NAMEINDEXNODE *pNode;
+  SIMILARNAME *pFound;
+  NAMEPATTERN pattern;
+
+
+  if ((pIndex->nNodes == 0) || (nMax <= 0))
+    return 0;
+
+  cbName = strlen (pName);
+  MaxDistance = (cbName <= 3) ? 1 : ((cbName <= 7) ? 2 : 3);
+
+  PrepareNamePattern (&pattern, pName);
+
+
+  /*  Each node is pushed at most once, so the stack can't overflow.
+  */
+
+  pStack = (int*) malloc (sizeof (int) * pIndex->nNodes);
+  pStack [0] = 0;
+  nStack = 1;
+
+  nAllocated = 64;
+  pFound = (SIMILARNAME*) malloc (sizeof (SIMILARNAME) * nAllocated);
+  nFound = 0;
+
+  while (nStack > 0)
+  {
+    pNode = pIndex->pNodes + pStack [--nStack];
+    d = NameDistance (&pattern, pIndex->pText + pIndex->pEntries [pNode->entry].name);
+
+    for (k = 0; (d <= MaxDistance) && (k < (int) pNode->nEntries); k++)
+    {
+      pEntryName = pIndex->pText + pIndex->pEntries [pNode->entry + k].name;
+      pEntrySection = pIndex->pText + pIndex->pEntries [pNode->entry + k].section;
+
+      if ((d == 0) && (strcmp (pEntryName, pName) == 0) && (strcmp (pEntrySection, pSection) == 0))
+        continue;
+
+      if (nFound == nAllocated)
+      {
+        nAllocated *= 2;
+        pFound = (SIMILARNAME*) realloc (pFound, sizeof (SIMILARNAME) * nAllocated);
+      }
+
+      pFound [nFound].distance = d;
+      pFound [nFound].entry = pNode->entry + k;
+
+      if ((pSection [0] == '\0') || (strcmp (pEntrySection, pSection) == 0))
+        pFound [nFound].rank = 0;
+      else if (pEntrySection [0] == pSection [0])
+        pFound [nFound].rank = 1;
+      else
+        pFound [nFound].rank = 2;
+
+      nFound++;
+    }
+
+    for (i = pNode->iFirstChild; i >= 0; i = pIndex->pNodes [i].iNextSibling)
+    {
+      if (abs (pIndex->pNodes [i].distance - d) <= MaxDistance)
+      {
+        pStack [nStack++] = i;
+      }
+    }
+  }
+
+
+  qsort (pFound, nFound, sizeof (SIMILARNAME), CompareSimilarNames);
+
+  for (k = 0; (k < nFound) && (k < nMax); k++)
+  {
+    pEntriesOut [k] = pFound [k].entry;
+  }
+
+  free (pStack);
+  free (pFound);
+
+  return k;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            BuildNewIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  If apropos(1) fails, the old indexes (if any) stay in place.
+*/
+
+static
+bool BuildNewIndex
+   (void   *pContext,
+    void  **ppIndexOut)
+
+{
+  APROPOSRESULT *pResults, *pSorted;
+  int nResults;
+  PROCESSERRORINFO error;
+
+
+  if (!GetAproposContent (".", APROPOS_REGEX, &pResults, &nResults, &error))
+    return false;
+
+
+  /*  BuildIndex() reorders the results, so it gets a copy of the 
+  *   array (the strings stay where they are) and the apropos index
+  *   takes over the original.
+  */
+
+  pSorted = (APROPOSRESULT*) malloc (sizeof (APROPOSRESULT) * (nResults + 1));
+  memcpy (pSorted, pResults, sizeof (APROPOSRESULT) * nResults);
+
+  *ppIndexOut = BuildIndex (pSorted, nResults);
+  free (pSorted);
+
+  UpdateAproposIndex (pResults, nResults);
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               BuildIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Sorts the apropos results, drops duplicate (name, section) pairs, 
+*   and packs what's left into a NAMEINDEX.  Since there are only a few 
+*   dozen distinct sections, they are simply looked up by a linear
+*   search through the ones seen so far.
+*/
+
+static
+NAMEINDEX* BuildIndex
+   (APROPOSRESULT  *pResults,
+    int             nResults)
+
+{
+  int i, k, n, c, nSections, cbNames, cbSections;
+  char *pStr;
+  const char *pName, *pSection, **pSections;
+  uint32_t *pSectionOffsets;
+  NAMEINDEX *pIndex;
+
+
+  qsort (pResults, nResults, sizeof (APROPOSRESULT), CompareResults);
+
+
+  /*  Find the unique pairs and the distinct sections, and total up the 
+  *   space needed for their text.
+  */
+
+  pSections = (const char**) malloc (sizeof (char*) * (nResults + 1));
+  nSections = 0;
+  cbNames = cbSections = 0;
+
+  for (i = n = 0; i < nResults; i++)
+  {
+    pName = pResults [i].pPageTitle;
+    pSection = pResults [i].pSection;
+
+    if ((pName [0] == '\0')
+          || ((n > 0) 
+                && (strcmp (pName, pResults [n - 1].pPageTitle) == 0)
+                && (strcmp (pSection, pResults [n - 1].pSection) == 0)))
+      continue;
+
+    pResults [n++] = pResults [i];
+    cbNames += strlen (pName) + 1;
+
+    for (k = 0; (k < nSections) && (strcmp (pSections [k], pSection) != 0); k++)
+      ;
+
+    if (k == nSections)
+    {
+      pSections [nSections++] = pSection;
+      cbSections += strlen (pSection) + 1;
+    }
+  }
+
+
+  pIndex = (NAMEINDEX*) malloc (sizeof (NAMEINDEX));
+  pIndex->pText = (char*) malloc (cbNames + cbSections + 1);
+  pIndex->pEntries = (NAMEINDEXENTRY*) malloc (sizeof (NAMEINDEXENTRY) * (n + 1));
+  pIndex->nEntries = n;
+
+
+  /*  The sections go after all of the names.
+  */
+
+  pSectionOffsets = (uint32_t*) malloc (sizeof (uint32_t) * (nSections + 1));
+  pStr = pIndex->pText + cbNames;
+
+  for (k = 0; k < nSections; k++)
+  {
+    pSectionOffsets [k] = pStr - pIndex->pText;
+    pStr = stpcpy (pStr, pSections [k]) + 1;
+  }
+
+
+  pStr = pIndex->pText;
+  memset (pIndex->Buckets, 0, sizeof (pIndex->Buckets));
+
+  for (i = 0; i < n; i++)
+  {
+    pIndex->pEntries [i].name = pStr - pIndex->pText;
+    pStr = stpcpy (pStr, pResults [i].pPageTitle) + 1;
+
+    for (k = 0; strcmp (pSections [k], pResults [i].pSection) != 0; k++)
+      ;
+
+    pIndex->pEntries [i].section = pSectionOffsets [k];
+
+    pIndex->Buckets [FoldChar (pResults [i].pPageTitle [0]) + 1]++;
+  }
+
+
+  /*  Turn the counts into starting positions.  (The entries are sorted
+  *   by their folded first byte, so each bucket is one run.)
+  */
+
+  for (c = 1; c <= 256; c++)
+  {
+    pIndex->Buckets [c] += pIndex->Buckets [c - 1];
+  }
+
+  BuildTree (pIndex);
+
+
+  free (pSectionOffsets);
+  free (pSections);
+
+  return pIndex;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                FreeIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void FreeIndex
+   (void  *pIndex)
+
+{
+  NAMEINDEX *pNames = (NAMEINDEX*) pIndex;
+
+
+  free (pNames->pText);
+  free (pNames->pEntries);
+  free (pNames->pNodes);
+  free (pNames);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           CompareResults
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Orders by name ignoring case, then by exact name, then by section.
+*   The first key must agree with ComparePrefix() for the binary 
+*   searches in FindNamePrefix() to work.
+*/
+
+static
+int CompareResults
+   (const void  *pLeft,
+    const void  *pRight)
+
+{
+  const APROPOSRESULT *pA = (const APROPOSRESULT*) pLeft;
+  const APROPOSRESULT *pB = (const APROPOSRESULT*) pRight;
+  const unsigned char *p = (const unsigned char*) pA->pPageTitle;
+  const unsigned char *q = (const unsigned char*) pB->pPageTitle;
+  int t;
+
+
+  while ((*p != '\0') && (FoldChar (*p) == FoldChar (*q)))
+  {
+    p++;
+    q++;
+  }
+
+  if ((t = FoldChar (*p) - FoldChar (*q)) != 0)
+    return t;
+
+  if ((t = strcmp (pA->pPageTitle, pB->pPageTitle)) != 0)
+    return t;
+
+  return strcmp (pA->pSection, pB->pSection);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                BuildTree
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Builds the BK-tree, with one node for each run of entries whose 
+*   names are the same apart from case.  Each name goes down from the 
+*   root, following the child at its distance from each node, until
+*   there is no such child; then it becomes one.
+*/
+
+static
+void BuildTree
+   (NAMEINDEX  *pIndex)
+
+{
+  int i, iEnd, iNode, iCurrent, iChild, d;
+  const char *pName;
+  NAMEINDEXNODE *pNodes;
+  NAMEPATTERN pattern;
+
+
+  pNodes = (NAMEINDEXNODE*) malloc (sizeof (NAMEINDEXNODE) * (pIndex->nEntries + 1));
+  pIndex->pNodes = pNodes;
+  pIndex->nNodes = 0;
+
+  for (i = 0; i < pIndex->nEntries; i = iEnd)
+  {
+    pName = pIndex->pText + pIndex->pEntries [i].name;
+
+    for (iEnd = i + 1; 
+         (iEnd < pIndex->nEntries) 
+           && (ComparePrefix (pIndex->pText + pIndex->pEntries [iEnd].name, 
+                              pName, strlen (pName) + 1) == 0); 
+         iEnd++)
+      ;
+
+    PrepareNamePattern (&pattern, pName);
+
+    iNode = pIndex->nNodes++;
+    pNodes [iNode].entry         = i;
+    pNodes [iNode].nEntries      = iEnd - i;
+    pNodes [iNode].iFirstChild   = -1;
+    pNodes [iNode].iNextSibling  = -1;
+    pNodes [iNode].distance      = 0;
+
+    for (iCurrent = 0; iCurrent != iNode; iCurrent = iChild)
+    {
+      d = NameDistance (&pattern, pIndex->pText + pIndex->pEntries [pNodes [iCurrent].entry].name);
+
+      for (iChild = pNodes [iCurrent].iFirstChild; 
+           (iChild >= 0) && (pNodes [iChild].distance != d); 
+           iChild = pNodes [iChild].iNextSibling)
+        ;
+
+      if (iChild < 0)
+      {
+        pNodes [iNode].distance = d;
+        pNodes [iNode].iNextSibling = pNodes [iCurrent].iFirstChild;
+        pNodes [iCurrent].iFirstChild = iNode;
+        break;
+      }
+    }
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       PrepareNamePattern
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void PrepareNamePattern
+   (NAMEPATTERN  *pPattern,
+    const char   *pName)
+
+{
+  int i;
+
+
+  memset (pPattern->Match, 0, sizeof (pPattern->Match));
+
+  pPattern->cb = strnlen (pName, MAX_COMPARED_LENGTH);
+
+  for (i = 0; i < pPattern->cb; i++)
+  {
+    pPattern->Match [FoldChar (pName [i])] |= (uint64_t) 1 << i;
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             NameDistance
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  The Levenshtein distance between a prepared name and another one, 
+*   ignoring ASCII case.  Only the first MAX_COMPARED_LENGTH bytes of 
+*   each are compared, which still satisfies the triangle inequality the
+*   BK-tree depends on, and lets a whole column of the usual dynamic 
+*   programming table fit in two words: Plus and Minus have bit i set 
+*   where row i + 1 is one more or one less than row i.  Each byte of 
+*   pName then takes a few word operations (Myers' algorithm, in 
+*   Hyyro's formulation) instead of a pass down the column.
+*/
+
+static
+int NameDistance
+   (const NAMEPATTERN  *pPattern,
+    const char         *pName)
+
+{
+  int i, cbName, d;
+  uint64_t Plus, Minus, Match, Vertical, Horizontal, PlusH, MinusH, Last;
+
+
+  cbName = strnlen (pName, MAX_COMPARED_LENGTH);
+
+  if (pPattern->cb == 0)
+    return cbName;
+
+  Last = (uint64_t) 1 << (pPattern->cb - 1);
+  Plus = ~(uint64_t) 0;
+  Minus = 0;
+  d = pPattern->cb;
+
+  for (i = 0; i < cbName; i++)
+  {
+    Match = pPattern->Match [FoldChar (pName [i])];
+
+    Vertical = Match | Minus;
+    Horizontal = (((Match & Plus) + Plus) ^ Plus) | Match;
+    PlusH = Minus | ~(Horizontal | Plus);
+    MinusH = Plus & Horizontal;
+
+    if (PlusH & Last)
+      d++;
+    else if (MinusH & Last)
+      d--;
+
+    /*  The top row of the table counts up by one across, so a 1 is 
+    *   shifted in as its horizontal difference.
+    */
+
+    PlusH = (PlusH << 1) | 1;
+    MinusH <<= 1;
+
+    Plus = MinusH | ~(Vertical | PlusH);
+    Minus = PlusH & Vertical;
+  }
+
+  return d;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      CompareSimilarNames
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+int CompareSimilarNames
+   (const void  *pLeft,
+    const void  *pRight)
+
+{
+  const SIMILARNAME *pA = (const SIMILARNAME*) pLeft;
+  const SIMILARNAME *pB = (const SIMILARNAME*) pRight;
+
+
+  if (pA->distance != pB->distance)
+    return pA->distance - pB->distance;
+
+  if (pA->rank != pB->rank)
+    return pA->rank - pB->rank;
+
+  return pA->entry - pB->entry;
+}
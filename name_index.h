@@ -0,0 +1,123 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#ifndef __NAME_INDEX_H_
+#define __NAME_INDEX_H_
+
+
+#include <stdint.h>
+
+
+
+/*  One (name, section) pair.  Both are offsets into the index's text;
+*   each section string is stored only once and shared by all of the 
+*   pages in it.
+*/
+
+struct NAMEINDEXENTRY
+{
+  uint32_t  name;
+  uint32_t  section;
+};
+
+
+
+/*  A node of the BK-tree (Burkhard-Keller tree) used to find names 
+*   close to a misspelled one.  Each node stands for one name, ignoring
+*   case: the run of nEntries entries beginning with entry.  A child's
+*   edit distance from its parent is given by distance, and no two 
+*   children of a node have the same one.
+*/
+
+struct NAMEINDEXNODE
+{
+  uint32_t  entry;
+  uint32_t  nEntries;
+  int32_t   iFirstChild;        /*  -1 if none.  */
+  int32_t   iNextSibling;       /*  -1 if none.  */
+  int32_t   distance;
+};
+
+
+
+/*  An index of every manual page name known to the whatis database,
+*   sorted by name (ignoring ASCII case) and then by section.  The names
+*   are laid out in pText in the same order, so a run of matches is one
+*   contiguous piece of memory.  Buckets [c] is the first entry whose 
+*   name begins with the (lowercased) byte c, and Buckets [256] is 
+*   nEntries.  pNodes [0] is the root of the BK-tree.  An index is 
+*   never changed once it has been built.
+*/
+
+struct NAMEINDEX
+{
+  char            *pText;
+  NAMEINDEXENTRY  *pEntries;
+  int              nEntries;
+  int              Buckets [257];
+  NAMEINDEXNODE   *pNodes;
+  int              nNodes;
+};
+
+
+
+/*  StartNameIndexBuild() builds a new index in the background and puts
+*   it in place of the old one when it is done.  Until the first build 
+*   finishes, AcquireNameIndex() returns NULL.  All of the functions are
+*   thread-safe.
+*/
+
+extern "C"
+{
+extern void StartNameIndexBuild
+    (void);
+
+
+extern const NAMEINDEX* AcquireNameIndex
+    (void);
+
+
+extern void ReleaseNameIndex
+    (const NAMEINDEX  *pIndex);
+
+
+extern int FindNamePrefix
+    (const NAMEINDEX  *pIndex,
+     const char       *pPrefix,
+     int              *piFirstOut);
+
+
+extern int FindSimilarNames
+    (const NAMEINDEX  *pIndex,
+     const char       *pName,
+     const char       *pSection,
+     int              *pEntriesOut,
+     int               nMax);
+}
+
+
+#endif
@@ -0,0 +1,532 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+
+#include <stdlib.h>                    /*  C/C++ RTL headers.  */
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <microhttpd.h>                /*  Library headers.  */
+
+#include "utility.h"                   /*  Application headers.  */
+#include "page_builder.h"
+
+
+
+/*  Static data shorter than this is copied rather than referenced, since
+*   an extra fragment costs more than the copy.
+*/
+
+#define MIN_STATIC_REFERENCE      512
+
+#define CALLBACK_BLOCK_SIZE       (32 * 1024)
+
+
+
+/*  A finished page, as handed to libmicrohttpd.  The cursor speeds up
+*   ReadPageContent(), which is normally called with increasing offsets.
+*/
+
+struct PAGECONTENT
+{
+  PAGEFRAGMENT  *pFragments;
+  int            nFragments;
+  int            iCursor;
+  uint64_t       CursorPos;
+};
+
+
+
+/*  Function prototypes.
+*/
+
+static void AddFragment (PAGEBUILDER*, const char*, int, bool);
+static void SealCurrentFragment (PAGEBUILDER*);
+static void FreePageContent (void*);
+#if MHD_VERSION < 0x00097400
+static ssize_t ReadPageContent (void*, uint64_t, char*, size_t);
+#endif
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          InitPageBuilder
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void InitPageBuilder
+   (PAGEBUILDER  *pPage)
+
+{
+  pPage->pFragments = NULL;
+  pPage->nFragments = 0;
+  pPage->nAllocated = 0;
+  pPage->cbTotal = 0;
+  pPage->iReadFragment = 0;
+  pPage->cbReadOffset = 0;
+
+  InitOutputBuffer (&pPage->current, NULL, 0);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          FreePageBuilder
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void FreePageBuilder
+   (PAGEBUILDER  *pPage)
+
+{
+  int i;
+
+
+  for (i = 0; i < pPage->nFragments; i++)
+  {
+    if (pPage->pFragments [i].fOwned)
+    {
+      free ((void*) pPage->pFragments [i].pData);
+    }
+  }
+
+  free (pPage->pFragments);
+  FreeOutputBuffer (&pPage->current);
+
+  InitPageBuilder (pPage);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               PageAppend
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Copies text into the page.
+*/
+
+void PageAppend
+   (PAGEBUILDER  *pPage,
+    const char   *pData,
+    int           cbData)
+
+{
+  AppendToOutputBuffer (&pPage->current, pData, cbData);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         PageAppendStatic
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Adds text that will outlive the page (string literals, the stylesheet,
+*   embedded scripts) by reference.
+*/
+
+void PageAppendStatic
+   (PAGEBUILDER  *pPage,
+    const char   *pData,
+    int           cbData)
+
+{
+  if (cbData < 0)
+  {
+    cbData = strlen (pData);
+  }
+
+  if (cbData < MIN_STATIC_REFERENCE)
+  {
+    AppendToOutputBuffer (&pPage->current, pData, cbData);
+    return;
+  }
+
+  SealCurrentFragment (pPage);
+  AddFragment (pPage, pData, cbData, false);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               PagePrintf
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void PagePrintf
+   (PAGEBUILDER  *pPage,
+    const char   *pFormat,
+    ...)
+
+{
+  int length, cbFree;
+  OUTPUTBUFFER *pOutput = &pPage->current;
+  va_list args;
+
+
+  ReserveOutputSpace (pOutput, 256);
+  cbFree = pOutput->cbAllocated - pOutput->cbData;
+
+  va_start (args, pFormat);
+  length = vsnprintf (pOutput->pData + pOutput->cbData, cbFree, pFormat, args);
+  va_end (args);
+
+  if (length < 0)
+    return;
+
+  if (length >= cbFree)
+  {
+    if (!ReserveOutputSpace (pOutput, length + 1))
+      return;
+
+    va_start (args, pFormat);
+    vsnprintf (pOutput->pData + pOutput->cbData, length + 1, pFormat, args);
+    va_end (args);
+  }
+
+  pOutput->cbData += length;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      PageGetOutputBuffer
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the buffer that copied text goes into, so that renderers can 
+*   write markup straight into the page.
+*/
+
+OUTPUTBUFFER* PageGetOutputBuffer
+   (PAGEBUILDER  *pPage)
+
+{
+  return &pPage->current;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               PageFinish
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Moves any pending text into the fragment list and computes cbTotal.
+*/
+
+void PageFinish
+   (PAGEBUILDER  *pPage)
+
+{
+  int i;
+
+
+  SealCurrentFragment (pPage);
+
+  pPage->cbTotal = 0;
+  for (i = 0; i < pPage->nFragments; i++)
+  {
+    pPage->cbTotal += pPage->pFragments [i].cbData;
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                 PageRead
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Removes up to cbMax bytes from the beginning of the page and copies
+*   them to pBuffer, for pages that are sent while they are still being
+*   built.  Returns the number of bytes copied.
+*/
+
+int PageRead
+   (PAGEBUILDER  *pPage,
+    char         *pBuffer,
+    int           cbMax)
+
+{
+  int cbChunk, cbOutput = 0;
+  PAGEFRAGMENT *pFragment;
+
+
+  SealCurrentFragment (pPage);
+
+  while ((pPage->iReadFragment < pPage->nFragments) && (cbOutput < cbMax))
+  {
+    pFragment = pPage->pFragments + pPage->iReadFragment;
+
+    cbChunk = pFragment->cbData - pPage->cbReadOffset;
+    if (cbChunk > cbMax - cbOutput)
+    {
+      cbChunk = cbMax - cbOutput;
+    }
+
+    memcpy (pBuffer + cbOutput, pFragment->pData + pPage->cbReadOffset, cbChunk);
+    cbOutput += cbChunk;
+    pPage->cbReadOffset += cbChunk;
+
+    if (pPage->cbReadOffset == pFragment->cbData)
+    {
+      if (pFragment->fOwned)
+      {
+        free ((void*) pFragment->pData);
+        pFragment->fOwned = false;
+      }
+
+      pPage->iReadFragment++;
+      pPage->cbReadOffset = 0;
+    }
+  }
+
+
+  /*  Once everything has been read, reuse the fragment list.
+  */
+
+  if (pPage->iReadFragment == pPage->nFragments)
+  {
+    pPage->nFragments = 0;
+    pPage->iReadFragment = 0;
+  }
+
+  return cbOutput;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       PageCreateResponse
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Creates a libmicrohttpd response for the page.  The response takes
+*   over the page's memory, and the builder is left empty.  Newer
+*   versions of libmicrohttpd send the fragments with writev(); older 
+*   ones get them through a content reader callback.
+*/
+
+struct MHD_Response* PageCreateResponse
+   (PAGEBUILDER  *pPage)
+
+{
+  PAGECONTENT *pContent;
+  struct MHD_Response *pResp;
+
+
+  PageFinish (pPage);
+
+  pContent = (PAGECONTENT*) malloc (sizeof (PAGECONTENT));
+  pContent->pFragments = pPage->pFragments;
+  pContent->nFragments = pPage->nFragments;
+  pContent->iCursor = 0;
+  pContent->CursorPos = 0;
+
+#if MHD_VERSION >= 0x00097400
+
+  int i;
+  struct MHD_IoVec *pIoVec;
+
+
+  pIoVec = (struct MHD_IoVec*) malloc (sizeof (struct MHD_IoVec) 
+                                          * (pContent->nFragments + 1));
+
+  for (i = 0; i < pContent->nFragments; i++)
+  {
+    pIoVec [i].iov_base = pContent->pFragments [i].pData;
+    pIoVec [i].iov_len = pContent->pFragments [i].cbData;
+  }
+
+  pResp = MHD_create_response_from_iovec 
+               (pIoVec, pContent->nFragments, FreePageContent, pContent);
+
+  free (pIoVec);
+
+#else
+
+  pResp = MHD_create_response_from_callback 
+               (pPage->cbTotal, CALLBACK_BLOCK_SIZE, 
+                ReadPageContent, pContent, FreePageContent);
+
+#endif
+
+  if (pResp == NULL)
+  {
+    FreePageContent (pContent);
+  }
+
+  pPage->pFragments = NULL;
+  pPage->nFragments = pPage->nAllocated = 0;
+  FreePageBuilder (pPage);
+
+  return pResp;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              AddFragment
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void AddFragment
+   (PAGEBUILDER  *pPage,
+    const char   *pData,
+    int           cbData,
+    bool          fOwned)
+
+{
+  PAGEFRAGMENT *pFragment;
+
+
+  if (pPage->nFragments == pPage->nAllocated)
+  {
+    pPage->nAllocated = (pPage->nAllocated > 0) ? (pPage->nAllocated * 2) : 16;
+    pPage->pFragments = (PAGEFRAGMENT*) realloc (pPage->pFragments,
+                                                 sizeof (PAGEFRAGMENT) * pPage->nAllocated);
+  }
+
+  pFragment = pPage->pFragments + pPage->nFragments++;
+  pFragment->pData = pData;
+  pFragment->cbData = cbData;
+  pFragment->fOwned = fOwned;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      SealCurrentFragment
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Turns the text copied so far into an owned fragment and starts a new
+*   output buffer.
+*/
+
+static
+void SealCurrentFragment
+   (PAGEBUILDER  *pPage)
+
+{
+  if (pPage->current.cbData == 0)
+    return;
+
+  AddFragment (pPage, pPage->current.pData, pPage->current.cbData, true);
+  InitOutputBuffer (&pPage->current, NULL, 0);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          FreePageContent
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+void FreePageContent
+   (void  *pContext)
+
+{
+  int i;
+  PAGECONTENT *pContent = (PAGECONTENT*) pContext;
+
+
+  for (i = 0; i < pContent->nFragments; i++)
+  {
+    if (pContent->pFragments [i].fOwned)
+    {
+      free ((void*) pContent->pFragments [i].pData);
+    }
+  }
+
+  free (pContent->pFragments);
+  free (pContent);
+}
+
+
+
+#if MHD_VERSION < 0x00097400
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          ReadPageContent
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+ssize_t ReadPageContent
+   (void      *pContext,
+    uint64_t   pos,
+    char      *pBuffer,
+    size_t     cbMax)
+
+{
+  int i, cbChunk;
+  size_t cbOutput = 0;
+  uint64_t FragmentPos, offset;
+  PAGECONTENT *pContent = (PAGECONTENT*) pContext;
+
+
+  /*  Start from the cursor if we can, otherwise from the beginning.
+  */
+
+  if (pos >= pContent->CursorPos)
+  {
+    i = pContent->iCursor;
+    FragmentPos = pContent->CursorPos;
+  }
+  else
+  {
+    i = 0;
+    FragmentPos = 0;
+  }
+
+  while ((i < pContent->nFragments)
+            && (pos >= FragmentPos + pContent->pFragments [i].cbData))
+  {
+    FragmentPos += pContent->pFragments [i++].cbData;
+  }
+
+  pContent->iCursor = i;
+  pContent->CursorPos = FragmentPos;
+
+
+  if (i >= pContent->nFragments)
+    return MHD_CONTENT_READER_END_OF_STREAM;
+
+
+  offset = pos - FragmentPos;
+  for (; (i < pContent->nFragments) && (cbOutput < cbMax); i++)
+  {
+    cbChunk = pContent->pFragments [i].cbData - (int) offset;
+    if ((size_t) cbChunk > cbMax - cbOutput)
+    {
+      cbChunk = cbMax - cbOutput;
+    }
+
+    memcpy (pBuffer + cbOutput, pContent->pFragments [i].pData + offset, cbChunk);
+    cbOutput += cbChunk;
+    offset = 0;
+  }
+
+  return cbOutput;
+}
+
+#endif
@@ -0,0 +1,112 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+
+#ifndef __PAGE_BUILDER_H_
+#define __PAGE_BUILDER_H_
+
+
+#include "utility.h"               /*  For OUTPUTBUFFER type.  */
+
+
+
+/*  A piece of a page under construction.  Fragments with fOwned set
+*   point to heap memory that belongs to the page; the others refer to
+*   static data (stylesheet, scripts, etc.) that is never copied.
+*/
+
+struct PAGEFRAGMENT
+{
+  const char  *pData;
+  int          cbData;
+  bool         fOwned;
+};
+
+
+struct PAGEBUILDER
+{
+  PAGEFRAGMENT  *pFragments;
+  int            nFragments;
+  int            nAllocated;
+  int            cbTotal;
+  int            iReadFragment;      /*  Position of PageRead().  */
+  int            cbReadOffset;
+  OUTPUTBUFFER   current;
+};
+
+
+
+extern "C"
+{
+
+extern void InitPageBuilder
+   (PAGEBUILDER  *pPage);
+
+
+extern void FreePageBuilder
+   (PAGEBUILDER  *pPage);
+
+
+extern void PageAppend
+   (PAGEBUILDER  *pPage,
+    const char   *pData,
+    int           cbData);
+
+
+extern void PageAppendStatic
+   (PAGEBUILDER  *pPage,
+    const char   *pData,
+    int           cbData);
+
+
+extern void PagePrintf
+   (PAGEBUILDER  *pPage,
+    const char   *pFormat,
+    ...)
+    __attribute__ ((format (printf, 2, 3)));
+
+
+extern OUTPUTBUFFER* PageGetOutputBuffer
+   (PAGEBUILDER  *pPage);
+
+
+extern void PageFinish
+   (PAGEBUILDER  *pPage);
+
+
+extern int PageRead
+   (PAGEBUILDER  *pPage,
+    char         *pBuffer,
+    int           cbMax);
+
+
+extern struct MHD_Response* PageCreateResponse
+   (PAGEBUILDER  *pPage);
+
+}
+
+#endif
@@ -0,0 +1,410 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#include <stdlib.h>                    /*  C/C++ RTL headers.  */
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "utility.h"                   /*  Application headers.  */
+#include "html_formatting.h"
+#include "page_builder.h"
+#include "fulltext_index.h"
+#include "info_index.h"
+#include "infotohtml.h"
+#include "searchtohtml.h"
+
+
+
+/*  Function prototypes.
+*/
+
+static void AppendHighlightedText (PAGEBUILDER*, const char*, const char*);
+static void PercentEncode (const char*, char*, int);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      SearchResultsToHTML
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Generates a page of full-text search results, starting with hit 
+*   number offset.  It borrows the apropos page's look, with an excerpt 
+*   from each manual page in place of its description.
+*/
+
+void SearchResultsToHTML
+    (PAGEBUILDER          *pPage,
+     ARENA                *pArena,
+     const char           *pQuery,
+     const char           *pUriPrefix,
+     const char           *pStylesheetUri,
+     const FULLTEXTINDEX  *pIndex,
+     const FULLTEXTHIT    *pHits,
+     int                   nHits,
+     int                   offset)
+
+{
+  int i, iEnd;
+  const FULLTEXTDOC *pDoc;
+  const char *pName, *pSection, *pSnippet;
+  char query [512], name [512], section [128], encoded [768];
+
+
+  HTMLEscapeText (query, sizeof (query), pQuery, -1);
+
+  PagePrintf (pPage,
+              "<!DOCTYPE html>\n\n"
+              "<html>\n"
+              "<head>\n"
+              "<title>Search: %s</title>\n"
+              "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
+              "<base href=\"%s\">\n"
+              "<link rel=\"stylesheet\" href=\"%s\">\n"
+              "</head>\n"
+              "<body Type=\"apropos\">\n",
+              query, 
+              pUriPrefix,
+              pStylesheetUri);
+
+  PagePrintf (pPage, 
+              "<div id=\"NavBar\">\n"
+              "<div id=\"Nav-Apropos-NResults\"><span Label=\"\">Results:</span>%d page%s</div>\n"
+              "</div>\n",
+              nHits, (nHits == 1) ? "" : "s");
+
+
+  PageAppendStatic (pPage, 
+                    "<div id=\"Main\">\n"
+                    "<div id=\"Results\">\n"
+                    "<table class=\"AproposTable\">\n"
+                    "<tr class=\"AproposTableHeader\">"
+                    "<th Column=\"page\">Page</th>"
+                    "<th Column=\"description\">Excerpt</th></tr>\n", -1);
+
+
+  if (offset > nHits)
+  {
+    offset = nHits;
+  }
+
+  iEnd = (nHits - offset > SEARCH_PAGE_SIZE) ? (offset + SEARCH_PAGE_SIZE) : nHits;
+
+  for (i = offset; i < iEnd; i++)
+  {
+    pDoc = pIndex->pDocs + pHits [i].iDoc;
+    pName = pIndex->pBase + pDoc->name;
+    pSection = pIndex->pBase + pDoc->section;
+
+    HTMLEscapeText (name, sizeof (name), pName, -1);
+    HTMLEscapeText (section, sizeof (section), pSection, -1);
+
+    PagePrintf (pPage,
+                "<tr class=\"AproposTableRow\"><td>"
+                "<a href=\"%sman/%s(%s)\" target=\"_blank\" RefType=\"manpage\">%s(%s)</a>"
+                "</td><td>",
+                (strchr (pName, ':') != NULL) ? pUriPrefix : "",
+                name, section, name, section);
+
+    if ((pSnippet = GetSearchSnippet (pIndex, pHits [i].iDoc, pArena, pQuery)) != NULL)
+    {
+      AppendHighlightedText (pPage, pSnippet, pQuery);
+    }
+
+    PageAppendStatic (pPage, "</td></tr>\n", -1);
+  }
+
+  PageAppendStatic (pPage, "</table>\n", -1);
+
+
+  /*  Links to the neighboring pages of results.
+  */
+
+  PercentEncode (pQuery, encoded, sizeof (encoded));
+
+  if (offset > 0)
+  {
+    PagePrintf (pPage, 
+                "<p><a href=\"search?q=%s&amp;offset=%d\">Previous results</a></p>\n",
+                encoded, 
+                (offset > SEARCH_PAGE_SIZE) ? (offset - SEARCH_PAGE_SIZE) : 0);
+  }
+
+  if (iEnd < nHits)
+  {
+    PagePrintf (pPage, 
+                "<p><a href=\"search?q=%s&amp;offset=%d\">More results</a></p>\n",
+                encoded, iEnd);
+  }
+
+
+  PageAppendStatic (pPage, 
+                    "</div>\n"
+                    "</div>\n"
+                    "</body>\n</html>\n", -1);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                  InfoSearchResultsToHTML
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Generates a page of Info index entries, starting with entry number 
+*   offset, each linked to the node it refers to.  An entry may refer to
+*   a node in another manual, as "(manual)node".
+*/
+
+void InfoSearchResultsToHTML
+    (PAGEBUILDER          *pPage,
+     const char           *pQuery,
+     const char           *pUriPrefix,
+     const char           *pStylesheetUri,
+     const INFOINDEX      *pIndex,
+     const int            *pEntries,
+     int                   nEntries,
+     int                   offset)
+
+{
+  int i, iEnd, cbManual;
+  const INFOINDEXENTRY *pEntry;
+  const char *pManual, *pNode, *pClose;
+  char query [512], text [1024], manual [256], node [512], encoded [768];
+  char argument [768];
+
+
+  HTMLEscapeText (query, sizeof (query), pQuery, -1);
+
+  PagePrintf (pPage,
+              "<!DOCTYPE html>\n\n"
+              "<html>\n"
+              "<head>\n"
+              "<title>Info index: %s</title>\n"
+              "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">\n"
+              "<base href=\"%s\">\n"
+              "<link rel=\"stylesheet\" href=\"%s\">\n"
+              "</head>\n"
+              "<body Type=\"apropos\">\n",
+              query, 
+              pUriPrefix,
+              pStylesheetUri);
+
+  PagePrintf (pPage, 
+              "<div id=\"NavBar\">\n"
+              "<div id=\"Nav-Apropos-NResults\"><span Label=\"\">Results:</span>%d entr%s</div>\n"
+              "</div>\n",
+              nEntries, (nEntries == 1) ? "y" : "ies");
+
+
+  PageAppendStatic (pPage, 
+                    "<div id=\"Main\">\n"
+                    "<div id=\"Results\">\n"
+                    "<table class=\"AproposTable\">\n"
+                    "<tr class=\"AproposTableHeader\">"
+                    "<th Column=\"page\">Entry</th>"
+                    "<th Column=\"description\">Node</th></tr>\n", -1);
+
+
+  if (offset > nEntries)
+  {
+    offset = nEntries;
+  }
+
+  iEnd = (nEntries - offset > INFO_SEARCH_PAGE_SIZE) 
+            ? (offset + INFO_SEARCH_PAGE_SIZE) : nEntries;
+
+  for (i = offset; i < iEnd; i++)
+  {
+    pEntry = pIndex->pEntries + pEntries [i];
+    pManual = pIndex->pText + pEntry->manual;
+    pNode = pIndex->pText + pEntry->node;
+    cbManual = strlen (pManual);
+
+    if ((pNode [0] == '(') && ((pClose = strchr (pNode, ')')) != NULL))
+    {
+      pManual = pNode + 1;
+      cbManual = pClose - pManual;
+      pNode = pClose + 1;
+    }
+
+    HTMLEscapeText (text, sizeof (text), pIndex->pText + pEntry->text, -1);
+    HTMLEscapeText (manual, sizeof (manual), pManual, cbManual);
+    HTMLEscapeText (node, sizeof (node), pNode, -1);
+
+    if (EncodeInfoNodeNameInto (encoded, sizeof (encoded), pNode, -1) < 0)
+    {
+      strcpy (encoded, "Top");
+    }
+
+    PagePrintf (pPage,
+                "<tr class=\"AproposTableRow\"><td>%s</td><td>"
+                "<a href=\"info/%s/%s\" target=\"_blank\" RefType=\"info\">(%s)%s</a>",
+                text, manual, encoded, manual, node);
+
+    if (pEntry->line > 0)
+    {
+      PagePrintf (pPage, " (line %u)", pEntry->line);
+    }
+
+    PageAppendStatic (pPage, "</td></tr>\n", -1);
+  }
+
+  PageAppendStatic (pPage, "</table>\n", -1);
+
+
+  /*  Links to the neighboring pages of results.
+  */
+
+  PercentEncode (pQuery, argument, sizeof (argument));
+
+  if (offset > 0)
+  {
+    PagePrintf (pPage, 
+                "<p><a href=\"info-search?q=%s&amp;offset=%d\">Previous results</a></p>\n",
+                argument, 
+                (offset > INFO_SEARCH_PAGE_SIZE) ? (offset - INFO_SEARCH_PAGE_SIZE) : 0);
+  }
+
+  if (iEnd < nEntries)
+  {
+    PagePrintf (pPage, 
+                "<p><a href=\"info-search?q=%s&amp;offset=%d\">More results</a></p>\n",
+                argument, iEnd);
+  }
+
+
+  PageAppendStatic (pPage, 
+                    "</div>\n"
+                    "</div>\n"
+                    "</body>\n</html>\n", -1);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                    AppendHighlightedText
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Writes an excerpt with the words of the query in bold.  Words are 
+*   matched the way the index matches them (whole words, ignoring ASCII
+*   case).
+*/
+
+static
+void AppendHighlightedText
+   (PAGEBUILDER  *pPage,
+    const char   *pText,
+    const char   *pQuery)
+
+{
+  int i, k, cbText, cbQuery, cbWord, iWord, cbTerm, iTerm, iCopied = 0;
+  bool fMatch;
+  char buffer [2048];
+
+
+  cbText = strlen (pText);
+  cbQuery = strlen (pQuery);
+
+  for (i = 0; i < cbText; i += iWord + cbWord)
+  {
+    if ((cbWord = NextSearchToken (pText + i, cbText - i, &iWord)) == 0)
+      break;
+
+    fMatch = false;
+
+    for (k = 0; !fMatch && (k < cbQuery); k += iTerm + cbTerm)
+    {
+      if ((cbTerm = NextSearchToken (pQuery + k, cbQuery - k, &iTerm)) == 0)
+        break;
+
+      fMatch = (cbTerm == cbWord) 
+                 && (strncasecmp (pQuery + k + iTerm, pText + i + iWord, cbWord) == 0);
+    }
+
+    if (!fMatch)
+      continue;
+
+
+    HTMLEscapeText (buffer, sizeof (buffer), pText + iCopied, i + iWord - iCopied);
+    PageAppend (pPage, buffer, -1);
+
+    HTMLEscapeText (buffer, sizeof (buffer), pText + i + iWord, cbWord);
+    PagePrintf (pPage, "<b>%s</b>", buffer);
+
+    iCopied = i + iWord + cbWord;
+  }
+
+  HTMLEscapeText (buffer, sizeof (buffer), pText + iCopied, cbText - iCopied);
+  PageAppend (pPage, buffer, -1);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            PercentEncode
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Encodes a string for use as a URL query argument.  The result is 
+*   truncated (at a character boundary) if it doesn't fit.
+*/
+
+static
+void PercentEncode
+   (const char  *pStr,
+    char        *pDest,
+    int          cbMax)
+
+{
+  int j = 0;
+  unsigned char c;
+
+  static const char HexDigits [] = "0123456789ABCDEF";
+
+
+  for (; (c = *pStr) != '\0'; pStr++)
+  {
+    if (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'))
+          || ((c >= '0') && (c <= '9')) || (strchr ("-_.~", c) != NULL))
+    {
+      if (j + 1 >= cbMax)
+        break;
+
+      pDest [j++] = c;
+    }
+    else
+    {
+      if (j + 3 >= cbMax)
+        break;
+
+      pDest [j++] = '%';
+      pDest [j++] = HexDigits [c >> 4];
+      pDest [j++] = HexDigits [c & 15];
+    }
+  }
+
+  pDest [j] = '\0';
+}
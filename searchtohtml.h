@@ -0,0 +1,79 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#ifndef __SEARCHTOHTML_H_
+#define __SEARCHTOHTML_H_
+
+
+#include "fulltext_index.h"        /*  For FULLTEXTINDEX, FULLTEXTHIT types.  */
+#include "info_index.h"            /*  For INFOINDEX type.  */
+#include "page_builder.h"          /*  For PAGEBUILDER type.  */
+#include "arena.h"                 /*  For ARENA type.  */
+
+
+
+/*  The number of full-text search results shown on one page.  Each one
+*   needs its manual page rendered for the excerpt, so this is small.
+*   Info index entries cost nothing to show.
+*/
+
+enum
+{
+  SEARCH_PAGE_SIZE       = 10,
+  INFO_SEARCH_PAGE_SIZE  = 100
+};
+
+
+
+extern "C"
+{
+
+extern void SearchResultsToHTML
+    (PAGEBUILDER          *pPage,
+     ARENA                *pArena,
+     const char           *pQuery,
+     const char           *pUriPrefix,
+     const char           *pStylesheetUri,
+     const FULLTEXTINDEX  *pIndex,
+     const FULLTEXTHIT    *pHits,
+     int                   nHits,
+     int                   offset);
+
+
+extern void InfoSearchResultsToHTML
+    (PAGEBUILDER          *pPage,
+     const char           *pQuery,
+     const char           *pUriPrefix,
+     const char           *pStylesheetUri,
+     const INFOINDEX      *pIndex,
+     const int            *pEntries,
+     int                   nEntries,
+     int                   offset);
+
+}
+
+#endif
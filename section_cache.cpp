@@ -0,0 +1,200 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#include <stdlib.h>                    /*  C/C++ RTL headers.  */
+#include <string.h>
+#include <pthread.h>
+
+#include "utility.h"                   /*  Application headers.  */
+#include "html_formatting.h"
+#include "page_builder.h"
+#include "manualpagetohtml.h"
+#include "section_cache.h"
+
+
+
+#define MAX_CACHED_PAGES     32
+
+
+
+/*  Entries are kept in order of use, most recent first.
+*/
+
+struct SECTIONCACHEENTRY
+{
+  SECTIONCACHEENTRY  *pNext;
+  char               *pPageID;
+  MANPAGESECTIONS    *pSections;
+};
+
+
+
+static SECTIONCACHEENTRY *pFirstEntry = NULL;
+static int nEntries = 0;
+static pthread_mutex_t CacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/*  Function prototypes.
+*/
+
+static SECTIONCACHEENTRY* FindEntry (const char*);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                  CacheManualPageSections
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Adds a page's deferred sections to the cache, replacing any that are
+*   already there for the same page.  The cache takes ownership of
+*   pSections; a page with no deferred sections (or a NULL pSections) 
+*   is not cached.  The least recently used page is dropped once the 
+*   cache is full.
+*/
+
+void CacheManualPageSections
+    (const char       *pPageID,
+     MANPAGESECTIONS  *pSections)
+
+{
+  SECTIONCACHEENTRY *pEntry, **ppLink;
+
+
+  if ((pSections == NULL) || (pSections->nSections == 0))
+  {
+    FreeManualPageSections (pSections);
+    return;
+  }
+
+
+  pthread_mutex_lock (&CacheLock);
+
+  if ((pEntry = FindEntry (pPageID)) != NULL)
+  {
+    FreeManualPageSections (pEntry->pSections);
+    pEntry->pSections = pSections;
+    pthread_mutex_unlock (&CacheLock);
+    return;
+  }
+
+
+  if (nEntries >= MAX_CACHED_PAGES)
+  {
+    for (ppLink = &pFirstEntry; (*ppLink)->pNext != NULL; ppLink = &(*ppLink)->pNext)
+      ;
+
+    pEntry = *ppLink;
+    *ppLink = NULL;
+    nEntries--;
+
+    FreeManualPageSections (pEntry->pSections);
+    free (pEntry->pPageID);
+    free (pEntry);
+  }
+
+
+  pEntry = (SECTIONCACHEENTRY*) malloc (sizeof (SECTIONCACHEENTRY));
+  pEntry->pPageID    = strdup (pPageID);
+  pEntry->pSections  = pSections;
+  pEntry->pNext      = pFirstEntry;
+
+  pFirstEntry = pEntry;
+  nEntries++;
+
+  pthread_mutex_unlock (&CacheLock);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                               GetCachedManualPageSection
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Looks up the body of section iSection of the given page.  Returns 
+*   false if the page is not in the cache.  Otherwise *pfFound tells
+*   whether the page has such a deferred section, and if so, *ppData
+*   receives a copy of it, which the caller must free.
+*/
+
+bool GetCachedManualPageSection
+    (const char  *pPageID,
+     int          iSection,
+     bool        *pfFound,
+     char       **ppData,
+     int         *pcbData)
+
+{
+  SECTIONCACHEENTRY *pEntry;
+
+
+  pthread_mutex_lock (&CacheLock);
+
+  if ((pEntry = FindEntry (pPageID)) == NULL)
+  {
+    pthread_mutex_unlock (&CacheLock);
+    return false;
+  }
+
+  *pfFound = CopyManualPageSection (pEntry->pSections, iSection, 
+                                    ppData, pcbData);
+
+  pthread_mutex_unlock (&CacheLock);
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                FindEntry
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Finds a page's entry and moves it to the front of the list.  The 
+*   caller must hold CacheLock.
+*/
+
+static
+SECTIONCACHEENTRY* FindEntry
+   (const char  *pPageID)
+
+{
+  SECTIONCACHEENTRY *pEntry, **ppLink;
+
+
+  for (ppLink = &pFirstEntry; (pEntry = *ppLink) != NULL; ppLink = &pEntry->pNext)
+  {
+    if (strcmp (pEntry->pPageID, pPageID) == 0)
+    {
+      *ppLink = pEntry->pNext;
+      pEntry->pNext = pFirstEntry;
+      pFirstEntry = pEntry;
+      return pEntry;
+    }
+  }
+
+  return NULL;
+}
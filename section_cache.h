@@ -0,0 +1,58 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+  manhttp 
+
+  An HTTP server that provides a web-based, hypertext-driven
+  frontend for man(1), info(1), and apropos(1).  MANHTTP lets you
+  browse and search your system's online documentation using a web
+  browser.
+
+~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~
+
+  Copyright 2019 Jonathan Stewart
+  
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+      http://www.apache.org/licenses/LICENSE-2.0
+  
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#ifndef __SECTION_CACHE_H_
+#define __SECTION_CACHE_H_
+
+
+#include "manualpagetohtml.h"      /*  For MANPAGESECTIONS type.  */
+
+
+
+/*  A small cache of the deferred sections of recently-sent manual 
+*   pages, so that expanding a section doesn't mean running man(1) 
+*   again.  Pages are identified by their canonical IDs.  All of the 
+*   functions are thread-safe.
+*/
+
+extern "C"
+{
+extern void CacheManualPageSections
+    (const char       *pPageID,
+     MANPAGESECTIONS  *pSections);
+
+
+extern bool GetCachedManualPageSection
+    (const char  *pPageID,
+     int          iSection,
+     bool        *pfFound,
+     char       **ppData,
+     int         *pcbData);
+}
+
+
+#endif
@@ -0,0 +1,480 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+
+  hyperlink_check compares RecognizeHyperlinks() against the TRE
+  regular expressions that it replaced.  Each input is scanned by both
+  implementations, starting from the same attributes, and the link
+  counts and resulting attributes must match exactly.
+
+  The inputs are the files named on the command line (each one is
+  scanned whole, first with clean attributes and then with random
+  appearance and Info link bits) followed by a number of random
+  strings built from URI and page reference fragments:
+
+    hyperlink_check [-n count] [-s seed] [file ...]
+
+  It is built and run by "make check".  The exit status is 0 if every
+  input matched and 1 otherwise.
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <tre/tre.h>
+
+#include "../utility.h"
+#include "../html_formatting.h"
+
+
+
+#define DEFAULT_RANDOM_INPUTS      200000
+#define MAX_RANDOM_LENGTH          500
+#define MAX_RANDOM_FRAGMENTS       30
+
+
+
+static regex_t UriRegex, PageRefRegex;
+
+
+
+/*  Function prototypes.
+*/
+
+static void InitializeReferenceRegexes (void);
+static int ReferenceRecognizeURIs (const char*, int, TEXTATTRIBUTES*);
+static int ReferenceRecognizeManPageRefs (const char*, int, TEXTATTRIBUTES*);
+static bool CheckText (const char*, int, const TEXTATTRIBUTES*, const char*);
+static void RandomizeAttributes (TEXTATTRIBUTES*, int);
+static int CreateRandomText (char*);
+static char* ReadFile (const char*, int*);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                     main
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+int main
+   (int     argc,
+    char  **argv)
+
+{
+  int i, n, length, nInputs, nFiles, nFailures;
+  unsigned int seed;
+  char *pText, RandomText [MAX_RANDOM_LENGTH + 1];
+  TEXTATTRIBUTES *pAttrs, RandomAttrs [MAX_RANDOM_LENGTH];
+
+
+  nInputs = DEFAULT_RANDOM_INPUTS;
+  seed = 1;
+
+  for (i = 1; (i + 1 < argc) && (argv [i][0] == '-'); i += 2)
+  {
+    if (strcmp (argv [i], "-n") == 0)
+    {
+      nInputs = atoi (argv [i + 1]);
+    }
+    else if (strcmp (argv [i], "-s") == 0)
+    {
+      seed = strtoul (argv [i + 1], NULL, 10);
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  InitializeReferenceRegexes ();
+  srand (seed);
+  nFiles = nFailures = 0;
+
+
+  /*  The corpus files.
+  */
+
+  for (; i < argc; i++, nFiles++)
+  {
+    pText = ReadFile (argv [i], &length);
+    if (pText == NULL)
+    {
+      fprintf (stderr, "hyperlink_check: Unable to read %s.\n", argv [i]);
+      return 1;
+    }
+
+    pAttrs = (TEXTATTRIBUTES*) calloc (length + 1, sizeof (TEXTATTRIBUTES));
+
+    if (!CheckText (pText, length, pAttrs, argv [i]))
+    {
+      nFailures++;
+    }
+
+    RandomizeAttributes (pAttrs, length);
+
+    if (!CheckText (pText, length, pAttrs, argv [i]))
+    {
+      nFailures++;
+    }
+
+    free (pAttrs);
+    free (pText);
+  }
+
+
+  /*  Random inputs.
+  */
+
+  for (n = 0; (n < nInputs) && (nFailures < 10); n++)
+  {
+    length = CreateRandomText (RandomText);
+    RandomizeAttributes (RandomAttrs, length);
+
+    if (!CheckText (RandomText, length, RandomAttrs, "random input"))
+    {
+      nFailures++;
+    }
+  }
+
+
+  if (nFailures > 0)
+  {
+    printf ("hyperlink_check: %d mismatches (seed %u).\n", nFailures, seed);
+    return 1;
+  }
+
+  printf ("hyperlink_check: %d corpus files and %d random inputs match.\n",
+          nFiles, nInputs);
+  return 0;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                               InitializeReferenceRegexes
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  These are the expressions that htmlInitializeRegexes() compiled
+*   before the hand-written scanner replaced them.
+*/
+
+static void InitializeReferenceRegexes
+   (void)
+
+{
+  int error;
+
+
+  error = tre_regcomp
+              (&UriRegex,
+               "\\b(https?|ftp)://[-A-Z0-9+&@#/%?=~_|!:,.;]*[A-Z0-9+&@#/%=~_|]",
+               REG_EXTENDED | REG_ICASE);
+
+  if (error != 0)
+  {
+    fprintf (stderr, "FATAL ERROR: tre_regcomp() failed for UriRegex.  (Error %d)\n",
+             error);
+    exit (100);
+  }
+
+
+  error = tre_regcomp
+              (&PageRefRegex,
+               "[a-z0-9.+_:-]{1,32}\\([0-9]{1,3}[a-z]{0,4}\\)",
+               REG_EXTENDED | REG_ICASE);
+
+  if (error != 0)
+  {
+    fprintf (stderr, "FATAL ERROR: tre_regcomp() failed for PageRefRegex.  (Error %d)\n",
+             error);
+    exit (100);
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                   ReferenceRecognizeURIs
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static int ReferenceRecognizeURIs
+   (const char      *pText,
+    int              length,
+    TEXTATTRIBUTES  *pAttrs)
+
+{
+  int i, index, iStart, iEnd, count;
+  regmatch_t match;
+
+
+  index = count = 0;
+  while ((index < length)
+            && !tre_regnexec (&UriRegex, pText + index, length - index, 1, &match, 0))
+  {
+    iStart = index + match.rm_so;
+    iEnd = index + match.rm_eo;
+
+    for (i = iStart; i < iEnd; i++)
+    {
+      pAttrs [i] = (pAttrs [i] & ~TEXT_ATTR_APPEARANCE_MASK)
+                      | TEXT_ATTR_URI;
+    }
+
+    count++;
+    index = iEnd;
+  }
+
+  return count;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                            ReferenceRecognizeManPageRefs
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static int ReferenceRecognizeManPageRefs
+   (const char      *pText,
+    int              length,
+    TEXTATTRIBUTES  *pAttrs)
+
+{
+  int i, index, iStart, iEnd, count;
+  bool fValidLink;
+  regmatch_t match;
+
+
+  index = count = 0;
+  while ((index < length)
+            && !tre_regnexec (&PageRefRegex, pText + index, length - index, 1, &match, 0))
+  {
+    iStart = index + match.rm_so;
+    iEnd = index + match.rm_eo;
+
+    fValidLink = true;
+    for (i = iStart; i < iEnd; i++)
+    {
+      if (pAttrs [i] & (TEXT_ATTR_URI | TEXT_ATTR_INFO_LINK))
+      {
+        fValidLink = false;
+        break;
+      }
+    }
+
+    if (fValidLink)
+    {
+      for (i = iStart; i < iEnd; i++)
+      {
+        pAttrs [i] = (pAttrs [i] & ~TEXT_ATTR_APPEARANCE_MASK)
+                        | TEXT_ATTR_MAN_PAGE_REF;
+      }
+      count++;
+    }
+
+    index = iEnd;
+  }
+
+  return count;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                CheckText
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Runs both implementations over a copy of pInitialAttrs and reports
+*   the first position where they disagree.
+*/
+
+static bool CheckText
+   (const char            *pText,
+    int                    length,
+    const TEXTATTRIBUTES  *pInitialAttrs,
+    const char            *pLabel)
+
+{
+  int i, nExpected, nActual;
+  bool fMatch;
+  TEXTATTRIBUTES *pExpected, *pActual;
+
+
+  pExpected = (TEXTATTRIBUTES*) malloc ((length + 1) * sizeof (TEXTATTRIBUTES));
+  pActual = (TEXTATTRIBUTES*) malloc ((length + 1) * sizeof (TEXTATTRIBUTES));
+
+  memcpy (pExpected, pInitialAttrs, length * sizeof (TEXTATTRIBUTES));
+  memcpy (pActual, pInitialAttrs, length * sizeof (TEXTATTRIBUTES));
+
+  nExpected = ReferenceRecognizeURIs (pText, length, pExpected);
+  nExpected += ReferenceRecognizeManPageRefs (pText, length, pExpected);
+
+  nActual = RecognizeHyperlinks (pText, length, pActual,
+                                 TEXT_ATTR_URI | TEXT_ATTR_MAN_PAGE_REF);
+
+  fMatch = (nExpected == nActual)
+              && (memcmp (pExpected, pActual, length * sizeof (TEXTATTRIBUTES)) == 0);
+
+  if (!fMatch)
+  {
+    for (i = 0; (i < length) && (pExpected [i] == pActual [i]); i++)
+      ;
+
+    printf ("MISMATCH in %s: %d links expected, %d found; "
+            "attributes differ at offset %d:\n  %.*s\n",
+            pLabel, nExpected, nActual, i,
+            (length - i < 80) ? length - i : 80, pText + i);
+  }
+
+  free (pActual);
+  free (pExpected);
+
+  return fMatch;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      RandomizeAttributes
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Sprinkles bold, italic and (occasionally) Info link bits over the
+*   attributes, so that the overlap rule for page references and the
+*   clearing of the appearance bits are exercised.
+*/
+
+static void RandomizeAttributes
+   (TEXTATTRIBUTES  *pAttrs,
+    int              length)
+
+{
+  int i;
+
+
+  for (i = 0; i < length; i++)
+  {
+    switch (rand () % 32)
+    {
+      case 0 ... 3:
+        pAttrs [i] = TEXT_ATTR_BOLD;
+        break;
+
+      case 4 ... 7:
+        pAttrs [i] = TEXT_ATTR_ITALIC;
+        break;
+
+      case 8:
+        pAttrs [i] = TEXT_ATTR_INFO_LINK;
+        break;
+
+      default:
+        pAttrs [i] = 0;
+        break;
+    }
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         CreateRandomText
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Fills pBuffer (MAX_RANDOM_LENGTH + 1 bytes) with either a string of
+*   fragments that tend to form URIs and page references, or a short run
+*   of characters drawn from a small alphabet.  Returns the length.
+*/
+
+static int CreateRandomText
+   (char  *pBuffer)
+
+{
+  int i, length, cbFragment, nFragments;
+  const char *pFragment;
+
+  static const char *Fragments [] =
+          {
+            "http://", "https://", "ftp://", "HTTP://", "Ftp://", "ls(1)",
+            "printf(3)", "(3pm)", "(12345)", "(1x)", "foo", "bar.baz", "a-b",
+            "_x", ":", "(", ")", " ", "\n", ".", ",", "x", "1", "9", "/", "#",
+            "%", "~", "|", "!", "?", "=", "&", "@", "+", ";", "\xc3\xa9", "\t",
+            "(7abcde)", "(7abcd)", "(42)", "ahttp://x", "http://a.b/c,",
+            "see man(1).", "abcdefghijklmnopqrstuvwxyz0123456"
+          };
+
+  static const char ExtraChars [] = "abcAZ09._-:(/)h ",
+                    Alphabet [] = "abhtp:/(1)x.-3 fHT";
+
+
+  length = 0;
+
+  if (rand () % 3 == 0)
+  {
+    length = rand () % 60;
+    for (i = 0; i < length; i++)
+    {
+      pBuffer [i] = Alphabet [rand () % (sizeof (Alphabet) - 1)];
+    }
+  }
+  else
+  {
+    nFragments = rand () % MAX_RANDOM_FRAGMENTS;
+    while (nFragments-- > 0)
+    {
+      pFragment = Fragments [rand () % (sizeof (Fragments) / sizeof (Fragments [0]))];
+      cbFragment = strlen (pFragment);
+      if (length + cbFragment >= MAX_RANDOM_LENGTH)
+      {
+        break;
+      }
+
+      memcpy (pBuffer + length, pFragment, cbFragment);
+      length += cbFragment;
+
+      if ((rand () % 4 == 0) && (length < MAX_RANDOM_LENGTH))
+      {
+        pBuffer [length++] = ExtraChars [rand () % (sizeof (ExtraChars) - 1)];
+      }
+    }
+  }
+
+  pBuffer [length] = '\0';
+  return length;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                 ReadFile
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static char* ReadFile
+   (const char  *pFilename,
+    int         *pLength)
+
+{
+  int length, cbRead;
+  char *pText;
+  FILE *pFile;
+
+
+  pFile = fopen (pFilename, "rb");
+  if (pFile == NULL)
+  {
+    return NULL;
+  }
+
+  length = 0;
+  pText = (char*) malloc (65536);
+
+  while ((cbRead = fread (pText + length, 1, 65535, pFile)) > 0)
+  {
+    length += cbRead;
+    pText = (char*) realloc (pText, length + 65536);
+  }
+
+  fclose (pFile);
+
+  pText [length] = '\0';
+  *pLength = length;
+
+  return pText;
+}
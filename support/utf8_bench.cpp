@@ -0,0 +1,604 @@
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+
+  utf8_bench times CountCharsUTF8(), EllipsizeString(), NormalizeSpaces()
+  and JSEscapeString() against the byte-at-a-time versions that they
+  replaced, which are copied here unchanged.  Each file named on the
+  command line is run through every function twice: line by line, as
+  the page generators call them, and as one string.  Every timing is
+  the best of several runs, each of which goes over at least
+  MIN_BYTES_PER_RUN bytes of text:
+
+    utf8_bench [-r runs] file ...
+
+  It is built and run by "make bench", which uses the files listed in
+  BENCH_FILES.  Rendered manual pages and uncompressed Info files give
+  the most telling numbers.  Throughput is reported in MB/s.
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+#include "../utility.h"
+
+
+
+#define DEFAULT_RUNS             7
+#define MIN_BYTES_PER_RUN        (8 << 20)
+#define LINE_DEST_SIZE           (64 << 10)
+#define ELLIPSIS_MAX_BYTES       64
+#define ELLIPSIS_MAX_CHARS       24
+
+
+
+/*  A corpus file, whole and split into lines.  pLines is a copy of the
+*   text with every newline replaced by a NUL.  pDest is big enough for
+*   the escaped form of the whole text.
+*/
+
+struct CORPUS
+{
+  char   *pText;
+  int     cbText;
+  char   *pLines;
+  int    *pStarts;
+  int    *pLengths;
+  int     nLines;
+  char   *pDest;
+  int     cbDest;
+};
+
+
+enum BENCHMARK { BENCH_COUNT, BENCH_ELLIPSIZE, BENCH_NORMALIZE, BENCH_ESCAPE, N_BENCHMARKS };
+
+static const char *BenchmarkNames [N_BENCHMARKS] =
+  {"CountCharsUTF8", "EllipsizeString", "NormalizeSpaces", "JSEscapeString"};
+
+
+/*  Keeps the compiler from dropping calls whose results aren't used.  */
+static volatile long Sink;
+
+
+
+/*  Function prototypes.
+*/
+
+static bool LoadCorpus (const char*, CORPUS*);
+static void FreeCorpus (CORPUS*);
+static double TimeBenchmark (const CORPUS*, BENCHMARK, bool, bool, int);
+static long RunLines (const CORPUS*, BENCHMARK, bool);
+static long RunWhole (const CORPUS*, BENCHMARK, bool);
+static double Now (void);
+static bool ReferenceEllipsizeString (const char*, char*, int, int);
+static int ReferenceNormalizeSpaces (const char*, char*, int);
+static bool ReferenceJSEscapeString (const char*, char*, int);
+static int ReferenceCountCharsUTF8 (const char*, int);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                     main
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+int main
+   (int     argc,
+    char  **argv)
+
+{
+  int i, b, nRuns;
+  double OldLines, NewLines, OldWhole, NewWhole;
+  CORPUS corpus;
+
+
+  nRuns = DEFAULT_RUNS;
+  i = 1;
+
+  if ((argc > 2) && (strcmp (argv [1], "-r") == 0))
+  {
+    nRuns = atoi (argv [2]);
+    i = 3;
+  }
+
+  if ((i == argc) || (nRuns < 1))
+  {
+    fprintf (stderr, "Usage: utf8_bench [-r runs] file ...\n");
+    return 1;
+  }
+
+
+  for (; i < argc; i++)
+  {
+    if (!LoadCorpus (argv [i], &corpus))
+    {
+      fprintf (stderr, "utf8_bench: Unable to read %s.\n", argv [i]);
+      return 1;
+    }
+
+    printf ("%s: %d lines, %d bytes, best of %d runs, MB/s\n"
+            "                       line by line                whole text\n"
+            "                      old      new             old      new\n",
+            argv [i], corpus.nLines, corpus.cbText, nRuns);
+
+    for (b = 0; b < N_BENCHMARKS; b++)
+    {
+      OldLines = TimeBenchmark (&corpus, (BENCHMARK) b, true, true, nRuns);
+      NewLines = TimeBenchmark (&corpus, (BENCHMARK) b, true, false, nRuns);
+      OldWhole = TimeBenchmark (&corpus, (BENCHMARK) b, false, true, nRuns);
+      NewWhole = TimeBenchmark (&corpus, (BENCHMARK) b, false, false, nRuns);
+
+      printf ("  %-16s %8.0f %8.0f %6.2fx   %8.0f %8.0f %6.2fx\n",
+              BenchmarkNames [b],
+              OldLines, NewLines, NewLines / OldLines,
+              OldWhole, NewWhole, NewWhole / OldWhole);
+    }
+
+    printf ("\n");
+    FreeCorpus (&corpus);
+  }
+
+  return 0;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               LoadCorpus
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static bool LoadCorpus
+   (const char  *pPath,
+    CORPUS      *pCorpus)
+
+{
+  int i;
+  char *pError, *pLine, *pEnd;
+
+
+  memset (pCorpus, 0, sizeof (CORPUS));
+
+  if (!LoadFile (pPath, &pCorpus->pText, &pCorpus->cbText, &pError))
+  {
+    free (pError);
+    return false;
+  }
+
+
+  pCorpus->pLines = (char*) malloc (pCorpus->cbText + 1);
+  memcpy (pCorpus->pLines, pCorpus->pText, pCorpus->cbText + 1);
+
+  pCorpus->pStarts = (int*) malloc (sizeof (int) * (pCorpus->cbText + 1));
+  pCorpus->pLengths = (int*) malloc (sizeof (int) * (pCorpus->cbText + 1));
+
+  for (pLine = pCorpus->pLines, i = 0; *pLine != '\0'; i++)
+  {
+    if ((pEnd = strchr (pLine, '\n')) == NULL)
+    {
+      pEnd = pLine + strlen (pLine);
+    }
+
+    pCorpus->pStarts [i] = pLine - pCorpus->pLines;
+    pCorpus->pLengths [i] = pEnd - pLine;
+
+    pLine = pEnd + (*pEnd == '\n');
+    *pEnd = '\0';
+  }
+
+  pCorpus->nLines = i;
+
+
+  /*  Every byte can become a six-byte \u escape.  */
+  pCorpus->cbDest = 6 * pCorpus->cbText + LINE_DEST_SIZE;
+  pCorpus->pDest = (char*) malloc (pCorpus->cbDest);
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               FreeCorpus
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static void FreeCorpus
+   (CORPUS  *pCorpus)
+
+{
+  free (pCorpus->pText);
+  free (pCorpus->pLines);
+  free (pCorpus->pStarts);
+  free (pCorpus->pLengths);
+  free (pCorpus->pDest);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            TimeBenchmark
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the best throughput, in MB/s, of nRuns runs.  A small file
+*   is gone over as many times per run as it takes to reach
+*   MIN_BYTES_PER_RUN, so that the clock's resolution doesn't matter.
+*/
+
+static double TimeBenchmark
+   (const CORPUS  *pCorpus,
+    BENCHMARK      benchmark,
+    bool           fByLine,
+    bool           fReference,
+    int            nRuns)
+
+{
+  int i, r, nPasses;
+  long sum = 0;
+  double start, elapsed, best = 0.0;
+
+
+  nPasses = (pCorpus->cbText > 0) ? (MIN_BYTES_PER_RUN / pCorpus->cbText + 1) : 1;
+
+  for (r = 0; r < nRuns; r++)
+  {
+    start = Now ();
+
+    for (i = 0; i < nPasses; i++)
+    {
+      sum += fByLine
+               ? RunLines (pCorpus, benchmark, fReference)
+               : RunWhole (pCorpus, benchmark, fReference);
+    }
+
+    elapsed = Now () - start;
+
+    if ((r == 0) || (elapsed < best))
+    {
+      best = elapsed;
+    }
+  }
+
+  Sink = sum;
+
+  return (best > 0.0) ? ((double) pCorpus->cbText * nPasses / best / 1e6) : 0.0;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                 RunLines
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static long RunLines
+   (const CORPUS  *pCorpus,
+    BENCHMARK      benchmark,
+    bool           fReference)
+
+{
+  int i;
+  long sum = 0;
+  const char *pLine;
+  char *pDest = pCorpus->pDest;
+
+
+  for (i = 0; i < pCorpus->nLines; i++)
+  {
+    pLine = pCorpus->pLines + pCorpus->pStarts [i];
+
+    switch (benchmark)
+    {
+      case BENCH_COUNT:
+        sum += fReference
+                 ? ReferenceCountCharsUTF8 (pLine, pCorpus->pLengths [i])
+                 : CountCharsUTF8 (pLine, pCorpus->pLengths [i]);
+        break;
+
+      case BENCH_ELLIPSIZE:
+        sum += fReference
+                 ? ReferenceEllipsizeString (pLine, pDest, ELLIPSIS_MAX_BYTES, ELLIPSIS_MAX_CHARS)
+                 : EllipsizeString (pLine, pDest, ELLIPSIS_MAX_BYTES, ELLIPSIS_MAX_CHARS);
+        break;
+
+      case BENCH_NORMALIZE:
+        sum += fReference
+                 ? ReferenceNormalizeSpaces (pLine, pDest, LINE_DEST_SIZE)
+                 : NormalizeSpaces (pLine, pDest, LINE_DEST_SIZE);
+        break;
+
+      default:
+        sum += fReference
+                 ? ReferenceJSEscapeString (pLine, pDest, LINE_DEST_SIZE)
+                 : JSEscapeString (pLine, pDest, LINE_DEST_SIZE);
+        break;
+    }
+  }
+
+  return sum;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                 RunWhole
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  EllipsizeString() is given no character limit, so that it scans the
+*   whole text and copies it.
+*/
+
+static long RunWhole
+   (const CORPUS  *pCorpus,
+    BENCHMARK      benchmark,
+    bool           fReference)
+
+{
+  const char *pText = pCorpus->pText;
+  char *pDest = pCorpus->pDest;
+  int cbDest = pCorpus->cbDest;
+
+
+  switch (benchmark)
+  {
+    case BENCH_COUNT:
+      return fReference
+               ? ReferenceCountCharsUTF8 (pText, pCorpus->cbText)
+               : CountCharsUTF8 (pText, pCorpus->cbText);
+
+    case BENCH_ELLIPSIZE:
+      return fReference
+               ? ReferenceEllipsizeString (pText, pDest, cbDest, INT_MAX)
+               : EllipsizeString (pText, pDest, cbDest, INT_MAX);
+
+    case BENCH_NORMALIZE:
+      return fReference
+               ? ReferenceNormalizeSpaces (pText, pDest, cbDest)
+               : NormalizeSpaces (pText, pDest, cbDest);
+
+    default:
+      return fReference
+               ? ReferenceJSEscapeString (pText, pDest, cbDest)
+               : JSEscapeString (pText, pDest, cbDest);
+  }
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                      Now
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static double Now
+   (void)
+
+{
+  struct timespec now;
+
+
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                 ReferenceEllipsizeString
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  These are the versions of the functions from before they were
+*   vectorized.
+*/
+
+static bool ReferenceEllipsizeString
+   (const char   *pSourceStr,
+    char         *pDestStr,
+    int           cbMax,
+    int           nMaxChars)
+
+{
+  int i, nChars = 0, cb = -1;
+  char c;
+
+
+  for (i = 0; (c = pSourceStr [i]) != '\0'; i++)
+  {
+    if (((c & 0xc0) != 0x80) && (++nChars == nMaxChars))
+    {
+      cb = i;
+      break;
+    }
+  }
+
+
+  if (pSourceStr == pDestStr)
+  {
+    if (cb >= 0)
+    {
+      strcpy (pDestStr + cb, "...");
+    }
+  }
+  else
+  {
+    if (cb >= 0)
+    {
+      snprintf (pDestStr, cbMax, "%.*s...", cb, pSourceStr);
+    }
+    else
+    {
+      strncpy (pDestStr, pSourceStr, cbMax);
+    }
+  }
+
+  return cb >= 0;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                 ReferenceNormalizeSpaces
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static int ReferenceNormalizeSpaces
+   (const char  *pStr,
+    char        *pDest,
+    int          cbMax)
+
+{
+  int i, j;
+  char c;
+  bool fSpace;
+
+
+  for (i = j = 0, fSpace = false; (c = pStr [i]) != '\0'; i++)
+  {
+    if ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'))
+    {
+      fSpace = true;
+    }
+    else
+    {
+      if (cbMax - j < (fSpace ? 3 : 2))
+        break;
+
+      if (fSpace && (j > 0))
+      {
+        pDest [j++] = ' ';
+      }
+
+      pDest [j++] = c;
+      fSpace = false;
+    }
+  }
+
+  pDest [j] = '\0';
+
+  return j;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                  ReferenceJSEscapeString
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static bool ReferenceJSEscapeString
+   (const char  *pStrSource,
+    char        *pStrDest,
+    int          cbDestMax)
+
+{
+  int i, n, cbEscape;
+  unsigned int CodePoint, c2, c3, c4;
+  unsigned char c;
+  char d;
+  bool fTruncated = false;
+
+  static const char HexDigits [] = "0123456789abcdef";
+
+
+  i = n = 0;
+  while ((c = (unsigned char) pStrSource [i++]) != '\0')
+  {
+    if ((c >= 32) && (c <= 126)
+           && (c != '\\') && (c != '"'))
+    {
+      if (cbDestMax - n < 2)
+      {
+        fTruncated = true;
+        break;
+      }
+
+      pStrDest [n++] = (char) c;
+      continue;
+    }
+
+    switch (c)
+    {
+      case '"':   d = '"';   cbEscape = 2;  break;
+      case '\\':  d = '\\';  cbEscape = 2;  break;
+      case '\t':  d = 't';   cbEscape = 2;  break;
+      case '\n':  d = 'n';   cbEscape = 2;  break;
+      case '\r':  d = 'r';   cbEscape = 2;  break;
+      default:    d = 'u';   cbEscape = 6;
+    }
+
+    if (cbDestMax - n < cbEscape + 1)
+    {
+      fTruncated = true;
+      break;
+    }
+
+    pStrDest [n++] = '\\';
+    pStrDest [n++] = d;
+
+    if (d == 'u')
+    {
+      if ((c & 0x80) == 0)
+      {
+        CodePoint = (unsigned int) c;
+      }
+      else if ((c & 0xe0) == 0xc0)
+      {
+        c2 = (unsigned int) (pStrSource [i++] & 0x3f);
+        CodePoint = ((c & 0x1f) << 6) | c2;
+      }
+      else if ((c & 0xf0) == 0xe0)
+      {
+        c2 = (unsigned int) (pStrSource [i++] & 0x3f);
+        c3 = (unsigned int) (pStrSource [i++] & 0x3f);
+        CodePoint = ((c & 0x0f) << 12) | (c2 << 6) | c3;
+      }
+      else if ((c & 0xf8) == 0xf0)
+      {
+        c2 = (unsigned int) (pStrSource [i++] & 0x3f);
+        c3 = (unsigned int) (pStrSource [i++] & 0x3f);
+        c4 = (unsigned int) (pStrSource [i++] & 0x3f);
+        CodePoint = ((c & 0x03) << 18) | (c2 << 12) | (c3 << 6) | c4;
+      }
+      else
+      {
+        /*  Invalid UTF-8 sequence--skip it.  */
+        continue;
+      }
+
+      pStrDest [n++] = HexDigits [(CodePoint & 0xF000) >> 12];
+      pStrDest [n++] = HexDigits [(CodePoint & 0x0F00) >> 8];
+      pStrDest [n++] = HexDigits [(CodePoint & 0x00F0) >> 4];
+      pStrDest [n++] = HexDigits [CodePoint & 0x000F];
+    }
+  }
+
+  pStrDest [n] = '\0';
+
+  return fTruncated;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                  ReferenceCountCharsUTF8
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static int ReferenceCountCharsUTF8
+  (const char  *pStr,
+   int          cbStr)
+
+{
+  int i, count;
+
+
+  if (cbStr < 0)
+  {
+    cbStr = strlen (pStr);
+  }
+
+
+  for (i = count = 0; i < cbStr; i++)
+  {
+    if ((pStr [i] & 0xC0) != 0x80)
+    {
+      count++;
+    }
+  }
+
+  return count;
+}
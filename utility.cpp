@@ -37,311 +37,1585 @@
 #include <sys/stat.h>
 #include <limits.h>
 #include <envz.h>
+#include <sched.h>
+
+#if defined (__x86_64__) || defined (__i386__)
+#include <immintrin.h>                /*  Compiler intrinsics.  */
+#endif
 
 #include "utility.h"                  /*  Application headers.  */
 
 
 
+/*  Function prototypes.
+*/
+
+static int IndexRemainingLines (const char*, int, int, int, LINEINDEX*, int, int);
+static void SetLineIndex (LINEINDEX*, const char*, int, int);
+static bool FindOwnCgroup (char*, int, const char**, bool*);
+static int ReadCgroupQuota (const char*, bool);
+static int WriteUnicodeEscape (char*, unsigned int);
+static int DecodeUTF8 (const char*, int, unsigned int*);
+static int TrimPartialUTF8 (const char*, int);
+static int FindJSEscapeChar (const char*, int);
+static int FindSpaceToCollapse (const char*, int);
+static int FindCharOffsetUTF8 (const char*, int, int);
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           IsJSEscapeChar
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static inline
+bool IsJSEscapeChar
+   (char  c)
+
+{
+  return ((unsigned char) c < ' ') || ((unsigned char) c > '~') 
+            || (c == '\\') || (c == '"') || (c == '<');
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                              IsSpaceChar
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static inline
+bool IsSpaceChar
+   (char  c)
+
+{
+  return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r');
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          EllipsizeString
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  If the string has nMaxChars characters or more, keeps the first 
+*   nMaxChars - 1 of them and appends an ellipsis; returns true if it 
+*   did.  A copy that has to be cut short to fit in cbMax bytes is cut 
+*   at a character boundary.
+*/
+
+bool EllipsizeString
+   (const char   *pSourceStr,
+    char         *pDestStr,
+    int           cbMax,
+    int           nMaxChars)
+
+{
+  int cbSource, cbCopy, cb = -1;
+
+
+  cbSource = strlen (pSourceStr);
+
+  if (nMaxChars > 0)
+  {
+    cb = FindCharOffsetUTF8 (pSourceStr, cbSource, nMaxChars - 1);
+  }
+
+
+  if (pSourceStr == pDestStr)
+  {
+    if (cb >= 0)
+    {
+      strcpy (pDestStr + cb, "..."); 
+    }
+  }
+  else if (cbMax > 0)
+  {
+    if (cb >= 0)
+    {
+      cbCopy = (cb <= cbMax - 4) 
+                 ? cb 
+                 : TrimPartialUTF8 (pSourceStr, (cbMax >= 4) ? cbMax - 4 : 0);
+
+      memcpy (pDestStr, pSourceStr, cbCopy);
+      snprintf (pDestStr + cbCopy, cbMax - cbCopy, "...");
+    }
+    else
+    {
+      cbCopy = (cbSource < cbMax) 
+                 ? cbSource 
+                 : TrimPartialUTF8 (pSourceStr, cbMax - 1);
+
+      memcpy (pDestStr, pSourceStr, cbCopy);
+      pDestStr [cbCopy] = '\0';
+    }
+  }
+
+  return cb >= 0;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                 LoadFile
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+bool LoadFile
+   (const char   *pPath,
+    char        **ppContentOut,
+    int          *pcbOut,
+    char        **ppErrorOut)
+
+{
+  int fd, cbFile;
+  char *pContent;
+  struct stat status;
+
+
+  *ppContentOut = NULL;
+  *pcbOut = 0;  
+
+
+  if ((fd = open (pPath, O_RDONLY | O_CLOEXEC)) < 0)
+  {
+    *ppErrorOut = strdup (strerror (errno));
+    return false;
+  }
+
+
+  fstat (fd, &status);
+
+  if ((status.st_mode & S_IFMT) != S_IFREG)
+  {
+    close (fd);
+    *ppErrorOut = strdup ("Not a regular file");
+    return false;
+  }
+
+
+  cbFile = status.st_size;
+  pContent = (char*) malloc (cbFile + 1);
+  read (fd, pContent, cbFile);
+  close (fd);
+
+
+  pContent [cbFile] = '\0';
+
+  *ppContentOut = pContent;
+  *pcbOut = cbFile;
+  *ppErrorOut = NULL;
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          NormalizeSpaces
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Copies the string with leading and trailing whitespace dropped and
+*   each run of it inside reduced to one space.  Stretches that are 
+*   already normal--words separated by single spaces--are found with 
+*   FindSpaceToCollapse() and copied whole; if the last one doesn't 
+*   fit, it is cut at a character boundary.
+*/
+
+int NormalizeSpaces 
+   (const char  *pStr, 
+    char        *pDest,
+    int          cbMax)
+
+{
+  int i, j, cbStr, cbRun, cbCopy;
+  bool fSpace;
+
+
+  cbStr = strlen (pStr);
+
+  for (i = j = 0, fSpace = false; i < cbStr; )
+  {
+    if (IsSpaceChar (pStr [i]))
+    {
+      fSpace = true;
+      i++;
+      continue;
+    }
+
+
+    if (cbMax - j < (fSpace ? 3 : 2))
+      break;
+
+    if (fSpace && (j > 0))
+    {
+      pDest [j++] = ' ';        
+    }
+
+    cbRun = FindSpaceToCollapse (pStr + i, cbStr - i);
+
+    if (cbRun > cbMax - j - 1)
+    {
+      cbCopy = TrimPartialUTF8 (pStr + i, cbMax - j - 1);
+      memcpy (pDest + j, pStr + i, cbCopy);
+      j += cbCopy;
+
+      while ((j > 0) && (pDest [j - 1] == ' '))
+      {
+        j--;
+      }
+
+      break;
+    }
+
+    memcpy (pDest + j, pStr + i, cbRun);
+    i += cbRun;
+    j += cbRun;
+    fSpace = false;  
+  }
+
+  pDest [j] = '\0';
+
+  return j;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           JSEscapeString
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Escapes the string for use inside a double-quoted JavaScript string
+*   literal (or JSON string).  Runs of printable ASCII are found with 
+*   FindJSEscapeChar() and copied as they are; everything else is 
+*   escaped, non-ASCII characters as \u escapes (two of them, a 
+*   surrogate pair, above U+FFFF).  '<' is escaped too, so that the 
+*   result can't close a <script> element it is placed in.  Malformed 
+*   UTF-8 comes out as U+FFFD.  Returns true if the result had to be 
+*   truncated; escapes are never cut in half.
+*/
+
+bool JSEscapeString 
+   (const char  *pStrSource, 
+    char        *pStrDest, 
+    int          cbDestMax)
+
+{
+  int i, n, cbSource, cbRun, cbEscape, cbSequence;
+  unsigned int CodePoint = 0;
+  char d;
+  bool fTruncated = false;
+
+
+  cbSource = strlen (pStrSource);
+
+  for (i = n = 0; i < cbSource; i += cbSequence)
+  {
+    cbRun = FindJSEscapeChar (pStrSource + i, cbSource - i);
+
+    if (cbRun > cbDestMax - n - 1)
+    {
+      memcpy (pStrDest + n, pStrSource + i, cbDestMax - n - 1);
+      n = cbDestMax - 1;
+      fTruncated = true;
+      break;
+    }
+
+    memcpy (pStrDest + n, pStrSource + i, cbRun);
+    n += cbRun;
+    i += cbRun;
+
+    if (i >= cbSource)
+      break;
+
+
+    cbSequence = 1;
+
+    switch (pStrSource [i])
+    {
+      case '"':   d = '"';   cbEscape = 2;  break;
+      case '\\':  d = '\\';  cbEscape = 2;  break;
+      case '\t':  d = 't';   cbEscape = 2;  break;
+      case '\n':  d = 'n';   cbEscape = 2;  break;
+      case '\r':  d = 'r';   cbEscape = 2;  break;
+      default:    
+        d = 'u';
+        cbSequence = DecodeUTF8 (pStrSource + i, cbSource - i, &CodePoint);
+        cbEscape = (CodePoint > 0xffff) ? 12 : 6;
+    }  
+
+    if (cbDestMax - n < cbEscape + 1)
+    {
+      fTruncated = true;
+      break;
+    }
+
+
+    if (d != 'u')
+    {
+      pStrDest [n++] = '\\';
+      pStrDest [n++] = d;
+    }
+    else if (CodePoint > 0xffff)
+    {
+      CodePoint -= 0x10000;
+      n += WriteUnicodeEscape (pStrDest + n, 0xd800 | (CodePoint >> 10));
+      n += WriteUnicodeEscape (pStrDest + n, 0xdc00 | (CodePoint & 0x3ff));
+    }
+    else
+    {
+      n += WriteUnicodeEscape (pStrDest + n, CodePoint);
+    }
+  }
+
+  pStrDest [n] = '\0';
+
+  return fTruncated;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       WriteUnicodeEscape
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+static
+int WriteUnicodeEscape
+   (char          *pDest,
+    unsigned int   CodeUnit)
+
+{
+  static const char HexDigits [] = "0123456789abcdef";
+
+
+  pDest [0] = '\\';
+  pDest [1] = 'u';
+  pDest [2] = HexDigits [(CodeUnit & 0xF000) >> 12];
+  pDest [3] = HexDigits [(CodeUnit & 0x0F00) >> 8];        
+  pDest [4] = HexDigits [(CodeUnit & 0x00F0) >> 4];
+  pDest [5] = HexDigits [CodeUnit & 0x000F];  
+
+  return 6;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               DecodeUTF8
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Decodes the UTF-8 sequence at the start of the text, storing its code
+*   point and returning its length.  A malformed sequence (overlong, a 
+*   surrogate, beyond U+10FFFF, or cut short) decodes as U+FFFD, taking
+*   up the bytes that could have begun a valid one, or at least one 
+*   byte--the "maximal subpart" Unicode recommends replacing.  Nothing 
+*   past cbText is read.
+*/
+
+static
+int DecodeUTF8
+   (const char    *pText,
+    int            cbText,
+    unsigned int  *pCodePoint)
+
+{
+  int i, cbSequence;
+  unsigned int c, CodePoint, low = 0x80, high = 0xbf;
+
+
+  c = (unsigned char) pText [0];
+
+  if (c < 0x80)
+  {
+    *pCodePoint = c;
+    return 1;
+  }
+  else if ((c >= 0xc2) && (c <= 0xdf))
+  {
+    cbSequence = 2;
+    CodePoint = c & 0x1f;
+  }
+  else if ((c >= 0xe0) && (c <= 0xef))
+  {
+    cbSequence = 3;
+    CodePoint = c & 0x0f;
+
+    if (c == 0xe0)
+      low = 0xa0;              /*  Overlong.  */
+    else if (c == 0xed)
+      high = 0x9f;             /*  Surrogates.  */
+  }
+  else if ((c >= 0xf0) && (c <= 0xf4))
+  {
+    cbSequence = 4;
+    CodePoint = c & 0x07;
+
+    if (c == 0xf0)
+      low = 0x90;              /*  Overlong.  */
+    else if (c == 0xf4)
+      high = 0x8f;             /*  Beyond U+10FFFF.  */
+  }
+  else
+  {
+    *pCodePoint = 0xfffd;
+    return 1;
+  }
+
+
+  for (i = 1; i < cbSequence; i++)
+  {
+    if ((i >= cbText) 
+          || ((unsigned char) pText [i] < low) 
+          || ((unsigned char) pText [i] > high))
+    {
+      *pCodePoint = 0xfffd;
+      return i;
+    }
+
+    CodePoint = (CodePoint << 6) | (pText [i] & 0x3f);
+    low = 0x80;
+    high = 0xbf;
+  }
+
+  *pCodePoint = CodePoint;
+
+  return cbSequence;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                          TrimPartialUTF8
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns cb, less the length of any incomplete UTF-8 sequence at the
+*   end of the first cb bytes of the text.
+*/
+
+static
+int TrimPartialUTF8
+   (const char  *pText,
+    int          cb)
+
+{
+  int i, cbSequence;
+  unsigned char c;
+
+
+  for (i = cb - 1; (i > cb - 4) && (i >= 0) && ((pText [i] & 0xc0) == 0x80); i--)
+    ;
+
+  if (i < 0)
+    return cb;
+
+  c = (unsigned char) pText [i];
+  cbSequence = (c < 0xc0) ? 1 : (c < 0xe0) ? 2 : (c < 0xf0) ? 3 : 4;
+
+  return (i + cbSequence > cb) ? i : cb;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         FindJSEscapeChar
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the offset of the first byte in the text that JSEscapeString()
+*   can't copy as it is--anything outside printable ASCII, a backslash, 
+*   a double quote or a '<'--or cbText if there is none.  Bytes of 0x80 and up
+*   are negative as signed chars, so one signed comparison at each end 
+*   of the range does.
+*/
+
+#if defined (__x86_64__) || defined (__i386__)
+
+__attribute__ ((target ("avx2")))
+static
+int FindJSEscapeCharAVX2
+   (const char  *pText,
+    int          cbText)
+
+{
+  int i;
+  unsigned int mask;
+  const __m256i space = _mm256_set1_epi8 (' '), tilde = _mm256_set1_epi8 ('~'),
+                backslash = _mm256_set1_epi8 ('\\'), quote = _mm256_set1_epi8 ('"'),
+                less = _mm256_set1_epi8 ('<');
+  __m256i block, special;
+
+
+  for (i = 0; i + 32 <= cbText; i += 32)
+  {
+    block = _mm256_loadu_si256 ((const __m256i*) (pText + i));
+    special = _mm256_or_si256 (_mm256_or_si256 (_mm256_cmpgt_epi8 (space, block),
+                                                _mm256_cmpgt_epi8 (block, tilde)),
+                               _mm256_or_si256 (_mm256_cmpeq_epi8 (block, backslash),
+                                                _mm256_cmpeq_epi8 (block, quote)));
+    special = _mm256_or_si256 (special, _mm256_cmpeq_epi8 (block, less));
+    mask = (unsigned int) _mm256_movemask_epi8 (special);
+
+    if (mask != 0)
+      return i + __builtin_ctz (mask);
+  }
+
+  for (; i < cbText; i++)
+  {
+    if (IsJSEscapeChar (pText [i]))
+      return i;
+  }
+
+  return cbText;
+}
+
+#endif
+
+
+static
+int FindJSEscapeChar
+   (const char  *pText,
+    int          cbText)
+
+{
+  int i = 0;
+
+
+#if defined (__x86_64__) || defined (__i386__)
+  static const bool fHaveAVX2 = __builtin_cpu_supports ("avx2");
+
+  if (fHaveAVX2 && (cbText >= 64))
+    return FindJSEscapeCharAVX2 (pText, cbText);
+#endif
+
+
+#if defined (__SSE2__)
+  unsigned int mask;
+  const __m128i space = _mm_set1_epi8 (' '), tilde = _mm_set1_epi8 ('~'),
+                backslash = _mm_set1_epi8 ('\\'), quote = _mm_set1_epi8 ('"'),
+                less = _mm_set1_epi8 ('<');
+  __m128i block, special;
+
+  for (; i + 16 <= cbText; i += 16)
+  {
+    block = _mm_loadu_si128 ((const __m128i*) (pText + i));
+    special = _mm_or_si128 (_mm_or_si128 (_mm_cmpgt_epi8 (space, block),
+                                          _mm_cmpgt_epi8 (block, tilde)),
+                            _mm_or_si128 (_mm_cmpeq_epi8 (block, backslash),
+                                          _mm_cmpeq_epi8 (block, quote)));
+    special = _mm_or_si128 (special, _mm_cmpeq_epi8 (block, less));
+    mask = (unsigned int) _mm_movemask_epi8 (special);
+
+    if (mask != 0)
+      return i + __builtin_ctz (mask);
+  }
+#endif
+
+
+  for (; i < cbText; i++)
+  {
+    if (IsJSEscapeChar (pText [i]))
+      return i;
+  }
+
+  return cbText;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                      FindSpaceToCollapse
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the offset of the first whitespace in the text that 
+*   NormalizeSpaces() can't copy as it is, or cbText if there is none.
+*   That is any tab, carriage return or newline, and any space that is
+*   followed by more whitespace or by the end of the text; a single 
+*   space between two words is left alone.  Each vector is compared 
+*   along with the same bytes shifted by one, so the scan stops a byte 
+*   short of the end and leaves the last few to the plain C loop.
+*/
+
+static inline
+bool IsSpaceToCollapse
+   (const char  *pText,
+    int          cbText,
+    int          i)
+
+{
+  return IsSpaceChar (pText [i]) 
+           && ((pText [i] != ' ') || (i + 1 == cbText) || IsSpaceChar (pText [i + 1]));
+}
+
+
+#if defined (__x86_64__) || defined (__i386__)
+
+__attribute__ ((target ("avx2")))
+static
+int FindSpaceToCollapseAVX2
+   (const char  *pText,
+    int          cbText)
+
+{
+  int i;
+  unsigned int mask;
+  const __m256i space = _mm256_set1_epi8 (' '), tab = _mm256_set1_epi8 ('\t'),
+                cr = _mm256_set1_epi8 ('\r'), newline = _mm256_set1_epi8 ('\n');
+  __m256i block, next, ControlSpace, NextSpace;
+
+
+  for (i = 0; i + 33 <= cbText; i += 32)
+  {
+    block = _mm256_loadu_si256 ((const __m256i*) (pText + i));
+    next = _mm256_loadu_si256 ((const __m256i*) (pText + i + 1));
+
+    ControlSpace = _mm256_or_si256 (_mm256_or_si256 (_mm256_cmpeq_epi8 (block, tab),
+                                                     _mm256_cmpeq_epi8 (block, cr)),
+                                    _mm256_cmpeq_epi8 (block, newline));
+    NextSpace = _mm256_or_si256 (_mm256_or_si256 (_mm256_cmpeq_epi8 (next, space),
+                                                  _mm256_cmpeq_epi8 (next, tab)),
+                                 _mm256_or_si256 (_mm256_cmpeq_epi8 (next, cr),
+                                                  _mm256_cmpeq_epi8 (next, newline)));
+    mask = (unsigned int) _mm256_movemask_epi8 
+                             (_mm256_or_si256 (ControlSpace,
+                                               _mm256_and_si256 (_mm256_cmpeq_epi8 (block, space),
+                                                                 NextSpace)));
+    if (mask != 0)
+      return i + __builtin_ctz (mask);
+  }
+
+  for (; i < cbText; i++)
+  {
+    if (IsSpaceToCollapse (pText, cbText, i))
+      return i;
+  }
+
+  return cbText;
+}
+
+#endif
+
+
+static
+int FindSpaceToCollapse
+   (const char  *pText,
+    int          cbText)
+
+{
+  int i = 0;
+
+
+#if defined (__x86_64__) || defined (__i386__)
+  static const bool fHaveAVX2 = __builtin_cpu_supports ("avx2");
+
+  if (fHaveAVX2 && (cbText >= 64))
+    return FindSpaceToCollapseAVX2 (pText, cbText);
+#endif
+
+
+#if defined (__SSE2__)
+  unsigned int mask;
+  const __m128i space = _mm_set1_epi8 (' '), tab = _mm_set1_epi8 ('\t'),
+                cr = _mm_set1_epi8 ('\r'), newline = _mm_set1_epi8 ('\n');
+  __m128i block, next, ControlSpace, NextSpace;
+
+  for (; i + 17 <= cbText; i += 16)
+  {
+    block = _mm_loadu_si128 ((const __m128i*) (pText + i));
+    next = _mm_loadu_si128 ((const __m128i*) (pText + i + 1));
+
+    ControlSpace = _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (block, tab),
+                                               _mm_cmpeq_epi8 (block, cr)),
+                                 _mm_cmpeq_epi8 (block, newline));
+    NextSpace = _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (next, space),
+                                            _mm_cmpeq_epi8 (next, tab)),
+                              _mm_or_si128 (_mm_cmpeq_epi8 (next, cr),
+                                            _mm_cmpeq_epi8 (next, newline)));
+    mask = (unsigned int) _mm_movemask_epi8 
+                             (_mm_or_si128 (ControlSpace,
+                                            _mm_and_si128 (_mm_cmpeq_epi8 (block, space),
+                                                           NextSpace)));
+    if (mask != 0)
+      return i + __builtin_ctz (mask);
+  }
+#endif
+
+
+  for (; i < cbText; i++)
+  {
+    if (IsSpaceToCollapse (pText, cbText, i))
+      return i;
+  }
+
+  return cbText;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                                 FoldChar
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Lowercases ASCII letters only, so that the indices sort and match 
+*   the same way whatever the server's locale.
+*/
+
+int FoldChar
+   (unsigned char  c)
+
+{
+  return ((c >= 'A') && (c <= 'Z')) ? (c + ('a' - 'A')) : c;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                            ComparePrefix
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Compares the first cbPrefix bytes of a string with a prefix, 
+*   ignoring case.  A string shorter than the prefix sorts before it, 
+*   since its terminating NUL is compared with one of the prefix's 
+*   bytes.
+*/
+
+int ComparePrefix
+   (const char  *pStr,
+    const char  *pPrefix,
+    int          cbPrefix)
+
+{
+  const unsigned char *p = (const unsigned char*) pStr;
+  const unsigned char *q = (const unsigned char*) pPrefix;
+  int i, t;
+
+
+  for (i = 0; i < cbPrefix; i++)
+  {
+    if ((t = FoldChar (p [i]) - FoldChar (q [i])) != 0)
+      return t;
+  }
+
+  return 0;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         InitOutputBuffer
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  If pFixedBuffer is NULL, the buffer starts out empty and is allocated 
+*   (and grown) on demand.  Otherwise it is a fixed-size wrapper around 
+*   pFixedBuffer.
+*/
+
+void InitOutputBuffer
+   (OUTPUTBUFFER  *pBuffer,
+    char          *pFixedBuffer,
+    int            cbFixedBuffer)
+
+{
+  pBuffer->pData        = pFixedBuffer;
+  pBuffer->cbData       = 0;
+  pBuffer->cbAllocated  = (pFixedBuffer != NULL) ? cbFixedBuffer : 0;
+  pBuffer->fFixedSize   = (pFixedBuffer != NULL);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       ReserveOutputSpace
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Makes sure there are at least cbNeeded bytes free after the current 
+*   data, growing the buffer if possible.  Returns false if there isn't 
+*   enough room in a fixed-size buffer (or if memory runs out).
+*/
+
+bool ReserveOutputSpace
+   (OUTPUTBUFFER  *pBuffer,
+    int            cbNeeded)
+
+{
+  int cbNew;
+  char *pNew;
+
+
+  if (pBuffer->cbAllocated - pBuffer->cbData >= cbNeeded)
+    return true;
+
+  if (pBuffer->fFixedSize)
+    return false;
+
+
+  cbNew = (pBuffer->cbAllocated > 0) ? pBuffer->cbAllocated : 4096;
+  while (cbNew - pBuffer->cbData < cbNeeded)
+  {
+    cbNew *= 2;
+  }
+
+  pNew = (char*) realloc (pBuffer->pData, cbNew);
+  if (pNew == NULL)
+    return false;
+
+  pBuffer->pData = pNew;
+  pBuffer->cbAllocated = cbNew;
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                     AppendToOutputBuffer
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+bool AppendToOutputBuffer
+   (OUTPUTBUFFER  *pBuffer,
+    const char    *pData,
+    int            cbData)
+
+{
+  if (cbData < 0)
+  {
+    cbData = strlen (pData);
+  }
+
+  if (!ReserveOutputSpace (pBuffer, cbData))
+    return false;
+
+  memcpy (pBuffer->pData + pBuffer->cbData, pData, cbData);
+  pBuffer->cbData += cbData;
+
+  return true;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                         FreeOutputBuffer
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+void FreeOutputBuffer
+   (OUTPUTBUFFER  *pBuffer)
+
+{
+  if (!pBuffer->fFixedSize)
+  {
+    free (pBuffer->pData);
+  }
+
+  InitOutputBuffer (pBuffer, NULL, 0);
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                           CountCharsUTF8
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Counts the bytes that aren't continuation bytes (0x80 to 0xbf), 
+*   which as signed chars are just those greater than (char) 0xbf, a 
+*   vector at a time.
+*/
+
+#if defined (__x86_64__) || defined (__i386__)
+
+__attribute__ ((target ("avx2,popcnt")))
+static
+int CountCharsUTF8AVX2
+  (const char  *pStr,
+   int          cbStr)
+
+{
+  int i, count = 0;
+  const __m256i LastContinuation = _mm256_set1_epi8 ((char) 0xbf);
+
+
+  for (i = 0; i + 32 <= cbStr; i += 32)
+  {
+    count += __builtin_popcount 
+                ((unsigned int) _mm256_movemask_epi8 
+                     (_mm256_cmpgt_epi8 (_mm256_loadu_si256 ((const __m256i*) (pStr + i)),
+                                         LastContinuation)));
+  }
+
+  for (; i < cbStr; i++)
+  {
+    count += ((pStr [i] & 0xC0) != 0x80);
+  }
+
+  return count;
+}
+
+#endif
+
+
+int CountCharsUTF8
+  (const char  *pStr,
+   int          cbStr)
+
+{
+  int i = 0, count = 0;
+
+
+  if (cbStr < 0)
+  {
+    cbStr = strlen (pStr);
+  }
+
+
+#if defined (__x86_64__) || defined (__i386__)
+  static const bool fHaveAVX2 = __builtin_cpu_supports ("avx2")
+                                  && __builtin_cpu_supports ("popcnt");
+
+  if (fHaveAVX2 && (cbStr >= 64))
+    return CountCharsUTF8AVX2 (pStr, cbStr);
+#endif
+
+
+#if defined (__SSE2__)
+  const __m128i LastContinuation = _mm_set1_epi8 ((char) 0xbf);
+
+  for (; i + 16 <= cbStr; i += 16)
+  {
+    count += __builtin_popcount 
+                ((unsigned int) _mm_movemask_epi8 
+                     (_mm_cmpgt_epi8 (_mm_loadu_si128 ((const __m128i*) (pStr + i)),
+                                      LastContinuation)));
+  }
+#endif
+
+
+  for (; i < cbStr; i++)
+  {
+    count += ((pStr [i] & 0xC0) != 0x80);
+  }
+
+  return count;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                       FindCharOffsetUTF8
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the offset at which character iChar (counting from zero) 
+*   starts, or -1 if the text has no more than iChar characters.  Whole
+*   vectors are counted as in CountCharsUTF8() and skipped until the 
+*   character falls within one.
+*/
+
+static inline
+int FindNthBit
+   (unsigned int  mask,
+    int           n)
+
+{
+  for (; n > 0; n--)
+  {
+    mask &= mask - 1;
+  }
+
+  return __builtin_ctz (mask);
+}
+
+
+#if defined (__x86_64__) || defined (__i386__)
+
+__attribute__ ((target ("avx2,popcnt")))
+static
+int FindCharOffsetUTF8AVX2
+   (const char  *pStr,
+    int          cbStr,
+    int          iChar)
+
+{
+  int i, n;
+  unsigned int mask;
+  const __m256i LastContinuation = _mm256_set1_epi8 ((char) 0xbf);
+
+
+  for (i = 0; i + 32 <= cbStr; i += 32)
+  {
+    mask = (unsigned int) _mm256_movemask_epi8 
+                             (_mm256_cmpgt_epi8 (_mm256_loadu_si256 ((const __m256i*) (pStr + i)),
+                                                 LastContinuation));
+    n = __builtin_popcount (mask);
+
+    if (iChar < n)
+      return i + FindNthBit (mask, iChar);
+
+    iChar -= n;
+  }
+
+  for (; i < cbStr; i++)
+  {
+    if (((pStr [i] & 0xC0) != 0x80) && (iChar-- == 0))
+      return i;
+  }
+
+  return -1;
+}
+
+#endif
+
+
+static
+int FindCharOffsetUTF8
+   (const char  *pStr,
+    int          cbStr,
+    int          iChar)
+
+{
+  int i = 0;
+
+
+#if defined (__x86_64__) || defined (__i386__)
+  static const bool fHaveAVX2 = __builtin_cpu_supports ("avx2")
+                                  && __builtin_cpu_supports ("popcnt");
+
+  if (fHaveAVX2 && (cbStr >= 64))
+    return FindCharOffsetUTF8AVX2 (pStr, cbStr, iChar);
+#endif
+
+
+#if defined (__SSE2__)
+  int n;
+  unsigned int mask;
+  const __m128i LastContinuation = _mm_set1_epi8 ((char) 0xbf);
+
+  for (; i + 16 <= cbStr; i += 16)
+  {
+    mask = (unsigned int) _mm_movemask_epi8 
+                             (_mm_cmpgt_epi8 (_mm_loadu_si128 ((const __m128i*) (pStr + i)),
+                                              LastContinuation));
+    n = __builtin_popcount (mask);
+
+    if (iChar < n)
+      return i + FindNthBit (mask, iChar);
+
+    iChar -= n;
+  }
+#endif
+
+
+  for (; i < cbStr; i++)
+  {
+    if (((pStr [i] & 0xC0) != 0x80) && (iChar-- == 0))
+      return i;
+  }
+
+  return -1;
+}
+
+
+
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                               CountLines
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
+
+/*  Returns the number of lines IndexLines() finds in the given text 
+*   (one more than the number of newlines), so that its array can be
+*   allocated up front.
+*/
+
+#if defined (__x86_64__) || defined (__i386__)
+
+__attribute__ ((target ("avx2,popcnt")))
+static
+int CountLinesAVX2
+   (const char  *pText,
+    int          cbText)
+
+{
+  int i, count = 1;
+  const __m256i newline = _mm256_set1_epi8 ('\n');
+
+
+  for (i = 0; i + 32 <= cbText; i += 32)
+  {
+    count += __builtin_popcount 
+                ((unsigned int) _mm256_movemask_epi8 
+                     (_mm256_cmpeq_epi8 (_mm256_loadu_si256 ((const __m256i*) (pText + i)),
+                                         newline)));
+  }
+
+  for (; i < cbText; i++)
+  {
+    count += (pText [i] == '\n');
+  }
+
+  return count;
+}
+
+#endif
+
+
+int CountLines
+   (const char  *pText,
+    int          cbText)
+
+{
+  int i = 0, count = 1;
+
+
+#if defined (__x86_64__) || defined (__i386__)
+  static const bool fHaveAVX2 = __builtin_cpu_supports ("avx2")
+                                  && __builtin_cpu_supports ("popcnt");
+
+  if (fHaveAVX2 && (cbText >= 64))
+    return CountLinesAVX2 (pText, cbText);
+#endif
+
+
+#if defined (__SSE2__)
+  const __m128i newline = _mm_set1_epi8 ('\n');
+
+  for (; i + 16 <= cbText; i += 16)
+  {
+    count += __builtin_popcount 
+                ((unsigned int) _mm_movemask_epi8 
+                     (_mm_cmpeq_epi8 (_mm_loadu_si128 ((const __m128i*) (pText + i)),
+                                      newline)));
+  }
+#endif
+
+
+  for (; i < cbText; i++)
+  {
+    count += (pText [i] == '\n');
+  }
+
+  return count;
+}
+
+
+
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                          EllipsizeString
+                                                               IndexLines
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-bool EllipsizeString
-   (const char   *pSourceStr,
-    char         *pDestStr,
-    int           cbMax,
-    int           nMaxChars)
+/*  Describes the lines of the text from offset iStart on, up to 
+*   nMaxLines of them, and returns the number described.  Offsets are
+*   from the start of pText.  Whatever follows the last newline counts 
+*   as a line, even if it is empty, so a caller can tell that a line is
+*   complete by its not being the last one.
+*
+*   The newlines are found a vector at a time; the indent and trailing
+*   whitespace of each line are then looked at from either end.
+*/
+
+#if defined (__x86_64__) || defined (__i386__)
+
+__attribute__ ((target ("avx2")))
+static
+int IndexLinesAVX2
+   (const char  *pText,
+    int          cbText,
+    int          iStart,
+    LINEINDEX   *pLines,
+    int          nMaxLines)
 
 {
-  int i, nChars = 0, cb = -1;
-  char c;
+  int i, n = 0, iLine = iStart;
+  unsigned int mask;
+  const __m256i newline = _mm256_set1_epi8 ('\n');
 
 
-  for (i = 0; (c = pSourceStr [i]) != '\0'; i++)
+  for (i = iStart; i + 32 <= cbText; i += 32)
   {
-    if (((c & 0xc0) != 0x80) && (++nChars == nMaxChars))
+    mask = (unsigned int) _mm256_movemask_epi8 
+                             (_mm256_cmpeq_epi8 (_mm256_loadu_si256 ((const __m256i*) (pText + i)),
+                                                 newline));
+
+    while (mask != 0)
     {
-      cb = i;
-      break;
+      SetLineIndex (pLines + n, pText, iLine, i + __builtin_ctz (mask));
+      iLine = i + __builtin_ctz (mask) + 1;
+      mask &= mask - 1;
+
+      if (++n == nMaxLines)
+        return n;
     }
   }
 
+  return IndexRemainingLines (pText, cbText, i, iLine, pLines, n, nMaxLines);
+}
 
-  if (pSourceStr == pDestStr)
-  {
-    if (cb >= 0)
-    {
-      strcpy (pDestStr + cb, "..."); 
-    }
-  }
-  else
+#endif
+
+
+int IndexLines
+   (const char  *pText,
+    int          cbText,
+    int          iStart,
+    LINEINDEX   *pLines,
+    int          nMaxLines)
+
+{
+  int i = iStart, n = 0, iLine = iStart;
+
+
+  if (nMaxLines <= 0)
+    return 0;
+
+
+#if defined (__x86_64__) || defined (__i386__)
+  static const bool fHaveAVX2 = __builtin_cpu_supports ("avx2");
+
+  if (fHaveAVX2 && (cbText - iStart >= 64))
+    return IndexLinesAVX2 (pText, cbText, iStart, pLines, nMaxLines);
+#endif
+
+
+#if defined (__SSE2__)
+  unsigned int mask;
+  const __m128i newline = _mm_set1_epi8 ('\n');
+
+  for (; i + 16 <= cbText; i += 16)
   {
-    if (cb >= 0)
-    {
-      snprintf (pDestStr, cbMax, "%.*s...", cb, pSourceStr);
-    }
-    else
+    mask = (unsigned int) _mm_movemask_epi8 
+                             (_mm_cmpeq_epi8 (_mm_loadu_si128 ((const __m128i*) (pText + i)),
+                                              newline));
+
+    while (mask != 0)
     {
-      strncpy (pDestStr, pSourceStr, cbMax);
+      SetLineIndex (pLines + n, pText, iLine, i + __builtin_ctz (mask));
+      iLine = i + __builtin_ctz (mask) + 1;
+      mask &= mask - 1;
+
+      if (++n == nMaxLines)
+        return n;
     }
   }
+#endif
 
-  return cb >= 0;
+
+  return IndexRemainingLines (pText, cbText, i, iLine, pLines, n, nMaxLines);
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                                 LoadFile
+                                                      IndexRemainingLines
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-bool LoadFile
-   (const char   *pPath,
-    char        **ppContentOut,
-    int          *pcbOut,
-    char        **ppErrorOut)
+/*  Finishes IndexLines() a byte at a time from offset i, where the 
+*   current line starts at iLine and n lines have been described so far.
+*/
 
-{
-  int fd, cbFile;
-  char *pContent;
-  struct stat status;
+static
+int IndexRemainingLines
+   (const char  *pText,
+    int          cbText,
+    int          i,
+    int          iLine,
+    LINEINDEX   *pLines,
+    int          n,
+    int          nMaxLines)
 
+{
+  for (; i < cbText; i++)
+  {
+    if (pText [i] == '\n')
+    {
+      SetLineIndex (pLines + n, pText, iLine, i);
+      iLine = i + 1;
 
-  *ppContentOut = NULL;
-  *pcbOut = 0;  
+      if (++n == nMaxLines)
+        return n;
+    }
+  }
 
+  SetLineIndex (pLines + n, pText, iLine, cbText);
 
-  if ((fd = open (pPath, O_RDONLY | O_CLOEXEC)) < 0)
-  {
-    *ppErrorOut = strdup (strerror (errno));
-    return false;
-  }
+  return n + 1;
+}
 
 
-  fstat (fd, &status);
 
-  if ((status.st_mode & S_IFMT) != S_IFREG)
-  {
-    close (fd);
-    *ppErrorOut = strdup ("Not a regular file");
-    return false;
-  }
+/*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
+                                                             SetLineIndex
+-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
+static inline
+void SetLineIndex
+   (LINEINDEX   *pLine,
+    const char  *pText,
+    int          iLine,
+    int          iEnd)
 
-  cbFile = status.st_size;
-  pContent = (char*) malloc (cbFile + 1);
-  read (fd, pContent, cbFile);
-  close (fd);
+{
+  int i, j;
+  char c;
 
 
-  pContent [cbFile] = '\0';
+  for (i = iLine; (i < iEnd) && ((pText [i] == ' ') || (pText [i] == '\t')); i++)
+  { /* Empty loop. */ }
 
-  *ppContentOut = pContent;
-  *pcbOut = cbFile;
-  *ppErrorOut = NULL;
+  for (j = iEnd
+         ; (j > iLine) && (c = pText [j - 1], ((c == ' ') || (c == '\t') || (c == '\r')))
+         ; j--)
+  { /* Empty loop. */ }
 
-  return true;
+  pLine->offset         = iLine;
+  pLine->length         = iEnd - iLine;
+  pLine->TrimmedLength  = j - iLine;
+  pLine->indent         = i - iLine;
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                          NormalizeSpaces
+                                                           SetCloseOnExec
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-int NormalizeSpaces 
-   (const char  *pStr, 
-    char        *pDest,
-    int          cbMax)
+void SetCloseOnExec
+   (int   fd,
+    bool  fCloseOnExec)
 
 {
-  int i, j;
-  char c;
-  bool fSpace;
-
+  int OldFlags, NewFlags;
 
-  for (i = j = 0, fSpace = false; (c = pStr [i]) != '\0'; i++)
-  {
-    if ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'))
-    {
-      fSpace = true;
-    }
-    else
-    {
-      if (cbMax - j < (fSpace ? 3 : 2))
-        break;
 
-      if (fSpace && (j > 0))
-      {
-        pDest [j++] = ' ';        
-      }
+  if (fd < 0)
+    return;
 
-      pDest [j++] = c;
-      fSpace = false;  
-    }
-  }
+  OldFlags = fcntl (fd, F_GETFD, 0);
 
-  pDest [j] = '\0';
+  NewFlags = fCloseOnExec
+                ? (OldFlags | FD_CLOEXEC)
+                : (OldFlags & ~FD_CLOEXEC);
 
-  return j;
+  if (NewFlags != OldFlags)
+  {
+    fcntl (fd, F_SETFD, NewFlags);
+  }
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                           JSEscapeString
+                                                       CountAvailableCPUs
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-bool JSEscapeString 
-   (const char  *pStrSource, 
-    char        *pStrDest, 
-    int          cbDestMax)
+/*  Returns the number of CPUs this process can actually use: those in 
+*   its affinity mask, or fewer if a CPU quota has been set for its 
+*   control group or any group above it (as in a container).  Both 
+*   cgroup v2's cpu.max and v1's cfs_quota_us are understood; a 
+*   fractional quota is rounded up.  The result is at least 1.
+*/
 
-{
-  int i, n, cbEscape;
-  unsigned int CodePoint, c2, c3, c4;
-  unsigned char c;
-  char d;
-  bool fTruncated = false;
+int CountAvailableCPUs
+   (void)
 
-  static const char HexDigits [] = "0123456789abcdef";
+{
+  int nCPUs = 0, nQuotaCPUs;
+  bool fVersion2;
+  cpu_set_t mask;
+  const char *pMount = NULL;
+  char group [PATH_MAX], path [PATH_MAX], *pSlash;
 
 
-  i = n = 0;
-  while ((c = (unsigned char) pStrSource [i++]) != '\0')
+  if (sched_getaffinity (0, sizeof (mask), &mask) == 0)
   {
-    if ((c >= 32) && (c <= 126) 
-           && (c != '\\') && (c != '"'))
-    {
-      if (cbDestMax - n < 2)
-      {
-        fTruncated = true;
-        break;
-      }
-
-      pStrDest [n++] = (char) c;
-      continue;
-    }
+    nCPUs = CPU_COUNT (&mask);
+  }
 
-    switch (c)
-    {
-      case '"':   d = '"';   cbEscape = 2;  break;
-      case '\\':  d = '\\';  cbEscape = 2;  break;
-      case '\t':  d = 't';   cbEscape = 2;  break;
-      case '\n':  d = 'n';   cbEscape = 2;  break;
-      case '\r':  d = 'r';   cbEscape = 2;  break;
-      default:    d = 'u';   cbEscape = 6;  
-    }  
+  if (nCPUs <= 0)
+  {
+    nCPUs = (int) sysconf (_SC_NPROCESSORS_ONLN);
+  }
 
-    if (cbDestMax - n < cbEscape + 1)
-    {
-      fTruncated = true;
-      break;
-    }
 
-    pStrDest [n++] = '\\';
-    pStrDest [n++] = d;
+  /*  Check the process's own group and each one above it up to the root 
+  *   of the mounted hierarchy, since a quota anywhere on the way applies.
+  *   A group that isn't visible under the mount point (because the mount
+  *   is itself a group below the root, as in many containers) is simply
+  *   not found, and the search goes on with its parent.  So is one whose
+  *   path is too long to open.
+  */
 
-    if (d == 'u') 
+  if (FindOwnCgroup (group, sizeof (group), &pMount, &fVersion2))
+  {
+    for (;;)
     {
-      if ((c & 0x80) == 0)
-      {
-        CodePoint = (unsigned int) c;
-      }
-      else if ((c & 0xe0) == 0xc0)
-      {
-        c2 = (unsigned int) (pStrSource [i++] & 0x3f);
-        CodePoint = ((c & 0x1f) << 6) | c2;
-      }
-      else if ((c & 0xf0) == 0xe0)
-      {
-        c2 = (unsigned int) (pStrSource [i++] & 0x3f);
-        c3 = (unsigned int) (pStrSource [i++] & 0x3f);
-        CodePoint = ((c & 0x0f) << 12) | (c2 << 6) | c3;
-      }
-      else if ((c & 0xf8) == 0xf0)
-      {
-        c2 = (unsigned int) (pStrSource [i++] & 0x3f);
-        c3 = (unsigned int) (pStrSource [i++] & 0x3f);
-        c4 = (unsigned int) (pStrSource [i++] & 0x3f);
-        CodePoint = ((c & 0x03) << 18) | (c2 << 12) | (c3 << 6) | c4;
-      }
+      if (snprintf (path, sizeof (path), "%s%s", pMount, group) < (int) sizeof (path))
+        nQuotaCPUs = ReadCgroupQuota (path, fVersion2);
       else
+        nQuotaCPUs = 0;
+
+      if ((nQuotaCPUs > 0) && (nQuotaCPUs < nCPUs))
       {
-        /*  Invalid UTF-8 sequence--skip it.  */
-        continue;
+        nCPUs = nQuotaCPUs;
       }
 
-      pStrDest [n++] = HexDigits [(CodePoint & 0xF000) >> 12];
-      pStrDest [n++] = HexDigits [(CodePoint & 0x0F00) >> 8];        
-      pStrDest [n++] = HexDigits [(CodePoint & 0x00F0) >> 4];
-      pStrDest [n++] = HexDigits [CodePoint & 0x000F];  
+      if ((group [0] == '\0') || (strcmp (group, "/") == 0))
+        break;
+
+      pSlash = strrchr (group, '/');
+      *((pSlash != NULL) ? pSlash : group) = '\0';
     }
   }
 
-  pStrDest [n] = '\0';
-
-  return fTruncated;
+  return (nCPUs > 0) ? nCPUs : 1;
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                           CountCharsUTF8
+                                                            FindOwnCgroup
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-int CountCharsUTF8
-  (const char  *pStr,
-   int          cbStr)
+/*  Finds the control group that governs this process's CPU time, from
+*   /proc/self/cgroup.  A v1 hierarchy with the "cpu" controller is used
+*   if there is one (on a hybrid system the v2 hierarchy then has no CPU
+*   controller); otherwise the v2 group from the "0::" line.  Returns 
+*   the group's path in pGroup and the mount point of its hierarchy in 
+*   *ppMount.
+*/
+
+static
+bool FindOwnCgroup
+   (char         *pGroup,
+    int           cbMax,
+    const char  **ppMount,
+    bool         *pfVersion2)
 
 {
-  int i, count;
+  char line [PATH_MAX + 64], *pControllers, *pPath, *pController, *pSave;
+  bool fFoundV1 = false, fFoundV2 = false;
+  FILE *pFile;
+  struct stat info;
 
 
-  if (cbStr < 0)
+  if ((pFile = fopen ("/proc/self/cgroup", "r")) == NULL)
+    return false;
+
+  /*  Each line is "hierarchy-ID:controller-list:path".
+  */
+
+  while (!fFoundV1 && (fgets (line, sizeof (line), pFile) != NULL))
   {
-    cbStr = strlen (pStr);
+    line [strcspn (line, "\n")] = '\0';
+
+    if ((pControllers = strchr (line, ':')) == NULL)
+      continue;
+
+    *pControllers++ = '\0';
+
+    if ((pPath = strchr (pControllers, ':')) == NULL)
+      continue;
+
+    *pPath++ = '\0';
+
+    if ((strcmp (line, "0") == 0) && (pControllers [0] == '\0'))
+    {
+      snprintf (pGroup, cbMax, "%s", pPath);
+      fFoundV2 = true;
+      continue;
+    }
+
+    for (pController = strtok_r (pControllers, ",", &pSave)
+           ; pController != NULL
+           ; pController = strtok_r (NULL, ",", &pSave))
+    {
+      if (strcmp (pController, "cpu") == 0)
+      {
+        /*  The controller's mount point is usually /sys/fs/cgroup/cpu, 
+        *   or, without that link, the directory named after all the 
+        *   controllers mounted with it.
+        */
+
+        snprintf (pGroup, cbMax, "%s", pPath);
+
+        *ppMount = (stat ("/sys/fs/cgroup/cpu", &info) == 0)
+                      ? "/sys/fs/cgroup/cpu"
+                      : "/sys/fs/cgroup/cpu,cpuacct";
+        *pfVersion2 = false;
+        fFoundV1 = true;
+        break;
+      }
+    }
   }
 
+  fclose (pFile);
 
-  for (i = count = 0; i < cbStr; i++)
+  if (!fFoundV1 && fFoundV2)
   {
-  	if ((pStr [i] & 0xC0) != 0x80)
-  	{
-  	  count++;
-  	}
+    *ppMount = "/sys/fs/cgroup";
+    *pfVersion2 = true;
   }
 
-  return count;
+  return fFoundV1 || fFoundV2;
 }
 
 
 
 /*-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
-                                                           SetCloseOnExec
+                                                          ReadCgroupQuota
 -~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-*/
 
-void SetCloseOnExec
-   (int   fd,
-    bool  fCloseOnExec)
+/*  Returns the CPU quota of the control group in directory pDir as a 
+*   number of CPUs, rounded up, or 0 if it has none or can't be read.
+*/
 
-{
-  int OldFlags, NewFlags;
+static
+int ReadCgroupQuota
+   (const char  *pDir,
+    bool         fVersion2)
 
+{
+  long long quota = -1, period = 0;
+  char path [PATH_MAX];
+  FILE *pFile;
 
-  if (fd < 0)
-    return;
 
-  OldFlags = fcntl (fd, F_GETFD, 0);
+  /*  cpu.max holds "max PERIOD" when there is no quota, which leaves
+  *   quota at -1.
+  */
 
-  NewFlags = fCloseOnExec
-                ? (OldFlags | FD_CLOEXEC)
-                : (OldFlags & ~FD_CLOEXEC);
+  if (fVersion2)
+  {
+    if ((snprintf (path, sizeof (path), "%s/cpu.max", pDir) < (int) sizeof (path))
+          && ((pFile = fopen (path, "r")) != NULL))
+    {
+      if (fscanf (pFile, "%lld %lld", &quota, &period) != 2)
+      {
+        quota = -1;
+      }
 
-  if (NewFlags != OldFlags)
+      fclose (pFile);
+    }
+  }
+  else
   {
-    fcntl (fd, F_SETFD, NewFlags);
+    if ((snprintf (path, sizeof (path), "%s/cpu.cfs_quota_us", pDir) < (int) sizeof (path))
+          && ((pFile = fopen (path, "r")) != NULL))
+    {
+      if (fscanf (pFile, "%lld", &quota) != 1)
+      {
+        quota = -1;
+      }
+
+      fclose (pFile);
+    }
+
+    if ((quota > 0)
+          && (snprintf (path, sizeof (path), "%s/cpu.cfs_period_us", pDir) < (int) sizeof (path))
+          && ((pFile = fopen (path, "r")) != NULL))
+    {
+      if (fscanf (pFile, "%lld", &period) != 1)
+      {
+        period = 0;
+      }
+
+      fclose (pFile);
+    }
   }
+
+  if ((quota <= 0) || (period <= 0))
+    return 0;
+
+  return (int) ((quota + period - 1) / period);
 }
 
 
@@ -627,7 +1901,12 @@ int CaptureInput
         break;
     }
 
-    if (pfd.revents & (POLLHUP | POLLERR))
+    /*  A hang-up can be reported along with data that is still waiting 
+    *   in the pipe, which is read before the zero-length read ends the 
+    *   loop.
+    */
+
+    if ((pfd.revents & (POLLHUP | POLLERR)) && !(pfd.revents & POLLIN))
       break;
   }
 
@@ -63,6 +63,36 @@ struct PROCESSERRORINFO
 
 
 
+/*  An output buffer that grows as needed, or a wrapper around a fixed-
+*   size buffer supplied by the caller.
+*/
+
+struct OUTPUTBUFFER
+{
+  char  *pData;
+  int    cbData;
+  int    cbAllocated;
+  bool   fFixedSize;
+};
+
+
+
+/*  One line of a block of text, as found by IndexLines().  The length
+*   does not include the newline; the trimmed length also leaves out
+*   trailing spaces, tabs and carriage returns, and the indent is the
+*   number of leading spaces and tabs.
+*/
+
+struct LINEINDEX
+{
+  int  offset;
+  int  length;
+  int  TrimmedLength;
+  int  indent;
+};
+
+
+
 extern "C"
 {
 extern bool EllipsizeString
@@ -91,16 +121,64 @@ extern bool JSEscapeString
     int          cbDestMax);
    
 
+extern int FoldChar
+   (unsigned char  c);
+
+
+extern int ComparePrefix
+   (const char  *pStr,
+    const char  *pPrefix,
+    int          cbPrefix);
+
+
+extern void InitOutputBuffer
+   (OUTPUTBUFFER  *pBuffer,
+    char          *pFixedBuffer,
+    int            cbFixedBuffer);
+
+
+extern bool ReserveOutputSpace
+   (OUTPUTBUFFER  *pBuffer,
+    int            cbNeeded);
+
+
+extern bool AppendToOutputBuffer
+   (OUTPUTBUFFER  *pBuffer,
+    const char    *pData,
+    int            cbData);
+
+
+extern void FreeOutputBuffer
+   (OUTPUTBUFFER  *pBuffer);
+
+
 extern int CountCharsUTF8
    (const char  *pStr,
     int          cbStr);
 
 
+extern int CountLines
+   (const char  *pText,
+    int          cbText);
+
+
+extern int IndexLines
+   (const char  *pText,
+    int          cbText,
+    int          iStart,
+    LINEINDEX   *pLines,
+    int          nMaxLines);
+
+
 extern void SetCloseOnExec
    (int   fd,
     bool  fCloseOnExec);
 
 
+extern int CountAvailableCPUs
+   (void);
+
+
 extern bool CreateChildProcess
    (pid_t              *pidOut,     
     PROCESSERRORINFO   *pErrorOut,   